@@ -0,0 +1,12 @@
+# Google Benchmark is looked up in the system (or in benchmark_DIR)
+find_package(benchmark REQUIRED)
+
+add_custom_target(build_benchmarks ALL)
+
+function(add_benchmark targetname)
+  message(STATUS "Registering benchmark ${targetname}")
+
+  add_dependencies(build_benchmarks ${targetname})
+
+  target_link_libraries(${targetname} benchmark::benchmark)
+endfunction(add_benchmark)
@@ -0,0 +1,864 @@
+// End-to-end benchmark of a SSF tunnel on the loopback interface
+//
+// A SSF server and a SSF client run in the same process with the network
+// protocol of the build (see DISABLE_TLS). The client opens a user service
+// (-L, -D or -U) to an echo server and parallel connections send requests
+// through the tunnel for a given duration. The results are written as JSON so
+// that runs can be compared across commits.
+
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <cxxopts.hpp>
+#include <json.hpp>
+
+#include <ssf/log/log.h>
+
+#include "common/config/config.h"
+
+#include "core/client/client.h"
+#include "core/client/status.h"
+#include "core/network_protocol.h"
+#include "core/server/server.h"
+#include "core/transport_virtual_layer_policies/transport_protocol_policy.h"
+
+#include "services/user_services/base_user_service.h"
+#include "services/user_services/parameters.h"
+#include "services/user_services/port_forwarding.h"
+#include "services/user_services/socks.h"
+#include "services/user_services/udp_port_forwarding.h"
+
+#include "tests/tls_config_helper.h"
+
+#include "versions.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using NetworkProtocol = ssf::network::NetworkProtocol;
+using Server =
+    ssf::SSFServer<NetworkProtocol::Protocol, ssf::TransportProtocolPolicy>;
+using Demux = ssf::Client::Demux;
+using BaseUserServicePtr =
+    ssf::services::BaseUserService<Demux>::BaseUserServicePtr;
+using TcpForward = ssf::services::PortForwarding<Demux>;
+using Socks = ssf::services::Socks<Demux>;
+using UdpForward = ssf::services::UdpPortForwarding<Demux>;
+
+// A datagram without echo after this delay is counted as lost
+const std::chrono::milliseconds kDatagramTimeout(1000);
+
+struct Parameters {
+  std::string service;
+  uint32_t connections;
+  uint32_t links;
+  std::size_t request_size;
+  uint32_t duration;
+  uint32_t threads;
+  uint16_t port;
+  std::string output;
+};
+
+int64_t ElapsedUs(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               start)
+      .count();
+}
+
+/// Result of one load connection
+struct ConnectionResult {
+  ConnectionResult() : ok(false), setup_us(0), requests(0), errors(0) {}
+
+  bool ok;
+  // time until the first response is received (the tunnel is established)
+  int64_t setup_us;
+  uint64_t requests;
+  uint64_t errors;
+  std::vector<int64_t> latencies_us;
+};
+
+using ConnectionDoneHandler = std::function<void()>;
+
+/// TCP echo server (target of -L and -D)
+class TcpEchoServer {
+ public:
+  TcpEchoServer(boost::asio::io_service& io_service)
+      : acceptor_(io_service), socket_(io_service) {}
+
+  void Start(const boost::asio::ip::tcp::endpoint& endpoint,
+             boost::system::error_code& ec) {
+    acceptor_.open(endpoint.protocol(), ec);
+    if (ec) {
+      return;
+    }
+    acceptor_.set_option(boost::asio::socket_base::reuse_address(true), ec);
+    acceptor_.bind(endpoint, ec);
+    if (ec) {
+      return;
+    }
+    acceptor_.listen(boost::asio::socket_base::max_connections, ec);
+    if (ec) {
+      return;
+    }
+    Accept();
+  }
+
+  void Stop() {
+    boost::system::error_code ec;
+    acceptor_.close(ec);
+  }
+
+ private:
+  struct Session : std::enable_shared_from_this<Session> {
+    Session(boost::asio::ip::tcp::socket socket)
+        : socket(std::move(socket)), buffer(64 * 1024) {}
+
+    void Read() {
+      auto self = shared_from_this();
+      socket.async_read_some(
+          boost::asio::buffer(buffer),
+          [self](const boost::system::error_code& ec, std::size_t length) {
+            if (ec) {
+              return;
+            }
+            boost::asio::async_write(
+                self->socket, boost::asio::buffer(self->buffer.data(), length),
+                [self](const boost::system::error_code& ec, std::size_t) {
+                  if (!ec) {
+                    self->Read();
+                  }
+                });
+          });
+    }
+
+    boost::asio::ip::tcp::socket socket;
+    std::vector<char> buffer;
+  };
+
+  void Accept() {
+    acceptor_.async_accept(socket_, [this](
+                                        const boost::system::error_code& ec) {
+      if (ec) {
+        return;
+      }
+      boost::system::error_code option_ec;
+      socket_.set_option(boost::asio::ip::tcp::no_delay(true), option_ec);
+      std::make_shared<Session>(std::move(socket_))->Read();
+      Accept();
+    });
+  }
+
+ private:
+  boost::asio::ip::tcp::acceptor acceptor_;
+  boost::asio::ip::tcp::socket socket_;
+};
+
+/// UDP echo server (target of -U)
+class UdpEchoServer {
+ public:
+  UdpEchoServer(boost::asio::io_service& io_service)
+      : socket_(io_service), sender_(), buffer_(64 * 1024) {}
+
+  void Start(const boost::asio::ip::udp::endpoint& endpoint,
+             boost::system::error_code& ec) {
+    socket_.open(endpoint.protocol(), ec);
+    if (ec) {
+      return;
+    }
+    socket_.bind(endpoint, ec);
+    if (ec) {
+      return;
+    }
+    Receive();
+  }
+
+  void Stop() {
+    boost::system::error_code ec;
+    socket_.close(ec);
+  }
+
+ private:
+  void Receive() {
+    socket_.async_receive_from(
+        boost::asio::buffer(buffer_), sender_,
+        [this](const boost::system::error_code& ec, std::size_t length) {
+          if (ec == boost::asio::error::operation_aborted) {
+            return;
+          }
+          if (ec) {
+            return Receive();
+          }
+          socket_.async_send_to(
+              boost::asio::buffer(buffer_.data(), length), sender_,
+              [this](const boost::system::error_code& ec, std::size_t) {
+                if (ec != boost::asio::error::operation_aborted) {
+                  Receive();
+                }
+              });
+        });
+  }
+
+ private:
+  boost::asio::ip::udp::socket socket_;
+  boost::asio::ip::udp::endpoint sender_;
+  std::vector<char> buffer_;
+};
+
+/// Request/response loop over a TCP connection (-L and -D)
+/**
+* With SOCKS, a SOCKS5 CONNECT to the echo server is sent first.
+*/
+class StreamConnection : public std::enable_shared_from_this<StreamConnection> {
+ public:
+  StreamConnection(boost::asio::io_service& io_service, std::size_t size,
+                   bool socks, const boost::asio::ip::tcp::endpoint& target)
+      : socket_(io_service),
+        request_(size, 'r'),
+        response_(size),
+        socks_(socks),
+        target_(target),
+        socks_buffer_(),
+        result_() {}
+
+  void Start(const boost::asio::ip::tcp::endpoint& endpoint,
+             Clock::time_point deadline, ConnectionDoneHandler done) {
+    deadline_ = deadline;
+    done_ = done;
+    start_ = Clock::now();
+    auto self = shared_from_this();
+    socket_.async_connect(
+        endpoint, [self](const boost::system::error_code& ec) {
+          if (ec) {
+            return self->Finish();
+          }
+          boost::system::error_code option_ec;
+          self->socket_.set_option(boost::asio::ip::tcp::no_delay(true),
+                                   option_ec);
+          if (self->socks_) {
+            self->SocksGreeting();
+          } else {
+            self->Request();
+          }
+        });
+  }
+
+  const ConnectionResult& result() const { return result_; }
+
+ private:
+  void SocksGreeting() {
+    // version 5, one method: no authentication
+    socks_buffer_ = {{0x05, 0x01, 0x00}};
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        socket_, boost::asio::buffer(socks_buffer_.data(), 3),
+        [self](const boost::system::error_code& ec, std::size_t) {
+          if (ec) {
+            return self->Finish();
+          }
+          boost::asio::async_read(
+              self->socket_, boost::asio::buffer(self->socks_buffer_.data(), 2),
+              [self](const boost::system::error_code& ec, std::size_t) {
+                if (ec || self->socks_buffer_[1] != 0x00) {
+                  return self->Finish();
+                }
+                self->SocksConnect();
+              });
+        });
+  }
+
+  void SocksConnect() {
+    // version 5, CONNECT, IPv4 address and port of the echo server
+    auto address = target_.address().to_v4().to_bytes();
+    auto port = target_.port();
+    socks_buffer_ = {{0x05, 0x01, 0x00, 0x01, address[0], address[1],
+                      address[2], address[3], static_cast<uint8_t>(port >> 8),
+                      static_cast<uint8_t>(port & 0xff)}};
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        socket_, boost::asio::buffer(socks_buffer_),
+        [self](const boost::system::error_code& ec, std::size_t) {
+          if (ec) {
+            return self->Finish();
+          }
+          boost::asio::async_read(
+              self->socket_, boost::asio::buffer(self->socks_buffer_),
+              [self](const boost::system::error_code& ec, std::size_t) {
+                if (ec || self->socks_buffer_[1] != 0x00) {
+                  return self->Finish();
+                }
+                self->Request();
+              });
+        });
+  }
+
+  void Request() {
+    auto request_start = Clock::now();
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        socket_, boost::asio::buffer(request_),
+        [self, request_start](const boost::system::error_code& ec,
+                              std::size_t) {
+          if (ec) {
+            ++self->result_.errors;
+            return self->Finish();
+          }
+          boost::asio::async_read(
+              self->socket_, boost::asio::buffer(self->response_),
+              [self, request_start](const boost::system::error_code& ec,
+                                    std::size_t) {
+                if (ec) {
+                  ++self->result_.errors;
+                  return self->Finish();
+                }
+                self->OnResponse(request_start);
+              });
+        });
+  }
+
+  void OnResponse(Clock::time_point request_start) {
+    if (!result_.ok) {
+      result_.ok = true;
+      result_.setup_us = ElapsedUs(start_);
+    }
+    ++result_.requests;
+    result_.latencies_us.push_back(ElapsedUs(request_start));
+    if (Clock::now() < deadline_) {
+      Request();
+    } else {
+      Finish();
+    }
+  }
+
+  void Finish() {
+    boost::system::error_code ec;
+    socket_.close(ec);
+    done_();
+  }
+
+ private:
+  boost::asio::ip::tcp::socket socket_;
+  std::vector<char> request_;
+  std::vector<char> response_;
+  bool socks_;
+  boost::asio::ip::tcp::endpoint target_;
+  std::array<uint8_t, 10> socks_buffer_;
+  Clock::time_point start_;
+  Clock::time_point deadline_;
+  ConnectionDoneHandler done_;
+  ConnectionResult result_;
+};
+
+/// Request/response loop over a UDP socket (-U)
+class DatagramConnection
+    : public std::enable_shared_from_this<DatagramConnection> {
+ public:
+  DatagramConnection(boost::asio::io_service& io_service, std::size_t size)
+      : strand_(io_service),
+        socket_(io_service),
+        timer_(io_service),
+        request_(size, 'r'),
+        response_(size),
+        sender_(),
+        request_id_(0),
+        finished_(false),
+        result_() {}
+
+  void Start(const boost::asio::ip::udp::endpoint& endpoint,
+             Clock::time_point deadline, ConnectionDoneHandler done) {
+    endpoint_ = endpoint;
+    deadline_ = deadline;
+    done_ = done;
+    start_ = Clock::now();
+    boost::system::error_code ec;
+    socket_.open(endpoint.protocol(), ec);
+    if (ec) {
+      return Finish();
+    }
+    strand_.post(std::bind(&DatagramConnection::Request, shared_from_this()));
+  }
+
+  const ConnectionResult& result() const { return result_; }
+
+ private:
+  void Request() {
+    auto request_start = Clock::now();
+    auto request_id = ++request_id_;
+    auto self = shared_from_this();
+    socket_.async_send_to(
+        boost::asio::buffer(request_), endpoint_,
+        strand_.wrap([self](const boost::system::error_code& ec, std::size_t) {
+          if (ec && ec != boost::asio::error::operation_aborted) {
+            ++self->result_.errors;
+            return self->Finish();
+          }
+        }));
+    timer_.expires_from_now(kDatagramTimeout);
+    timer_.async_wait(
+        strand_.wrap([self, request_id](const boost::system::error_code& ec) {
+          // the timer may expire while the echo is being handled
+          if (!ec && request_id == self->request_id_) {
+            // no echo: the receive operation is aborted
+            boost::system::error_code cancel_ec;
+            self->socket_.cancel(cancel_ec);
+          }
+        }));
+    socket_.async_receive_from(
+        boost::asio::buffer(response_), sender_,
+        strand_.wrap([self, request_start](const boost::system::error_code& ec,
+                                           std::size_t) {
+          boost::system::error_code cancel_ec;
+          self->timer_.cancel(cancel_ec);
+          if (ec == boost::asio::error::operation_aborted &&
+              self->socket_.is_open()) {
+            // datagram lost
+            ++self->result_.errors;
+          } else if (ec) {
+            ++self->result_.errors;
+            return self->Finish();
+          } else {
+            self->OnResponse(request_start);
+          }
+          if (Clock::now() < self->deadline_) {
+            self->Request();
+          } else {
+            self->Finish();
+          }
+        }));
+  }
+
+  void OnResponse(Clock::time_point request_start) {
+    if (!result_.ok) {
+      result_.ok = true;
+      result_.setup_us = ElapsedUs(start_);
+    }
+    ++result_.requests;
+    result_.latencies_us.push_back(ElapsedUs(request_start));
+  }
+
+  void Finish() {
+    if (finished_) {
+      return;
+    }
+    finished_ = true;
+    boost::system::error_code ec;
+    timer_.cancel(ec);
+    socket_.close(ec);
+    done_();
+  }
+
+ private:
+  boost::asio::io_service::strand strand_;
+  boost::asio::ip::udp::socket socket_;
+  boost::asio::steady_timer timer_;
+  std::vector<char> request_;
+  std::vector<char> response_;
+  boost::asio::ip::udp::endpoint endpoint_;
+  boost::asio::ip::udp::endpoint sender_;
+  uint64_t request_id_;
+  bool finished_;
+  Clock::time_point start_;
+  Clock::time_point deadline_;
+  ConnectionDoneHandler done_;
+  ConnectionResult result_;
+};
+
+/// SSF server and client connected on the loopback interface
+class Tunnel {
+ public:
+  Tunnel()
+      : running_(),
+        service_ready_(),
+        running_set_(),
+        service_ready_set_(),
+        setup_us_(0) {}
+
+  ~Tunnel() { Stop(); }
+
+  bool Start(uint16_t server_port, uint32_t links,
+             const ssf::UserServiceParameters& user_service_params,
+             const std::string& service) {
+    auto start = Clock::now();
+    auto port = std::to_string(server_port);
+
+    ssf::config::Config server_config;
+    server_config.Init();
+    ssf::tests::SetServerTlsConfig(&server_config);
+    auto server_query = NetworkProtocol::GenerateServerQuery("127.0.0.1", port,
+                                                             server_config);
+    p_server_.reset(new Server(server_config.services()));
+    boost::system::error_code ec;
+    p_server_->Run(server_query, ec);
+    if (ec) {
+      SSF_LOG("benchmark", error, "could not run server: {}", ec.message());
+      return false;
+    }
+
+    ssf::config::Config client_config;
+    client_config.Init();
+    ssf::tests::SetClientTlsConfig(&client_config);
+    auto client_query = NetworkProtocol::GenerateClientQuery(
+        "127.0.0.1", port, client_config, {});
+
+    // the callbacks are also called after Start (e.g. on disconnection)
+    auto on_status = [this](ssf::Status status) {
+      switch (status) {
+        case ssf::Status::kEndpointNotResolvable:
+        case ssf::Status::kServerUnreachable:
+        case ssf::Status::kServerNotSupported:
+          SetRunning(false);
+          SetServiceReady(false);
+          break;
+        case ssf::Status::kRunning:
+          SetRunning(true);
+          break;
+        default:
+          break;
+      }
+    };
+    auto on_user_service_status = [this, service](
+        BaseUserServicePtr p_user_service,
+        const boost::system::error_code& service_ec) {
+      if (p_user_service->GetName() == service) {
+        SetServiceReady(!service_ec);
+      }
+    };
+
+    p_client_.reset(new ssf::Client());
+    p_client_->Register<TcpForward>();
+    p_client_->Register<Socks>();
+    p_client_->Register<UdpForward>();
+    p_client_->Init(client_query, 1, 0, true, links, user_service_params,
+                    client_config.services(), on_status,
+                    on_user_service_status, ec);
+    if (ec) {
+      SSF_LOG("benchmark", error, "could not init client: {}", ec.message());
+      return false;
+    }
+    p_client_->Run(ec);
+    if (ec) {
+      SSF_LOG("benchmark", error, "could not run client: {}", ec.message());
+      return false;
+    }
+
+    auto running_future = running_.get_future();
+    auto service_ready_future = service_ready_.get_future();
+    if (!running_future.get() || !service_ready_future.get()) {
+      SSF_LOG("benchmark", error, "could not start the user service");
+      return false;
+    }
+    setup_us_ = ElapsedUs(start);
+    return true;
+  }
+
+  void Stop() {
+    boost::system::error_code ec;
+    if (p_client_) {
+      p_client_->Stop(ec);
+      p_client_->Deinit();
+      p_client_.reset();
+    }
+    if (p_server_) {
+      p_server_->Stop();
+      p_server_.reset();
+    }
+  }
+
+  // time to connect the client and start the user service
+  int64_t setup_us() const { return setup_us_; }
+
+ private:
+  void SetRunning(bool running) {
+    std::call_once(running_set_, [this, running]() {
+      running_.set_value(running);
+    });
+  }
+
+  void SetServiceReady(bool ready) {
+    std::call_once(service_ready_set_, [this, ready]() {
+      service_ready_.set_value(ready);
+    });
+  }
+
+ private:
+  std::unique_ptr<Server> p_server_;
+  std::unique_ptr<ssf::Client> p_client_;
+  std::promise<bool> running_;
+  std::promise<bool> service_ready_;
+  std::once_flag running_set_;
+  std::once_flag service_ready_set_;
+  int64_t setup_us_;
+};
+
+nlohmann::json Percentiles(std::vector<int64_t> values) {
+  nlohmann::json result;
+  if (values.empty()) {
+    return result;
+  }
+  std::sort(values.begin(), values.end());
+  auto at = [&values](double percentile) {
+    return values[static_cast<std::size_t>(percentile * (values.size() - 1))];
+  };
+  result["p50"] = at(0.50);
+  result["p90"] = at(0.90);
+  result["p99"] = at(0.99);
+  result["p999"] = at(0.999);
+  result["max"] = values.back();
+  return result;
+}
+
+bool ParseParameters(int argc, char** argv, Parameters* p_params) {
+  cxxopts::Options opts(argv[0], "SSF loopback benchmark " SSF_VERSION_STRING);
+  // clang-format off
+  opts.add_options()
+    ("h,help", "Show help message")
+    ("s,service",
+        "User service: tcp-forward (-L), socks (-D) or udp-forward (-U)",
+        cxxopts::value<std::string>()->default_value("tcp-forward"))
+    ("n,connections", "Number of parallel connections",
+        cxxopts::value<uint32_t>()->default_value("4"))
+    ("l,links", "Number of links between the SSF client and server",
+        cxxopts::value<uint32_t>()->default_value("1"))
+    ("r,request-size", "Size of the requests (echoed back) in bytes",
+        cxxopts::value<uint32_t>()->default_value("4096"))
+    ("d,duration", "Duration of the load in seconds",
+        cxxopts::value<uint32_t>()->default_value("10"))
+    ("t,threads", "Number of threads running the echo server and the load",
+        cxxopts::value<uint32_t>()->default_value("2"))
+    ("p,port", "Port of the SSF server (the two next ports are also used)",
+        cxxopts::value<uint32_t>()->default_value("18011"))
+    ("o,output", "Output JSON file (default: standard output)",
+        cxxopts::value<std::string>()->default_value(""));
+  // clang-format on
+
+  try {
+    opts.parse(argc, argv);
+    if (opts.count("help")) {
+      std::cerr << opts.help() << std::endl;
+      return false;
+    }
+    p_params->service = opts["service"].as<std::string>();
+    p_params->connections = opts["connections"].as<uint32_t>();
+    p_params->links = std::max<uint32_t>(opts["links"].as<uint32_t>(), 1);
+    p_params->request_size = opts["request-size"].as<uint32_t>();
+    p_params->duration = opts["duration"].as<uint32_t>();
+    p_params->threads = std::max<uint32_t>(opts["threads"].as<uint32_t>(), 1);
+    p_params->output = opts["output"].as<std::string>();
+    auto port = opts["port"].as<uint32_t>();
+    if (port == 0 || port > 65533) {
+      std::cerr << "invalid port" << std::endl;
+      return false;
+    }
+    p_params->port = static_cast<uint16_t>(port);
+  } catch (const std::exception& e) {
+    std::cerr << "cannot parse options: " << e.what() << std::endl;
+    return false;
+  }
+
+  const auto& service = p_params->service;
+  if (service != TcpForward::GetParseName() &&
+      service != Socks::GetParseName() &&
+      service != UdpForward::GetParseName()) {
+    std::cerr << "unknown service " << p_params->service << std::endl;
+    return false;
+  }
+  if (p_params->connections == 0 || p_params->request_size == 0) {
+    std::cerr << "connections and request size must not be null" << std::endl;
+    return false;
+  }
+  if (service == UdpForward::GetParseName() &&
+      p_params->request_size > 65507) {
+    std::cerr << "request size too big for a datagram" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Parameters params;
+  if (!ParseParameters(argc, argv, &params)) {
+    return 1;
+  }
+  SetLogLevel(spdlog::level::warn);
+
+  bool is_udp = params.service == UdpForward::GetParseName();
+  bool is_socks = params.service == Socks::GetParseName();
+  auto listen_port = static_cast<uint16_t>(params.port + 1);
+  auto target_port = static_cast<uint16_t>(params.port + 2);
+  auto loopback = boost::asio::ip::address_v4::loopback();
+
+  // echo server and load connections
+  boost::asio::io_service io_service;
+  std::unique_ptr<boost::asio::io_service::work> p_worker(
+      new boost::asio::io_service::work(io_service));
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < params.threads; ++i) {
+    threads.emplace_back([&io_service]() {
+      boost::system::error_code ec;
+      io_service.run(ec);
+    });
+  }
+  auto stop_threads = [&]() {
+    p_worker.reset();
+    io_service.stop();
+    for (auto& thread : threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  };
+
+  TcpEchoServer tcp_echo(io_service);
+  UdpEchoServer udp_echo(io_service);
+  boost::system::error_code ec;
+  if (is_udp) {
+    udp_echo.Start(boost::asio::ip::udp::endpoint(loopback, target_port), ec);
+  } else {
+    tcp_echo.Start(boost::asio::ip::tcp::endpoint(loopback, target_port), ec);
+  }
+  if (ec) {
+    std::cerr << "could not start echo server: " << ec.message() << std::endl;
+    stop_threads();
+    return 1;
+  }
+
+  ssf::UserServiceParameters user_service_params;
+  if (is_socks) {
+    user_service_params = {
+        {params.service,
+         {{{"addr", "127.0.0.1"}, {"port", std::to_string(listen_port)}}}}};
+  } else {
+    user_service_params = {{params.service,
+                            {{{"from_addr", "127.0.0.1"},
+                              {"from_port", std::to_string(listen_port)},
+                              {"to_addr", "127.0.0.1"},
+                              {"to_port", std::to_string(target_port)}}}}};
+  }
+
+  Tunnel tunnel;
+  if (!tunnel.Start(params.port, params.links, user_service_params,
+                    params.service)) {
+    std::cerr << "could not start the tunnel" << std::endl;
+    tcp_echo.Stop();
+    udp_echo.Stop();
+    stop_threads();
+    return 1;
+  }
+
+  // load
+  std::vector<std::shared_ptr<StreamConnection>> stream_connections;
+  std::vector<std::shared_ptr<DatagramConnection>> datagram_connections;
+  std::promise<void> load_done;
+  std::atomic<uint32_t> remaining(params.connections);
+  auto on_connection_done = [&remaining, &load_done]() {
+    if (--remaining == 0) {
+      load_done.set_value();
+    }
+  };
+
+  auto start = Clock::now();
+  auto deadline = start + std::chrono::seconds(params.duration);
+  for (uint32_t i = 0; i < params.connections; ++i) {
+    if (is_udp) {
+      auto p_connection =
+          std::make_shared<DatagramConnection>(io_service, params.request_size);
+      datagram_connections.push_back(p_connection);
+      p_connection->Start(boost::asio::ip::udp::endpoint(loopback, listen_port),
+                          deadline, on_connection_done);
+    } else {
+      auto p_connection = std::make_shared<StreamConnection>(
+          io_service, params.request_size, is_socks,
+          boost::asio::ip::tcp::endpoint(loopback, target_port));
+      stream_connections.push_back(p_connection);
+      p_connection->Start(boost::asio::ip::tcp::endpoint(loopback, listen_port),
+                          deadline, on_connection_done);
+    }
+  }
+  load_done.get_future().wait();
+  auto elapsed_us = ElapsedUs(start);
+
+  tunnel.Stop();
+  tcp_echo.Stop();
+  udp_echo.Stop();
+  stop_threads();
+
+  // results
+  std::vector<ConnectionResult> results;
+  for (auto& p_connection : stream_connections) {
+    results.push_back(p_connection->result());
+  }
+  for (auto& p_connection : datagram_connections) {
+    results.push_back(p_connection->result());
+  }
+
+  uint64_t requests = 0;
+  uint64_t errors = 0;
+  uint32_t failed_connections = 0;
+  std::vector<int64_t> setups_us;
+  std::vector<int64_t> latencies_us;
+  for (const auto& result : results) {
+    requests += result.requests;
+    errors += result.errors;
+    if (result.ok) {
+      setups_us.push_back(result.setup_us);
+    } else {
+      ++failed_connections;
+    }
+    latencies_us.insert(latencies_us.end(), result.latencies_us.begin(),
+                        result.latencies_us.end());
+  }
+  double elapsed_s = static_cast<double>(elapsed_us) / 1000000.0;
+
+  nlohmann::json report;
+  report["version"] = SSF_VERSION_STRING;
+#ifdef TLS_OVER_TCP_LINK
+  report["protocol"] = "full_tls";
+#else
+  report["protocol"] = "plain";
+#endif
+  report["service"] = params.service;
+  report["connections"] = params.connections;
+  report["links"] = params.links;
+  report["request_size"] = params.request_size;
+  report["duration_s"] = elapsed_s;
+  report["tunnel_setup_us"] = tunnel.setup_us();
+  report["requests"] = requests;
+  report["errors"] = errors;
+  report["failed_connections"] = failed_connections;
+  report["requests_per_second"] = requests / elapsed_s;
+  // echoed payload (each byte crosses the tunnel both ways)
+  report["bytes_per_second"] = requests * params.request_size / elapsed_s;
+  report["connection_setup_us"] = Percentiles(setups_us);
+  report["latency_us"] = Percentiles(latencies_us);
+
+  if (params.output.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream output(params.output);
+    output << report.dump(2) << std::endl;
+    if (!output) {
+      std::cerr << "could not write " << params.output << std::endl;
+      return 1;
+    }
+  }
+
+  return failed_connections == params.connections ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "common/boost/fiber/basic_endpoint.hpp"
+#include "common/boost/fiber/basic_fiber_demux.hpp"
+#include "common/boost/fiber/stream_fiber.hpp"
+
+// Allocations of the whole process (the io_service threads included)
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size != 0 ? size : 1);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef boost::asio::ip::tcp::socket socket_type;
+typedef boost::asio::fiber::basic_fiber_demux<socket_type> fiber_demux;
+typedef boost::asio::fiber::stream_fiber<socket_type> stream_fiber;
+typedef stream_fiber::socket fiber;
+typedef stream_fiber::acceptor fiber_acceptor;
+typedef stream_fiber::endpoint fiber_endpoint;
+
+/// Frames sent on each fiber per benchmark iteration
+enum : std::size_t { kFramesPerBatch = 64 };
+
+/// Two fiber demuxes connected over a loopback TCP socket pair
+/**
+* Each fiber pair streams frames of payload_size bytes from the client demux
+* to the server demux. A frame carries its send time so that the receiver
+* measures the latency of the frame through the demuxes (queueing included).
+* A payload smaller than the MTU of the demux is sent as a single demux frame.
+*/
+class DemuxBench {
+ private:
+  struct FiberPair {
+    FiberPair(boost::asio::io_service& io_service, std::size_t payload_size)
+        : acceptor(io_service),
+          sender(io_service),
+          receiver(io_service),
+          out_buffer(payload_size),
+          in_buffer(payload_size),
+          to_send(0),
+          to_receive(0),
+          latencies(kFramesPerBatch) {}
+
+    fiber_acceptor acceptor;
+    fiber sender;
+    fiber receiver;
+    std::vector<char> out_buffer;
+    std::vector<char> in_buffer;
+    std::size_t to_send;
+    std::size_t to_receive;
+    // latency (ns) of the frames of the current batch
+    std::vector<int64_t> latencies;
+  };
+
+ public:
+  DemuxBench(std::size_t threads, std::size_t fibers, std::size_t payload_size)
+      : io_service_(),
+        p_worker_(new boost::asio::io_service::work(io_service_)),
+        demux_client_(io_service_),
+        demux_server_(io_service_),
+        pairs_(),
+        threads_(),
+        connected_(false),
+        mutex_(),
+        done_(),
+        remaining_(0),
+        error_(false) {
+    payload_size = std::max(payload_size, sizeof(int64_t));
+    for (std::size_t i = 0; i < fibers; ++i) {
+      pairs_.emplace_back(new FiberPair(io_service_, payload_size));
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back([this]() {
+        boost::system::error_code ec;
+        io_service_.run(ec);
+      });
+    }
+    connected_ = Connect();
+  }
+
+  ~DemuxBench() {
+    boost::system::error_code ec;
+    for (auto& p_pair : pairs_) {
+      p_pair->sender.close(ec);
+      p_pair->receiver.close(ec);
+      p_pair->acceptor.close(ec);
+    }
+    demux_client_.close();
+    demux_server_.close();
+    p_worker_.reset();
+
+    for (auto& thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+    io_service_.stop();
+  }
+
+  bool connected() const { return connected_; }
+
+  /// Send kFramesPerBatch frames on each fiber and wait for their reception
+  bool Run() {
+    Expect(2 * pairs_.size());
+    for (auto& p_pair : pairs_) {
+      p_pair->to_send = kFramesPerBatch;
+      p_pair->to_receive = kFramesPerBatch;
+      auto p = p_pair.get();
+      io_service_.post([this, p]() { Receive(p); });
+      io_service_.post([this, p]() { Send(p); });
+    }
+    return Wait();
+  }
+
+  /// Append the latencies of the frames of the last batch
+  void CollectLatencies(std::vector<int64_t>* p_latencies) const {
+    for (auto& p_pair : pairs_) {
+      p_latencies->insert(p_latencies->end(), p_pair->latencies.begin(),
+                          p_pair->latencies.end());
+    }
+  }
+
+ private:
+  bool Connect() {
+    boost::system::error_code ec;
+    boost::asio::ip::tcp::acceptor acceptor(io_service_);
+    boost::asio::ip::tcp::endpoint endpoint(
+        boost::asio::ip::address_v4::loopback(), 0);
+    socket_type client(io_service_);
+    socket_type server(io_service_);
+    acceptor.open(endpoint.protocol(), ec);
+    if (!ec) {
+      acceptor.bind(endpoint, ec);
+    }
+    if (!ec) {
+      acceptor.listen(boost::asio::socket_base::max_connections, ec);
+    }
+    if (!ec) {
+      endpoint = acceptor.local_endpoint(ec);
+    }
+    if (!ec) {
+      client.connect(endpoint, ec);
+    }
+    if (!ec) {
+      acceptor.accept(server, ec);
+    }
+    if (ec) {
+      return false;
+    }
+    client.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+    server.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+
+    demux_client_.fiberize(std::move(client));
+    demux_server_.fiberize(std::move(server));
+
+    Expect(2 * pairs_.size());
+    for (std::size_t i = 0; i < pairs_.size(); ++i) {
+      auto& pair = *pairs_[i];
+      auto port = static_cast<uint32_t>(i + 1);
+      fiber_endpoint server_endpoint(stream_fiber::v1(), demux_server_, port);
+      pair.acceptor.open(server_endpoint.protocol(), ec);
+      pair.acceptor.bind(server_endpoint, ec);
+      pair.acceptor.listen(boost::asio::socket_base::max_connections, ec);
+      pair.acceptor.async_accept(
+          pair.receiver,
+          [this](const boost::system::error_code& ec) { Done(ec); });
+
+      fiber_endpoint client_endpoint(stream_fiber::v1(), demux_client_, port);
+      pair.sender.async_connect(
+          client_endpoint,
+          [this](const boost::system::error_code& ec) { Done(ec); });
+    }
+    return Wait();
+  }
+
+  void Send(FiberPair* p_pair) {
+    if (p_pair->to_send == 0) {
+      return Done(boost::system::error_code());
+    }
+    --p_pair->to_send;
+
+    int64_t now = Clock::now().time_since_epoch().count();
+    std::memcpy(p_pair->out_buffer.data(), &now, sizeof(now));
+    boost::asio::async_write(
+        p_pair->sender, boost::asio::buffer(p_pair->out_buffer),
+        [this, p_pair](const boost::system::error_code& ec, std::size_t) {
+          if (ec) {
+            return Done(ec);
+          }
+          Send(p_pair);
+        });
+  }
+
+  void Receive(FiberPair* p_pair) {
+    if (p_pair->to_receive == 0) {
+      return Done(boost::system::error_code());
+    }
+
+    boost::asio::async_read(
+        p_pair->receiver, boost::asio::buffer(p_pair->in_buffer),
+        [this, p_pair](const boost::system::error_code& ec, std::size_t) {
+          if (ec) {
+            return Done(ec);
+          }
+          int64_t sent;
+          std::memcpy(&sent, p_pair->in_buffer.data(), sizeof(sent));
+          auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+              Clock::now().time_since_epoch() - Clock::duration(sent));
+          --p_pair->to_receive;
+          p_pair->latencies[kFramesPerBatch - 1 - p_pair->to_receive] =
+              latency.count();
+          Receive(p_pair);
+        });
+  }
+
+  void Expect(std::size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    remaining_ = count;
+    error_ = false;
+  }
+
+  void Done(const boost::system::error_code& ec) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (ec) {
+      error_ = true;
+    }
+    if (--remaining_ == 0) {
+      done_.notify_all();
+    }
+  }
+
+  bool Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return remaining_ == 0; });
+    return !error_;
+  }
+
+ private:
+  boost::asio::io_service io_service_;
+  std::unique_ptr<boost::asio::io_service::work> p_worker_;
+  fiber_demux demux_client_;
+  fiber_demux demux_server_;
+  std::vector<std::unique_ptr<FiberPair>> pairs_;
+  std::vector<std::thread> threads_;
+  bool connected_;
+
+  std::mutex mutex_;
+  std::condition_variable done_;
+  std::size_t remaining_;
+  bool error_;
+};
+
+int64_t Percentile(std::vector<int64_t>* p_values, double percentile) {
+  if (p_values->empty()) {
+    return 0;
+  }
+  auto rank = static_cast<std::size_t>(percentile * (p_values->size() - 1));
+  std::nth_element(p_values->begin(), p_values->begin() + rank,
+                   p_values->end());
+  return (*p_values)[rank];
+}
+
+/// Stream frames over several fibers of a demux
+/**
+* Arguments: payload size (bytes), number of fibers, number of threads running
+* the io_service of the demuxes.
+*/
+void BM_StreamFiberFrames(benchmark::State& state) {
+  auto payload_size = static_cast<std::size_t>(state.range(0));
+  auto fibers = static_cast<std::size_t>(state.range(1));
+  auto threads = static_cast<std::size_t>(state.range(2));
+
+  DemuxBench bench(threads, fibers, payload_size);
+  if (!bench.connected()) {
+    state.SkipWithError("could not connect the fibers");
+    return;
+  }
+
+  std::vector<int64_t> latencies;
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    auto allocations_before = g_allocations.load();
+    if (!bench.Run()) {
+      state.SkipWithError("fiber transfer failed");
+      break;
+    }
+    allocations += g_allocations.load() - allocations_before;
+
+    state.PauseTiming();
+    bench.CollectLatencies(&latencies);
+    state.ResumeTiming();
+  }
+
+  auto frames = static_cast<double>(state.iterations() * fibers *
+                                    kFramesPerBatch);
+  state.SetBytesProcessed(state.iterations() * fibers * kFramesPerBatch *
+                          payload_size);
+  state.counters["frames_per_second"] =
+      benchmark::Counter(frames, benchmark::Counter::kIsRate);
+  state.counters["p50_latency_us"] = Percentile(&latencies, 0.50) / 1000.0;
+  state.counters["p99_latency_us"] = Percentile(&latencies, 0.99) / 1000.0;
+  state.counters["allocs_per_frame"] =
+      frames > 0 ? static_cast<double>(allocations) / frames : 0;
+}
+
+}  // namespace
+
+BENCHMARK(BM_StreamFiberFrames)
+    ->ArgNames({"payload", "fibers", "threads"})
+    ->ArgsProduct({{64, 1024, 16 * 1024, 60 * 1024}, {1, 8, 64}, {1, 2, 4}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -1,8 +1,13 @@
+#include <chrono>
+
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/system/error_code.hpp>
 
 #include <ssf/log/log.h>
+#include <ssf/metrics/exporter.h>
+#include <ssf/metrics/metrics.h>
 
 #include "common/config/config.h"
 
@@ -29,6 +34,11 @@ void RegisterUserServices(
     ssf::Client* client,
     ssf::UserServiceOptionFactory* user_service_option_factory);
 
+// append the metrics of the server to the metrics file once per period
+void PollRemoteStats(ssf::Client* client, boost::asio::steady_timer* timer,
+                     ssf::metrics::Exporter* exporter,
+                     std::chrono::seconds period);
+
 void Run(int argc, char** argv, boost::system::error_code& exit_ec);
 
 int main(int argc, char** argv) {
@@ -83,11 +93,29 @@ void Run(int argc, char** argv, boost::system::error_code& exit_ec) {
     }
   }
 
+  if (ssf_config.logging().async()) {
+    SetAsyncLog(ssf_config.logging().queue_size(),
+                ssf_config.logging().overflow_policy());
+  }
+
   ssf_config.Log();
   if (cmd.show_status()) {
     ssf_config.LogStatus();
   }
 
+  ssf::metrics::Exporter metrics_exporter;
+  if (ssf_config.metrics().enabled()) {
+    ssf::metrics::Enable();
+    boost::system::error_code metrics_ec;
+    metrics_exporter.Start(ssf_config.metrics().file(),
+                           std::chrono::seconds(ssf_config.metrics().period()),
+                           metrics_ec);
+    if (metrics_ec) {
+      SSF_LOG("ssf", warn, "cannot export metrics to <{}>",
+              ssf_config.metrics().file());
+    }
+  }
+
   if (!cmd.host_set()) {
     SSF_LOG("ssf", error, "no server host provided");
     exit_ec.assign(::error::destination_address_required,
@@ -139,7 +167,7 @@ void Run(int argc, char** argv, boost::system::error_code& exit_ec) {
       const boost::system::error_code& ec) {};
 
   client.Init(endpoint_query, cmd.max_connection_attempts(),
-              cmd.reconnection_timeout(), cmd.no_reconnection(),
+              cmd.reconnection_timeout(), cmd.no_reconnection(), cmd.links(),
               user_service_parameters, ssf_config.services(), on_status,
               on_user_service_status, exit_ec);
   if (exit_ec) {
@@ -170,12 +198,19 @@ void Run(int argc, char** argv, boost::system::error_code& exit_ec) {
     return;
   }
 
+  boost::asio::steady_timer remote_stats_timer(client.get_io_service());
+  if (ssf_config.metrics().enabled() && ssf_config.metrics().remote()) {
+    PollRemoteStats(&client, &remote_stats_timer, &metrics_exporter,
+                    std::chrono::seconds(ssf_config.metrics().period()));
+  }
+
   // blocks until signal or max reconnection attempts
   boost::system::error_code stop_ec;
   client.WaitStop(stop_ec);
 
   SSF_LOG("ssf", debug, "stop");
   signal.cancel(stop_ec);
+  remote_stats_timer.cancel(stop_ec);
 
   client.Deinit();
 }
@@ -206,3 +241,32 @@ void RegisterUserServices(
   user_service_option_factory->Register<ssf::services::Shell<Demux>>();
   user_service_option_factory->Register<ssf::services::RemoteShell<Demux>>();
 }
+
+void PollRemoteStats(ssf::Client* client, boost::asio::steady_timer* timer,
+                     ssf::metrics::Exporter* exporter,
+                     std::chrono::seconds period) {
+  timer->expires_from_now(period);
+  timer->async_wait([client, timer, exporter,
+                     period](const boost::system::error_code& ec) {
+    if (ec) {
+      return;
+    }
+
+    boost::system::error_code session_ec;
+    auto p_session = client->GetSession(session_ec);
+    if (p_session) {
+      p_session->AsyncGetRemoteStats(
+          "", [exporter](const boost::system::error_code& stats_ec,
+                         const std::string& stats) {
+            if (stats_ec) {
+              SSF_LOG("ssf", debug, "cannot get server metrics: {}",
+                      stats_ec.message());
+              return;
+            }
+            exporter->Write("{\"remote\": " + stats + "}");
+          });
+    }
+
+    PollRemoteStats(client, timer, exporter, period);
+  });
+}
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <type_traits>
 
 #include <boost/asio/io_service.hpp>
@@ -5,6 +6,8 @@
 #include <boost/system/error_code.hpp>
 
 #include <ssf/log/log.h>
+#include <ssf/metrics/exporter.h>
+#include <ssf/metrics/metrics.h>
 
 #include "common/config/config.h"
 
@@ -82,8 +85,26 @@ void Run(int argc, char** argv, boost::system::error_code& exit_ec) {
     }
   }
 
+  if (ssf_config.logging().async()) {
+    SetAsyncLog(ssf_config.logging().queue_size(),
+                ssf_config.logging().overflow_policy());
+  }
+
   ssf_config.Log();
 
+  ssf::metrics::Exporter metrics_exporter;
+  if (ssf_config.metrics().enabled()) {
+    ssf::metrics::Enable();
+    boost::system::error_code metrics_ec;
+    metrics_exporter.Start(ssf_config.metrics().file(),
+                           std::chrono::seconds(ssf_config.metrics().period()),
+                           metrics_ec);
+    if (metrics_ec) {
+      SSF_LOG("ssfcp", warn, "cannot export metrics to <{}>",
+              ssf_config.metrics().file());
+    }
+  }
+
   // create and initialize copy user service
   ssf::UserServiceParameters copy_params = {
       {CopyService::GetParseName(),
@@ -111,7 +132,7 @@ void Run(int argc, char** argv, boost::system::error_code& exit_ec) {
   ssf::services::copy::CopyRequest req(
       cmd.stdin_input(), cmd.resume(), cmd.recursive(),
       cmd.check_file_integrity(), cmd.max_parallel_copies(),
-      cmd.input_pattern(), cmd.output_pattern());
+      cmd.input_pattern(), cmd.output_pattern(), cmd.stream());
 
   auto endpoint_query = ssf::GenerateNetworkQuery(
       cmd.host(), std::to_string(cmd.port()), ssf_config);
@@ -164,8 +185,9 @@ void Run(int argc, char** argv, boost::system::error_code& exit_ec) {
     }
   };
 
-  client.Init(endpoint_query, 1, 0, true, copy_params, ssf_config.services(),
-              on_status, on_user_service_status, exit_ec);
+  client.Init(endpoint_query, 1, 0, true, 1, copy_params,
+              ssf_config.services(), on_status, on_user_service_status,
+              exit_ec);
   if (exit_ec) {
     SSF_LOG("ssfcp", error, "cannot init client ({})", exit_ec.message());
     return;
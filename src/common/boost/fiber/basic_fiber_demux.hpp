@@ -13,6 +13,7 @@
 #endif  // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
 #include <functional>
+#include <mutex>
 
 #include <boost/asio.hpp>
 
@@ -71,6 +72,10 @@ class basic_fiber_demux : private boost::noncopyable {
       accept_op;
   typedef std::function<void()> close_handler_type;
 
+ public:
+  /// Bounds of the maximum payload size of one frame (MTU)
+  enum { kDefaultMTU = 60 * 1024, kMaxMTU = 1024 * 1024 };
+
  public:
   /// Construct a basic_fiber_demux object
   /**
@@ -95,28 +100,71 @@ class basic_fiber_demux : private boost::noncopyable {
     return service_.get_io_service();
   }
 
-  StreamSocket& socket() { return impl_->socket; }
+  /// Get the socket of the first live link
+  StreamSocket& socket() {
+    std::unique_lock<std::recursive_mutex> lock(impl_->links_mutex);
+    return impl_->links.front()->socket;
+  }
 
   /// Start demultiplexing the stream socket
   /**
   * This function is used to initiate the demultiplexing on the stream socket
   *
   * @param socket The stream socket on which to demultiplex.
+  * @param close The handler called when the demultiplexer is closed.
+  * @param mtu The maximum payload size of one frame. Both ends must use the
+  * same value (it is negotiated by the transport handshake).
   *
   * @note Once this function has been called, the socket should not be directly
   * read from or written to by the user.
   */
   void fiberize(StreamSocket socket, close_handler_type close = []() {},
-                size_t mtu = 60 * 1024) {
-    if (mtu > 60 * 1024) {
+                size_t mtu = kDefaultMTU) {
+    if (mtu > kMaxMTU) {
       SSF_LOG("demux", warn, "MTU too big, replaced with MAX_VALUE");
-      mtu = 60 * 1024;
+      mtu = kMaxMTU;
     }
 
     impl_ = implementation_deref_type::create(std::move(socket), close, mtu);
     service_.fiberize(impl_);
   }
 
+  /// Add a physical link to the demultiplexer
+  /**
+  * The fibers are spread over the links: all the frames of a fiber go through
+  * the link chosen when it connects, so that they stay ordered. When a link
+  * fails, only its fibers are reset and the demux goes on with the other
+  * links. The demux is closed when its last link fails.
+  *
+  * The remote end must add the other end of the link to its own demux.
+  *
+  * The socket may run on another io_service than the demux: the completions
+  * of its reads and writes are then handed over to the io_service of the
+  * demux, so that the fibers of the link stay on it.
+  *
+  * @param socket The stream socket of the link.
+  * @param ec Set to indicate what error occurred, if any.
+  *
+  * @note This function must be called after fiberize.
+  */
+  void add_link(StreamSocket socket, boost::system::error_code& ec) {
+    service_.add_link(impl_, std::move(socket), ec);
+  }
+
+  /// Get the number of live physical links
+  size_t link_count() { return service_.link_count(impl_); }
+
+  /// Set the handler called when a link fails while other links remain
+  /**
+  * The handler may add a new link to replace the lost one. It is not called
+  * anymore once the demux is closed.
+  *
+  * @note This function must be called after fiberize.
+  */
+  void set_link_lost_handler(close_handler_type handler) {
+    service_.set_link_lost_handler(impl_, std::move(handler));
+  }
+
   /// Bind a fiber acceptor to the given local fiber port.
   /**
   * This function binds a fiber acceptor to the specified local fiber port
@@ -160,6 +208,19 @@ class basic_fiber_demux : private boost::noncopyable {
     service_.async_send_ack(impl_, fib_impl, op);
   }
 
+  /// Asynchronously grant credits to the remote end of a fiber
+  /**
+  * This function notifies the remote fiber that the given number of bytes has
+  * been consumed by the user and can be sent again.
+  *
+  * @param fib_impl The implementation object of the fiber
+  *
+  * @param credit The number of bytes granted
+  */
+  void async_send_credit(fiber_impl_type fib_impl, uint32_t credit) {
+    service_.async_send_credit(impl_, fib_impl, credit);
+  }
+
   /// Start an asynchronous connect.
   /**
   * This function is used to asynchronously connect a
@@ -219,6 +280,21 @@ class basic_fiber_demux : private boost::noncopyable {
                                         handler);
   }
 
+  /// Set the limits of the gathered writes on the demultiplexed socket
+  /**
+  * Frames queued by the fibers are sent in one write on the socket as long as
+  * the batch stays under both limits.
+  *
+  * @param max_bytes The maximum number of bytes of one write.
+  * @param max_frames The maximum number of frames of one write (1 disables
+  * the coalescing of frames).
+  *
+  * @note This function must be called after fiberize.
+  */
+  void set_send_batch_limits(size_t max_bytes, size_t max_frames) {
+    service_.set_send_batch_limits(impl_, max_bytes, max_frames);
+  }
+
   /// Close fiber.
   /**
   * This closes a fiber immediatly. It cancels all pending operations from this
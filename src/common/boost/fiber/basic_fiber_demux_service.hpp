@@ -92,6 +92,9 @@ public:
   /// Type of a pointer to the implementation class of the fiber demux.
   typedef std::shared_ptr<implementation_deref_type> implementation_type;
 
+  /// Type of a pointer to a physical link of a fiber demux.
+  typedef typename implementation_deref_type::p_link link_type;
+
 public:
   /// Construct a basic_fiber_demux_service object
   /**
@@ -119,6 +122,33 @@ public:
   */
   void fiberize(implementation_type impl);
 
+  /// Add a physical link to a demux
+  /**
+  * The fibers are spread over the links of the demux. All the frames of a
+  * fiber go through the same link so that they stay ordered.
+  *
+  * @param impl A pointer to the implementation of a demux.
+  * @param socket The stream socket of the new link.
+  * @param ec The error code object in which any error will be stored.
+  */
+  void add_link(implementation_type impl, StreamSocket socket,
+                boost::system::error_code& ec);
+
+  /// Get the number of live physical links of a demux
+  /**
+  * @param impl A pointer to the implementation of a demux.
+  */
+  size_t link_count(implementation_type impl);
+
+  /// Set the handler called when a link of a demux fails
+  /**
+  * @param impl A pointer to the implementation of a demux.
+  * @param handler The handler called when a link fails while other links
+  *   remain.
+  */
+  void set_link_lost_handler(implementation_type impl,
+                             std::function<void()> handler);
+
   /// Bind a fiber to a fiber id and a demux
   /**
   * @param impl A pointer to the implementation of a demux.
@@ -214,6 +244,18 @@ public:
     async_send_dgr(impl, remote_port, fib_impl, buffers, handler);
   }
 
+  /// Set the limits of the gathered writes on the demultiplexed socket
+  /**
+  * Queued frames are coalesced into one write on the socket as long as the
+  * batch stays under both limits. A limit of one frame disables coalescing.
+  *
+  * @param impl A pointer to the implementation of the demux.
+  * @param max_bytes The maximum number of bytes of one write.
+  * @param max_frames The maximum number of frames of one write.
+  */
+  void set_send_batch_limits(implementation_type impl, size_t max_bytes,
+                             size_t max_frames);
+
   void close_fiber(implementation_type impl, fiber_impl_type fib_impl);
 
   void close(implementation_type impl);
@@ -222,6 +264,9 @@ public:
 
   void async_send_ack(implementation_type impl, fiber_impl_type fib_impl, accept_op* op);
 
+  void async_send_credit(implementation_type impl, fiber_impl_type fib_impl,
+                         uint32_t credit);
+
 private:
   enum
   {
@@ -229,9 +274,10 @@ private:
     kFlagReset = 2,
     kFlagAck = 4,
     kFlagDatagram = 8,
-    kFlagPush = 16
+    kFlagPush = 16,
+    kFlagCredit = 32
   };
-  void async_poll_packets(implementation_type impl);
+  void async_poll_packets(implementation_type impl, link_type p_link);
   template<typename Handler>
   void async_send_rst(implementation_type impl, fiber_id id, const Handler& handler);
   void async_send_syn(implementation_type impl, fiber_id id);
@@ -248,18 +294,27 @@ private:
   void handle_dgr(implementation_type impl, p_fiber_buffer p_fiber_buff);
   void handle_push(implementation_type impl, p_fiber_buffer p_fiber_buff);
   void handle_ack(implementation_type impl, p_fiber_buffer p_fiber_buff);
-  void handle_syn(implementation_type impl, p_fiber_buffer p_fiber_buff);
+  void handle_syn(implementation_type impl, link_type p_link,
+                  p_fiber_buffer p_fiber_buff);
   void handle_rst(implementation_type impl, p_fiber_buffer p_fiber_buff);
+  void handle_credit(implementation_type impl, p_fiber_buffer p_fiber_buff);
+
+  static uint32_t get_window(p_fiber_buffer p_fiber_buff);
+
+  void push_frame(implementation_type impl,
+                  const detail::extended_raw_fiber_buffer& toSend, bool pin);
+  void async_push_packets(implementation_type impl, link_type p_link);
+  void dispatch_buffer(implementation_type impl, link_type p_link,
+                       p_fiber_buffer p_fiber_buff);
 
-  void async_push_packets(implementation_type impl);
-  void dispatch_buffer(implementation_type impl, p_fiber_buffer p_fiber_buff);
+  void close_link(implementation_type impl, link_type p_link);
 
   local_port_type get_available_local_port(implementation_type impl);
 
   template <typename ConstBufferSequence, typename Handler>
   void async_send(implementation_type impl, fiber_id id, flag_type flags,
                   ConstBufferSequence& buffers, Handler handler,
-                  uint8_t priority = 0);
+                  uint8_t weight = 0);
 
   template <typename ConstBufferSequence>
   std::vector<boost::asio::const_buffer> get_partial_buffer_sequence(
@@ -12,10 +12,13 @@
 #pragma once
 #endif  // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <algorithm>
+#include <cstring>
 #include <ctime>
 #include <functional>
 #include <limits>
 #include <mutex>
+#include <set>
 
 #include <boost/asio.hpp>
 #include <boost/asio/steady_timer.hpp>
@@ -23,6 +26,7 @@
 #include <boost/system/error_code.hpp>
 
 #include <ssf/log/log.h>
+#include <ssf/metrics/metrics.h>
 
 #include "common/boost/fiber/detail/basic_fiber_demux_impl.hpp"
 #include "common/boost/fiber/detail/fiber_buffer.hpp"
@@ -42,8 +46,70 @@ void basic_fiber_demux_service<S>::fiberize(implementation_type impl) {
   }
 
   SSF_LOG("demux", trace, "fiberizing");
+  SSF_METRICS_GAUGE_ADD("demux.links", 1);
 
-  async_poll_packets(impl);
+  link_type p_link;
+  {
+    std::unique_lock<std::recursive_mutex> lock(impl->links_mutex);
+    p_link = impl->links.front();
+  }
+  async_poll_packets(impl, p_link);
+}
+
+template <typename S>
+void basic_fiber_demux_service<S>::add_link(implementation_type impl,
+                                            S socket,
+                                            boost::system::error_code& ec) {
+  if (!impl) {
+    SSF_LOG("demux", debug, "add link NOK {}", ::error::broken_pipe);
+    ec.assign(::error::broken_pipe, ::error::get_ssf_category());
+    return;
+  }
+
+  auto p_link = impl->new_link(std::move(socket));
+  p_link->foreign = (&p_link->socket.get_io_service() != &io_service_);
+
+  std::unique_lock<std::recursive_mutex> lock(impl->closing_mutex);
+  if (impl->closing) {
+    boost::system::error_code close_ec;
+    p_link->socket.close(close_ec);
+    ec.assign(::error::broken_pipe, ::error::get_ssf_category());
+    return;
+  }
+
+  size_t link_count = 0;
+  {
+    std::unique_lock<std::recursive_mutex> lock_links(impl->links_mutex);
+    impl->links.push_back(p_link);
+    link_count = impl->links.size();
+  }
+
+  SSF_LOG("demux", debug, "link added ({} links)", link_count);
+  SSF_METRICS_GAUGE_ADD("demux.links", 1);
+
+  ec.assign(::error::success, ::error::get_ssf_category());
+  async_poll_packets(impl, p_link);
+}
+
+template <typename S>
+size_t basic_fiber_demux_service<S>::link_count(implementation_type impl) {
+  if (!impl) {
+    return 0;
+  }
+
+  std::unique_lock<std::recursive_mutex> lock(impl->links_mutex);
+  return impl->links.size();
+}
+
+template <typename S>
+void basic_fiber_demux_service<S>::set_link_lost_handler(
+    implementation_type impl, std::function<void()> handler) {
+  if (!impl) {
+    return;
+  }
+
+  std::unique_lock<std::recursive_mutex> lock(impl->links_mutex);
+  impl->link_lost_handler = std::move(handler);
 }
 
 template <typename S>
@@ -71,9 +137,9 @@ void basic_fiber_demux_service<S>::bind(implementation_type impl,
     std::unique_lock<std::recursive_mutex> lock2(impl->used_ports_mutex);
     SSF_LOG("demux", trace, "try to bind fiber to {}:{}", id.local_port(),
             id.remote_port());
-    if (receiving_id.remote_port() && !impl->bound.count(receiving_id)) {
+    if (receiving_id.remote_port() &&
+        impl->bound.insert(receiving_id, fib_impl)) {
       SSF_LOG("demux", trace, "bind OK");
-      impl->bound[receiving_id] = fib_impl;
       impl->used_ports.insert(id.local_port());
 
       {
@@ -98,7 +164,6 @@ bool basic_fiber_demux_service<S>::is_bound(implementation_type impl,
     return false;
   }
 
-  std::unique_lock<std::recursive_mutex> lock(impl->bound_mutex);
   return !!impl->bound.count(id.returning_id());
 }
 
@@ -116,6 +181,9 @@ void basic_fiber_demux_service<S>::unbind(implementation_type impl,
 
   impl->bound.erase(id.returning_id());
   impl->used_ports.erase(id.local_port());
+
+  std::unique_lock<std::recursive_mutex> lock_links(impl->links_mutex);
+  impl->unpin_flow(id.packed());
 }
 
 template <typename S>
@@ -173,60 +241,150 @@ void basic_fiber_demux_service<S>::stop_listening(implementation_type impl,
 }
 
 template <typename S>
-void basic_fiber_demux_service<S>::async_poll_packets(
-    implementation_type impl) {
-  auto p_fiber_buff =
-      std::make_shared<boost::asio::fiber::detail::fiber_buffer>();
-
+void basic_fiber_demux_service<S>::async_poll_packets(implementation_type impl,
+                                                      link_type p_link) {
   /////////////////// BEGIN HANDLER ///////////////////////////////
-  auto dispatch_handler = [this, p_fiber_buff, impl](
-      const boost::system::error_code& ec, std::size_t bytes_transferred) {
+  auto dispatch_handler = [this, impl, p_link](
+      const boost::system::error_code& ec, std::size_t bytes_transferred,
+      p_fiber_buffer p_fiber_buff) {
     std::unique_lock<std::recursive_mutex> lock(impl->closing_mutex);
     if (impl->closing) {
       return;
     }
 
     if (!ec) {
-      this->dispatch_buffer(impl, p_fiber_buff);
-      this->async_poll_packets(impl);
+      this->dispatch_buffer(impl, p_link, std::move(p_fiber_buff));
+      this->async_poll_packets(impl, p_link);
     } else {
       SSF_LOG("demux", debug,
               "error in dispatch handler {}: {} | {} bytes transferred",
               ec.value(), ec.message(), bytes_transferred);
-      this->close(impl);
+      // close_link takes the send lock (which is taken before the closing
+      // lock)
+      lock.unlock();
+      this->close_link(impl, p_link);
     }
   };
   //////////////////// END HANDLER ///////////////////////////////
 
   std::unique_lock<std::recursive_mutex> lock(impl->closing_mutex);
-  if (!impl->closing) {
-    async_read_fiber_buffer(impl->socket, *p_fiber_buff, dispatch_handler);
+  if (impl->closing) {
+    return;
+  }
+
+  if (p_link->foreign) {
+    auto foreign_handler = io_service_.wrap(dispatch_handler);
+    async_read_fiber_buffer(p_link->socket, p_link->read_header,
+                            impl->buffer_pool, impl->mtu, foreign_handler);
+  } else {
+    async_read_fiber_buffer(p_link->socket, p_link->read_header,
+                            impl->buffer_pool, impl->mtu, dispatch_handler);
   }
 }
 
 template <typename S>
-void basic_fiber_demux_service<S>::async_push_packets(
-    implementation_type impl) {
+void basic_fiber_demux_service<S>::set_send_batch_limits(
+    implementation_type impl, size_t max_bytes, size_t max_frames) {
+  if (!impl) {
+    SSF_LOG("demux", debug, "set send batch limits NOK {}",
+            ::error::broken_pipe);
+    return;
+  }
+
   std::unique_lock<std::recursive_mutex> lock(impl->send_mutex);
-  const auto& to_send_priority = impl->toSendPriority.front();
+  impl->max_send_batch_bytes = max_bytes;
+  impl->max_send_batch_frames = max_frames;
+}
 
-  auto handler = [this, impl, to_send_priority](
+template <typename S>
+void basic_fiber_demux_service<S>::async_push_packets(implementation_type impl,
+                                                      link_type p_link) {
+  std::unique_lock<std::recursive_mutex> lock(impl->send_mutex);
+  if (p_link->toSendPriority.empty()) {
+    p_link->sending = false;
+    return;
+  }
+
+  // Gather queued frames in one write until the batch budget is reached
+  // (the first frame is always sent, whatever its size)
+  auto p_batch = std::make_shared<std::vector<detail::extended_raw_fiber_buffer>>();
+  size_t batch_size = 0;
+
+  while (!p_link->toSendPriority.empty()) {
+    const auto& to_send = p_link->toSendPriority.front();
+    auto frame_size = boost::asio::buffer_size(to_send.buffer);
+
+    if (!p_batch->empty() &&
+        ((batch_size + frame_size > impl->max_send_batch_bytes) ||
+         (p_batch->size() >= impl->max_send_batch_frames))) {
+      break;
+    }
+
+    batch_size += frame_size;
+    p_batch->push_back(to_send);
+    p_link->toSendPriority.pop();
+  }
+
+  // Copy the frames (header fields and payloads) in one buffer: stream layers
+  // like TLS write the first buffer of a sequence per call, i.e. one record
+  // and one syscall per buffer
+  auto& send_buffer = p_link->send_buffer;
+  send_buffer.resize(batch_size);
+  size_t copied = 0;
+  for (const auto& to_send : *p_batch) {
+    copied += boost::asio::buffer_copy(
+        boost::asio::buffer(send_buffer.data() + copied, batch_size - copied),
+        to_send.buffer);
+  }
+  auto buffers = boost::asio::buffer(send_buffer);
+
+  SSF_LOG("demux", trace, "push {} frame(s) | {} bytes", p_batch->size(),
+          batch_size);
+  SSF_METRICS_COUNT("demux.frames_sent", p_batch->size());
+  SSF_METRICS_COUNT("demux.bytes_sent", batch_size);
+  SSF_METRICS_RECORD("demux.send_batch_frames", p_batch->size());
+
+  auto handler = [this, impl, p_link, p_batch](
       const boost::system::error_code& ec, size_t transferred_bytes) {
+    bool reroute = false;
+    if (ec) {
+      // The link is broken: its resets go through a live link, if any
+      this->close_link(impl, p_link);
+      std::unique_lock<std::recursive_mutex> lock_closing(impl->closing_mutex);
+      std::unique_lock<std::recursive_mutex> lock_links(impl->links_mutex);
+      reroute = !impl->closing && !p_link->alive;
+    }
+
+    // Complete every frame of the batch
+    for (const auto& to_send : *p_batch) {
+      if (reroute && to_send.reset) {
+        this->push_frame(impl, to_send, false);
+        continue;
+      }
+      auto frame_size = boost::asio::buffer_size(to_send.buffer);
+      io_service_.post(std::bind(to_send.handler, ec, ec ? 0 : frame_size));
+    }
+
     std::unique_lock<std::recursive_mutex> lock(impl->send_mutex);
-    impl->toSendPriority.pop();
-    impl->socket.get_io_service().post(
-        std::bind(to_send_priority.handler, ec, transferred_bytes));
-    if (!impl->toSendPriority.empty()) {
-      impl->socket.get_io_service().post(std::bind(
-          &basic_fiber_demux_service<S>::async_push_packets, this, impl));
+    if (!p_link->toSendPriority.empty()) {
+      io_service_.post(
+          std::bind(&basic_fiber_demux_service<S>::async_push_packets, this,
+                    impl, p_link));
+    } else {
+      p_link->sending = false;
     }
   };
 
   std::unique_lock<std::recursive_mutex> lock2(impl->closing_mutex);
   if (!impl->closing) {
-    boost::asio::async_write(impl->socket, to_send_priority.buffer, handler);
+    if (p_link->foreign) {
+      boost::asio::async_write(p_link->socket, buffers,
+                               io_service_.wrap(handler));
+    } else {
+      boost::asio::async_write(p_link->socket, buffers, handler);
+    }
   } else {
-    impl->socket.get_io_service().post(std::bind(
+    io_service_.post(std::bind(
         handler, boost::system::error_code(::error::connection_aborted,
                                            ::error::get_ssf_category()),
         0));
@@ -235,7 +393,7 @@ void basic_fiber_demux_service<S>::async_push_packets(
 
 template <typename S>
 void basic_fiber_demux_service<S>::dispatch_buffer(
-    implementation_type impl, p_fiber_buffer p_fiber_buff) {
+    implementation_type impl, link_type p_link, p_fiber_buffer p_fiber_buff) {
   const auto& header = p_fiber_buff->header();
 
   const auto flags = header.flags();
@@ -243,13 +401,15 @@ void basic_fiber_demux_service<S>::dispatch_buffer(
   SSF_LOG("demux", trace, "dispatch {} {} {} {} {}", uint32_t(header.version()),
           header.id().remote_port(), header.id().local_port(), uint32_t(flags),
           header.data_size());
+  SSF_METRICS_COUNT("demux.frames_received", 1);
+  SSF_METRICS_COUNT("demux.bytes_received", header.data_size());
 
   switch (flags) {
     case kFlagPush:
       handle_push(impl, p_fiber_buff);
       break;
     case kFlagSyn:
-      handle_syn(impl, p_fiber_buff);
+      handle_syn(impl, p_link, p_fiber_buff);
       break;
     case kFlagReset:
       handle_rst(impl, p_fiber_buff);
@@ -260,6 +420,9 @@ void basic_fiber_demux_service<S>::dispatch_buffer(
     case kFlagDatagram:
       handle_dgr(impl, p_fiber_buff);
       break;
+    case kFlagCredit:
+      handle_credit(impl, p_fiber_buff);
+      break;
     default:
       break;
   }
@@ -271,21 +434,17 @@ void basic_fiber_demux_service<S>::handle_dgr(implementation_type impl,
   SSF_LOG("demux", trace, "handle dgr");
   const auto& full_id = p_fiber_buff->header().id();
   const auto& half_id = fiber_id(p_fiber_buff->header().id().remote_port(), 0);
-  std::unique_lock<std::recursive_mutex> lock(impl->bound_mutex);
 
-  if (impl->bound.count(full_id) != 0) {
-    if (impl->bound[full_id]->accepts_dgr) {
-      auto on_new_packet = impl->bound[full_id]->access_receive_dgr_handler();
-      on_new_packet(p_fiber_buff->take_data(),
-                    p_fiber_buff->header().id().local_port(),
-                    p_fiber_buff->data_size());
-    }
-  } else if (impl->bound.count(half_id) != 0) {
-    if (impl->bound[half_id]->accepts_dgr) {
-      auto on_new_packet = impl->bound[half_id]->access_receive_dgr_handler();
-      on_new_packet(p_fiber_buff->take_data(),
-                    p_fiber_buff->header().id().local_port(),
-                    p_fiber_buff->data_size());
+  auto p_fib_impl = impl->bound.find(full_id);
+  if (!p_fib_impl) {
+    p_fib_impl = impl->bound.find(half_id);
+  }
+
+  if (p_fib_impl) {
+    if (p_fib_impl->accepts_dgr) {
+      auto on_new_packet = p_fib_impl->access_receive_dgr_handler();
+      auto remote_port = p_fiber_buff->header().id().local_port();
+      on_new_packet(std::move(p_fiber_buff), remote_port);
     }
   }
 }
@@ -295,11 +454,11 @@ void basic_fiber_demux_service<S>::handle_push(implementation_type impl,
                                                p_fiber_buffer p_fiber_buff) {
   SSF_LOG("demux", trace, "handle push");
   const auto& header = p_fiber_buff->header();
-  std::unique_lock<std::recursive_mutex> lock(impl->bound_mutex);
 
-  if (impl->bound.count(header.id()) != 0) {
-    auto on_new_packet = impl->bound[header.id()]->access_receive_handler();
-    on_new_packet(p_fiber_buff->take_data(), p_fiber_buff->data_size());
+  auto p_fib_impl = impl->bound.find(header.id());
+  if (p_fib_impl) {
+    auto on_new_packet = p_fib_impl->access_receive_handler();
+    on_new_packet(p_fiber_buff);
   } else {
     async_send_rst(impl, header.id().returning_id(), []() {});
   }
@@ -309,16 +468,23 @@ template <typename S>
 void basic_fiber_demux_service<S>::handle_ack(implementation_type impl,
                                               p_fiber_buffer p_fiber_buff) {
   const auto& header = p_fiber_buff->header();
-  std::unique_lock<std::recursive_mutex> lock_bound(impl->bound_mutex);
   SSF_LOG("demux", trace, "handle ack");
 
-  if (impl->bound.count(header.id())) {
-    auto p_fib_impl = impl->bound[header.id()];
-    p_fib_impl->toggle_out();
+  auto p_fib_impl = impl->bound.find(header.id());
+  if (p_fib_impl) {
+    if (!p_fib_impl->is_credit_enabled()) {
+      p_fib_impl->toggle_out();
+    }
 
     std::unique_lock<std::recursive_mutex> lock_state(p_fib_impl->state_mutex);
 
     if (p_fib_impl->connecting) {
+      // The remote fiber announces its receive window in the connection ack
+      // if it supports credit-based flow control
+      auto peer_window = get_window(p_fiber_buff);
+      if (peer_window) {
+        p_fib_impl->init_credit(peer_window);
+      }
       p_fib_impl->set_connected();
       auto on_ack = p_fib_impl->access_connect_handler();
       on_ack(boost::system::error_code(::error::success,
@@ -331,6 +497,7 @@ void basic_fiber_demux_service<S>::handle_ack(implementation_type impl,
 
 template <typename S>
 void basic_fiber_demux_service<S>::handle_syn(implementation_type impl,
+                                              link_type p_link,
                                               p_fiber_buffer p_fiber_buff) {
   SSF_LOG("demux", trace, "handle syn");
   const auto& header = p_fiber_buff->header();
@@ -338,9 +505,16 @@ void basic_fiber_demux_service<S>::handle_syn(implementation_type impl,
   std::unique_lock<std::recursive_mutex> lock_bound(impl->bound_mutex);
 
   if (impl->listening.count(header.id().remote_port())) {
-    auto on_new_fiber = impl->bound[fiber_id(header.id().remote_port())]
+    {
+      // The accepted fiber answers on the link of the connecting fiber: both
+      // directions of a fiber share one link
+      std::unique_lock<std::recursive_mutex> lock_links(impl->links_mutex);
+      impl->pin_flow(header.id().returning_id().packed(), p_link);
+    }
+    auto on_new_fiber = impl->bound.find(fiber_id(header.id().remote_port()))
                             ->access_accept_handler();
-    io_service_.post(std::bind(on_new_fiber, header.id().local_port()));
+    io_service_.post(std::bind(on_new_fiber, header.id().local_port(),
+                               get_window(p_fiber_buff)));
   } else {
     async_send_rst(impl, header.id().returning_id(), []() {});
   }
@@ -353,8 +527,8 @@ void basic_fiber_demux_service<S>::handle_rst(implementation_type impl,
   const auto& header = p_fiber_buff->header();
   auto returning_id = header.id().returning_id();
   std::unique_lock<std::recursive_mutex> lock_bound(impl->bound_mutex);
-  if ((impl->bound).count(header.id())) {
-    auto p_fib_impl = impl->bound[header.id()];
+  auto p_fib_impl = impl->bound.find(header.id());
+  if (p_fib_impl) {
     auto on_close = p_fib_impl->access_close_handler();
 
     std::unique_lock<std::recursive_mutex> lock_state(p_fib_impl->state_mutex);
@@ -381,18 +555,49 @@ void basic_fiber_demux_service<S>::handle_rst(implementation_type impl,
   }
 }
 
+template <typename S>
+void basic_fiber_demux_service<S>::handle_credit(implementation_type impl,
+                                                 p_fiber_buffer p_fiber_buff) {
+  SSF_LOG("demux", trace, "handle credit");
+  const auto& header = p_fiber_buff->header();
+  auto credit = get_window(p_fiber_buff);
+  auto p_fib_impl = impl->bound.find(header.id());
+  if (!p_fib_impl) {
+    return;
+  }
+
+  p_fib_impl->add_send_credit(credit);
+}
+
+template <typename S>
+uint32_t basic_fiber_demux_service<S>::get_window(p_fiber_buffer p_fiber_buff) {
+  uint32_t window = 0;
+  if (p_fiber_buff->data_size() < sizeof(window)) {
+    return 0;
+  }
+
+  std::memcpy(&window, p_fiber_buff->cdata(), sizeof(window));
+  return window;
+}
+
 template <typename S>
 template <typename ConstBufferSequence, typename Handler>
 void basic_fiber_demux_service<S>::async_send_push(implementation_type impl,
                                                    fiber_id id,
                                                    ConstBufferSequence& buffer,
                                                    Handler& handler) {
-  std::unique_lock<std::recursive_mutex> lock1(impl->bound_mutex);
+  auto p_fiber_impl = impl->bound.find(id.returning_id());
+  if (!p_fiber_impl) {
+    handler(boost::system::error_code(::error::protocol_error,
+                                      ::error::get_ssf_category()),
+            0);
+    return;
+  }
 
-  if (impl->bound.count(id.returning_id())) {
-    auto p_fiber_impl = impl->bound[id.returning_id()];
+  if (!p_fiber_impl->is_credit_enabled()) {
+    // Legacy flow control: the remote fiber toggles ready_out with acks
     if (p_fiber_impl->ready_out) {
-      async_send(impl, id, kFlagPush, buffer, handler, p_fiber_impl->priority);
+      async_send(impl, id, kFlagPush, buffer, handler, p_fiber_impl->weight);
     } else {
       auto p_timer = std::make_shared<boost::asio::steady_timer>(io_service_);
       p_timer->expires_from_now(std::chrono::milliseconds(10));
@@ -404,11 +609,36 @@ void basic_fiber_demux_service<S>::async_send_push(implementation_type impl,
 
       p_timer->async_wait(lambda);
     }
-  } else {
-    handler(boost::system::error_code(::error::protocol_error,
-                                      ::error::get_ssf_category()),
-            0);
+    return;
+  }
+
+  std::unique_lock<std::recursive_mutex> lock_credit(
+      p_fiber_impl->credit_mutex);
+  if (!p_fiber_impl->send_credit) {
+    // Park the send until the remote fiber grants credits
+    SSF_LOG("demux", trace, "send parked {}:{} (no credit)", id.local_port(),
+            id.remote_port());
+    auto pending_send = [this, impl, id, buffer, handler](
+        const boost::system::error_code& ec) mutable {
+      if (ec) {
+        handler(ec, 0);
+        return;
+      }
+      this->async_send_push(impl, id, buffer, handler);
+    };
+    p_fiber_impl->pending_sends.push(std::move(pending_send));
+    return;
   }
+
+  auto send_size = std::min<uint64_t>(
+      std::min<uint64_t>(boost::asio::buffer_size(buffer), impl->mtu),
+      p_fiber_impl->send_credit);
+  p_fiber_impl->send_credit -= send_size;
+
+  auto credit_buffer = get_partial_buffer_sequence<ConstBufferSequence>(
+      buffer, static_cast<size_t>(send_size));
+  async_send(impl, id, kFlagPush, credit_buffer, handler,
+             p_fiber_impl->weight);
 }
 
 template <typename S>
@@ -418,33 +648,28 @@ void basic_fiber_demux_service<S>::async_send_dgr(implementation_type impl,
                                                   fiber_impl_type fib_impl,
                                                   ConstBufferSequence& buffer,
                                                   Handler& handler) {
-  std::unique_lock<std::recursive_mutex> lock1(impl->bound_mutex);
+  {
+    std::unique_lock<std::recursive_mutex> lock1(impl->bound_mutex);
 
-  if (fib_impl->id.local_port() == 0) {
-    fib_impl->id.set_local_port(get_available_local_port(impl));
-    boost::system::error_code ec;
-    bind(impl, fib_impl->id.local_port(), fib_impl, ec);
-    if (ec) {
-      SSF_LOG("demux", debug, "error dgr {} {}", ec.message(), ec.value());
-      io_service_.post(std::bind(handler, ec, 0));
-      return;
+    if (fib_impl->id.local_port() == 0) {
+      fib_impl->id.set_local_port(get_available_local_port(impl));
+      boost::system::error_code ec;
+      bind(impl, fib_impl->id.local_port(), fib_impl, ec);
+      if (ec) {
+        SSF_LOG("demux", debug, "error dgr {} {}", ec.message(), ec.value());
+        io_service_.post(std::bind(handler, ec, 0));
+        return;
+      }
     }
   }
 
   if (impl->bound.count(fib_impl->id.returning_id())) {
     if (fib_impl->ready_out) {
       async_send(impl, fiber_id(remote_port, fib_impl->id.local_port()),
-                 kFlagDatagram, buffer, handler, fib_impl->priority);
+                 kFlagDatagram, buffer, handler, fib_impl->weight);
     } else {
-      auto p_timer = std::make_shared<boost::asio::steady_timer>(io_service_);
-      p_timer->expires_from_now(std::chrono::milliseconds(10));
-
-      auto lambda = [handler,
-                     p_timer](const boost::system::error_code&) mutable {
-        handler(boost::system::error_code(), 0);
-      };
-
-      p_timer->async_wait(lambda);
+      // The remote end is not ready: drop the datagram
+      io_service_.post(std::bind(handler, boost::system::error_code(), 0));
     }
   } else {
     io_service_.post(std::bind(
@@ -478,9 +703,16 @@ void basic_fiber_demux_service<S>::async_send_ack(implementation_type impl,
         op->complete(ec, 0);
       };
 
-      boost::asio::const_buffer pre_buffer;
-      boost::asio::const_buffers_1 buffer(pre_buffer);
-      async_send(impl, fib_impl->id, kFlagAck, buffer, handler, 0);
+      // Announce the receive window of the accepted fiber
+      auto p_window = std::make_shared<uint32_t>(fib_impl->receive_window);
+      auto window_handler = [p_window, handler](
+          const boost::system::error_code& ec, std::size_t length) {
+        handler(ec, length);
+      };
+
+      boost::asio::const_buffers_1 buffer(
+          boost::asio::buffer(p_window.get(), sizeof(*p_window)));
+      async_send(impl, fib_impl->id, kFlagAck, buffer, window_handler, 0);
     }
   } else {
     boost::asio::const_buffer pre_buffer;
@@ -491,34 +723,53 @@ void basic_fiber_demux_service<S>::async_send_ack(implementation_type impl,
   }
 }
 
+template <typename S>
+void basic_fiber_demux_service<S>::async_send_credit(implementation_type impl,
+                                                     fiber_impl_type fib_impl,
+                                                     uint32_t credit) {
+  SSF_LOG("demux", trace, "async send credit {}", credit);
+  auto p_credit = std::make_shared<uint32_t>(credit);
+  auto handler = [p_credit](const boost::system::error_code& ec, std::size_t) {
+    if (ec) {
+      SSF_LOG("demux", debug, "error send credit {}", ec.message());
+    }
+  };
+
+  boost::asio::const_buffers_1 buffer(
+      boost::asio::buffer(p_credit.get(), sizeof(*p_credit)));
+  async_send(impl, fib_impl->id, kFlagCredit, buffer, handler, 0);
+}
+
 template <typename S>
 void basic_fiber_demux_service<S>::async_send_syn(implementation_type impl,
                                                   fiber_id id) {
   std::unique_lock<std::recursive_mutex> lock_bound(impl->bound_mutex);
   // Bind reverse the id in bound map so reverse it...
-  if ((impl->bound).count(id.returning_id())) {
-    auto p_fib_impl = impl->bound[id.returning_id()];
+  auto p_fib_impl = impl->bound.find(id.returning_id());
+  if (p_fib_impl) {
     SSF_LOG("demux", trace, "async send syn");
 
     std::unique_lock<std::recursive_mutex> lock_state(p_fib_impl->state_mutex);
 
     if (!p_fib_impl->connecting) {
       p_fib_impl->set_connecting();
-      auto handler = [impl, p_fib_impl](const boost::system::error_code& ec,
-                                        std::size_t) {
+      // Announce the receive window of the connecting fiber
+      auto p_window = std::make_shared<uint32_t>(p_fib_impl->receive_window);
+      auto handler = [this, impl, p_fib_impl, p_window](
+          const boost::system::error_code& ec, std::size_t) {
         if (ec) {
           SSF_LOG("demux", debug, "syn error {}", ec.message());
           auto connection_failed = [p_fib_impl, ec]() {
             p_fib_impl->access_connect_handler()(ec);
           };
-          impl->socket.get_io_service().post(connection_failed);
+          this->io_service_.post(connection_failed);
         } else {
           SSF_LOG("demux", trace, "syn sent");
         }
       };
 
-      boost::asio::const_buffer pre_buffer;
-      boost::asio::const_buffers_1 buffer(pre_buffer);
+      boost::asio::const_buffers_1 buffer(
+          boost::asio::buffer(p_window.get(), sizeof(*p_window)));
       async_send(impl, id, kFlagSyn, buffer, handler, 0);
     }
   }
@@ -581,7 +832,7 @@ void basic_fiber_demux_service<S>::async_connect(
 
   if (ec) {
     auto connection_failed = [=]() { fib_impl->access_connect_handler()(ec); };
-    impl->socket.get_io_service().post(connection_failed);
+    io_service_.post(connection_failed);
   } else {
     async_send_syn(impl, fib_impl->id);
   }
@@ -592,7 +843,7 @@ template <typename ConstBufferSequence, typename Handler>
 void basic_fiber_demux_service<S>::async_send(
     implementation_type impl, fiber_id id,
     boost::asio::fiber::detail::fiber_header::flags_type flags,
-    ConstBufferSequence& buffers, Handler handler, uint8_t priority) {
+    ConstBufferSequence& buffers, Handler handler, uint8_t weight) {
   auto buffers_size = boost::asio::buffer_size(buffers);
 
   if (buffers_size > impl->mtu) {
@@ -609,29 +860,30 @@ void basic_fiber_demux_service<S>::async_send(
   auto new_buffers =
       get_partial_buffer_sequence<ConstBufferSequence>(buffers, buffers_size);
 
-  fiber_header header(id, flags, (uint16_t)buffers_size);
+  fiber_header header(id, flags,
+                      static_cast<fiber_header::data_size_type>(buffers_size));
 
-  auto p_fiber_buffer = std::make_shared<fiber_buffer>();
+  // Only the header part is used to send
+  auto p_fiber_buffer = std::make_shared<fiber_buffer>(0);
   p_fiber_buffer->set_header(header);
   auto raw_buffer_to_send = p_fiber_buffer->const_buffer(new_buffers);
 
   auto do_user_handler = [p_fiber_buffer, handler](
       const boost::system::error_code& ec, size_t transferred_bytes) mutable {
-    handler(ec, transferred_bytes - fiber_header::pod_size());
+    handler(ec, (transferred_bytes > fiber_header::pod_size())
+                    ? transferred_bytes - fiber_header::pod_size()
+                    : 0);
   };
 
-  detail::extended_raw_fiber_buffer toSend(raw_buffer_to_send, do_user_handler,
-                                           priority);
-
-  auto do_push_packets = [this, toSend, impl]() {
-    std::unique_lock<std::recursive_mutex> lock(impl->send_mutex);
-    impl->toSendPriority.push(toSend);
+  // A connecting fiber is pinned to the least loaded link
+  bool pin = (flags == kFlagSyn);
+  bool reset = (flags == kFlagReset);
 
-    if (impl->toSendPriority.size() > 1) {
-      return;
-    }
+  detail::extended_raw_fiber_buffer toSend(raw_buffer_to_send, do_user_handler,
+                                           id.packed(), weight, reset);
 
-    this->async_push_packets(impl);
+  auto do_push_packets = [this, toSend, impl, pin]() {
+    this->push_frame(impl, toSend, pin);
   };
 
   auto& header_b = p_fiber_buffer->header();
@@ -642,7 +894,40 @@ void basic_fiber_demux_service<S>::async_send(
           header_b.id().remote_port(), header_b.id().local_port(),
           static_cast<uint32_t>(flags_b), header_b.data_size());
 
-  impl->socket.get_io_service().post(do_push_packets);
+  io_service_.post(do_push_packets);
+}
+
+template <typename S>
+void basic_fiber_demux_service<S>::push_frame(
+    implementation_type impl, const detail::extended_raw_fiber_buffer& toSend,
+    bool pin) {
+  std::unique_lock<std::recursive_mutex> lock(impl->send_mutex);
+  link_type p_link;
+  bool lost = false;
+  {
+    std::unique_lock<std::recursive_mutex> lock_links(impl->links_mutex);
+    p_link = pin ? impl->pin_flow(toSend.flow) : impl->get_link(toSend.flow);
+    lost = !toSend.reset && impl->lost_flows.count(toSend.flow);
+  }
+
+  if (lost) {
+    // Frames of the lost link may be missing: the fiber cannot go on
+    io_service_.post(std::bind(
+        toSend.handler, boost::system::error_code(::error::connection_aborted,
+                                                  ::error::get_ssf_category()),
+        0));
+    return;
+  }
+
+  p_link->toSendPriority.push(toSend);
+  SSF_METRICS_RECORD("demux.send_queue_depth", p_link->toSendPriority.size());
+
+  if (p_link->sending) {
+    return;
+  }
+
+  p_link->sending = true;
+  this->async_push_packets(impl, p_link);
 }
 
 template <typename S>
@@ -680,7 +965,7 @@ void basic_fiber_demux_service<S>::close_fiber(implementation_type impl,
     if (!fib_impl->closed) {
       stop_listening(impl, fib_impl->id.local_port());
       unbind(impl, fib_impl->id);
-      impl->socket.get_io_service().post(on_close);
+      io_service_.post(on_close);
     }
   } else {
     // fiber
@@ -695,14 +980,85 @@ void basic_fiber_demux_service<S>::close_fiber(implementation_type impl,
 
 template <typename S>
 void basic_fiber_demux_service<S>::close_all_fibers(implementation_type impl) {
-  std::map<fiber_id, fiber_impl_type> fibers;
+  auto fibers = impl->bound.values();
+
+  for (auto& fiber : fibers) {
+    close_fiber(impl, fiber);
+  }
+}
+
+template <typename S>
+void basic_fiber_demux_service<S>::close_link(implementation_type impl,
+                                              link_type p_link) {
+  std::set<uint64_t> lost_flows;
   {
-    std::unique_lock<std::recursive_mutex> lock1(impl->bound_mutex);
-    fibers = impl->bound;
+    std::unique_lock<std::recursive_mutex> lock(impl->links_mutex);
+    auto link_it = std::find(impl->links.begin(), impl->links.end(), p_link);
+    if (link_it == impl->links.end()) {
+      return;
+    }
+
+    if (impl->links.size() == 1) {
+      // Last link: the demux is closed
+      lock.unlock();
+      close(impl);
+      return;
+    }
+
+    // The flows of the lost link are pinned to the live links before their
+    // resets are sent: the lost link is not referenced anymore
+    p_link->alive = false;
+    impl->links.erase(link_it);
+    for (const auto& flow_link : impl->flow_links) {
+      if (flow_link.second == p_link) {
+        lost_flows.insert(flow_link.first);
+      }
+    }
+    for (auto flow : lost_flows) {
+      impl->repin_flow(flow);
+    }
+    io_service_.post(impl->link_lost_handler);
   }
 
+  SSF_LOG("demux", debug, "link lost ({} fiber(s) reset)", lost_flows.size());
+  SSF_METRICS_COUNT("demux.link_failures", 1);
+  SSF_METRICS_GAUGE_ADD("demux.links", -1);
+
+  boost::system::error_code close_ec;
+  p_link->socket.close(close_ec);
+
+  // The frames waiting for the lost link are dropped, except the resets which
+  // go through the live links
+  std::vector<detail::extended_raw_fiber_buffer> resets;
+  {
+    std::unique_lock<std::recursive_mutex> lock(impl->send_mutex);
+    while (!p_link->toSendPriority.empty()) {
+      auto to_send = p_link->toSendPriority.front();
+      p_link->toSendPriority.pop();
+      if (to_send.reset) {
+        resets.push_back(to_send);
+        continue;
+      }
+      io_service_.post(std::bind(
+          to_send.handler, boost::system::error_code(
+                               ::error::connection_aborted,
+                               ::error::get_ssf_category()),
+          0));
+    }
+  }
+
+  for (const auto& reset : resets) {
+    push_frame(impl, reset, false);
+  }
+
+  // The fibers of the lost link may have lost frames: they are reset. The
+  // other fibers are untouched and the new ones are spread over the live
+  // links.
+  auto fibers = impl->bound.values();
   for (auto& fiber : fibers) {
-    close_fiber(impl, fiber.second);
+    if (lost_flows.count(fiber->id.packed())) {
+      close_fiber(impl, fiber);
+    }
   }
 }
 
@@ -718,10 +1074,16 @@ void basic_fiber_demux_service<S>::close(implementation_type impl) {
         // reset close handler (circular dependency)
         impl->close_handler = []() {};
       };
-      impl->socket.get_io_service().post(close_handler);
-      // not enough: have to close socket...
-      boost::system::error_code ec;
-      impl->socket.close(ec);
+      io_service_.post(close_handler);
+      // not enough: have to close the sockets...
+      std::unique_lock<std::recursive_mutex> lock_links(impl->links_mutex);
+      impl->link_lost_handler = []() {};
+      SSF_METRICS_GAUGE_ADD("demux.links",
+                            -static_cast<int64_t>(impl->links.size()));
+      for (auto& p_link : impl->links) {
+        boost::system::error_code ec;
+        p_link->socket.close(ec);
+      }
     }
   }
 }
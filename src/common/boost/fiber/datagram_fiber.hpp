@@ -21,6 +21,7 @@
 #include "common/boost/fiber/basic_endpoint.hpp"
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 #include "common/boost/fiber/datagram_fiber_service.hpp"
+#include "common/boost/fiber/detail/fiber_weight.hpp"
 
 namespace boost {
 namespace asio {
@@ -71,6 +72,9 @@ public:
   typedef boost::asio::basic_datagram_socket<datagram_fiber,
     boost::asio::fiber::datagram_fiber_service<datagram_fiber<Socket>>> socket;
 
+  /// Socket option for the weight of a datagram fiber on its demultiplexer.
+  typedef boost::asio::fiber::detail::fiber_weight weight;
+
   /// Compare two protocols for equality.
   friend bool operator==(const datagram_fiber& p1, const datagram_fiber& p2)
   {
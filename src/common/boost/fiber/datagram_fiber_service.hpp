@@ -25,6 +25,7 @@
 #include "common/boost/fiber/detail/io_fiber_dgr_read_op.hpp"
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 #include "common/boost/fiber/detail/fiber_id.hpp"
+#include "common/boost/fiber/detail/fiber_weight.hpp"
 #include "common/boost/fiber/basic_endpoint.hpp"
 #include "common/boost/fiber/detail/basic_fiber_impl.hpp"
 
@@ -146,6 +147,26 @@ public:
     return impl;
   }
 
+  /// Set the weight of the fiber on its demultiplexer.
+  boost::system::error_code set_option(implementation_type& impl,
+                                       const detail::fiber_weight& option,
+                                       boost::system::error_code& ec)
+  {
+    impl->weight = option.value();
+    ec = boost::system::error_code();
+    return ec;
+  }
+
+  /// Get the weight of the fiber on its demultiplexer.
+  boost::system::error_code get_option(const implementation_type& impl,
+                                       detail::fiber_weight& option,
+                                       boost::system::error_code& ec) const
+  {
+    option = detail::fiber_weight(impl->weight);
+    ec = boost::system::error_code();
+    return ec;
+  }
+
   /// Cancel all asynchronous operations associated with the datagram fiber.
   boost::system::error_code cancel(implementation_type& impl,
                                    boost::system::error_code& ec)
@@ -12,13 +12,20 @@
 #pragma once
 #endif  // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <cstdint>
+
+#include <algorithm>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <set>
+#include <vector>
 
+#include "common/boost/fiber/detail/fiber_buffer_pool.hpp"
 #include "common/boost/fiber/detail/fiber_id.hpp"
+#include "common/boost/fiber/detail/fiber_send_scheduler.hpp"
+#include "common/boost/fiber/detail/fiber_table.hpp"
 
 namespace boost {
 namespace asio {
@@ -31,16 +38,18 @@ class basic_fiber_impl;
 /// Class used to handle QoS in fiber sendings
 template <typename Buffer, typename Handler>
 struct extended_buffer {
-  extended_buffer(const Buffer& b, const Handler& h, uint8_t p)
-      : buffer(b), handler(h), priority(p) {}
-
-  bool operator<(const extended_buffer& rhs) const {
-    return priority < rhs.priority;
-  }
+  extended_buffer(const Buffer& b, const Handler& h, uint64_t f, uint8_t w,
+                  bool r = false)
+      : buffer(b), handler(h), flow(f), weight(w), reset(r) {}
 
   Buffer buffer;
   Handler handler;
-  uint8_t priority;
+  /// flow (fiber) of the frame in the send scheduler
+  uint64_t flow;
+  /// weight of the flow in the send scheduler
+  uint8_t weight;
+  /// reset frame: rerouted to a live link if its link is lost
+  bool reset;
 };
 
 typedef extended_buffer<std::vector<boost::asio::const_buffer>,
@@ -55,22 +64,75 @@ class basic_fiber_demux_impl : public std::enable_shared_from_this<
   typedef boost::asio::fiber::detail::basic_fiber_impl<StreamSocket>
       fiber_impl_deref_type;
   typedef std::shared_ptr<fiber_impl_deref_type> fiber_impl_type;
-  typedef std::map<fiber_id, fiber_impl_type> bind_map;
+  typedef fiber_table<fiber_impl_type> bind_map;
   typedef std::set<fiber_id::local_port_type> listen_set;
   typedef std::set<fiber_id::local_port_type> in_use_port_set;
   typedef std::shared_ptr<basic_fiber_demux_impl<StreamSocket>> p_impl;
 
   typedef std::function<void()> close_handler_type;
 
+  typedef fiber_send_scheduler<extended_raw_fiber_buffer> send_scheduler_type;
+
+ public:
+  /// Physical link of the demux: a stream socket and its send queue
+  struct link {
+    link(StreamSocket s, size_t quantum)
+        : socket(std::move(s)), read_header(), alive(true), sending(false),
+          send_buffer(), foreign(false), flows(0), toSendPriority(quantum) {}
+
+    StreamSocket socket;
+
+    /// header of the frame being received
+    fiber_header read_header;
+
+    /// cleared when the link fails (protected by links_mutex). Its flows
+    /// are pinned to a live link then.
+    bool alive;
+
+    /// a gathered write is pending on the socket
+    bool sending;
+
+    /// frames of the pending write, copied contiguously (reused between
+    /// writes, protected by send_mutex)
+    std::vector<uint8_t> send_buffer;
+
+    /// the socket runs on another io_service than the demux: its completions
+    /// are handed over to the io_service of the demux
+    bool foreign;
+
+    /// number of flows pinned to the link
+    size_t flows;
+
+    /// frames waiting to be sent, scheduled between the fibers by weight
+    send_scheduler_type toSendPriority;
+  };
+
+  typedef std::shared_ptr<link> p_link;
+
+ public:
+  enum {
+    kDefaultMaxSendBatchBytes = 256 * 1024,
+    kDefaultMaxSendBatchFrames = 64,
+    kMaxPooledBufferBytes = 4 * 1024 * 1024
+  };
+
  private:
   basic_fiber_demux_impl(StreamSocket s, close_handler_type close, size_t a_mtu)
       : bound(),
         listening(),
         used_ports(),
-        socket(std::move(s)),
+        links(),
+        flow_links(),
+        lost_flows(),
         closing(false),
         mtu(a_mtu),
-        close_handler(close) {}
+        buffer_pool(fiber_buffer_pool::create(kMaxPooledBufferBytes)),
+        max_send_batch_bytes(kDefaultMaxSendBatchBytes),
+        max_send_batch_frames(kDefaultMaxSendBatchFrames),
+        close_handler(close),
+        link_lost_handler([]() {}) {
+    links.push_back(new_link(std::move(s)));
+  }
 
  public:
   ~basic_fiber_demux_impl() {}
@@ -81,9 +143,68 @@ class basic_fiber_demux_impl : public std::enable_shared_from_this<
         new basic_fiber_demux_impl<StreamSocket>(std::move(s), close, mtu));
   }
 
-  void set_socket(StreamSocket s) { socket = std::move(s); }
+  p_link new_link(StreamSocket s) {
+    return std::make_shared<link>(std::move(s), mtu + fiber_header::pod_size());
+  }
+
+  /// Link of a flow (links_mutex must be held)
+  /**
+  * A flow pinned to a link (see pin_flow) always uses it so that its frames
+  * stay ordered. When the link is lost, the flow is pinned to a live link
+  * (see repin_flow). The other flows (datagrams, resets of unknown fibers)
+  * are spread over the live links by hash.
+  */
+  p_link get_link(uint64_t flow) {
+    auto flow_it = flow_links.find(flow);
+    if (flow_it != flow_links.end()) {
+      return flow_it->second;
+    }
+    return get_hashed_link(flow);
+  }
+
+  /// Live link of a flow by hash (links_mutex must be held)
+  p_link get_hashed_link(uint64_t flow) { return links[flow % links.size()]; }
+
+  /// Pin a flow to a link, the least loaded one if p_flow_link is null or
+  /// not live anymore (links_mutex must be held)
+  p_link pin_flow(uint64_t flow, p_link p_flow_link = nullptr) {
+    auto flow_it = flow_links.find(flow);
+    if (flow_it != flow_links.end()) {
+      return flow_it->second;
+    }
+    if (!p_flow_link || !p_flow_link->alive) {
+      p_flow_link = *std::min_element(
+          links.begin(), links.end(),
+          [](const p_link& lhs, const p_link& rhs) {
+            return lhs->flows < rhs->flows;
+          });
+    }
+    ++p_flow_link->flows;
+    flow_links[flow] = p_flow_link;
+    return p_flow_link;
+  }
+
+  /// Release the link of a flow (links_mutex must be held)
+  void unpin_flow(uint64_t flow) {
+    auto flow_it = flow_links.find(flow);
+    if (flow_it == flow_links.end()) {
+      return;
+    }
+    --flow_it->second->flows;
+    flow_links.erase(flow_it);
+    lost_flows.erase(flow);
+  }
 
-  // Store the bound fibers
+  /// Pin a flow of a lost link to the least loaded live link: only its reset
+  /// can be sent from now on (links_mutex must be held)
+  void repin_flow(uint64_t flow) {
+    unpin_flow(flow);
+    pin_flow(flow);
+    lost_flows.insert(flow);
+  }
+
+  // Store the bound fibers (lookups are lock free, bound_mutex serializes
+  // the compound bind/unbind operations)
   std::recursive_mutex bound_mutex;
   bind_map bound;
 
@@ -95,20 +216,42 @@ class basic_fiber_demux_impl : public std::enable_shared_from_this<
   std::recursive_mutex used_ports_mutex;
   in_use_port_set used_ports;
 
-  StreamSocket socket;
+  /// Protect the send queues of the links
+  std::recursive_mutex send_mutex;
+
+  /// Protect links, flow_links, lost_flows and the flow counts of the links.
+  /// No other lock is taken while it is held.
+  std::recursive_mutex links_mutex;
+
+  /// live physical links (never empty: the last link is kept when it fails)
+  std::vector<p_link> links;
+
+  /// links of the pinned flows
+  std::map<uint64_t, p_link> flow_links;
+
+  /// pinned flows which have lost frames with their link
+  std::set<uint64_t> lost_flows;
 
   std::recursive_mutex closing_mutex;
   bool closing;
 
-  std::recursive_mutex send_mutex;
-
   /// maximum size of the payload of one packet
   size_t mtu;
 
+  /// pool of the buffers receiving the frames
+  p_fiber_buffer_pool buffer_pool;
+
+  /// maximum number of bytes gathered in one write on the socket
+  size_t max_send_batch_bytes;
+
+  /// maximum number of frames gathered in one write on the socket
+  size_t max_send_batch_frames;
+
   close_handler_type close_handler;
 
-  // std::priority_queue<extended_raw_fiber_buffer> toSendPriority;
-  std::queue<extended_raw_fiber_buffer> toSendPriority;
+  /// called when a link fails while other links remain (protected by
+  /// links_mutex)
+  close_handler_type link_lost_handler;
 };
 
 }  // namespace detail
@@ -18,10 +18,14 @@
 #include <queue>
 
 #include <ssf/log/log.h>
+#include <ssf/metrics/metrics.h>
 
 #include "common/boost/fiber/basic_fiber_demux.hpp"
+#include "common/boost/fiber/detail/fiber_buffer.hpp"
+#include "common/boost/fiber/detail/fiber_data_queue.hpp"
 #include "common/boost/fiber/detail/fiber_header.hpp"
 #include "common/boost/fiber/detail/fiber_id.hpp"
+#include "common/boost/fiber/detail/fiber_weight.hpp"
 #include "common/boost/fiber/detail/io_fiber_accept_op.hpp"
 #include "common/boost/fiber/detail/io_fiber_dgr_read_op.hpp"
 #include "common/boost/fiber/detail/io_fiber_read_op.hpp"
@@ -80,9 +84,10 @@ class basic_fiber_impl
   typedef make_asio_queue<dgr_read_op>::type read_dgr_op_queue_type;
 
   /// Type for the structure used to store the data received
-  typedef boost::asio::streambuf data_queue_type;
+  typedef fiber_data_queue data_queue_type;
 
-  typedef make_queue<std::vector<uint8_t>>::type dgr_data_queue_type;
+  /// Type for the queue storing the received datagram frames
+  typedef make_queue<p_fiber_buffer>::type dgr_data_queue_type;
 
   /// Type for the queue storing the pending accept requests
   typedef typename make_asio_queue<accept_op>::type accept_op_queue_type;
@@ -90,8 +95,11 @@ class basic_fiber_impl
   /// Type for to store remote fiber ports (for accepting or datagrams)
   typedef make_queue<remote_port_type>::type remote_port_queue_type;
 
+  /// Type for to store the receive windows announced by connecting fibers
+  typedef make_queue<uint32_t>::type peer_window_queue_type;
+
   /// Type of the handler used when accepting a new fiber
-  typedef std::function<void(local_port_type)> accept_handler_type;
+  typedef std::function<void(local_port_type, uint32_t)> accept_handler_type;
 
   /// Type of the handler used when connecting a new fiber
   typedef std::function<void(boost::system::error_code)> connect_handler_type;
@@ -101,12 +109,10 @@ class basic_fiber_impl
       connect_user_handler_type;
 
   /// Type of the handler used when receiving a new packet
-  typedef std::function<void(std::vector<uint8_t>&&, std::size_t)>
-      receive_handler_type;
+  typedef std::function<void(p_fiber_buffer)> receive_handler_type;
 
   /// Type of the handler used when receiving a new datagram
-  typedef std::function<void(std::vector<uint8_t>&&,
-                             remote_port_type remote_port, std::size_t)>
+  typedef std::function<void(p_fiber_buffer, remote_port_type remote_port)>
       receive_dgr_handler_type;
 
   /// Type of the handler used when closing a fiber
@@ -119,21 +125,32 @@ class basic_fiber_impl
   /// Type of the handler used when an unknown error occurs
   typedef std::function<void(boost::system::error_code)> error_handler_type;
 
+  /// Type of a send operation waiting for credits from the remote fiber
+  typedef std::function<void(const boost::system::error_code&)>
+      pending_send_type;
+
+  /// Type for the queue storing the send operations waiting for credits
+  typedef make_queue<pending_send_type>::type pending_send_queue_type;
+
+ public:
+  /// Receive window announced to the remote fiber (in bytes)
+  enum { kDefaultReceiveWindow = 4 * 1024 * 1024 };
+
  private:
   /// Constructor for a fiber implementation object
   /**
   * @param f_demux The demultiplexer used for this fiber
   * @param remote_port The remote port to chich the fiber is to be bound
-  * @param prio (Unused) The priority for this fiber on the demultiplexer
+  * @param a_weight The weight of this fiber on the demultiplexer
   * @param dgr The fiber accepts datagrams
   */
   basic_fiber_impl(fiber_demux_type* p_f_demux, remote_port_type remote_port,
-                   uint8_t prio, bool dgr)
+                   uint8_t a_weight, bool dgr)
       : id(remote_port),
         p_fib_demux(p_f_demux),
         ready_in(true),
         ready_out(true),
-        priority(prio),
+        weight(a_weight),
         state_mutex(),
         closed(true),
         connecting(false),
@@ -149,15 +166,24 @@ class basic_fiber_impl
         accept_op_queue(),
         port_queue_mutex(),
         port_queue(),
+        peer_window_queue(),
+        credit_mutex(),
+        credit_enabled(false),
+        send_credit(0),
+        receive_window(kDefaultReceiveWindow),
+        consumed_bytes(0),
+        pending_sends(),
         connect_user_handler([](const boost::system::error_code&) {}),
-        accepts_dgr(dgr) {}
+        accepts_dgr(dgr) {
+    SSF_METRICS_GAUGE_ADD("fiber.active", 1);
+  }
 
   basic_fiber_impl()
       : id(0),
         p_fib_demux(nullptr),
         ready_in(true),
         ready_out(true),
-        priority(0),
+        weight(fiber_weight::kDefaultWeight),
         state_mutex(),
         closed(true),
         connecting(false),
@@ -173,20 +199,35 @@ class basic_fiber_impl
         accept_op_queue(),
         port_queue_mutex(),
         port_queue(),
+        peer_window_queue(),
+        credit_mutex(),
+        credit_enabled(false),
+        send_credit(0),
+        receive_window(kDefaultReceiveWindow),
+        consumed_bytes(0),
+        pending_sends(),
         connect_user_handler([](const boost::system::error_code&) {}),
-        accepts_dgr() {}
+        accepts_dgr() {
+    SSF_METRICS_GAUGE_ADD("fiber.active", 1);
+  }
 
  public:
   /// Destructor
-  ~basic_fiber_impl() {}
+  ~basic_fiber_impl() {
+    SSF_METRICS_GAUGE_ADD("fiber.active", -1);
+    SSF_METRICS_GAUGE_ADD("fiber.data_queue_bytes",
+                          -static_cast<int64_t>(data_queue.size()));
+  }
 
  public:
   /// Initialize the fiber impl by setting all its handler
   void init() {
-    accept_handler = [this](remote_port_type remote_port) {
+    accept_handler = [this](remote_port_type remote_port,
+                            uint32_t peer_window) {
       {
         std::unique_lock<std::recursive_mutex> lock(this->port_queue_mutex);
         this->port_queue.push(remote_port);
+        this->peer_window_queue.push(peer_window);
       }
       this->a_queues_handler();
     };
@@ -203,28 +244,28 @@ class basic_fiber_impl
       con_user_handler(ec);
     };
 
-    receive_handler = [this](std::vector<uint8_t>&& data,
-                             std::size_t bytes_transfered) {
+    receive_handler = [this](p_fiber_buffer p_frame) {
       {
         std::unique_lock<std::recursive_mutex> lock(this->data_queue_mutex);
-        boost::asio::streambuf::mutable_buffers_type buffers =
-            this->data_queue.prepare(bytes_transfered);
-
-        boost::asio::buffer_copy(buffers, boost::asio::buffer(data));
-        this->data_queue.commit(bytes_transfered);
+        auto queue_size = this->data_queue.size();
+        this->data_queue.push(std::move(p_frame));
+        SSF_METRICS_GAUGE_ADD("fiber.data_queue_bytes",
+                              this->data_queue.size() - queue_size);
+        // the largest samples point at the fibers whose reader lags behind
+        SSF_METRICS_RECORD("fiber.data_queue_size", this->data_queue.size());
       }
       this->r_queues_handler();
     };
 
-    receive_dgr_handler = [this](std::vector<uint8_t>&& data,
-                                 remote_port_type remote_port,
-                                 std::size_t bytes_transfered) {
+    // The frame is kept until the datagram is read: its payload is copied
+    // once, in the user buffer
+    receive_dgr_handler = [this](p_fiber_buffer p_frame,
+                                 remote_port_type remote_port) {
       {
         std::unique_lock<std::recursive_mutex> lock1(this->data_queue_mutex);
         std::unique_lock<std::recursive_mutex> lock2(this->port_queue_mutex);
         this->port_queue.push(remote_port);
-        data.resize(bytes_transfered);
-        this->dgr_data_queue_.push(data);
+        this->dgr_data_queue_.push(std::move(p_frame));
       }
       this->r_dgr_queues_handler();
     };
@@ -237,6 +278,7 @@ class basic_fiber_impl
       boost::system::error_code ec(::error::connection_reset,
                                    ::error::get_ssf_category());
       cancel_operations(ec);
+      this->cancel_pending_sends(ec);
       auto connect_handler = this->access_connect_handler();
       connect_handler(ec);
     };
@@ -247,8 +289,9 @@ class basic_fiber_impl
   /// Accessor for the accept handler
   accept_handler_type access_accept_handler() {
     auto self = this->shared_from_this();
-    auto lambda = [self, this](remote_port_type remote_port) {
-      this->accept_handler(remote_port);
+    auto lambda = [self, this](remote_port_type remote_port,
+                               uint32_t peer_window) {
+      this->accept_handler(remote_port, peer_window);
     };
     return lambda;
   }
@@ -265,9 +308,8 @@ class basic_fiber_impl
   /// Accessor for the receive handler
   receive_handler_type access_receive_handler() {
     auto self = this->shared_from_this();
-    auto lambda = [self, this](std::vector<uint8_t>&& data,
-                               std::size_t bytes_transfered) {
-      this->receive_handler(std::move(data), bytes_transfered);
+    auto lambda = [self, this](p_fiber_buffer p_frame) {
+      this->receive_handler(std::move(p_frame));
     };
     return lambda;
   }
@@ -275,10 +317,9 @@ class basic_fiber_impl
   /// Accessor for the receive handler for datagrams
   receive_dgr_handler_type access_receive_dgr_handler() {
     auto self = this->shared_from_this();
-    auto lambda = [self, this](std::vector<uint8_t>&& data,
-                               remote_port_type remote_port,
-                               std::size_t bytes_transfered) {
-      this->receive_dgr_handler(std::move(data), remote_port, bytes_transfered);
+    auto lambda = [self, this](p_fiber_buffer p_frame,
+                               remote_port_type remote_port) {
+      this->receive_dgr_handler(std::move(p_frame), remote_port);
     };
     return lambda;
   }
@@ -301,14 +342,14 @@ class basic_fiber_impl
   /**
   * @param f_demux The demultiplexer used for this fiber
   * @param remote_port The remote port to chich the fiber is to be bound
-  * @param prio (Unused) The priority for this fiber on the demultiplexer
+  * @param a_weight The weight of this fiber on the demultiplexer
   * @param dgr The fiber accepts datagrams
   */
-  static p_impl create(fiber_demux_type* p_f_demux,
-                       remote_port_type remote_port, uint8_t prio = 0,
-                       bool dgr = false) {
-    p_impl res = p_impl(
-        new basic_fiber_impl<StreamSocket>(p_f_demux, remote_port, prio, dgr));
+  static p_impl create(
+      fiber_demux_type* p_f_demux, remote_port_type remote_port,
+      uint8_t a_weight = fiber_weight::kDefaultWeight, bool dgr = false) {
+    p_impl res = p_impl(new basic_fiber_impl<StreamSocket>(
+        p_f_demux, remote_port, a_weight, dgr));
     res->init();
 
     return res;
@@ -343,11 +384,16 @@ class basic_fiber_impl
     if (!accept_op_queue.empty() && !port_queue.empty()) {
       auto remote_port = port_queue.front();
       port_queue.pop();
+      auto peer_window = peer_window_queue.front();
+      peer_window_queue.pop();
       auto op = accept_op_queue.front();
       accept_op_queue.pop();
       op->set_remote_port(remote_port);
 
       op->get_p_fib()->init_accept_in_out();
+      if (peer_window) {
+        op->get_p_fib()->init_credit(peer_window);
+      }
 
       p_fib_demux->async_send_ack(op->get_p_fib(), op);
 
@@ -369,7 +415,7 @@ class basic_fiber_impl
     std::unique_lock<std::recursive_mutex> lock1(read_op_queue_mutex);
     std::unique_lock<std::recursive_mutex> lock2(data_queue_mutex);
 
-    {
+    if (!is_credit_enabled()) {
       std::unique_lock<std::recursive_mutex> lock(in_mutex);
       if (((data_queue.size() > 60 * 1024 * 1024) && ready_in) ||
           ((data_queue.size() < 40 * 1024 * 1024) && !ready_in)) {
@@ -386,6 +432,8 @@ class basic_fiber_impl
 
         if (data_queue.size()) {
           size_t copied = op->fill_buffers(data_queue);
+          SSF_METRICS_GAUGE_ADD("fiber.data_queue_bytes",
+                                -static_cast<int64_t>(copied));
           op->complete(boost::system::error_code(), copied);
         } else {
           op->complete(ec, 0);
@@ -399,6 +447,9 @@ class basic_fiber_impl
       read_op_queue.pop();
 
       size_t copied = op->fill_buffers(data_queue);
+      SSF_METRICS_GAUGE_ADD("fiber.data_queue_bytes",
+                            -static_cast<int64_t>(copied));
+      consume_credit(copied);
 
       auto do_complete = [op, copied]() {
         op->complete(boost::system::error_code(), copied);
@@ -434,10 +485,10 @@ class basic_fiber_impl
           auto remote_port = port_queue.front();
           port_queue.pop();
 
-          auto data = dgr_data_queue_.front();
+          auto p_frame = std::move(dgr_data_queue_.front());
           dgr_data_queue_.pop();
 
-          size_t copied = op->fill_buffers(data);
+          size_t copied = op->fill_buffers(dgr_payload(p_frame));
 
           op->set_remote_port(remote_port);
 
@@ -457,10 +508,10 @@ class basic_fiber_impl
       auto remote_port = port_queue.front();
       port_queue.pop();
 
-      auto data = dgr_data_queue_.front();
+      auto p_frame = std::move(dgr_data_queue_.front());
       dgr_data_queue_.pop();
 
-      size_t copied = op->fill_buffers(data);
+      size_t copied = op->fill_buffers(dgr_payload(p_frame));
 
       op->set_remote_port(remote_port);
 
@@ -475,6 +526,11 @@ class basic_fiber_impl
     }
   }
 
+  /// Get the payload of a received datagram frame
+  static boost::asio::const_buffer dgr_payload(const p_fiber_buffer& p_frame) {
+    return boost::asio::buffer(p_frame->cdata(), p_frame->data_size());
+  }
+
   /// Cancel all pending operations immediatly
   /**
   * @param ec The error code that will be given to the pending operations
@@ -505,16 +561,104 @@ class basic_fiber_impl
     ready_out = true;
   }
 
+  /// Switch the fiber to credit-based flow control
+  /**
+  * Both ends must announce a window: a fiber announcing none (0) keeps the
+  * ready_out/ACK toggle in both directions.
+  *
+  * @param peer_window The receive window announced by the remote fiber
+  */
+  void init_credit(uint32_t peer_window) {
+    std::unique_lock<std::recursive_mutex> lock(credit_mutex);
+    if (!peer_window || !receive_window) {
+      return;
+    }
+    credit_enabled = true;
+    send_credit = peer_window;
+    consumed_bytes = 0;
+  }
+
+  /// Check if the fiber uses credit-based flow control
+  bool is_credit_enabled() {
+    std::unique_lock<std::recursive_mutex> lock(credit_mutex);
+    return credit_enabled;
+  }
+
+  /// Add credits granted by the remote fiber and resume the parked sends
+  /**
+  * @param credit The number of bytes granted by the remote fiber
+  */
+  void add_send_credit(uint32_t credit) {
+    pending_send_queue_type to_resume;
+    {
+      std::unique_lock<std::recursive_mutex> lock(credit_mutex);
+      send_credit += credit;
+      std::swap(to_resume, pending_sends);
+    }
+
+    while (!to_resume.empty()) {
+      auto pending_send = to_resume.front();
+      to_resume.pop();
+      p_fib_demux->get_io_service().post(
+          std::bind(pending_send, boost::system::error_code()));
+    }
+  }
+
+  /// Account for data consumed by the user and grant it back to the remote
+  /// fiber once a quarter of the receive window has been consumed
+  /**
+  * @param consumed The number of bytes read by the user
+  */
+  void consume_credit(std::size_t consumed) {
+    uint32_t credit = 0;
+    {
+      std::unique_lock<std::recursive_mutex> lock(credit_mutex);
+      if (!credit_enabled) {
+        return;
+      }
+
+      consumed_bytes += consumed;
+      if (consumed_bytes < receive_window / 4) {
+        return;
+      }
+
+      credit = static_cast<uint32_t>(consumed_bytes);
+      consumed_bytes = 0;
+    }
+
+    p_fib_demux->async_send_credit(this->shared_from_this(), credit);
+  }
+
+  /// Complete all the sends waiting for credits with the given error
+  /**
+  * @param ec The error code that will be given to the pending sends
+  */
+  void cancel_pending_sends(const boost::system::error_code& ec) {
+    pending_send_queue_type to_cancel;
+    {
+      std::unique_lock<std::recursive_mutex> lock(credit_mutex);
+      std::swap(to_cancel, pending_sends);
+    }
+
+    while (!to_cancel.empty()) {
+      auto pending_send = to_cancel.front();
+      to_cancel.pop();
+      p_fib_demux->get_io_service().post(std::bind(pending_send, ec));
+    }
+  }
+
   /// Toggle the fiber ability to receive
   void toggle_in() {
     std::unique_lock<std::recursive_mutex> lock(in_mutex);
     ready_in = !ready_in;
+    SSF_METRICS_COUNT("fiber.toggle_in", 1);
   }
 
   /// Toggle the fiber ability to send
   void toggle_out() {
     std::unique_lock<std::recursive_mutex> lock(out_mutex);
     ready_out = !ready_out;
+    SSF_METRICS_COUNT("fiber.toggle_out", 1);
   }
 
   void set_opened() {
@@ -574,7 +718,8 @@ class basic_fiber_impl
   bool ready_in;
   bool ready_out;
 
-  uint8_t priority;
+  /// Share of the link bandwidth of the fiber (see fiber_weight)
+  uint8_t weight;
 
   std::recursive_mutex state_mutex;
   // States of the fiber
@@ -612,6 +757,27 @@ class basic_fiber_impl
   /// Store the connecting remote port
   remote_port_queue_type port_queue;
 
+  /// Store the receive window announced by the connecting fibers
+  /// (0 if the remote fiber does not use credit-based flow control)
+  peer_window_queue_type peer_window_queue;
+
+  std::recursive_mutex credit_mutex;
+
+  /// The remote fiber uses credit-based flow control
+  bool credit_enabled;
+
+  /// Number of bytes the remote fiber is ready to receive
+  uint64_t send_credit;
+
+  /// Receive window announced to the remote fiber
+  uint32_t receive_window;
+
+  /// Number of bytes read by the user but not yet granted back
+  uint64_t consumed_bytes;
+
+  /// Store the send operations waiting for credits
+  pending_send_queue_type pending_sends;
+
   /// Connect user handler
   connect_user_handler_type connect_user_handler;
 
@@ -14,6 +14,9 @@
 
 #include <boost/asio/coroutine.hpp>
 #include <boost/asio.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -25,11 +28,55 @@ namespace asio {
 namespace fiber {
 namespace detail {
 
+class fiber_buffer;
+
+/// Owner of pooled fiber buffers
+/**
+* A fiber buffer with an owner is handed back to it instead of being deleted
+* when its last reference is released.
+*/
+class fiber_buffer_owner
+{
+public:
+  virtual ~fiber_buffer_owner() {}
+
+  /// Take back a buffer which is not referenced anymore
+  virtual void recycle(fiber_buffer* p_buffer) = 0;
+};
+
+typedef std::shared_ptr<fiber_buffer_owner> p_fiber_buffer_owner;
+
 class fiber_buffer
 {
 public:
   /// Constructor for an empty fiber buffer of size 4096 bytes.
-  fiber_buffer() : data_(4096), data_bytes_transferred_(0) {}
+  fiber_buffer() : fiber_buffer(4096) {}
+
+  /// Constructor for an empty fiber buffer of the given size.
+  /**
+  * The payload part is not initialized: it is filled by the receptions.
+  *
+  * @param size The size of the payload part of the buffer
+  */
+  explicit fiber_buffer(std::size_t size)
+    : header_(),
+      data_(size ? new uint8_t[size] : nullptr),
+      capacity_(size),
+      data_bytes_transferred_(0),
+      ref_count_(0),
+      p_owner_()
+  {
+  }
+
+  fiber_buffer(const fiber_buffer&) = delete;
+  fiber_buffer& operator=(const fiber_buffer&) = delete;
+
+  /// Reset the fiber buffer before reusing it
+  void reset()
+  {
+    header_ = fiber_header();
+    data_bytes_transferred_ = 0;
+  }
 
   /// Get the header part of the fiber buffer in order to fill it.
   fiber_header& header()
@@ -53,13 +100,13 @@ public:
   void set_header(const fiber_header& header) { header_ = header; }
 
   /// Get the data part of the fiber buffer.
-  const std::vector<uint8_t>& cdata() const { return data_; }
+  const uint8_t* cdata() const { return data_.get(); }
 
   /// Get the data part of the fiber buffer to fill it.
-  std::vector<uint8_t>& data() { return data_; }
+  uint8_t* data() { return data_.get(); }
 
-  /// Move the received data out of the fiber buffer.
-  std::vector<uint8_t> take_data() { return std::move(data_); }
+  /// Get the size of the data part of the fiber buffer.
+  std::size_t capacity() const { return capacity_; }
 
   /// Set the size of the received payload.
   /**
@@ -79,16 +126,11 @@ public:
   */
   void set_id(const fiber_id& id) { header_.set_id(id); }
 
-  /// Increase the size of the current buffer
+  /// Set the owner taking the buffer back once it is not referenced anymore.
   /**
-  * @param new_size The new_size of the buffer
-  * (it has to be superior to the current size)
+  * @param p_owner The owner (null to delete the buffer)
   */
-  void resize(std::size_t new_size)
-  {
-    assert(new_size > data_.size());
-    data_.resize(new_size);
-  }
+  void set_owner(p_fiber_buffer_owner p_owner) { p_owner_ = std::move(p_owner); }
 
   /// Get the fiber buffer buffers for sending
   /**
@@ -119,42 +161,86 @@ public:
     std::vector<boost::asio::mutable_buffer> buf;
 
     header_.fill_buffer(buf);
-    buf.push_back(boost::asio::buffer(&data_, data_.size()));
+    buf.push_back(boost::asio::buffer(data_.get(), capacity_));
 
     return buf;
   }
 
+private:
+  friend void intrusive_ptr_add_ref(fiber_buffer* p_buffer);
+  friend void intrusive_ptr_release(fiber_buffer* p_buffer);
+
 private:
   fiber_header header_;
-  std::vector<uint8_t> data_;
+  std::unique_ptr<uint8_t[]> data_;
+  std::size_t capacity_;
 
   std::size_t data_bytes_transferred_;
 
   fiber_header::raw_fiber_header raw_;
+
+  std::atomic<std::size_t> ref_count_;
+  p_fiber_buffer_owner p_owner_;
 };
 
-typedef std::shared_ptr<fiber_buffer> p_fiber_buffer;
+// The buffers are reference counted in place: handing out a pooled buffer
+// does not allocate
+inline void intrusive_ptr_add_ref(fiber_buffer* p_buffer)
+{
+  p_buffer->ref_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void intrusive_ptr_release(fiber_buffer* p_buffer)
+{
+  if (p_buffer->ref_count_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+  {
+    return;
+  }
+
+  auto p_owner = std::move(p_buffer->p_owner_);
+  if (p_owner)
+  {
+    p_owner->recycle(p_buffer);
+  }
+  else
+  {
+    delete p_buffer;
+  }
+}
+
+typedef boost::intrusive_ptr<fiber_buffer> p_fiber_buffer;
 
 /// Coroutine class to receive a fiber buffer from a stream
 /**
+* The header is received first: the buffer holding the frame is then taken
+* from the pool at the size of the payload.
+*
 * @tparam StreamSocket The stream type to receive from
+* @tparam BufferPool The pointer type of the buffer pool
 * @tparam ReadHandler The type for the callback handler to call upon reception
 */
-template <typename StreamSocket, typename ReadHandler>
+template <typename StreamSocket, typename BufferPool, typename ReadHandler>
 class read_fiber_buf_op : public boost::asio::coroutine
 {
 public:
   /// Constructor
   /**
   * @param stream The stream to receive from
-  * @param buffer The fiber buffer to receive into
+  * @param header The header to receive into (kept until the handler is
+  *   called)
+  * @param p_pool The pool of the buffers to receive the payload into
+  * @param max_data_size The maximum payload size of a valid packet
   * @param handler The handler to be called upon reception
   */
-  read_fiber_buf_op(StreamSocket& stream, fiber_buffer& buffer,
+  read_fiber_buf_op(StreamSocket& stream, fiber_header& header,
+                    BufferPool p_pool, std::size_t max_data_size,
                     ReadHandler& handler)
                     : stream_(stream),
-                    buffer_(buffer),
+                    header_(header),
+                    p_pool_(std::move(p_pool)),
+                    max_data_size_(max_data_size),
                     handler_(handler),
+                    p_buffer_(),
                     total_transferred_(0),
                     data_transferred_(0)
   {
@@ -163,64 +249,79 @@ public:
 #include <boost/asio/yield.hpp>  // NOLINT
   void operator()(const boost::system::error_code& ec, std::size_t length)
   {
-    auto& header = buffer_.header();
-
     if (!ec) reenter(this)
     {
       // Receive the header
-      yield boost::asio::async_read(stream_, header.buffer(),
+      yield boost::asio::async_read(stream_, header_.buffer(),
                                     std::move(*this));
       total_transferred_ += length;
 
-      // Resize the buffer if needed
-      if (header.data_size() > buffer_.cdata().size())
+      // Reject the packets the demultiplexer cannot handle
+      if ((header_.version() != fiber_header::fiber_verion) ||
+          (header_.data_size() > max_data_size_))
       {
-        buffer_.resize(header.data_size());
+        handler_(boost::asio::error::message_size, total_transferred_,
+                 p_fiber_buffer());
+        return;
       }
 
+      p_buffer_ = p_pool_->get(header_.data_size());
+      p_buffer_->set_header(header_);
+
       // Receive the payload
-      yield boost::asio::async_read(
-        stream_, boost::asio::buffer(buffer_.data(), header.data_size()),
-        std::move(*this));
+      if (header_.data_size())
+      {
+        yield boost::asio::async_read(
+          stream_, boost::asio::buffer(p_buffer_->data(), header_.data_size()),
+          std::move(*this));
 
-      data_transferred_ = length;
-      total_transferred_ += data_transferred_;
-      buffer_.set_bytes_transferred(data_transferred_);
-      buffer_.set_id(header.id());
+        data_transferred_ = length;
+        total_transferred_ += data_transferred_;
+      }
+      p_buffer_->set_bytes_transferred(data_transferred_);
 
-      handler_(ec, total_transferred_);
+      handler_(ec, total_transferred_, std::move(p_buffer_));
     }
     else
     {
-      handler_(ec, total_transferred_);
+      handler_(ec, total_transferred_, p_fiber_buffer());
     }
   }
 #include <boost/asio/unyield.hpp>  // NOLINT
 
 private:
   StreamSocket& stream_;
-  fiber_buffer& buffer_;
+  fiber_header& header_;
+  BufferPool p_pool_;
+  std::size_t max_data_size_;
   ReadHandler handler_;
+  p_fiber_buffer p_buffer_;
   std::size_t total_transferred_;
   std::size_t data_transferred_;
 };
 
-/// Helper to receive a fiber packet in a fiber buffer
+/// Helper to receive a fiber packet in a pooled fiber buffer
 /**
 * @tparam StreamSocket The stream type to receive from
+* @tparam BufferPool The pointer type of the buffer pool
 * @tparam ReadHandler The type for the callback handler to call upon reception
 *
 * @param stream The stream to receive from
-* @param buffer The fiber buffer to receive into
-* @param handler The handler to be called upon reception
+* @param header The header to receive into (kept until the handler is called)
+* @param p_pool The pool of the buffers to receive the payload into
+* @param max_data_size The maximum payload size of a valid packet
+* @param handler The handler to be called upon reception with the error code,
+*   the number of bytes received and the received fiber buffer
 */
-template <typename StreamSocket, typename ReadHandler>
-void async_read_fiber_buffer(StreamSocket& stream, fiber_buffer& buffer,
-                              ReadHandler& handler)
+template <typename StreamSocket, typename BufferPool, typename ReadHandler>
+void async_read_fiber_buffer(StreamSocket& stream, fiber_header& header,
+                             BufferPool p_pool, std::size_t max_data_size,
+                             ReadHandler& handler)
 {
   // Start the coroutine
-  read_fiber_buf_op<StreamSocket, ReadHandler>(stream, buffer, handler)(
-    boost::system::error_code(), 0);
+  read_fiber_buf_op<StreamSocket, BufferPool, ReadHandler>(
+    stream, header, std::move(p_pool), max_data_size,
+    handler)(boost::system::error_code(), 0);
 }
 
 } // namespace detail
@@ -0,0 +1,178 @@
+//
+// fiber/detail/fiber_buffer_pool.hpp
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// Copyright (c) 2014-2015
+//
+
+#ifndef SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_BUFFER_POOL_HPP_
+#define SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_BUFFER_POOL_HPP_
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/boost/fiber/detail/fiber_buffer.hpp"
+
+namespace boost {
+namespace asio {
+namespace fiber {
+namespace detail {
+
+/// Pool of refcounted fiber buffers sized after the received frames
+/**
+* Buffers are allocated by size classes (powers of 2 from min_class_size to
+* max_class_size) so that a small frame does not pin a MTU-sized buffer.
+* Buffers handed out by the pool go back to it when their last reference is
+* released, up to max_pooled_bytes of idle buffers: the demux read loop does
+* not allocate a payload buffer per received frame.
+*/
+class fiber_buffer_pool
+  : public fiber_buffer_owner,
+    public std::enable_shared_from_this<fiber_buffer_pool>
+{
+public:
+  typedef std::shared_ptr<fiber_buffer_pool> p_fiber_buffer_pool;
+
+  enum : std::size_t {
+    min_class_size = 1024,
+    max_class_size = 1024 * 1024,
+    default_max_pooled_bytes = 4 * 1024 * 1024
+  };
+
+public:
+  /// Create a new pool
+  /**
+  * @param max_pooled_bytes The maximum number of bytes held by idle buffers
+  */
+  static p_fiber_buffer_pool create(
+    std::size_t max_pooled_bytes = default_max_pooled_bytes)
+  {
+    return p_fiber_buffer_pool(new fiber_buffer_pool(max_pooled_bytes));
+  }
+
+  ~fiber_buffer_pool()
+  {
+    for (auto& buffers : free_buffers_)
+    {
+      for (auto p_buffer : buffers)
+      {
+        delete p_buffer;
+      }
+    }
+  }
+
+  /// Get a buffer with a payload part of at least size bytes (allocate one if
+  /// the pool has none of its class)
+  p_fiber_buffer get(std::size_t size)
+  {
+    auto size_class = class_size(size);
+    fiber_buffer* p_buffer = nullptr;
+    if (size_class <= max_class_size)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto& buffers = free_buffers_[class_index(size_class)];
+      if (!buffers.empty())
+      {
+        p_buffer = buffers.back();
+        buffers.pop_back();
+        pooled_bytes_ -= size_class;
+      }
+    }
+
+    if (!p_buffer)
+    {
+      p_buffer = new fiber_buffer(size_class);
+    }
+    else
+    {
+      p_buffer->reset();
+    }
+
+    if (size_class <= max_class_size)
+    {
+      p_buffer->set_owner(this->shared_from_this());
+    }
+    return p_fiber_buffer(p_buffer);
+  }
+
+  /// Get the size class of a payload of size bytes
+  static std::size_t class_size(std::size_t size)
+  {
+    if (size > max_class_size)
+    {
+      return size;
+    }
+
+    std::size_t size_class = min_class_size;
+    while (size_class < size)
+    {
+      size_class <<= 1;
+    }
+    return size_class;
+  }
+
+  /// Get the number of bytes held by idle buffers
+  std::size_t pooled_bytes() const
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return pooled_bytes_;
+  }
+
+  void recycle(fiber_buffer* p_buffer) override
+  {
+    auto size_class = p_buffer->capacity();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (pooled_bytes_ + size_class <= max_pooled_bytes_)
+      {
+        free_buffers_[class_index(size_class)].push_back(p_buffer);
+        pooled_bytes_ += size_class;
+        return;
+      }
+    }
+    delete p_buffer;
+  }
+
+private:
+  enum : std::size_t { class_count = 11 };
+
+  explicit fiber_buffer_pool(std::size_t max_pooled_bytes)
+    : max_pooled_bytes_(max_pooled_bytes),
+      mutex_(),
+      free_buffers_(),
+      pooled_bytes_(0)
+  {
+  }
+
+  static std::size_t class_index(std::size_t size_class)
+  {
+    std::size_t index = 0;
+    while ((std::size_t(min_class_size) << index) < size_class)
+    {
+      ++index;
+    }
+    return index;
+  }
+
+private:
+  std::size_t max_pooled_bytes_;
+  mutable std::mutex mutex_;
+  std::array<std::vector<fiber_buffer*>, class_count> free_buffers_;
+  std::size_t pooled_bytes_;
+};
+
+typedef fiber_buffer_pool::p_fiber_buffer_pool p_fiber_buffer_pool;
+
+} // namespace detail
+} // namespace fiber
+} // namespace asio
+} // namespace boost
+
+#endif  // SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_BUFFER_POOL_HPP_
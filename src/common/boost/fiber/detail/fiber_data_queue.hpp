@@ -0,0 +1,128 @@
+//
+// fiber/detail/fiber_data_queue.hpp
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// Copyright (c) 2014-2015
+//
+
+#ifndef SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_DATA_QUEUE_HPP_
+#define SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_DATA_QUEUE_HPP_
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+
+#include <boost/asio/buffer.hpp>
+
+#include "common/boost/fiber/detail/fiber_buffer.hpp"
+
+namespace boost {
+namespace asio {
+namespace fiber {
+namespace detail {
+
+/// Queue of the frames received by a stream fiber
+/**
+* The received fiber buffers are queued as is: the payload is copied only once,
+* from the frame to the user buffers. A small payload which fits in the unused
+* part of the last queued frame is appended to it, so that a burst of small
+* frames does not pin one buffer each.
+*/
+class fiber_data_queue
+{
+public:
+  fiber_data_queue() : frames_(), front_offset_(0), size_(0) {}
+
+  /// Get the number of bytes queued
+  std::size_t size() const { return size_; }
+
+  /// Queue the payload of a received frame
+  /**
+  * @param p_frame The received fiber buffer
+  */
+  void push(p_fiber_buffer p_frame)
+  {
+    auto length = p_frame->data_size();
+    if (!length)
+    {
+      return;
+    }
+
+    if (!frames_.empty())
+    {
+      auto& p_tail = frames_.back();
+      auto tail_size = p_tail->data_size();
+      if (p_tail->capacity() - tail_size >= length)
+      {
+        std::memcpy(p_tail->data() + tail_size, p_frame->cdata(), length);
+        p_tail->set_bytes_transferred(tail_size + length);
+        size_ += length;
+        return;
+      }
+    }
+
+    frames_.push_back(std::move(p_frame));
+    size_ += length;
+  }
+
+  /// Copy queued data into the given buffer and consume it
+  /**
+  * @param buffer The user buffer to fill
+  *
+  * @return The number of bytes copied
+  */
+  std::size_t read(const boost::asio::mutable_buffer& buffer)
+  {
+    auto p_dest = boost::asio::buffer_cast<uint8_t*>(buffer);
+    auto remaining = boost::asio::buffer_size(buffer);
+    std::size_t copied = 0;
+
+    while (remaining && !frames_.empty())
+    {
+      auto& p_front = frames_.front();
+      auto length =
+        std::min(remaining, p_front->data_size() - front_offset_);
+
+      std::memcpy(p_dest + copied, p_front->cdata() + front_offset_,
+                  length);
+      front_offset_ += length;
+      copied += length;
+      remaining -= length;
+
+      if (front_offset_ == p_front->data_size())
+      {
+        // Release the frame (back to its pool)
+        frames_.pop_front();
+        front_offset_ = 0;
+      }
+    }
+
+    size_ -= copied;
+    return copied;
+  }
+
+  /// Drop all the queued data
+  void clear()
+  {
+    frames_.clear();
+    front_offset_ = 0;
+    size_ = 0;
+  }
+
+private:
+  std::deque<p_fiber_buffer> frames_;
+  std::size_t front_offset_;
+  std::size_t size_;
+};
+
+} // namespace detail
+} // namespace fiber
+} // namespace asio
+} // namespace boost
+
+#endif  // SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_DATA_QUEUE_HPP_
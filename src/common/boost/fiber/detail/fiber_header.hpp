@@ -36,11 +36,14 @@ public:
   typedef uint8_t flags_type;
 
   /// Type of the data size field in the header
-  typedef uint16_t data_size_type;
+  typedef uint32_t data_size_type;
 
 public:
   /// Constants used with the class
-  enum { fiber_verion = 1, field_number = 3 + fiber_id::field_number };
+  /**
+  * Version 2 of the header carries a 32 bits data size (jumbo frames).
+  */
+  enum { fiber_verion = 2, field_number = 3 + fiber_id::field_number };
 
 public:
 #pragma pack(push)
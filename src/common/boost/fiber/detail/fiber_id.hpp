@@ -99,6 +99,12 @@ public:
     }
   }
 
+  /// Get both ports packed in one 64-bit key (for hash tables)
+  uint64_t packed() const
+  {
+    return (static_cast<uint64_t>(remote_port_) << 32) | local_port_;
+  }
+
   /// Get the return id
   fiber_id returning_id() const { return fiber_id(local_port_, remote_port_); }
 
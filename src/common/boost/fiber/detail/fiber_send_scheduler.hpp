@@ -0,0 +1,235 @@
+//
+// fiber/detail/fiber_send_scheduler.hpp
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// Copyright (c) 2014-2015
+//
+
+#ifndef SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_SEND_SCHEDULER_HPP_
+#define SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_SEND_SCHEDULER_HPP_
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+namespace boost {
+namespace asio {
+namespace fiber {
+namespace detail {
+
+/// Deficit round robin scheduler of the frames queued on a demultiplexer
+/**
+* Frames are queued per flow (one flow per fiber id) and the flows having
+* frames to send are served in turn. On its turn, a flow is granted
+* quantum * weight bytes and sends its frames as long as the granted bytes
+* cover them. The bandwidth is then shared between the active flows in
+* proportion to their weights, while the frames of one flow keep their order.
+*
+* The flow states are slots reused from one burst to the next and the active
+* flows are linked through their slots: queuing the first frame of a flow
+* allocates nothing once the slots are there.
+*
+* @tparam Frame The queued frame type (must expose buffer, flow and weight)
+*/
+template <typename Frame>
+class fiber_send_scheduler
+{
+private:
+  enum : uint32_t { npos = static_cast<uint32_t>(-1) };
+
+  struct flow_state
+  {
+    flow_state() : frames(), deficit(0), weight(1), next(npos) {}
+
+    std::deque<std::pair<Frame, std::size_t>> frames;
+    std::size_t deficit;
+    uint8_t weight;
+    // Next active flow slot
+    uint32_t next;
+  };
+
+  // Slots of the active flows sorted by flow
+  typedef std::vector<std::pair<uint64_t, uint32_t>> flow_index;
+
+public:
+  /// Constructor
+  /**
+  * @param quantum The number of bytes granted to a flow of weight 1 on each
+  * turn (should be at least the size of the largest frame)
+  */
+  explicit fiber_send_scheduler(std::size_t quantum)
+    : quantum_(quantum ? quantum : 1), slots_(), free_slots_(), index_(),
+      head_(npos), tail_(npos), turn_started_(false), size_(0)
+  {
+  }
+
+  /// Check if no frame is queued
+  bool empty() const { return size_ == 0; }
+
+  /// Get the number of queued frames
+  std::size_t size() const { return size_; }
+
+  /// Queue a frame at the back of its flow
+  /**
+  * A frame of weight 0 (control frame) keeps the current weight of its flow.
+  */
+  void push(const Frame& frame)
+  {
+    auto index_it = find(frame.flow);
+    uint32_t slot;
+    if (index_it == index_.end() || index_it->first != frame.flow)
+    {
+      slot = activate();
+      index_.insert(index_it, std::make_pair(frame.flow, slot));
+    }
+    else
+    {
+      slot = index_it->second;
+    }
+
+    auto& flow = slots_[slot];
+    if (frame.weight)
+    {
+      flow.weight = frame.weight;
+    }
+    flow.frames.emplace_back(frame, boost::asio::buffer_size(frame.buffer));
+    ++size_;
+  }
+
+  /// Get the next frame to send
+  /**
+  * The scheduler must not be empty.
+  */
+  const Frame& front()
+  {
+    return select().frames.front().first;
+  }
+
+  /// Remove the frame returned by front
+  void pop()
+  {
+    auto& flow = select();
+    auto flow_id = flow.frames.front().first.flow;
+    flow.deficit -= flow.frames.front().second;
+    flow.frames.pop_front();
+    --size_;
+
+    if (flow.frames.empty())
+    {
+      // An idle flow does not keep its deficit
+      index_.erase(find(flow_id));
+      deactivate();
+    }
+  }
+
+private:
+  typename flow_index::iterator find(uint64_t flow)
+  {
+    return std::lower_bound(
+        index_.begin(), index_.end(), flow,
+        [](const std::pair<uint64_t, uint32_t>& entry, uint64_t value) {
+          return entry.first < value;
+        });
+  }
+
+  // Take a free slot and link it at the back of the active flows
+  uint32_t activate()
+  {
+    uint32_t slot;
+    if (free_slots_.empty())
+    {
+      slot = static_cast<uint32_t>(slots_.size());
+      slots_.emplace_back();
+    }
+    else
+    {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+    }
+
+    if (tail_ == npos)
+    {
+      head_ = slot;
+    }
+    else
+    {
+      slots_[tail_].next = slot;
+    }
+    tail_ = slot;
+    return slot;
+  }
+
+  // Unlink the first active flow and free its slot (its queue keeps its
+  // memory for the next burst)
+  void deactivate()
+  {
+    auto slot = head_;
+    auto& flow = slots_[slot];
+    head_ = flow.next;
+    if (head_ == npos)
+    {
+      tail_ = npos;
+    }
+    flow.deficit = 0;
+    flow.weight = 1;
+    flow.next = npos;
+    free_slots_.push_back(slot);
+    turn_started_ = false;
+  }
+
+  // Find the flow whose turn it is and which can send its first frame
+  flow_state& select()
+  {
+    for (;;)
+    {
+      auto& flow = slots_[head_];
+      if (!turn_started_)
+      {
+        flow.deficit += quantum_ * flow.weight;
+        turn_started_ = true;
+      }
+
+      if (flow.frames.front().second <= flow.deficit)
+      {
+        return flow;
+      }
+
+      // Not enough deficit left: hand the turn over to the next flow
+      if (head_ != tail_)
+      {
+        auto slot = head_;
+        head_ = flow.next;
+        flow.next = npos;
+        slots_[tail_].next = slot;
+        tail_ = slot;
+      }
+      turn_started_ = false;
+    }
+  }
+
+private:
+  std::size_t quantum_;
+  std::vector<flow_state> slots_;
+  std::vector<uint32_t> free_slots_;
+  flow_index index_;
+  uint32_t head_;
+  uint32_t tail_;
+  bool turn_started_;
+  std::size_t size_;
+};
+
+} // namespace detail
+} // namespace fiber
+} // namespace asio
+} // namespace boost
+
+#endif  // SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_SEND_SCHEDULER_HPP_
@@ -0,0 +1,404 @@
+//
+// fiber/detail/fiber_table.hpp
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// Copyright (c) 2014-2015
+//
+
+#ifndef SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_TABLE_HPP_
+#define SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_TABLE_HPP_
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/boost/fiber/detail/fiber_id.hpp"
+
+namespace boost {
+namespace asio {
+namespace fiber {
+namespace detail {
+
+/// Table of the fibers bound to a demux, indexed by fiber id
+/**
+* The table is an open-addressing hash table (linear probing) keyed on the
+* packed fiber id. Each slot points to an immutable node holding a key and its
+* value. Lookups do not take any lock: they probe the slots and copy the value
+* of the matching node. Writers are serialized and update the slots in place:
+* an insertion publishes a new node, an erasure replaces the node by a
+* tombstone. The slots are rebuilt (amortized) when live entries and
+* tombstones fill half of them.
+*
+* Unlinked nodes and slot arrays are reclaimed by epoch: a reader announces
+* the epoch in which it enters in a counter of its shard, and an object
+* retired in an epoch is deleted once no reader of that epoch remains.
+*
+* @tparam Value The type of the stored values (default constructed value is
+* returned when a fiber id is not found)
+*/
+template <typename Value>
+class fiber_table
+{
+private:
+  /// Object deleted once no reader can access it anymore
+  struct retired_object
+  {
+    virtual ~retired_object() {}
+  };
+
+  struct node : public retired_object
+  {
+    node(uint64_t k, const Value& v) : key(k), value(v) {}
+
+    const uint64_t key;
+    const Value value;
+  };
+
+  struct slot_array : public retired_object
+  {
+    explicit slot_array(std::size_t capacity)
+      : mask(capacity - 1), slots(new std::atomic<node*>[capacity])
+    {
+      for (std::size_t i = 0; i < capacity; ++i)
+      {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+
+    const std::size_t mask;
+    std::unique_ptr<std::atomic<node*>[]> slots;
+  };
+
+  enum : std::size_t { reader_shards = 16, min_capacity = 16 };
+
+  // one cache line per reader counter
+  struct reader_counter
+  {
+    reader_counter() : count(0) {}
+
+    std::atomic<std::size_t> count;
+    char padding[64 - sizeof(std::atomic<std::size_t>)];
+  };
+
+  /// Epoch critical section of a reader
+  class read_guard
+  {
+  public:
+    explicit read_guard(const fiber_table& table) : p_counter_(nullptr)
+    {
+      auto shard = reader_shard();
+      while (true)
+      {
+        auto epoch = table.epoch_.load();
+        p_counter_ = &table.readers_[epoch & 1][shard].count;
+        p_counter_->fetch_add(1);
+        // The epoch may have moved before the reader was counted in
+        if (table.epoch_.load() == epoch)
+        {
+          break;
+        }
+        p_counter_->fetch_sub(1);
+      }
+    }
+
+    ~read_guard() { p_counter_->fetch_sub(1); }
+
+    read_guard(const read_guard&) = delete;
+    read_guard& operator=(const read_guard&) = delete;
+
+  private:
+    std::atomic<std::size_t>* p_counter_;
+  };
+
+public:
+  fiber_table()
+    : write_mutex_(),
+      p_slots_(new slot_array(min_capacity)),
+      size_(0),
+      used_slots_(0),
+      epoch_(0),
+      readers_(),
+      retired_()
+  {
+  }
+
+  ~fiber_table()
+  {
+    auto p_slots = p_slots_.load();
+    for (std::size_t i = 0; i < p_slots->capacity(); ++i)
+    {
+      auto p_node = p_slots->slots[i].load();
+      if (p_node && p_node != tombstone())
+      {
+        delete p_node;
+      }
+    }
+    delete p_slots;
+    for (auto& retired : retired_)
+    {
+      delete_objects(retired);
+    }
+  }
+
+  fiber_table(const fiber_table&) = delete;
+  fiber_table& operator=(const fiber_table&) = delete;
+
+  /// Find the value bound to a fiber id (lock free)
+  /**
+  * @param id The fiber id to look up
+  */
+  Value find(const fiber_id& id) const
+  {
+    read_guard guard(*this);
+    auto p_node = find_node(*p_slots_.load(), id.packed());
+    return p_node ? p_node->value : Value();
+  }
+
+  /// Check if a value is bound to a fiber id (lock free)
+  /**
+  * @param id The fiber id to look up
+  */
+  std::size_t count(const fiber_id& id) const
+  {
+    read_guard guard(*this);
+    return find_node(*p_slots_.load(), id.packed()) ? 1 : 0;
+  }
+
+  /// Get the number of bound fibers
+  std::size_t size() const { return size_.load(); }
+
+  /// Get a copy of all the bound values
+  std::vector<Value> values() const
+  {
+    std::vector<Value> result;
+    read_guard guard(*this);
+    const auto& slots = *p_slots_.load();
+    for (std::size_t i = 0; i < slots.capacity(); ++i)
+    {
+      auto p_node = slots.slots[i].load();
+      if (p_node && p_node != tombstone())
+      {
+        result.push_back(p_node->value);
+      }
+    }
+    return result;
+  }
+
+  /// Bind a value to a fiber id
+  /**
+  * @param id The fiber id
+  * @param value The value to bind
+  *
+  * @return false if a value is already bound to the fiber id
+  */
+  bool insert(const fiber_id& id, const Value& value)
+  {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    auto key = id.packed();
+    if (2 * (used_slots_ + 1) > p_slots_.load()->capacity())
+    {
+      rebuild(size_.load() + 1);
+    }
+
+    auto& slots = *p_slots_.load();
+    std::atomic<node*>* p_free_slot = nullptr;
+    for (auto i = hash(key) & slots.mask;; i = (i + 1) & slots.mask)
+    {
+      auto& slot = slots.slots[i];
+      auto p_node = slot.load();
+      if (!p_node)
+      {
+        if (!p_free_slot)
+        {
+          p_free_slot = &slot;
+          ++used_slots_;
+        }
+        break;
+      }
+      if (p_node == tombstone())
+      {
+        if (!p_free_slot)
+        {
+          p_free_slot = &slot;
+        }
+        continue;
+      }
+      if (p_node->key == key)
+      {
+        return false;
+      }
+    }
+
+    p_free_slot->store(new node(key, value));
+    ++size_;
+
+    return true;
+  }
+
+  /// Unbind the value bound to a fiber id
+  /**
+  * @param id The fiber id
+  */
+  void erase(const fiber_id& id)
+  {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    auto key = id.packed();
+    auto& slots = *p_slots_.load();
+    for (auto i = hash(key) & slots.mask;; i = (i + 1) & slots.mask)
+    {
+      auto& slot = slots.slots[i];
+      auto p_node = slot.load();
+      if (!p_node)
+      {
+        return;
+      }
+      if (p_node != tombstone() && p_node->key == key)
+      {
+        slot.store(tombstone());
+        --size_;
+        retire(p_node);
+        return;
+      }
+    }
+  }
+
+private:
+  static const node* find_node(const slot_array& slots, uint64_t key)
+  {
+    for (auto i = hash(key) & slots.mask;; i = (i + 1) & slots.mask)
+    {
+      auto p_node = slots.slots[i].load(std::memory_order_acquire);
+      if (!p_node)
+      {
+        return nullptr;
+      }
+      if (p_node != tombstone() && p_node->key == key)
+      {
+        return p_node;
+      }
+    }
+  }
+
+  // Move the live nodes into new slots without tombstone, the load factor
+  // under 1/2 (write_mutex_ must be held)
+  void rebuild(std::size_t entries)
+  {
+    std::size_t capacity = min_capacity;
+    while (capacity < 4 * entries)
+    {
+      capacity <<= 1;
+    }
+
+    auto p_current = p_slots_.load();
+    auto p_next = new slot_array(capacity);
+    for (std::size_t i = 0; i < p_current->capacity(); ++i)
+    {
+      auto p_node = p_current->slots[i].load();
+      if (!p_node || p_node == tombstone())
+      {
+        continue;
+      }
+      auto j = hash(p_node->key) & p_next->mask;
+      while (p_next->slots[j].load(std::memory_order_relaxed))
+      {
+        j = (j + 1) & p_next->mask;
+      }
+      p_next->slots[j].store(p_node, std::memory_order_relaxed);
+    }
+
+    used_slots_ = size_.load();
+    p_slots_.store(p_next);
+    retire(p_current);
+  }
+
+  // Delete the object once no reader can access it anymore (write_mutex_
+  // must be held)
+  void retire(retired_object* p_object)
+  {
+    retired_[epoch_.load() & 1].push_back(p_object);
+
+    // The objects retired in the current epoch can be deleted after two
+    // epoch moves
+    for (int i = 0; i < 2 && try_advance_epoch(); ++i)
+    {
+    }
+  }
+
+  // Move to the next epoch if no reader of the previous one remains and
+  // delete the objects retired in the previous epoch (write_mutex_ must be
+  // held)
+  bool try_advance_epoch()
+  {
+    auto epoch = epoch_.load();
+    auto previous = (epoch + 1) & 1;
+    for (const auto& counter : readers_[previous])
+    {
+      if (counter.count.load())
+      {
+        return false;
+      }
+    }
+
+    delete_objects(retired_[previous]);
+    epoch_.store(epoch + 1);
+    return true;
+  }
+
+  static void delete_objects(std::vector<retired_object*>& objects)
+  {
+    for (auto p_object : objects)
+    {
+      delete p_object;
+    }
+    objects.clear();
+  }
+
+  static node* tombstone()
+  {
+    static node erased(0, Value());
+    return &erased;
+  }
+
+  static std::size_t hash(uint64_t key)
+  {
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32);
+  }
+
+  static std::size_t reader_shard()
+  {
+    static std::atomic<std::size_t> next_shard(0);
+    thread_local std::size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % reader_shards;
+    return shard;
+  }
+
+private:
+  std::mutex write_mutex_;
+  std::atomic<slot_array*> p_slots_;
+  std::atomic<std::size_t> size_;
+  // slots holding a node or a tombstone (write_mutex_)
+  std::size_t used_slots_;
+
+  std::atomic<uint64_t> epoch_;
+  // readers in the current and in the previous epoch (by parity)
+  mutable std::array<std::array<reader_counter, reader_shards>, 2> readers_;
+  // objects retired in the current and in the previous epoch (write_mutex_)
+  std::array<std::vector<retired_object*>, 2> retired_;
+};
+
+} // namespace detail
+} // namespace fiber
+} // namespace asio
+} // namespace boost
+
+#endif  // SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_TABLE_HPP_
@@ -0,0 +1,56 @@
+//
+// fiber/detail/fiber_weight.hpp
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// Copyright (c) 2014-2015
+//
+
+#ifndef SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_WEIGHT_HPP_
+#define SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_WEIGHT_HPP_
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+
+namespace boost {
+namespace asio {
+namespace fiber {
+namespace detail {
+
+/// Socket option for the weight of a fiber on its demultiplexer
+/**
+* The demultiplexer shares the bandwidth of the link between the fibers which
+* have data to send in proportion to their weights. An accepted fiber inherits
+* the weight of its acceptor.
+*
+* @par Example
+* @code
+* fiber.set_option(stream_fiber<socket_type>::weight(4));
+* @endcode
+*/
+class fiber_weight
+{
+public:
+  typedef uint8_t value_type;
+
+  enum { kDefaultWeight = 1 };
+
+public:
+  fiber_weight() : value_(kDefaultWeight) {}
+
+  explicit fiber_weight(value_type value) : value_(value ? value : 1) {}
+
+  value_type value() const { return value_; }
+
+private:
+  value_type value_;
+};
+
+} // namespace detail
+} // namespace fiber
+} // namespace asio
+} // namespace boost
+
+#endif  // SSF_COMMON_BOOST_ASIO_FIBER_DETAIL_FIBER_WEIGHT_HPP_
@@ -124,13 +124,13 @@ class pending_dgr_read_operation : public basic_pending_dgr_read_operation
   /// Implementation of the filling buffer callback
   /**
   * @param base A pointer to the base class
-  * @param stream The buffer to copy the data to
+  * @param data The datagram to copy
   */
   static size_t do_fill_buffers(basic_pending_io_operation* base,
-                                const std::vector<uint8_t>& data)
+                                boost::asio::const_buffer data)
   {
     pending_dgr_read_operation* o(static_cast<pending_dgr_read_operation*>(base));
-    return boost::asio::buffer_copy(o->buffers_, boost::asio::buffer(data));
+    return boost::asio::buffer_copy(o->buffers_, boost::asio::const_buffers_1(data));
   }
 
  private:
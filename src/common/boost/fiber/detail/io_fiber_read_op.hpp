@@ -25,6 +25,7 @@
 #include <boost/asio/error.hpp>
 
 #include "common/boost/fiber/detail/io_operation.hpp"
+#include "common/boost/fiber/detail/fiber_data_queue.hpp"
 #include "common/boost/fiber/detail/fiber_id.hpp"
 
 #include <boost/asio/detail/push_options.hpp>
@@ -123,10 +124,10 @@ public:
   /// Implementation of the filling buffer callback
   /**
   * @param base A pointer to the base class
-  * @param stream The buffer to copy the data to
+  * @param queue The queue of received data to copy the data from
   */
   static size_t do_fill_buffers(basic_pending_io_operation* base,
-                                boost::asio::streambuf& stream)
+                                fiber_data_queue& queue)
   {
     pending_read_operation* o(static_cast<pending_read_operation*>(base));
 
@@ -135,10 +136,8 @@ public:
     for (auto it_buffer = o->buffers_.begin(); it_buffer != o->buffers_.end();
           ++it_buffer)
     {
-      size_t just_copied = boost::asio::buffer_copy(*it_buffer, stream.data());
-      stream.consume(just_copied);
-      copied += just_copied;
-      if (!stream.size())
+      copied += queue.read(*it_buffer);
+      if (!queue.size())
       {
         break;
       }
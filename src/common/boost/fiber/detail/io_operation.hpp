@@ -15,10 +15,12 @@
 #include <boost/asio/detail/handler_tracking.hpp>
 #include <boost/asio/detail/op_queue.hpp>
 #include <boost/system/error_code.hpp>
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/streambuf.hpp>
 
 #include <vector>
 
+#include "common/boost/fiber/detail/fiber_data_queue.hpp"
 #include "common/boost/fiber/detail/fiber_id.hpp"
 
 namespace boost {
@@ -114,7 +116,7 @@ class basic_pending_read_operation : public basic_pending_io_operation
 {
 private:
   typedef size_t(*fill_buffer_func_type)(basic_pending_io_operation*,
-                                          boost::asio::streambuf&);
+                                          fiber_data_queue&);
 
 protected:
   /// Constructor
@@ -137,9 +139,9 @@ protected:
 public:
   /// Function called to fill the buffer with read data
   /**
-  * @param buf The buffer where to store the read data
+  * @param buf The queue of received data to read from
   */
-  size_t fill_buffers(boost::asio::streambuf& buf)
+  size_t fill_buffers(fiber_data_queue& buf)
   {
     if (fill_buffer_func_)
     {
@@ -178,7 +180,7 @@ class basic_pending_dgr_read_operation : public basic_pending_io_operation
 {
 private:
   typedef size_t(*fill_dgr_buffer_func_type)(basic_pending_io_operation*,
-                                             const std::vector<uint8_t>&);
+                                             boost::asio::const_buffer);
 
 protected:
   /// Constructor
@@ -200,9 +202,9 @@ protected:
 public:
   /// Function called to fill the buffer with read data
   /**
-  * @param buf The buffer where to store the read data
+  * @param buf The datagram to copy in the buffer
   */
-  size_t fill_buffers(const std::vector<uint8_t>& buf) {
+  size_t fill_buffers(boost::asio::const_buffer buf) {
     if (fill_dgr_buffer_func_) {
       return fill_dgr_buffer_func_(this, buf);
     } else {
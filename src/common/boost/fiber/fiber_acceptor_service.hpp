@@ -24,6 +24,7 @@
 
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 #include "common/boost/fiber/detail/fiber_id.hpp"
+#include "common/boost/fiber/detail/fiber_weight.hpp"
 #include "common/boost/fiber/basic_endpoint.hpp"
 #include "common/boost/fiber/detail/basic_fiber_impl.hpp"
 
@@ -150,6 +151,24 @@ class fiber_acceptor_service
   /// Get the native acceptor implementation.
   native_handle_type native_handle(implementation_type& impl) { return impl; }
 
+  /// Set the weight inherited by the accepted fibers.
+  boost::system::error_code set_option(implementation_type& impl,
+                                       const detail::fiber_weight& option,
+                                       boost::system::error_code& ec) {
+    impl->weight = option.value();
+    ec = boost::system::error_code();
+    return ec;
+  }
+
+  /// Get the weight inherited by the accepted fibers.
+  boost::system::error_code get_option(const implementation_type& impl,
+                                       detail::fiber_weight& option,
+                                       boost::system::error_code& ec) const {
+    option = detail::fiber_weight(impl->weight);
+    ec = boost::system::error_code();
+    return ec;
+  }
+
   /// Get the local endpoint.
   endpoint_type local_endpoint(const implementation_type& impl,
                                boost::system::error_code& ec) const {
@@ -186,6 +205,7 @@ class fiber_acceptor_service
     auto fiber_impl = peer.native_handle();
     fiber_impl->p_fib_demux = impl->p_fib_demux;
     fiber_impl->id.set_local_port(impl->id.local_port());
+    fiber_impl->weight = impl->weight;
 
     SSF_LOG("fiber_acceptor", debug, "local port set {}",
             impl->id.local_port());
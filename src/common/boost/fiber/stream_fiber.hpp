@@ -28,6 +28,7 @@
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 #include "common/boost/fiber/stream_fiber_service.hpp"
 #include "common/boost/fiber/fiber_acceptor_service.hpp"
+#include "common/boost/fiber/detail/fiber_weight.hpp"
 
 namespace boost {
 namespace asio {
@@ -84,6 +85,9 @@ public:
     stream_fiber, boost::asio::fiber::fiber_acceptor_service<
       stream_fiber<Socket>>> acceptor;
 
+  /// Socket option for the weight of a stream fiber on its demultiplexer.
+  typedef boost::asio::fiber::detail::fiber_weight weight;
+
   /// Compare two protocols for equality.
   friend bool operator==(const stream_fiber& p1, const stream_fiber& p2)
   {
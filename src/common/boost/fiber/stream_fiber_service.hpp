@@ -31,6 +31,7 @@
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 #include "common/boost/fiber/detail/basic_fiber_impl.hpp"
 #include "common/boost/fiber/detail/fiber_id.hpp"
+#include "common/boost/fiber/detail/fiber_weight.hpp"
 
 #include <boost/asio/detail/push_options.hpp>
 
@@ -190,6 +191,24 @@ class stream_fiber_service
   /// Get the native socket implementation.
   native_handle_type native_handle(implementation_type& impl) { return impl; }
 
+  /// Set the weight of the fiber on its demultiplexer.
+  boost::system::error_code set_option(implementation_type& impl,
+                                       const detail::fiber_weight& option,
+                                       boost::system::error_code& ec) {
+    impl->weight = option.value();
+    ec = boost::system::error_code();
+    return ec;
+  }
+
+  /// Get the weight of the fiber on its demultiplexer.
+  boost::system::error_code get_option(const implementation_type& impl,
+                                       detail::fiber_weight& option,
+                                       boost::system::error_code& ec) const {
+    option = detail::fiber_weight(impl->weight);
+    ec = boost::system::error_code();
+    return ec;
+  }
+
   /// Start an asynchronous send.
   template <typename ConstBufferSequence, typename WriteHandler>
   BOOST_ASIO_INITFN_RESULT_TYPE(WriteHandler,
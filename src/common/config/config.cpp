@@ -80,6 +80,8 @@ void Config::Log() const {
   socks_proxy_.Log();
   services_.Log();
   circuit_.Log();
+  logging_.Log();
+  metrics_.Log();
 }
 
 void Config::LogStatus() const { services_.LogServiceStatus(); }
@@ -107,6 +109,8 @@ void Config::UpdateFromJson(const Json& json) {
   UpdateSocksProxy(ssf_config);
   UpdateServices(ssf_config);
   UpdateCircuit(ssf_config);
+  UpdateLogging(ssf_config);
+  UpdateMetrics(ssf_config);
   UpdateArguments(ssf_config);
 }
 
@@ -155,6 +159,24 @@ void Config::UpdateCircuit(const Json& json) {
   circuit_.Update(json.at("circuit"));
 }
 
+void Config::UpdateLogging(const Json& json) {
+  if (json.count("logging") == 0) {
+    SSF_LOG("config", debug, "update logging: configuration not found");
+    return;
+  }
+
+  logging_.Update(json.at("logging"));
+}
+
+void Config::UpdateMetrics(const Json& json) {
+  if (json.count("metrics") == 0) {
+    SSF_LOG("config", debug, "update metrics: configuration not found");
+    return;
+  }
+
+  metrics_.Update(json.at("metrics"));
+}
+
 void Config::UpdateArguments(const Json& json) {
   if (json.count("arguments") == 0) {
     SSF_LOG("config", debug, "update arguments: configuration not found");
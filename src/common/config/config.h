@@ -9,6 +9,8 @@
 #include <json.hpp>
 
 #include "common/config/circuit.h"
+#include "common/config/logging.h"
+#include "common/config/metrics.h"
 #include "common/config/proxy.h"
 #include "common/config/services.h"
 #include "common/config/tls.h"
@@ -73,6 +75,17 @@ class Config {
    *       "socks": { "enable": true }
    *     },
    *     "circuit": [],
+   *     "logging": {
+   *       "async": false,
+   *       "queue_size": 8192,
+   *       "overflow_policy": "drop"
+   *     },
+   *     "metrics": {
+   *       "file": "",
+   *       "period": 10,
+   *       "remote": false,
+   *       "serve": false
+   *     },
    *     "arguments": ""
    *   }
    * }
@@ -121,6 +134,12 @@ class Config {
   const Circuit& circuit() const { return circuit_; }
   Circuit& circuit() { return circuit_; }
 
+  const Logging& logging() const { return logging_; }
+  Logging& logging() { return logging_; }
+
+  const Metrics& metrics() const { return metrics_; }
+  Metrics& metrics() { return metrics_; }
+
   uint32_t GetArgc() const { return static_cast<uint32_t>(argv_.size()); };
   std::vector<char*> GetArgv() const;
 
@@ -131,6 +150,8 @@ class Config {
   void UpdateSocksProxy(const Json& json);
   void UpdateServices(const Json& json);
   void UpdateCircuit(const Json& json);
+  void UpdateLogging(const Json& json);
+  void UpdateMetrics(const Json& json);
   void UpdateArguments(const Json& json);
 
  private:
@@ -140,6 +161,8 @@ class Config {
   SocksProxy socks_proxy_;
   Services services_;
   Circuit circuit_;
+  Logging logging_;
+  Metrics metrics_;
   std::list<std::string> argv_;
 };
 
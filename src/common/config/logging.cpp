@@ -0,0 +1,55 @@
+#include "common/config/logging.h"
+
+#include <string>
+
+#include <boost/algorithm/string.hpp>
+
+namespace ssf {
+namespace config {
+
+Logging::Logging()
+    : async_(false),
+      queue_size_(8192),
+      overflow_policy_(ssf::log::OverflowPolicy::kDrop) {}
+
+void Logging::Update(const Json& logging_prop) {
+  if (logging_prop.count("async") == 1) {
+    async_ = logging_prop.at("async").get<bool>();
+  }
+
+  if (logging_prop.count("queue_size") == 1) {
+    auto queue_size = logging_prop.at("queue_size").get<uint32_t>();
+    if (queue_size > 0) {
+      queue_size_ = queue_size;
+    } else {
+      SSF_LOG("config", warn, "[logging] invalid queue size, keep {}",
+              queue_size_);
+    }
+  }
+
+  if (logging_prop.count("overflow_policy") == 1) {
+    auto policy = logging_prop.at("overflow_policy").get<std::string>();
+    boost::trim(policy);
+    if (policy == "drop") {
+      overflow_policy_ = ssf::log::OverflowPolicy::kDrop;
+    } else if (policy == "block") {
+      overflow_policy_ = ssf::log::OverflowPolicy::kBlock;
+    } else {
+      SSF_LOG("config", warn, "[logging] unknown overflow policy <{}>",
+              policy);
+    }
+  }
+}
+
+void Logging::Log() const {
+  SSF_LOG("config", info, "[logging] async: <{}>", async_ ? "true" : "false");
+  if (async_) {
+    SSF_LOG("config", info, "[logging] queue size: <{}>", queue_size_);
+    SSF_LOG("config", info, "[logging] overflow policy: <{}>",
+            overflow_policy_ == ssf::log::OverflowPolicy::kDrop ? "drop"
+                                                                : "block");
+  }
+}
+
+}  // config
+}  // ssf
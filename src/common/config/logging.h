@@ -0,0 +1,41 @@
+#ifndef SSF_COMMON_CONFIG_LOGGING_H_
+#define SSF_COMMON_CONFIG_LOGGING_H_
+
+#include <cstdint>
+
+#include <json.hpp>
+
+#include <ssf/log/log.h>
+
+namespace ssf {
+namespace config {
+
+class Logging {
+ public:
+  using Json = nlohmann::json;
+
+ public:
+  Logging();
+
+ public:
+  void Update(const Json& json);
+
+  void Log() const;
+
+  bool async() const { return async_; }
+  uint32_t queue_size() const { return queue_size_; }
+  ssf::log::OverflowPolicy overflow_policy() const { return overflow_policy_; }
+
+ private:
+  // Write logs from a dedicated thread
+  bool async_;
+  // Asynchronous queue size in messages
+  uint32_t queue_size_;
+  // Drop messages or block the logging thread when the queue is full
+  ssf::log::OverflowPolicy overflow_policy_;
+};
+
+}  // config
+}  // ssf
+
+#endif  // SSF_COMMON_CONFIG_LOGGING_H_
@@ -0,0 +1,47 @@
+#include "common/config/metrics.h"
+
+#include <ssf/log/log.h>
+
+namespace ssf {
+namespace config {
+
+Metrics::Metrics() : file_(""), period_(10), remote_(false), serve_(false) {}
+
+void Metrics::Update(const Json& metrics_prop) {
+  if (metrics_prop.count("file") == 1) {
+    file_ = metrics_prop.at("file").get<std::string>();
+  }
+
+  if (metrics_prop.count("period") == 1) {
+    auto period = metrics_prop.at("period").get<uint32_t>();
+    if (period > 0) {
+      period_ = period;
+    } else {
+      SSF_LOG("config", warn, "[metrics] invalid period, keep {}", period_);
+    }
+  }
+
+  if (metrics_prop.count("remote") == 1) {
+    remote_ = metrics_prop.at("remote").get<bool>();
+  }
+
+  if (metrics_prop.count("serve") == 1) {
+    serve_ = metrics_prop.at("serve").get<bool>();
+  }
+}
+
+void Metrics::Log() const {
+  SSF_LOG("config", info, "[metrics] serve: <{}>", serve_ ? "true" : "false");
+
+  if (file_.empty()) {
+    SSF_LOG("config", info, "[metrics] export: <disabled>");
+    return;
+  }
+
+  SSF_LOG("config", info, "[metrics] file: <{}>", file_);
+  SSF_LOG("config", info, "[metrics] period: <{}s>", period_);
+  SSF_LOG("config", info, "[metrics] remote: <{}>", remote_ ? "true" : "false");
+}
+
+}  // config
+}  // ssf
@@ -0,0 +1,45 @@
+#ifndef SSF_COMMON_CONFIG_METRICS_H_
+#define SSF_COMMON_CONFIG_METRICS_H_
+
+#include <cstdint>
+
+#include <string>
+
+#include <json.hpp>
+
+namespace ssf {
+namespace config {
+
+class Metrics {
+ public:
+  using Json = nlohmann::json;
+
+ public:
+  Metrics();
+
+ public:
+  void Update(const Json& json);
+
+  void Log() const;
+
+  bool enabled() const { return !file_.empty(); }
+  const std::string& file() const { return file_; }
+  uint32_t period() const { return period_; }
+  bool remote() const { return remote_; }
+  bool serve() const { return serve_; }
+
+ private:
+  // JSON lines file the metrics are appended to (empty: no export)
+  std::string file_;
+  // Time between two exports in seconds
+  uint32_t period_;
+  // Also export the metrics of the server (client only)
+  bool remote_;
+  // Answer the metrics requests of the clients (server only)
+  bool serve_;
+};
+
+}  // config
+}  // ssf
+
+#endif  // SSF_COMMON_CONFIG_METRICS_H_
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <limits>
+
 #include <boost/algorithm/string.hpp>
 
 #include <ssf/log/log.h>
@@ -90,6 +93,9 @@ void Services::UpdateDatagramForwarder(const Json& json) {
 
   datagram_forwarder_.set_enabled(IsServiceEnabled(
       json.at("datagram_forwarder"), datagram_forwarder_.enabled()));
+  UpdateFiberWeight(json.at("datagram_forwarder"), &datagram_forwarder_);
+  datagram_forwarder_.set_flow_limits(UpdateFlowLimits(
+      json.at("datagram_forwarder"), datagram_forwarder_.flow_limits()));
 }
 
 void Services::UpdateDatagramListener(const Json& json) {
@@ -103,6 +109,9 @@ void Services::UpdateDatagramListener(const Json& json) {
 
   datagram_listener_.set_enabled(
       IsServiceEnabled(datagram_listener_prop, datagram_listener_.enabled()));
+  UpdateFiberWeight(datagram_listener_prop, &datagram_listener_);
+  datagram_listener_.set_flow_limits(UpdateFlowLimits(
+      datagram_listener_prop, datagram_listener_.flow_limits()));
 
   if (datagram_listener_prop.count("gateway_ports") == 1) {
     datagram_listener_.set_gateway_ports(
@@ -117,6 +126,7 @@ void Services::UpdateCopy(const Json& json) {
   }
 
   copy_.set_enabled(IsServiceEnabled(json.at("copy"), copy_.enabled()));
+  UpdateFiberWeight(json.at("copy"), &copy_);
 }
 
 void Services::UpdateShell(const Json& json) {
@@ -127,6 +137,7 @@ void Services::UpdateShell(const Json& json) {
 
   auto& shell_prop = json.at("shell");
   shell_.set_enabled(IsServiceEnabled(shell_prop, shell_.enabled()));
+  UpdateFiberWeight(shell_prop, &shell_);
 
   if (shell_prop.count("path") == 1) {
     std::string shell_path(shell_prop.at("path").get<std::string>());
@@ -148,6 +159,8 @@ void Services::UpdateSocks(const Json& json) {
   }
 
   socks_.set_enabled(IsServiceEnabled(json.at("socks"), socks_.enabled()));
+  UpdateFiberWeight(json.at("socks"), &socks_);
+  UpdateBufferLimits(json.at("socks"), &socks_);
 }
 
 void Services::UpdateStreamForwarder(const Json& json) {
@@ -159,6 +172,8 @@ void Services::UpdateStreamForwarder(const Json& json) {
 
   stream_forwarder_.set_enabled(IsServiceEnabled(json.at("stream_forwarder"),
                                                  stream_forwarder_.enabled()));
+  UpdateFiberWeight(json.at("stream_forwarder"), &stream_forwarder_);
+  UpdateBufferLimits(json.at("stream_forwarder"), &stream_forwarder_);
 }
 
 void Services::UpdateStreamListener(const Json& json) {
@@ -172,6 +187,8 @@ void Services::UpdateStreamListener(const Json& json) {
 
   stream_listener_.set_enabled(
       IsServiceEnabled(stream_listener_prop, stream_listener_.enabled()));
+  UpdateFiberWeight(stream_listener_prop, &stream_listener_);
+  UpdateBufferLimits(stream_listener_prop, &stream_listener_);
 
   if (stream_listener_prop.count("gateway_ports") == 1) {
     stream_listener_.set_gateway_ports(
@@ -187,5 +204,85 @@ bool Services::IsServiceEnabled(const Json& service_json, bool default_value) {
   }
 }
 
+void Services::UpdateBufferLimits(const Json& service_json,
+                                  BaseServiceConfig* p_config) {
+  auto limits = p_config->buffer_limits();
+  if (service_json.count("min_buffer_size") == 1) {
+    limits.min_size = service_json.at("min_buffer_size").get<uint32_t>();
+  }
+  if (service_json.count("max_buffer_size") == 1) {
+    limits.max_size = service_json.at("max_buffer_size").get<uint32_t>();
+  }
+
+  if (limits.min_size == 0 || limits.min_size > limits.max_size) {
+    SSF_LOG("config", warn,
+            "[microservices] invalid buffer sizes {}-{}, keep {}-{}",
+            limits.min_size, limits.max_size,
+            p_config->buffer_limits().min_size,
+            p_config->buffer_limits().max_size);
+    return;
+  }
+
+  p_config->set_buffer_limits(limits);
+}
+
+FlowLimits Services::UpdateFlowLimits(const Json& service_json,
+                                      const FlowLimits& flow_limits) {
+  auto limits = flow_limits;
+  if (service_json.count("max_flows") == 1) {
+    limits.max_flows = service_json.at("max_flows").get<uint32_t>();
+  }
+  if (service_json.count("flow_timeout") == 1) {
+    limits.idle_timeout =
+        std::chrono::seconds(service_json.at("flow_timeout").get<uint32_t>());
+  }
+  if (service_json.count("queue_size") == 1) {
+    limits.queue_size = service_json.at("queue_size").get<uint32_t>();
+  }
+  if (service_json.count("queue_overflow") == 1) {
+    auto policy = service_json.at("queue_overflow").get<std::string>();
+    if (policy == "drop_newest") {
+      limits.overflow_policy = QueueOverflowPolicy::kDropNewest;
+    } else if (policy == "drop_oldest") {
+      limits.overflow_policy = QueueOverflowPolicy::kDropOldest;
+    } else {
+      SSF_LOG("config", warn,
+              "[microservices] invalid queue overflow policy <{}> (expected "
+              "drop_newest or drop_oldest)",
+              policy);
+    }
+  }
+
+  if (limits.max_flows == 0 || limits.idle_timeout.count() == 0 ||
+      limits.queue_size == 0) {
+    SSF_LOG("config", warn,
+            "[microservices] invalid flow limits {} flows/{}s/{} datagrams, "
+            "keep {} flows/{}s/{} datagrams",
+            limits.max_flows, limits.idle_timeout.count(), limits.queue_size,
+            flow_limits.max_flows, flow_limits.idle_timeout.count(),
+            flow_limits.queue_size);
+    return flow_limits;
+  }
+
+  return limits;
+}
+
+void Services::UpdateFiberWeight(const Json& service_json,
+                                 BaseServiceConfig* p_config) {
+  if (service_json.count("weight") == 0) {
+    return;
+  }
+
+  auto weight = service_json.at("weight").get<int>();
+  if (weight < 1 || weight > std::numeric_limits<uint8_t>::max()) {
+    SSF_LOG("config", warn,
+            "[microservices] invalid weight {} (expected between 1 and {})",
+            weight, std::numeric_limits<uint8_t>::max());
+    return;
+  }
+
+  p_config->set_fiber_weight(static_cast<uint8_t>(weight));
+}
+
 }  // config
 }  // ssf
\ No newline at end of file
@@ -93,6 +93,13 @@ class Services {
 
   static bool IsServiceEnabled(const Json& service, bool default_value);
 
+  static void UpdateBufferLimits(const Json& service,
+                                 BaseServiceConfig* p_config);
+  static FlowLimits UpdateFlowLimits(const Json& service,
+                                     const FlowLimits& flow_limits);
+  static void UpdateFiberWeight(const Json& service,
+                                BaseServiceConfig* p_config);
+
  private:
   DatagramForwarderConfig datagram_forwarder_;
   DatagramListenerConfig datagram_listener_;
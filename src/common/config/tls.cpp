@@ -42,7 +42,15 @@ Tls::Tls()
       key_(TlsParam::Type::kFile, "./certs/private.key"),
       key_password_(""),
       dh_(TlsParam::Type::kFile, "./certs/dh4096.pem"),
-      cipher_alg_("DHE-RSA-AES256-GCM-SHA384") {}
+      cipher_alg_("DHE-RSA-AES256-GCM-SHA384"),
+      session_resumption_(false),
+      session_lifetime_(3600),
+      direct_read_(false),
+      direct_read_threshold_(4 * 1024),
+      receive_buffer_size_(50 * 1024),
+      receive_queue_low_bound_(1 * 1024 * 1024),
+      receive_queue_high_bound_(16 * 1024 * 1024),
+      kernel_tls_(false) {}
 
 void Tls::Update(const Json& tls_prop) {
   // ca cert
@@ -105,6 +113,55 @@ void Tls::Update(const Json& tls_prop) {
     cipher_alg_ = tls_prop.at("cipher_alg").get<std::string>();
     boost::trim(cipher_alg_);
   }
+
+  // session resumption
+  if (tls_prop.count("session_resumption") == 1) {
+    session_resumption_ = tls_prop.at("session_resumption").get<bool>();
+  }
+  if (tls_prop.count("session_lifetime") == 1) {
+    auto session_lifetime = tls_prop.at("session_lifetime").get<uint32_t>();
+    if (session_lifetime > 0) {
+      session_lifetime_ = session_lifetime;
+    } else {
+      SSF_LOG("config", warn,
+              "[tls] invalid session lifetime, keep {} seconds",
+              session_lifetime_);
+    }
+  }
+
+  // receive buffering
+  if (tls_prop.count("direct_read") == 1) {
+    direct_read_ = tls_prop.at("direct_read").get<bool>();
+  }
+  UpdateSize(tls_prop, "direct_read_threshold", &direct_read_threshold_);
+  UpdateSize(tls_prop, "receive_buffer_size", &receive_buffer_size_);
+  UpdateSize(tls_prop, "receive_queue_low_bound", &receive_queue_low_bound_);
+  UpdateSize(tls_prop, "receive_queue_high_bound", &receive_queue_high_bound_);
+  if (receive_queue_low_bound_ > receive_queue_high_bound_) {
+    SSF_LOG("config", warn,
+            "[tls] receive queue low bound above high bound, use high bound");
+    receive_queue_low_bound_ = receive_queue_high_bound_;
+  }
+
+  // kernel TLS
+  if (tls_prop.count("kernel_tls") == 1) {
+    kernel_tls_ = tls_prop.at("kernel_tls").get<bool>();
+  }
+}
+
+void Tls::UpdateSize(const Json& tls_prop, const std::string& key,
+                     uint32_t* p_size) {
+  if (tls_prop.count(key) == 0) {
+    return;
+  }
+
+  auto size = tls_prop.at(key).get<uint32_t>();
+  if (size == 0) {
+    SSF_LOG("config", warn, "[tls] invalid {}, keep {}", key, *p_size);
+    return;
+  }
+
+  *p_size = size;
 }
 
 void Tls::Log() const {
@@ -115,6 +172,21 @@ void Tls::Log() const {
   SSF_LOG("config", info, "[tls] key password: <{}>", key_password_);
   SSF_LOG("config", info, "[tls] dh path: <{}>", dh_.ToString());
   SSF_LOG("config", info, "[tls] cipher suite: <{}>", cipher_alg_);
+  SSF_LOG("config", info, "[tls] session resumption: <{}>",
+          session_resumption_ ? "true" : "false");
+  if (session_resumption_) {
+    SSF_LOG("config", info, "[tls] session lifetime: <{}s>", session_lifetime_);
+  }
+  SSF_LOG("config", debug, "[tls] direct read: <{}>",
+          direct_read_ ? "true" : "false");
+  SSF_LOG("config", debug, "[tls] direct read threshold: <{}>",
+          direct_read_threshold_);
+  SSF_LOG("config", debug, "[tls] receive buffer size: <{}>",
+          receive_buffer_size_);
+  SSF_LOG("config", debug, "[tls] receive queue bounds: <{}, {}>",
+          receive_queue_low_bound_, receive_queue_high_bound_);
+  SSF_LOG("config", debug, "[tls] kernel TLS: <{}>",
+          kernel_tls_ ? "true" : "false");
 #endif
 }
 
@@ -1,6 +1,7 @@
 #ifndef SSF_COMMON_CONFIG_TLS_H_
 #define SSF_COMMON_CONFIG_TLS_H_
 
+#include <cstdint>
 #include <string>
 
 #include <json.hpp>
@@ -46,6 +47,20 @@ class Tls {
   const TlsParam& dh() const { return dh_; }
   TlsParam* mutable_dh() { return &dh_; }
   const std::string& cipher_alg() const { return cipher_alg_; }
+  bool session_resumption() const { return session_resumption_; }
+  uint32_t session_lifetime() const { return session_lifetime_; }
+  bool direct_read() const { return direct_read_; }
+  uint32_t direct_read_threshold() const { return direct_read_threshold_; }
+  uint32_t receive_buffer_size() const { return receive_buffer_size_; }
+  uint32_t receive_queue_low_bound() const { return receive_queue_low_bound_; }
+  uint32_t receive_queue_high_bound() const {
+    return receive_queue_high_bound_;
+  }
+  bool kernel_tls() const { return kernel_tls_; }
+
+ private:
+  void UpdateSize(const Json& tls_prop, const std::string& key,
+                  uint32_t* p_size);
 
  private:
   // CA certificate
@@ -60,6 +75,21 @@ class Tls {
   TlsParam dh_;
   // Cipher suite algorithms
   std::string cipher_alg_;
+  // Session resumption (tickets and session cache)
+  bool session_resumption_;
+  // Session (and ticket key) lifetime in seconds
+  uint32_t session_lifetime_;
+  // Decrypt received data directly into the reader buffers
+  bool direct_read_;
+  // Smaller reads go through the receive queue
+  uint32_t direct_read_threshold_;
+  // Size of the buffered reads
+  uint32_t receive_buffer_size_;
+  // Received data queue bounds (resume and pause reading)
+  uint32_t receive_queue_low_bound_;
+  uint32_t receive_queue_high_bound_;
+  // Let the kernel encrypt the sent records (Linux kTLS)
+  bool kernel_tls_;
 };
 
 }  // config
@@ -0,0 +1,144 @@
+#ifndef SSF_COMMON_CRYPTO_HASH_MANIFEST_H_
+#define SSF_COMMON_CRYPTO_HASH_MANIFEST_H_
+
+#include <cstdint>
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include <boost/system/error_code.hpp>
+
+#include "common/filesystem/path.h"
+
+namespace ssf {
+namespace crypto {
+
+/// Digests of the consecutive chunks of a file
+/**
+* The file is cut in chunks of kChunkSize bytes (the last one may be shorter)
+* hashed independently: chunks can be hashed in parallel or while they are
+* transferred, and two files can be compared chunk by chunk. The root digest
+* (digest of the chunk digests) identifies the whole file.
+*/
+template <class Hash>
+class HashManifest {
+ public:
+  using Digest = typename Hash::Digest;
+  using Digests = std::vector<Digest>;
+
+  enum : uint64_t { kChunkSize = 1024 * 1024 };
+
+ public:
+  /// Number of chunks of a file of size bytes
+  static uint64_t ChunkCount(uint64_t size) {
+    return (size + kChunkSize - 1) / kChunkSize;
+  }
+
+  static Digest HashChunk(const char* p_data, std::size_t size) {
+    Digest digest;
+    Hash hash;
+    hash.Update(DataView{p_data}, size);
+    hash.Finalize(&digest);
+    return digest;
+  }
+
+  /// Hash the chunks [first, last) of a file
+  /**
+  * The last chunk of the file is hashed as it is if it is short. No digest is
+  * returned for chunks after the end of the file.
+  */
+  static Digests HashFileChunks(const ssf::Path& path, uint64_t first,
+                                uint64_t last, boost::system::error_code& ec) {
+    std::ifstream file(path.GetString(),
+                       std::ifstream::binary | std::ifstream::in);
+    if (!file.is_open()) {
+      ec.assign(boost::system::errc::bad_file_descriptor,
+                boost::system::system_category());
+      return {};
+    }
+
+    Digests digests;
+    std::vector<char> buffer(static_cast<std::size_t>(kChunkSize));
+    file.seekg(first * kChunkSize, std::ifstream::beg);
+    for (uint64_t chunk = first; chunk < last && file.good(); ++chunk) {
+      file.read(buffer.data(), buffer.size());
+      auto size = static_cast<std::size_t>(file.gcount());
+      if (file.bad()) {
+        ec.assign(boost::system::errc::io_error,
+                  boost::system::system_category());
+        return {};
+      }
+      if (size == 0) {
+        break;
+      }
+      digests.push_back(HashChunk(buffer.data(), size));
+    }
+
+    ec.assign(0, boost::system::system_category());
+    return digests;
+  }
+
+ public:
+  HashManifest() : digests_() {}
+  explicit HashManifest(Digests digests) : digests_(std::move(digests)) {}
+
+  /// Number of chunks
+  std::size_t size() const { return digests_.size(); }
+
+  const Digests& digests() const { return digests_; }
+
+  const Digest& operator[](std::size_t i) const { return digests_[i]; }
+
+  void Append(const Digests& digests) {
+    digests_.insert(digests_.end(), digests.begin(), digests.end());
+  }
+
+  /// Keep the first chunks only
+  void Truncate(std::size_t size) {
+    digests_.resize(std::min(size, digests_.size()));
+  }
+
+  void Clear() { digests_.clear(); }
+
+  /// Digest of the whole file
+  Digest Root() const { return Combine(0, digests_.size()); }
+
+  /// Digests of the groups of group_size consecutive chunks
+  /**
+  * Compares large files with few digests. The last group may be shorter.
+  */
+  Digests GroupDigests(std::size_t group_size) const {
+    group_size = std::max<std::size_t>(group_size, 1);
+    Digests groups;
+    for (std::size_t first = 0; first < digests_.size(); first += group_size) {
+      groups.push_back(Combine(
+          first, std::min(first + group_size, digests_.size()) - first));
+    }
+    return groups;
+  }
+
+ private:
+  struct DataView {
+    const char* p_data;
+    const char* data() const { return p_data; }
+  };
+
+  Digest Combine(std::size_t first, std::size_t count) const {
+    Digest digest;
+    Hash hash;
+    for (std::size_t i = first; i < first + count; ++i) {
+      hash.Update(digests_[i], digests_[i].size());
+    }
+    hash.Finalize(&digest);
+    return digest;
+  }
+
+ private:
+  Digests digests_;
+};
+
+}  // crypto
+}  // ssf
+
+#endif  // SSF_COMMON_CRYPTO_HASH_MANIFEST_H_
@@ -32,6 +32,11 @@ uint64_t Filesystem::GetFilesize(const Path& path,
   return boost::filesystem::file_size(path.GetString(), ec);
 }
 
+void Filesystem::ResizeFile(const Path& path, uint64_t size,
+                            boost::system::error_code& ec) const {
+  boost::filesystem::resize_file(path.GetString(), size, ec);
+}
+
 bool Filesystem::MakeDirectory(const Path& path,
                                boost::system::error_code& ec) const {
   return boost::filesystem::create_directory(path.GetString(), ec);
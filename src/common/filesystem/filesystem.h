@@ -22,6 +22,9 @@ class Filesystem {
 
   uint64_t GetFilesize(const Path& path, boost::system::error_code& ec) const;
 
+  void ResizeFile(const Path& path, uint64_t size,
+                  boost::system::error_code& ec) const;
+
   bool MakeDirectory(const Path& path, boost::system::error_code& ec) const;
 
   bool MakeDirectories(const Path& path, boost::system::error_code& ec) const;
@@ -1,36 +1,82 @@
 #include <cstdint>
 #include <thread>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
 #include "core/async_engine.h"
 
 #include "ssf/log/log.h"
 
 namespace ssf {
 
-AsyncEngine::AsyncEngine()
-    : io_service_(), p_worker_(nullptr), threads_(), is_started_(false) {}
+AsyncEngine::AsyncEngine(Mode mode)
+    : mode_(mode),
+      cores_(AllowedCores()),
+      io_services_(),
+      p_workers_(),
+      threads_(),
+      next_io_service_(0),
+      is_started_(false) {
+  io_services_.emplace_back(new boost::asio::io_service());
+  if (mode_ == Mode::kPerCore) {
+    for (std::size_t i = 0; i < cores_.size(); ++i) {
+      // concurrency hint of 1: the io_service is run by a single thread
+      io_services_.emplace_back(new boost::asio::io_service(1));
+    }
+  }
+}
 
 AsyncEngine::~AsyncEngine() { Stop(); }
 
-boost::asio::io_service& AsyncEngine::get_io_service() { return io_service_; }
+boost::asio::io_service& AsyncEngine::get_io_service() {
+  return *io_services_.front();
+}
+
+boost::asio::io_service& AsyncEngine::GetNextIoService() {
+  if (io_services_.size() == 1) {
+    return *io_services_.front();
+  }
+
+  // Skip the main io_service
+  auto index = 1 + next_io_service_.fetch_add(1) % (io_services_.size() - 1);
+  return *io_services_[index];
+}
 
 void AsyncEngine::Start() {
   if (is_started_) {
     return;
   }
 
-  SSF_LOG("async_engine", debug, "starting");
+  SSF_LOG("async_engine", debug, "starting ({} io_service(s), {} thread(s))",
+          io_services_.size(), ThreadCount());
   is_started_ = true;
-  p_worker_.reset(new boost::asio::io_service::work(io_service_));
-  for (uint8_t i = 0; i < std::thread::hardware_concurrency(); ++i) {
-    threads_.emplace_back([this]() {
-      boost::system::error_code ec;
-      io_service_.run(ec);
-      if (ec) {
-        SSF_LOG("async_engine", error, "run io_service failed: {}",
-                ec.message());
-      }
-    });
+  for (auto& p_io_service : io_services_) {
+    p_workers_.emplace_back(new boost::asio::io_service::work(*p_io_service));
+  }
+
+  if (mode_ == Mode::kPerCore) {
+    auto& main_io_service = *io_services_.front();
+    threads_.emplace_back(
+        [this, &main_io_service]() { RunIoService(main_io_service); });
+    for (std::size_t i = 1; i < io_services_.size(); ++i) {
+      auto& io_service = *io_services_[i];
+      auto core = cores_[i - 1];
+      threads_.emplace_back([this, core, &io_service]() {
+        PinCurrentThread(core);
+        RunIoService(io_service);
+      });
+    }
+  } else {
+    auto& io_service = *io_services_.front();
+    for (std::size_t i = 0; i < ThreadCount(); ++i) {
+      threads_.emplace_back(
+          [this, &io_service]() { RunIoService(io_service); });
+    }
   }
 }
 
@@ -40,17 +86,87 @@ void AsyncEngine::Stop() {
   }
 
   SSF_LOG("async_engine", debug, "stop");
-  p_worker_.reset(nullptr);
+  p_workers_.clear();
   for (auto& thread : threads_) {
     if (thread.joinable()) {
       thread.join();
     }
   }
-  io_service_.stop();
-  io_service_.reset();
+  threads_.clear();
+  for (auto& p_io_service : io_services_) {
+    p_io_service->stop();
+    p_io_service->reset();
+  }
   is_started_ = false;
 }
 
 bool AsyncEngine::IsStarted() const { return is_started_; }
 
+std::size_t AsyncEngine::ThreadCount() const { return cores_.size(); }
+
+std::vector<std::size_t> AsyncEngine::AllowedCores() {
+  std::vector<std::size_t> cores;
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    for (std::size_t core = 0; core < CPU_SETSIZE; ++core) {
+      if (CPU_ISSET(core, &cpu_set)) {
+        cores.push_back(core);
+      }
+    }
+  }
+#elif defined(_WIN32)
+  DWORD_PTR process_mask = 0;
+  DWORD_PTR system_mask = 0;
+  if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask,
+                             &system_mask)) {
+    for (std::size_t core = 0; core < sizeof(DWORD_PTR) * 8; ++core) {
+      if (process_mask & (static_cast<DWORD_PTR>(1) << core)) {
+        cores.push_back(core);
+      }
+    }
+  }
+#endif
+
+  if (cores.empty()) {
+    // Unknown affinity: one core per hardware thread
+    auto count = std::thread::hardware_concurrency();
+    for (std::size_t core = 0; core < (count ? count : 1); ++core) {
+      cores.push_back(core);
+    }
+  }
+
+  return cores;
+}
+
+void AsyncEngine::PinCurrentThread(std::size_t core) {
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(core, &cpu_set);
+  int result =
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (result != 0) {
+    SSF_LOG("async_engine", debug, "could not pin thread to core {}", core);
+  }
+#elif defined(_WIN32)
+  if (core < sizeof(DWORD_PTR) * 8 &&
+      !SetThreadAffinityMask(GetCurrentThread(),
+                             static_cast<DWORD_PTR>(1) << core)) {
+    SSF_LOG("async_engine", debug, "could not pin thread to core {}", core);
+  }
+#else
+  (void)core;
+#endif
+}
+
+void AsyncEngine::RunIoService(boost::asio::io_service& io_service) {
+  boost::system::error_code ec;
+  io_service.run(ec);
+  if (ec) {
+    SSF_LOG("async_engine", error, "run io_service failed: {}", ec.message());
+  }
+}
+
 }  // ssf
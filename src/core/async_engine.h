@@ -1,6 +1,8 @@
 #ifndef SSF_CORE_ASYNC_ENGINE_H_
 #define SSF_CORE_ASYNC_ENGINE_H_
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <thread>
 #include <vector>
@@ -10,27 +12,59 @@
 namespace ssf {
 
 class AsyncEngine {
+ public:
+  enum class Mode {
+    // all the worker threads run the same io_service
+    kShared,
+    // one io_service per worker thread, each thread pinned to one of the
+    // cores allowed to the process. The main io_service (acceptor,
+    // resolutions) has its own thread.
+    kPerCore
+  };
+
  private:
+  using IoServicePtr = std::unique_ptr<boost::asio::io_service>;
   using WorkerPtr = std::unique_ptr<boost::asio::io_service::work>;
 
  public:
-  AsyncEngine();
+  explicit AsyncEngine(Mode mode = Mode::kShared);
   ~AsyncEngine();
 
   AsyncEngine(const AsyncEngine&) = delete;
   AsyncEngine& operator=(const AsyncEngine&) = delete;
 
+  // Main io_service (the only one in shared mode)
   boost::asio::io_service& get_io_service();
 
+  // Pick an io_service in a round robin way. In per core mode, it is a worker
+  // io_service: everything bound to it runs on a single pinned thread.
+  boost::asio::io_service& GetNextIoService();
+
+  std::size_t io_service_count() const { return io_services_.size(); }
+
+  // Cores the process may run on
+  static std::vector<std::size_t> AllowedCores();
+
+  Mode mode() const { return mode_; }
+
   void Start();
   void Stop();
 
   bool IsStarted() const;
 
  private:
-  boost::asio::io_service io_service_;
-  WorkerPtr p_worker_;
+  std::size_t ThreadCount() const;
+  static void PinCurrentThread(std::size_t core);
+
+  void RunIoService(boost::asio::io_service& io_service);
+
+ private:
+  Mode mode_;
+  std::vector<std::size_t> cores_;
+  std::vector<IoServicePtr> io_services_;
+  std::vector<WorkerPtr> p_workers_;
   std::vector<std::thread> threads_;
+  std::atomic<std::size_t> next_io_service_;
   bool is_started_;
 };
 
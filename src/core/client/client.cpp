@@ -12,6 +12,7 @@ Client::Client()
     : async_engine_(),
       connection_attempts_(1),
       max_connection_attempts_(1),
+      links_(1),
       reconnection_timeout_(0),
       timer_(async_engine_.get_io_service()),
       stopped_(false) {}
@@ -24,7 +25,7 @@ Client::~Client() {
 void Client::Init(const NetworkQuery& network_query,
                   uint32_t max_connection_attempts,
                   uint32_t reconnection_timeout, bool no_reconnection,
-                  UserServiceParameters user_service_params,
+                  uint32_t links, UserServiceParameters user_service_params,
                   const ssf::config::Services& user_services_config,
                   OnStatusCb on_status,
                   OnUserServiceStatusCb on_user_service_status,
@@ -39,6 +40,7 @@ void Client::Init(const NetworkQuery& network_query,
   max_connection_attempts_ = max_connection_attempts;
   reconnection_timeout_ = std::chrono::seconds(reconnection_timeout);
   no_reconnection_ = no_reconnection;
+  links_ = links;
   user_service_params_ = user_service_params;
   user_services_config_ = user_services_config;
   network_query_ = network_query;
@@ -165,7 +167,7 @@ void Client::RunSession(const boost::system::error_code& ec) {
 
   auto session = ClientSession::Create(
       async_engine_.get_io_service(), user_services, user_services_config_,
-      on_session_status, on_user_service_status, create_session_ec);
+      links_, on_session_status, on_user_service_status, create_session_ec);
 
   if (create_session_ec) {
     return;
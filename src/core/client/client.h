@@ -53,8 +53,9 @@ class Client {
     user_service_factory_.Register<UserService>();
   }
 
+  // links: number of physical links of a session to the server
   void Init(const NetworkQuery& network_query, uint32_t max_connection_attempts,
-            uint32_t reconnection_timeout, bool no_reconnection,
+            uint32_t reconnection_timeout, bool no_reconnection, uint32_t links,
             UserServiceParameters user_service_params,
             const ssf::config::Services& user_services_config,
             OnStatusCb on_status, OnUserServiceStatusCb on_user_service_status,
@@ -97,6 +98,7 @@ class Client {
   uint32_t connection_attempts_;
   uint32_t max_connection_attempts_;
   bool no_reconnection_;
+  uint32_t links_;
   std::chrono::seconds reconnection_timeout_;
   OnStatusCb on_status_;
   OnUserServiceStatusCb on_user_service_status_;
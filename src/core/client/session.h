@@ -1,10 +1,16 @@
 #ifndef SSF_CORE_CLIENT_SESSION_H_
 #define SSF_CORE_CLIENT_SESSION_H_
 
+#include <cstdint>
+
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <string>
 #include <vector>
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/system/error_code.hpp>
 
 #include "common/boost/fiber/basic_fiber_demux.hpp"
@@ -16,6 +22,14 @@
 #include "services/user_services/base_user_service.h"
 
 namespace ssf {
+namespace services {
+namespace admin {
+
+template <typename Demux>
+class Admin;
+
+}  // admin
+}  // services
 
 template <class NetworkProtocol,
           template <class> class TransportVirtualLayerPolicy>
@@ -30,6 +44,7 @@ class Session
   using NetworkSocketPtr = std::shared_ptr<NetworkSocket>;
   using NetworkEndpoint = typename NetworkProtocol::endpoint;
   using NetworkResolver = typename NetworkProtocol::resolver;
+  using NetworkEndpointIterator = typename NetworkResolver::iterator;
   using NetworkQuery = typename NetworkProtocol::resolver::query;
   using Demux = boost::asio::fiber::basic_fiber_demux<NetworkSocket>;
   using BaseUserServicePtr =
@@ -37,13 +52,20 @@ class Session
   using OnStatusCb = std::function<void(Status)>;
   using OnUserServiceStatusCb =
       std::function<void(BaseUserServicePtr, const boost::system::error_code&)>;
+  using OnRemoteStatsCb = std::function<void(const boost::system::error_code&,
+                                             const std::string&)>;
 
  public:
+  /// Create a client session
+  /**
+  * @param links Number of physical links to the server. With more than one
+  *   link, the fibers are spread over the links.
+  */
   static std::shared_ptr<Session> Create(
       boost::asio::io_service& io_service,
       std::vector<BaseUserServicePtr> user_services,
-      const ssf::config::Services& services_config, OnStatusCb on_status,
-      OnUserServiceStatusCb on_user_service_status,
+      const ssf::config::Services& services_config, uint32_t links,
+      OnStatusCb on_status, OnUserServiceStatusCb on_user_service_status,
       boost::system::error_code& ec);
 
   ~Session();
@@ -54,21 +76,54 @@ class Session
 
   Demux& GetDemux() { return fiber_demux_; }
 
+  /// Ask the server for its metrics
+  /**
+  * @param prefix Only the metrics whose name starts with prefix are returned
+  * @param on_remote_stats Called with the metrics JSON line of the server
+  */
+  void AsyncGetRemoteStats(const std::string& prefix,
+                           OnRemoteStatsCb on_remote_stats);
+
   bool is_stopped() { return stopped_; }
 
   boost::asio::io_service& get_io_service() { return io_service_; }
 
+ private:
+  // Delays between the connection attempts of a link (doubled up to the max)
+  enum : uint32_t { kLinkRetryDelayMs = 500, kLinkRetryMaxDelayMs = 30000 };
+
  private:
   Session(boost::asio::io_service& io_service,
           const std::vector<BaseUserServicePtr>& user_services,
-          const ssf::config::Services& services_config, OnStatusCb on_status,
-          OnUserServiceStatusCb on_user_service_status);
+          const ssf::config::Services& services_config, uint32_t links,
+          OnStatusCb on_status, OnUserServiceStatusCb on_user_service_status);
 
   void NetworkToTransport(const boost::system::error_code& ec);
 
-  void DoSSFStart(const boost::system::error_code& ec);
+  void DoSSFStart(const boost::system::error_code& ec, uint32_t max_frame_size);
+
+  void DoFiberize(uint32_t max_frame_size, boost::system::error_code& ec);
+
+  // Open the other links of the session
+  void StartLinks();
+
+  // Connect a link to the server, after a backoff delay when it is a retry
+  void ConnectLink(uint32_t attempt);
+
+  void LinkToTransport(NetworkSocketPtr p_link_socket, uint32_t attempt,
+                       const boost::system::error_code& ec);
+
+  void DoAddLink(NetworkSocketPtr p_link_socket, uint32_t attempt,
+                 const boost::system::error_code& ec);
+
+  // Close a link which could not be added and try again
+  void RetryLink(NetworkSocketPtr p_link_socket, uint32_t attempt);
+
+  // Replace a link lost by the demux
+  void OnLinkLost();
 
-  void DoFiberize(boost::system::error_code& ec);
+  // Close the links being connected and stop connecting new ones
+  void CloseLinkSockets();
 
   void OnDemuxClose();
 
@@ -77,14 +132,25 @@ class Session
  private:
   boost::asio::io_service& io_service_;
   NetworkSocketPtr p_socket_;
+  NetworkEndpointIterator endpoint_it_;
   std::vector<BaseUserServicePtr> user_services_;
   ssf::config::Services services_config_;
+  uint32_t links_;
+  // shared by the links of the session (0 with a single link)
+  uint64_t session_id_;
+  // links being connected and their retry timers
+  std::mutex link_sockets_mutex_;
+  bool link_sockets_closed_;
+  std::set<NetworkSocketPtr> p_link_sockets_;
+  std::set<std::shared_ptr<boost::asio::steady_timer>> p_link_timers_;
   ServiceManagerPtr<Demux> p_service_manager_;
   Demux fiber_demux_;
   bool stopped_;
   Status status_;
   OnStatusCb on_status_;
   OnUserServiceStatusCb on_user_service_status_;
+  std::mutex admin_service_mutex_;
+  std::weak_ptr<services::admin::Admin<Demux>> p_admin_service_;
 };
 
 }  // ssf
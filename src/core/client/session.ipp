@@ -1,6 +1,10 @@
 #ifndef SSF_CORE_CLIENT_SESSION_IPP_
 #define SSF_CORE_CLIENT_SESSION_IPP_
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 #include "common/error/error.h"
 
 #include "core/factories/service_factory.h"
@@ -8,6 +12,8 @@
 #include "services/admin/admin.h"
 #include "services/admin/requests/create_service_request.h"
 #include "services/admin/requests/service_status.h"
+#include "services/admin/requests/stats_reply.h"
+#include "services/admin/requests/stats_request.h"
 #include "services/admin/requests/stop_service_request.h"
 
 #include "services/datagrams_to_fibers/datagrams_to_fibers.h"
@@ -25,11 +31,11 @@ template <class N, template <class> class T>
 std::shared_ptr<Session<N, T>> Session<N, T>::Create(
     boost::asio::io_service& io_service,
     std::vector<BaseUserServicePtr> user_services,
-    const ssf::config::Services& services_config, OnStatusCb on_status,
-    OnUserServiceStatusCb on_user_service_status,
+    const ssf::config::Services& services_config, uint32_t links,
+    OnStatusCb on_status, OnUserServiceStatusCb on_user_service_status,
     boost::system::error_code& ec) {
   std::shared_ptr<Session<N, T>> p_session(
-      new Session(io_service, user_services, services_config, on_status,
+      new Session(io_service, user_services, services_config, links, on_status,
                   on_user_service_status));
 
   return p_session;
@@ -39,17 +45,35 @@ template <class N, template <class> class T>
 Session<N, T>::Session(boost::asio::io_service& io_service,
                        const std::vector<BaseUserServicePtr>& user_services,
                        const ssf::config::Services& services_config,
-                       OnStatusCb on_status,
+                       uint32_t links, OnStatusCb on_status,
                        OnUserServiceStatusCb on_user_service_status)
     : T<typename N::socket>(),
       io_service_(io_service),
+      endpoint_it_(),
       user_services_(user_services),
       services_config_(services_config),
+      links_(std::max<uint32_t>(links, 1)),
+      session_id_(0),
+      link_sockets_mutex_(),
+      link_sockets_closed_(false),
+      p_link_sockets_(),
+      p_link_timers_(),
       fiber_demux_(io_service),
       stopped_(false),
       status_(Status::kInitialized),
       on_status_(on_status),
-      on_user_service_status_(on_user_service_status) {}
+      on_user_service_status_(on_user_service_status),
+      admin_service_mutex_(),
+      p_admin_service_() {
+  if (links_ > 1) {
+    // The server gathers the links of the session by id
+    std::random_device random_device;
+    while (!session_id_) {
+      session_id_ = (static_cast<uint64_t>(random_device()) << 32) |
+                    random_device();
+    }
+  }
+}
 
 template <class N, template <class> class T>
 Session<N, T>::~Session() {
@@ -67,7 +91,7 @@ void Session<N, T>::Start(const NetworkQuery& query,
 
   // resolve remote endpoint with query
   NetworkResolver resolver(io_service_);
-  auto endpoint_it = resolver.resolve(query, ec);
+  endpoint_it_ = resolver.resolve(query, ec);
   if (ec) {
     SSF_LOG("client_session", error, "could not resolve network endpoint");
     UpdateStatus(Status::kEndpointNotResolvable);
@@ -79,7 +103,7 @@ void Session<N, T>::Start(const NetworkQuery& query,
   auto on_connect = [this, self](const boost::system::error_code& ec) {
     NetworkToTransport(ec);
   };
-  p_socket_->async_connect(*endpoint_it, on_connect);
+  p_socket_->async_connect(*endpoint_it_, on_connect);
 }
 
 template <class N, template <class> class T>
@@ -103,6 +127,8 @@ void Session<N, T>::Stop(boost::system::error_code& ec) {
     p_socket_->close(close_ec);
   }
 
+  CloseLinkSockets();
+
   auto self = this->shared_from_this();
   if (status_ == Status::kConnected || status_ == Status::kRunning) {
     auto update_status = [this, self]() {
@@ -124,14 +150,17 @@ void Session<N, T>::NetworkToTransport(const boost::system::error_code& ec) {
   UpdateStatus(Status::kConnected);
   auto self = this->shared_from_this();
   auto on_ssf_initiate = [this, self](NetworkSocket& socket,
-                                      const boost::system::error_code& ec) {
-    DoSSFStart(ec);
+                                      const boost::system::error_code& ec,
+                                      uint32_t max_frame_size,
+                                      uint64_t session_id) {
+    DoSSFStart(ec, max_frame_size);
   };
-  this->DoSSFInitiate(*p_socket_, on_ssf_initiate);
+  this->DoSSFInitiate(*p_socket_, on_ssf_initiate, session_id_);
 }
 
 template <class N, template <class> class T>
-void Session<N, T>::DoSSFStart(const boost::system::error_code& ec) {
+void Session<N, T>::DoSSFStart(const boost::system::error_code& ec,
+                               uint32_t max_frame_size) {
   boost::system::error_code stop_ec;
 
   if (ec) {
@@ -142,18 +171,175 @@ void Session<N, T>::DoSSFStart(const boost::system::error_code& ec) {
 
   SSF_LOG("client_session", trace, "SSF reply ok");
   boost::system::error_code fiberize_ec;
-  DoFiberize(fiberize_ec);
+  DoFiberize(max_frame_size, fiberize_ec);
   if (fiberize_ec) {
     UpdateStatus(Status::kServerNotSupported);
     return;
   }
+
+  StartLinks();
+}
+
+template <class N, template <class> class T>
+void Session<N, T>::StartLinks() {
+  if (links_ <= 1) {
+    return;
+  }
+
+  SSF_LOG("client_session", debug, "opening {} more link(s)", links_ - 1);
+
+  // A lost link is replaced: the session keeps its number of links
+  auto self = this->shared_from_this();
+  fiber_demux_.set_link_lost_handler([this, self]() { OnLinkLost(); });
+
+  for (uint32_t i = 1; i < links_; ++i) {
+    ConnectLink(0);
+  }
 }
 
 template <class N, template <class> class T>
-void Session<N, T>::DoFiberize(boost::system::error_code& ec) {
+void Session<N, T>::ConnectLink(uint32_t attempt) {
+  auto p_link_socket = std::make_shared<NetworkSocket>(io_service_);
+  auto p_timer = std::make_shared<boost::asio::steady_timer>(io_service_);
+  {
+    std::unique_lock<std::mutex> lock(link_sockets_mutex_);
+    if (stopped_ || link_sockets_closed_) {
+      return;
+    }
+    p_link_sockets_.insert(p_link_socket);
+    p_link_timers_.insert(p_timer);
+  }
+
+  uint32_t delay_ms = 0;
+  if (attempt > 0) {
+    delay_ms = std::min<uint32_t>(kLinkRetryMaxDelayMs,
+                                  kLinkRetryDelayMs
+                                      << std::min<uint32_t>(attempt - 1, 16));
+    SSF_LOG("client_session", debug, "reconnecting link in {} ms (attempt {})",
+            delay_ms, attempt + 1);
+  }
+
+  auto self = this->shared_from_this();
+  auto on_connect = [this, self, p_link_socket,
+                     attempt](const boost::system::error_code& ec) {
+    LinkToTransport(p_link_socket, attempt, ec);
+  };
+  auto on_timeout = [this, self, p_link_socket, p_timer,
+                     on_connect](const boost::system::error_code& ec) {
+    {
+      std::unique_lock<std::mutex> lock(link_sockets_mutex_);
+      if (!p_link_timers_.erase(p_timer) || ec) {
+        // session stopped
+        return;
+      }
+    }
+    p_link_socket->async_connect(*endpoint_it_, on_connect);
+  };
+  p_timer->expires_from_now(std::chrono::milliseconds(delay_ms));
+  p_timer->async_wait(on_timeout);
+}
+
+template <class N, template <class> class T>
+void Session<N, T>::LinkToTransport(NetworkSocketPtr p_link_socket,
+                                    uint32_t attempt,
+                                    const boost::system::error_code& ec) {
+  if (ec) {
+    SSF_LOG("client_session", warn, "could not connect link: {}",
+            ec.message());
+    RetryLink(p_link_socket, attempt);
+    return;
+  }
+
+  // The session id makes the server add the link to the demux of the session
+  auto self = this->shared_from_this();
+  auto on_ssf_initiate = [this, self, p_link_socket, attempt](
+      NetworkSocket& socket, const boost::system::error_code& ec,
+      uint32_t max_frame_size, uint64_t session_id) {
+    DoAddLink(p_link_socket, attempt, ec);
+  };
+  this->DoSSFInitiate(*p_link_socket, on_ssf_initiate, session_id_);
+}
+
+template <class N, template <class> class T>
+void Session<N, T>::DoAddLink(NetworkSocketPtr p_link_socket,
+                              uint32_t attempt,
+                              const boost::system::error_code& ec) {
+  if (ec) {
+    SSF_LOG("client_session", warn, "link SSF protocol error: {}",
+            ec.message());
+    RetryLink(p_link_socket, attempt);
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(link_sockets_mutex_);
+    if (!p_link_sockets_.erase(p_link_socket)) {
+      // session stopped
+      return;
+    }
+  }
+
+  // The link negotiated the same frame size as the first one (same peers)
+  boost::system::error_code link_ec;
+  fiber_demux_.add_link(std::move(*p_link_socket), link_ec);
+  if (link_ec) {
+    // the demux is closed
+    SSF_LOG("client_session", warn, "could not add link: {}",
+            link_ec.message());
+    return;
+  }
+
+  SSF_LOG("client_session", debug, "link added ({}/{})",
+          fiber_demux_.link_count(), links_);
+}
+
+template <class N, template <class> class T>
+void Session<N, T>::RetryLink(NetworkSocketPtr p_link_socket,
+                              uint32_t attempt) {
+  {
+    std::unique_lock<std::mutex> lock(link_sockets_mutex_);
+    if (!p_link_sockets_.erase(p_link_socket)) {
+      // session stopped
+      return;
+    }
+  }
+
+  boost::system::error_code close_ec;
+  p_link_socket->close(close_ec);
+
+  ConnectLink(attempt + 1);
+}
+
+template <class N, template <class> class T>
+void Session<N, T>::OnLinkLost() {
+  SSF_LOG("client_session", info, "link lost: reconnecting it");
+  ConnectLink(1);
+}
+
+template <class N, template <class> class T>
+void Session<N, T>::CloseLinkSockets() {
+  std::unique_lock<std::mutex> lock(link_sockets_mutex_);
+  link_sockets_closed_ = true;
+  for (auto& p_link_socket : p_link_sockets_) {
+    boost::system::error_code close_ec;
+    p_link_socket->close(close_ec);
+  }
+  p_link_sockets_.clear();
+
+  for (auto& p_timer : p_link_timers_) {
+    boost::system::error_code cancel_ec;
+    p_timer->cancel(cancel_ec);
+  }
+  p_link_timers_.clear();
+}
+
+template <class N, template <class> class T>
+void Session<N, T>::DoFiberize(uint32_t max_frame_size,
+                               boost::system::error_code& ec) {
   auto self = this->shared_from_this();
   auto close_demux_handler = [this, self]() { OnDemuxClose(); };
-  fiber_demux_.fiberize(std::move(*p_socket_), close_demux_handler);
+  fiber_demux_.fiberize(std::move(*p_socket_), close_demux_handler,
+                        max_frame_size);
 
   p_socket_.reset();
 
@@ -214,6 +400,25 @@ void Session<N, T>::DoFiberize(boost::system::error_code& ec) {
     ec.assign(::error::service_not_started, ::error::get_ssf_category());
     return;
   }
+  if (!p_admin_service
+           ->template RegisterCommand<services::admin::StatsRequest>()) {
+    SSF_LOG("client_session", error,
+            "cannot register StatsRequest into admin service");
+    ec.assign(::error::service_not_started, ::error::get_ssf_category());
+    return;
+  }
+  if (!p_admin_service
+           ->template RegisterCommand<services::admin::StatsReply>()) {
+    SSF_LOG("client_session", error,
+            "cannot register StatsReply into admin service");
+    ec.assign(::error::service_not_started, ::error::get_ssf_category());
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(admin_service_mutex_);
+    p_admin_service_ = p_admin_service;
+  }
+
   // Start admin microservice
   p_service_manager_->start(p_admin_service, ec);
 
@@ -223,8 +428,29 @@ void Session<N, T>::DoFiberize(boost::system::error_code& ec) {
   }
 }
 
+template <class N, template <class> class T>
+void Session<N, T>::AsyncGetRemoteStats(const std::string& prefix,
+                                        OnRemoteStatsCb on_remote_stats) {
+  std::shared_ptr<services::admin::Admin<Demux>> p_admin_service;
+  {
+    std::unique_lock<std::mutex> lock(admin_service_mutex_);
+    p_admin_service = p_admin_service_.lock();
+  }
+
+  if (!p_admin_service) {
+    io_service_.post([on_remote_stats]() {
+      on_remote_stats({::error::broken_pipe, ::error::get_ssf_category()}, {});
+    });
+    return;
+  }
+
+  p_admin_service->GetRemoteStats(prefix, std::move(on_remote_stats));
+}
+
 template <class N, template <class> class T>
 void Session<N, T>::OnDemuxClose() {
+  CloseLinkSockets();
+
   auto p_service_factory =
       ServiceFactoryManager<Demux>::GetServiceFactory(&fiber_demux_);
   if (p_service_factory) {
@@ -23,7 +23,8 @@ CopyCommandLine::CopyCommandLine()
       resume_(false),
       recursive_(false),
       check_file_integrity_(false),
-      max_parallel_copies_() {}
+      max_parallel_copies_(),
+      stream_(false) {}
 
 void CopyCommandLine::InitOptions(Options& opts) {
   // clang-format off
@@ -36,6 +37,7 @@ void CopyCommandLine::InitOptions(Options& opts) {
     ("r,recursive", "Copy files recursively")
     ("max-transfers", "Max transfers in parallel",
         cxxopts::value<uint32_t>()->default_value("1"))
+    ("stream", "Send all the files in a single transfer (no resume)")
     ("args", "", cxxopts::value<std::vector<std::string>>());
 
   opts.parse_positional("args");
@@ -64,6 +66,8 @@ uint32_t CopyCommandLine::max_parallel_copies() const {
   return max_parallel_copies_;
 }
 
+bool CopyCommandLine::stream() const { return stream_; }
+
 std::string CopyCommandLine::input_pattern() const { return input_pattern_; }
 
 std::string CopyCommandLine::output_pattern() const { return output_pattern_; }
@@ -77,6 +81,7 @@ void CopyCommandLine::ParseOptions(const Options& opts,
     recursive_ = opts.count("recursive");
     check_file_integrity_ = opts.count("check-integrity");
     max_parallel_copies_ = opts["max-transfers"].as<uint32_t>();
+    stream_ = opts.count("stream");
     if (max_parallel_copies_ == 0) {
       SSF_LOG("cli", error, "max-transfers must be > 0");
       ec.assign(::error::invalid_argument, ::error::get_ssf_category());
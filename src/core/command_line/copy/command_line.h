@@ -24,6 +24,8 @@ class CopyCommandLine : public Base {
 
   uint32_t max_parallel_copies() const;
 
+  bool stream() const;
+
   std::string input_pattern() const;
 
   std::string output_pattern() const;
@@ -54,6 +56,7 @@ class CopyCommandLine : public Base {
   bool recursive_;
   bool check_file_integrity_;
   uint32_t max_parallel_copies_;
+  bool stream_;
 };
 
 }  // command_line
@@ -12,9 +12,12 @@ StandardCommandLine::StandardCommandLine(bool is_server)
       is_server_(is_server),
       show_status_(false),
       relay_only_(false),
+      io_per_core_(false),
       gateway_ports_(false),
       max_connection_attempts_(1),
-      reconnection_timeout_(60) {}
+      reconnection_timeout_(60),
+      no_reconnection_(false),
+      links_(1) {}
 
 void StandardCommandLine::InitOptions(Options& opts) {
   Base::InitOptions(opts);
@@ -23,6 +26,8 @@ void StandardCommandLine::InitOptions(Options& opts) {
     // server cli
     opts.add_options()
       ("R,relay-only", "The server will only relay connections")
+      ("io-per-core",
+       "Run one I/O loop per core and spread client connections over them")
       ("l,bind-address", "Server bind address", cxxopts::value<std::string>());
   } else {
     // client cli
@@ -35,6 +40,9 @@ void StandardCommandLine::InitOptions(Options& opts) {
         cxxopts::value<uint32_t>()->default_value("60"))
       ("n,no-reconnect",
        "Do not attempt to reconnect after loosing a connection")
+      ("links",
+       "Number of parallel connections to the server carrying the session",
+       cxxopts::value<uint32_t>()->default_value("1"))
       ("server-address", "", cxxopts::value<std::vector<std::string>>());
 
     opts.parse_positional("server-address");
@@ -74,6 +82,7 @@ void StandardCommandLine::ParseOptions(const Options& opts,
 
   if (IsServerCli()) {
     relay_only_ = opts.count("relay-only");
+    io_per_core_ = opts.count("io-per-core");
   } else {
     uint32_t max_attempts = opts["max-connect-attempts"].as<uint32_t>();
     if (max_attempts == 0) {
@@ -85,6 +94,14 @@ void StandardCommandLine::ParseOptions(const Options& opts,
 
     reconnection_timeout_ = opts["reconnect-delay"].as<uint32_t>();
     no_reconnection_ = opts.count("no-reconnect");
+
+    uint32_t links = opts["links"].as<uint32_t>();
+    if (links == 0) {
+      SSF_LOG("cli", error, "option links must be > 0");
+      ec.assign(::error::invalid_argument, ::error::get_ssf_category());
+    } else {
+      links_ = links;
+    }
   }
 
   gateway_ports_ = opts.count("gateway-ports");
@@ -16,6 +16,8 @@ class StandardCommandLine : public Base {
 
   bool relay_only() const { return relay_only_; }
 
+  bool io_per_core() const { return io_per_core_; }
+
   bool gateway_ports() const { return gateway_ports_; }
 
   uint32_t max_connection_attempts() const { return max_connection_attempts_; }
@@ -24,6 +26,8 @@ class StandardCommandLine : public Base {
 
   bool no_reconnection() const { return no_reconnection_; }
 
+  uint32_t links() const { return links_; }
+
  protected:
   void InitOptions(Options& opts) override;
   bool IsServerCli() override;
@@ -34,10 +38,12 @@ class StandardCommandLine : public Base {
   bool is_server_;
   bool show_status_;
   bool relay_only_;
+  bool io_per_core_;
   bool gateway_ports_;
   uint32_t max_connection_attempts_;
   uint32_t reconnection_timeout_;
   bool no_reconnection_;
+  uint32_t links_;
 };
 
 }  // command_line
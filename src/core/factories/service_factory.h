@@ -29,6 +29,8 @@ class ServiceFactory
   using ServiceCreator = std::function<BaseServicePtr(
       boost::asio::io_service&, Demux&, const Parameters&)>;
   using ServiceCreatorMap = std::map<uint32_t, ServiceCreator>;
+  using FiberWeightMap = std::map<uint32_t, uint8_t>;
+  using BufferLimitsMap = std::map<uint32_t, BufferLimits>;
   using ServiceManagerPtr = std::shared_ptr<ServiceManager<Demux>>;
 
  public:
@@ -48,12 +50,18 @@ class ServiceFactory
 
   ~ServiceFactory() {}
 
-  bool RegisterServiceCreator(uint32_t index, ServiceCreator creator) {
+  bool RegisterServiceCreator(
+      uint32_t index, ServiceCreator creator,
+      uint8_t fiber_weight =
+          boost::asio::fiber::detail::fiber_weight::kDefaultWeight,
+      const BufferLimits& buffer_limits = BufferLimits()) {
     std::unique_lock<std::recursive_mutex> lock(service_creators_mutex_);
     if (service_creators_.count(index)) {
       return false;
     } else {
       service_creators_[index] = creator;
+      fiber_weights_[index] = fiber_weight;
+      buffer_limits_[index] = buffer_limits;
       return true;
     }
   }
@@ -68,6 +76,8 @@ class ServiceFactory
       auto& service_creator = it->second;
       auto p_service = service_creator(io_service_, demux_, parameters);
       if (p_service) {
+        p_service->set_fiber_weight(fiber_weights_[index]);
+        p_service->set_buffer_limits(buffer_limits_[index]);
         auto service_id = p_service_manager_->start(p_service, ec);
         p_service->set_local_id(service_id);
         return service_id;
@@ -129,6 +139,8 @@ class ServiceFactory
 
   std::recursive_mutex service_creators_mutex_;
   ServiceCreatorMap service_creators_;
+  FiberWeightMap fiber_weights_;
+  BufferLimitsMap buffer_limits_;
 };
 
 }  // ssf
@@ -163,7 +163,21 @@ ssf::layer::LayerParameters NetworkProtocol::TlsConfigToLayerParameters(
           {"key_password", ssf_config.tls().key_password()},
           {ssf_config.tls().dh().IsBuffer() ? "dhparam_buffer" : "dhparam_file",
            ssf_config.tls().dh().value()},
-          {"cipher_suit", ssf_config.tls().cipher_alg()}};
+          {"cipher_suit", ssf_config.tls().cipher_alg()},
+          {"session_resumption",
+           ssf_config.tls().session_resumption() ? "true" : "false"},
+          {"session_lifetime",
+           std::to_string(ssf_config.tls().session_lifetime())},
+          {"direct_read", ssf_config.tls().direct_read() ? "true" : "false"},
+          {"direct_read_threshold",
+           std::to_string(ssf_config.tls().direct_read_threshold())},
+          {"receive_buffer_size",
+           std::to_string(ssf_config.tls().receive_buffer_size())},
+          {"receive_queue_low_bound",
+           std::to_string(ssf_config.tls().receive_queue_low_bound())},
+          {"receive_queue_high_bound",
+           std::to_string(ssf_config.tls().receive_queue_high_bound())},
+          {"kernel_tls", ssf_config.tls().kernel_tls() ? "true" : "false"}};
 }
 
 ssf::layer::LayerParameters NetworkProtocol::ProxyConfigToLayerParameters(
@@ -4,8 +4,10 @@
 #include <set>
 #include <map>
 #include <mutex>
+#include <string>
 
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
 
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 
@@ -33,10 +35,19 @@ class SSFServer
   using DemuxPtr = std::shared_ptr<Demux>;
   using DemuxPtrSet = std::set<DemuxPtr>;
   using ServiceManagerPtrMap = std::map<DemuxPtr, ServiceManagerPtr<Demux>>;
+  // demux of a session and address of the peer which opened it: the other
+  // links of the session must come from the same peer
+  struct SessionDemux {
+    DemuxPtr p_fiber_demux;
+    std::string peer_address;
+  };
+  using SessionDemuxMap = std::map<uint64_t, SessionDemux>;
 
  public:
   SSFServer(const ssf::config::Services& services_config,
-            bool relay_only = false);
+            bool relay_only = false,
+            AsyncEngine::Mode engine_mode = AsyncEngine::Mode::kShared,
+            bool serve_metrics = false);
 
   ~SSFServer();
 
@@ -53,8 +64,17 @@ class SSFServer
   void AddDemux(DemuxPtr p_fiber_demux,
                 ServiceManagerPtr<Demux> p_service_manager);
   void DoSSFStart(NetworkSocketPtr p_socket, NetworkSocket& socket,
-                  const boost::system::error_code& ec);
-  void DoFiberize(NetworkSocketPtr p_socket, boost::system::error_code& ec);
+                  const boost::system::error_code& ec, uint32_t max_frame_size,
+                  uint64_t session_id);
+  void DoFiberize(NetworkSocketPtr p_socket, uint32_t max_frame_size,
+                  uint64_t session_id, boost::system::error_code& ec);
+  bool JoinSession(NetworkSocketPtr p_socket, uint64_t session_id,
+                   const std::string& peer_address);
+  static std::string GetPeerAddress(const NetworkSocket& socket);
+  static std::string GetPeerAddress(
+      const boost::asio::ip::tcp::endpoint& endpoint);
+  template <class Endpoint>
+  static std::string GetPeerAddress(const Endpoint& endpoint);
   void RemoveDemux(DemuxPtr p_fiber_demux);
   void RemoveAllDemuxes();
 
@@ -63,9 +83,13 @@ class SSFServer
   NetworkAcceptor network_acceptor_;
   ssf::config::Services services_config_;
   bool relay_only_;
+  // answer the metrics requests of the clients
+  bool serve_metrics_;
 
   DemuxPtrSet p_fiber_demuxes_;
   ServiceManagerPtrMap p_service_managers_;
+  // demuxes of the clients connected with several links
+  SessionDemuxMap session_demuxes_;
 
   std::recursive_mutex storage_mutex_;
 };
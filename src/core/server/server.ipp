@@ -27,12 +27,15 @@ namespace ssf {
 
 template <class N, template <class> class T>
 SSFServer<N, T>::SSFServer(const ssf::config::Services& services_config,
-                           bool relay_only)
+                           bool relay_only,
+                           AsyncEngine::Mode engine_mode,
+                           bool serve_metrics)
     : T<typename N::socket>(),
-      async_engine_(),
+      async_engine_(engine_mode),
       network_acceptor_(async_engine_.get_io_service()),
       services_config_(services_config),
-      relay_only_(relay_only) {}
+      relay_only_(relay_only),
+      serve_metrics_(serve_metrics) {}
 
 template <class N, template <class> class T>
 SSFServer<N, T>::~SSFServer() {
@@ -112,8 +115,10 @@ boost::asio::io_service& SSFServer<N, T>::get_io_service() {
 template <class N, template <class> class T>
 void SSFServer<N, T>::AsyncAcceptConnection() {
   if (network_acceptor_.is_open()) {
+    // Shard the connections over the engine io_services: the socket, its demux
+    // and everything created by its services stay on the same io_service
     NetworkSocketPtr p_socket =
-        std::make_shared<NetworkSocket>(async_engine_.get_io_service());
+        std::make_shared<NetworkSocket>(async_engine_.GetNextIoService());
 
     auto on_accept = [this, p_socket](const boost::system::error_code& ec) {
       NetworkToTransport(ec, p_socket);
@@ -129,8 +134,10 @@ void SSFServer<N, T>::NetworkToTransport(const boost::system::error_code& ec,
 
   if (!ec && !relay_only_) {
     this->DoSSFInitiateReceive(
-        *p_socket, std::bind(&SSFServer::DoSSFStart, this, p_socket,
-                             std::placeholders::_1, std::placeholders::_2));
+        *p_socket,
+        std::bind(&SSFServer::DoSSFStart, this, p_socket, std::placeholders::_1,
+                  std::placeholders::_2, std::placeholders::_3,
+                  std::placeholders::_4));
     return;
   }
 
@@ -149,7 +156,9 @@ void SSFServer<N, T>::NetworkToTransport(const boost::system::error_code& ec,
 template <class N, template <class> class T>
 void SSFServer<N, T>::DoSSFStart(NetworkSocketPtr p_socket,
                                  NetworkSocket& socket,
-                                 const boost::system::error_code& ec) {
+                                 const boost::system::error_code& ec,
+                                 uint32_t max_frame_size,
+                                 uint64_t session_id) {
   if (ec) {
     SSF_LOG("server", error, "SSF protocol error {}", ec.message());
     boost::system::error_code close_ec;
@@ -160,28 +169,37 @@ void SSFServer<N, T>::DoSSFStart(NetworkSocketPtr p_socket,
 
   SSF_LOG("server", debug, "SSF reply ok");
   boost::system::error_code fiberize_ec;
-  DoFiberize(p_socket, fiberize_ec);
+  DoFiberize(p_socket, max_frame_size, session_id, fiberize_ec);
 }
 
 template <class N, template <class> class T>
 void SSFServer<N, T>::DoFiberize(NetworkSocketPtr p_socket,
+                                 uint32_t max_frame_size, uint64_t session_id,
                                  boost::system::error_code& ec) {
   std::unique_lock<std::recursive_mutex> lock(storage_mutex_);
 
+  auto peer_address = GetPeerAddress(*p_socket);
+  if (session_id && JoinSession(p_socket, session_id, peer_address)) {
+    return;
+  }
+
+  auto& io_service = p_socket->get_io_service();
+
   // Make a new fiber demux and fiberize
-  auto p_fiber_demux = std::make_shared<Demux>(async_engine_.get_io_service());
+  auto p_fiber_demux = std::make_shared<Demux>(io_service);
   auto close_demux_handler = [this, p_fiber_demux]() {
     std::unique_lock<std::recursive_mutex> lock(storage_mutex_);
     RemoveDemux(p_fiber_demux);
   };
-  p_fiber_demux->fiberize(std::move(*p_socket), close_demux_handler);
+  p_fiber_demux->fiberize(std::move(*p_socket), close_demux_handler,
+                          max_frame_size);
 
   // Make a new service manager
   auto p_service_manager = std::make_shared<ServiceManager<Demux>>();
 
   // Make a new service factory
   auto p_service_factory = ServiceFactory<Demux>::Create(
-      async_engine_.get_io_service(), *p_fiber_demux, p_service_manager);
+      io_service, *p_fiber_demux, p_service_manager);
 
   // Register supported microservices
   services::socks::SocksServer<Demux>::RegisterToServiceFactory(
@@ -205,7 +223,7 @@ void SSFServer<N, T>::DoFiberize(NetworkSocketPtr p_socket,
   std::map<std::string, std::string> empty_map;
 
   auto p_admin_service = services::admin::Admin<Demux>::Create(
-      async_engine_.get_io_service(), *p_fiber_demux, empty_map);
+      io_service, *p_fiber_demux, empty_map);
   if (!p_admin_service->template RegisterCommand<
           services::admin::CreateServiceRequest>()) {
     SSF_LOG("server", error,
@@ -227,12 +245,96 @@ void SSFServer<N, T>::DoFiberize(NetworkSocketPtr p_socket,
     ec.assign(::error::service_not_started, ::error::get_ssf_category());
     return;
   }
+  // The metrics are only served when enabled (metrics.serve), the requests
+  // are answered with an error otherwise
+  bool stats_registered =
+      serve_metrics_
+          ? p_admin_service
+                ->template RegisterCommand<services::admin::StatsRequest>()
+          : p_admin_service->template RegisterCommand<
+                services::admin::RefusedStatsRequest>();
+  if (!stats_registered) {
+    SSF_LOG("server", error, "cannot register StatsRequest into admin service");
+    ec.assign(::error::service_not_started, ::error::get_ssf_category());
+    return;
+  }
+  if (!p_admin_service
+           ->template RegisterCommand<services::admin::StatsReply>()) {
+    SSF_LOG("server", error, "cannot register StatsReply into admin service");
+    ec.assign(::error::service_not_started, ::error::get_ssf_category());
+    return;
+  }
 
   p_admin_service->SetAsServer();
   p_service_manager->start(p_admin_service, ec);
 
   // Save the demux, the socket and the service manager
   AddDemux(p_fiber_demux, p_service_manager);
+  if (session_id && !peer_address.empty()) {
+    session_demuxes_[session_id] = {p_fiber_demux, peer_address};
+  }
+}
+
+template <class N, template <class> class T>
+bool SSFServer<N, T>::JoinSession(NetworkSocketPtr p_socket,
+                                  uint64_t session_id,
+                                  const std::string& peer_address) {
+  auto session_it = session_demuxes_.find(session_id);
+  if (session_it == session_demuxes_.end()) {
+    return false;
+  }
+
+  auto& session = session_it->second;
+  if (peer_address != session.peer_address) {
+    // The session id is not a secret: a link from another peer is refused
+    SSF_LOG("server", warn, "link to session refused (peer {} instead of {})",
+            peer_address, session.peer_address);
+    boost::system::error_code close_ec;
+    p_socket->shutdown(boost::asio::socket_base::shutdown_both, close_ec);
+    p_socket->close(close_ec);
+    return true;
+  }
+
+  // The link is added to the demux of the session. The socket stays on the
+  // io_service it was accepted on (per core mode), the demux hands its
+  // completions over to its own io_service.
+  boost::system::error_code link_ec;
+  session.p_fiber_demux->add_link(std::move(*p_socket), link_ec);
+  if (link_ec) {
+    SSF_LOG("server", debug, "could not add link to session: {}",
+            link_ec.message());
+  } else {
+    SSF_LOG("server", debug, "link added to session ({} links)",
+            session.p_fiber_demux->link_count());
+  }
+
+  return true;
+}
+
+template <class N, template <class> class T>
+std::string SSFServer<N, T>::GetPeerAddress(const NetworkSocket& socket) {
+  boost::system::error_code ec;
+  auto endpoint = socket.remote_endpoint(ec);
+  if (ec) {
+    return "";
+  }
+
+  return GetPeerAddress(endpoint);
+}
+
+template <class N, template <class> class T>
+std::string SSFServer<N, T>::GetPeerAddress(
+    const boost::asio::ip::tcp::endpoint& endpoint) {
+  boost::system::error_code ec;
+  auto address = endpoint.address().to_string(ec);
+  return ec ? "" : address;
+}
+
+/// Address of the physical peer, at the bottom of the layered endpoint
+template <class N, template <class> class T>
+template <class Endpoint>
+std::string SSFServer<N, T>::GetPeerAddress(const Endpoint& endpoint) {
+  return GetPeerAddress(endpoint.next_layer_endpoint());
 }
 
 template <class N, template <class> class T>
@@ -260,6 +362,15 @@ void SSFServer<N, T>::RemoveDemux(DemuxPtr p_fiber_demux) {
     p_service_factory->Destroy();
   }
 
+  for (auto session_it = session_demuxes_.begin();
+       session_it != session_demuxes_.end();) {
+    if (session_it->second.p_fiber_demux == p_fiber_demux) {
+      session_it = session_demuxes_.erase(session_it);
+    } else {
+      ++session_it;
+    }
+  }
+
   p_fiber_demux->close();
   p_fiber_demuxes_.erase(p_fiber_demux);
 }
@@ -2,25 +2,39 @@
 
 namespace ssf {
 
-SSFReply::SSFReply() : result_(false) {}
-SSFReply::SSFReply(bool result) : result_(result) {}
+SSFReply::SSFReply() : result_(false), max_frame_size_(0) {}
+SSFReply::SSFReply(bool result, MaxFrameSizeField max_frame_size)
+    : result_(result), max_frame_size_(max_frame_size) {}
 
 bool SSFReply::result() const { return result_; }
 
-std::array<boost::asio::const_buffer, SSFReply::field_number>
-SSFReply::const_buffer() const {
-  std::array<boost::asio::const_buffer, field_number> buf = {
-      {boost::asio::const_buffer(&result_, sizeof(result_))}};
+SSFReply::MaxFrameSizeField SSFReply::max_frame_size() const {
+  return max_frame_size_;
+}
+
+std::vector<boost::asio::const_buffer> SSFReply::const_buffer() const {
+  std::vector<boost::asio::const_buffer> buf;
+  buf.push_back(boost::asio::const_buffer(&result_, sizeof(result_)));
+  if (result_) {
+    buf.push_back(
+        boost::asio::const_buffer(&max_frame_size_, sizeof(max_frame_size_)));
+  }
 
   return buf;
 }
 
-std::array<boost::asio::mutable_buffer, SSFReply::field_number>
-SSFReply::buffer() {
-  std::array<boost::asio::mutable_buffer, field_number> buf = {
+std::array<boost::asio::mutable_buffer, 1> SSFReply::result_buffer() {
+  std::array<boost::asio::mutable_buffer, 1> buf = {
       {boost::asio::mutable_buffer(&result_, sizeof(result_))}};
 
   return buf;
 }
 
+std::array<boost::asio::mutable_buffer, 1> SSFReply::max_frame_size_buffer() {
+  std::array<boost::asio::mutable_buffer, 1> buf = {
+      {boost::asio::mutable_buffer(&max_frame_size_, sizeof(max_frame_size_))}};
+
+  return buf;
+}
+
 }  // ssf
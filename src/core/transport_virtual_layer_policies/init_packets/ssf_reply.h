@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <array>
 #include <memory>
+#include <vector>
 
 #include <boost/asio/buffer.hpp>
 
@@ -11,20 +12,30 @@ namespace ssf {
 
 class SSFReply {
  public:
-  enum { field_number = 1, total_size = sizeof(bool) };
+  using MaxFrameSizeField = uint32_t;
+
+  enum {
+    field_number = 2,
+    total_size = sizeof(bool) + sizeof(MaxFrameSizeField)
+  };
 
  public:
   SSFReply();
-  SSFReply(bool result);
+  SSFReply(bool result, MaxFrameSizeField max_frame_size);
 
   bool result() const;
 
-  std::array<boost::asio::const_buffer, field_number> const_buffer() const;
+  MaxFrameSizeField max_frame_size() const;
+
+  // A negative reply is made of the result field only
+  std::vector<boost::asio::const_buffer> const_buffer() const;
 
-  std::array<boost::asio::mutable_buffer, field_number> buffer();
+  std::array<boost::asio::mutable_buffer, 1> result_buffer();
+  std::array<boost::asio::mutable_buffer, 1> max_frame_size_buffer();
 
  private:
   bool result_;
+  MaxFrameSizeField max_frame_size_;
 };
 
 using SSFReplyPtr = std::shared_ptr<SSFReply>;
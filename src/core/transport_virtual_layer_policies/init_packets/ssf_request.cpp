@@ -2,26 +2,47 @@
 
 namespace ssf {
 
-SSFRequest::SSFRequest() : version_(0) {}
+SSFRequest::SSFRequest() : version_(0), max_frame_size_(0), session_id_(0) {}
 
-SSFRequest::SSFRequest(VersionField version) : version_(version) {}
+SSFRequest::SSFRequest(VersionField version, MaxFrameSizeField max_frame_size,
+                       SessionIdField session_id)
+    : version_(version),
+      max_frame_size_(max_frame_size),
+      session_id_(session_id) {}
 
 SSFRequest::VersionField SSFRequest::version() const { return version_; }
 
+SSFRequest::MaxFrameSizeField SSFRequest::max_frame_size() const {
+  return max_frame_size_;
+}
+
+SSFRequest::SessionIdField SSFRequest::session_id() const {
+  return session_id_;
+}
+
 std::array<boost::asio::const_buffer, SSFRequest::field_number>
 SSFRequest::const_buffer() const {
   std::array<boost::asio::const_buffer, field_number> buf = {
-      {boost::asio::const_buffer(&version_, sizeof(version_))}};
+      {boost::asio::const_buffer(&version_, sizeof(version_)),
+       boost::asio::const_buffer(&max_frame_size_, sizeof(max_frame_size_)),
+       boost::asio::const_buffer(&session_id_, sizeof(session_id_))}};
 
   return buf;
 }
 
-std::array<boost::asio::mutable_buffer, SSFRequest::field_number>
-SSFRequest::buffer() {
-  std::array<boost::asio::mutable_buffer, field_number> buf = {
+std::array<boost::asio::mutable_buffer, 1> SSFRequest::version_buffer() {
+  std::array<boost::asio::mutable_buffer, 1> buf = {
       {boost::asio::mutable_buffer(&version_, sizeof(version_))}};
 
   return buf;
 }
 
+std::array<boost::asio::mutable_buffer, 2> SSFRequest::parameters_buffer() {
+  std::array<boost::asio::mutable_buffer, 2> buf = {
+      {boost::asio::mutable_buffer(&max_frame_size_, sizeof(max_frame_size_)),
+       boost::asio::mutable_buffer(&session_id_, sizeof(session_id_))}};
+
+  return buf;
+}
+
 }  // ssf
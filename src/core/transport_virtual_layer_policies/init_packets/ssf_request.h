@@ -12,20 +12,37 @@ namespace ssf {
 class SSFRequest {
  public:
   using VersionField = uint32_t;
+  using MaxFrameSizeField = uint32_t;
+  using SessionIdField = uint64_t;
 
-  enum { field_number = 1, total_size = sizeof(VersionField) };
+  enum {
+    field_number = 3,
+    total_size = sizeof(VersionField) + sizeof(MaxFrameSizeField) +
+                 sizeof(SessionIdField)
+  };
 
  public:
   SSFRequest();
-  SSFRequest(VersionField version);
+  SSFRequest(VersionField version, MaxFrameSizeField max_frame_size,
+             SessionIdField session_id);
 
   VersionField version() const;
 
+  MaxFrameSizeField max_frame_size() const;
+
+  // Links sharing a non zero session id are demultiplexed together
+  SessionIdField session_id() const;
+
   std::array<boost::asio::const_buffer, field_number> const_buffer() const;
-  std::array<boost::asio::mutable_buffer, field_number> buffer();
+
+  // The version is received first: the other fields depend on it
+  std::array<boost::asio::mutable_buffer, 1> version_buffer();
+  std::array<boost::asio::mutable_buffer, 2> parameters_buffer();
 
  private:
   VersionField version_;
+  MaxFrameSizeField max_frame_size_;
+  SessionIdField session_id_;
 };
 
 using SSFRequestPtr = std::shared_ptr<SSFRequest>;
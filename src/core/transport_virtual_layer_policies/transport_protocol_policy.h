@@ -3,6 +3,7 @@
 
 #include <cstdint>
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -26,18 +27,37 @@ class TransportProtocolPolicy {
  private:
   using SocketPtr = std::shared_ptr<Socket>;
   using TransportCb =
-      std::function<void(Socket&, const boost::system::error_code&)>;
+      std::function<void(Socket&, const boost::system::error_code&,
+                         uint32_t max_frame_size, uint64_t session_id)>;
 
  public:
-  TransportProtocolPolicy() {}
+  // Bounds of the maximum frame payload size negotiated during the handshake
+  enum : uint32_t {
+    kMinFrameSize = 4 * 1024,
+    kDefaultMaxFrameSize = 256 * 1024
+  };
+
+ public:
+  TransportProtocolPolicy() : max_frame_size_(kDefaultMaxFrameSize) {}
 
   virtual ~TransportProtocolPolicy() {}
 
-  void DoSSFInitiate(Socket& socket, TransportCb callback) {
+  // Set the maximum frame payload size proposed to the remote end
+  void set_max_frame_size(uint32_t max_frame_size) {
+    max_frame_size_ = std::max<uint32_t>(max_frame_size, kMinFrameSize);
+  }
+
+  uint32_t max_frame_size() const { return max_frame_size_; }
+
+  // Links initiated with the same non zero session id are demultiplexed
+  // together by the server
+  void DoSSFInitiate(Socket& socket, TransportCb callback,
+                     uint64_t session_id = 0) {
     SSF_LOG("transport", debug, "starting SSF protocol");
 
     uint32_t version = GetVersion();
-    auto p_ssf_request = std::make_shared<SSFRequest>(version);
+    auto p_ssf_request =
+        std::make_shared<SSFRequest>(version, max_frame_size_, session_id);
 
     auto on_write = [this, p_ssf_request, &socket, callback](
         const boost::system::error_code& ec, size_t length) {
@@ -53,7 +73,7 @@ class TransportProtocolPolicy {
         const boost::system::error_code& ec, size_t length) {
       DoSSFValid(p_ssf_request, socket, callback, ec, length);
     };
-    boost::asio::async_read(socket, p_ssf_request->buffer(), on_read);
+    boost::asio::async_read(socket, p_ssf_request->version_buffer(), on_read);
   }
 
   void DoSSFValid(SSFRequestPtr p_ssf_request, Socket& socket,
@@ -62,7 +82,7 @@ class TransportProtocolPolicy {
     if (ec) {
       SSF_LOG("transport", error, "SSF version NOT read {}", ec.message());
       socket.get_io_service().post(
-          [&socket, ec, callback]() { callback(socket, ec); });
+          [&socket, ec, callback]() { callback(socket, ec, 0, 0); });
       return;
     }
 
@@ -75,14 +95,53 @@ class TransportProtocolPolicy {
       boost::system::error_code result_ec(::error::wrong_protocol_type,
                                           ::error::get_ssf_category());
       socket.get_io_service().post(
-          [&socket, result_ec, callback]() { callback(socket, result_ec); });
+          [&socket, result_ec, callback]() {
+            callback(socket, result_ec, 0, 0);
+          });
+      return;
+    }
+
+    // The remaining request fields are only sent by supported versions
+    auto on_read = [this, p_ssf_request, &socket, callback](
+        const boost::system::error_code& ec, size_t length) {
+      DoSSFNegotiate(p_ssf_request, socket, callback, ec, length);
+    };
+    boost::asio::async_read(socket, p_ssf_request->parameters_buffer(),
+                            on_read);
+  }
+
+  void DoSSFNegotiate(SSFRequestPtr p_ssf_request, Socket& socket,
+                      TransportCb callback, const boost::system::error_code& ec,
+                      size_t length) {
+    if (ec) {
+      SSF_LOG("transport", error, "SSF request NOT read {}", ec.message());
+      socket.get_io_service().post(
+          [&socket, ec, callback]() { callback(socket, ec, 0, 0); });
+      return;
+    }
+
+    auto max_frame_size =
+        std::min(max_frame_size_, p_ssf_request->max_frame_size());
+    if (max_frame_size < kMinFrameSize) {
+      SSF_LOG("transport", error, "SSF max frame size NOT supported {}",
+              p_ssf_request->max_frame_size());
+      boost::system::error_code result_ec(::error::wrong_protocol_type,
+                                          ::error::get_ssf_category());
+      socket.get_io_service().post(
+          [&socket, result_ec, callback]() {
+            callback(socket, result_ec, 0, 0);
+          });
       return;
     }
 
-    auto p_ssf_reply = std::make_shared<SSFReply>(true);
-    auto on_write = [this, p_ssf_reply, &socket, callback](
+    SSF_LOG("transport", debug, "SSF max frame size {}", max_frame_size);
+
+    auto session_id = p_ssf_request->session_id();
+    auto p_ssf_reply = std::make_shared<SSFReply>(true, max_frame_size);
+    auto on_write = [this, p_ssf_reply, session_id, &socket, callback](
         const boost::system::error_code& ec, size_t length) {
-      DoSSFProtocolFinished(p_ssf_reply, socket, callback, ec, length);
+      DoSSFProtocolFinished(p_ssf_reply, session_id, socket, callback, ec,
+                            length);
     };
     boost::asio::async_write(socket, p_ssf_reply->const_buffer(), on_write);
   }
@@ -94,42 +153,69 @@ class TransportProtocolPolicy {
       SSF_LOG("transport", error, "could NOT send the SSF request {}",
               ec.message());
       socket.get_io_service().post(
-          [&socket, ec, callback]() { callback(socket, ec); });
+          [&socket, ec, callback]() { callback(socket, ec, 0, 0); });
       return;
     }
 
     SSF_LOG("transport", debug, "SSF request sent");
 
+    auto session_id = p_ssf_request->session_id();
     auto p_ssf_reply = std::make_shared<SSFReply>();
 
-    auto on_read = [this, p_ssf_reply, &socket, callback](
+    auto on_read = [this, p_ssf_reply, session_id, &socket, callback](
+        const boost::system::error_code& ec, size_t length) {
+      DoSSFReplyReceive(p_ssf_reply, session_id, socket, callback, ec, length);
+    };
+    boost::asio::async_read(socket, p_ssf_reply->result_buffer(), on_read);
+  }
+
+  void DoSSFReplyReceive(SSFReplyPtr p_ssf_reply, uint64_t session_id,
+                         Socket& socket, TransportCb callback,
+                         const boost::system::error_code& ec, size_t length) {
+    if (ec || !p_ssf_reply->result()) {
+      // Nothing follows a negative reply
+      DoSSFProtocolFinished(p_ssf_reply, session_id, socket, callback, ec,
+                            length);
+      return;
+    }
+
+    auto on_read = [this, p_ssf_reply, session_id, &socket, callback](
         const boost::system::error_code& ec, size_t length) {
-      DoSSFProtocolFinished(p_ssf_reply, socket, callback, ec, length);
+      DoSSFProtocolFinished(p_ssf_reply, session_id, socket, callback, ec,
+                            length);
     };
-    boost::asio::async_read(socket, p_ssf_reply->buffer(), on_read);
+    boost::asio::async_read(socket, p_ssf_reply->max_frame_size_buffer(),
+                            on_read);
   }
 
-  void DoSSFProtocolFinished(SSFReplyPtr p_ssf_reply, Socket& socket,
-                             TransportCb callback,
+  void DoSSFProtocolFinished(SSFReplyPtr p_ssf_reply, uint64_t session_id,
+                             Socket& socket, TransportCb callback,
                              const boost::system::error_code& ec,
                              size_t length) {
     if (ec) {
       SSF_LOG("transport", error, "could NOT read SSF reply ", ec.message());
       socket.get_io_service().post(
-          [&socket, ec, callback]() { callback(socket, ec); });
+          [&socket, ec, callback]() { callback(socket, ec, 0, 0); });
       return;
     }
-    if (!p_ssf_reply->result()) {
+    auto max_frame_size =
+        std::min(max_frame_size_, p_ssf_reply->max_frame_size());
+    if (!p_ssf_reply->result() || max_frame_size < kMinFrameSize) {
       boost::system::error_code result_ec(::error::wrong_protocol_type,
                                           ::error::get_ssf_category());
       SSF_LOG("transport", error, "SSF reply NOT ok {}", ec.message());
       socket.get_io_service().post(
-          [&socket, result_ec, callback]() { callback(socket, result_ec); });
+          [&socket, result_ec, callback]() {
+            callback(socket, result_ec, 0, 0);
+          });
       return;
     }
-    SSF_LOG("transport", trace, "SSF reply OK");
+    SSF_LOG("transport", trace, "SSF reply OK (max frame size {})",
+            max_frame_size);
     socket.get_io_service().post(
-        [&socket, ec, callback]() { callback(socket, ec); });
+        [&socket, ec, callback, max_frame_size, session_id]() {
+          callback(socket, ec, max_frame_size, session_id);
+        });
   }
 
   uint32_t GetVersion() {
@@ -161,6 +247,9 @@ class TransportProtocolPolicy {
 
     return (major == versions::major) && (transport == versions::transport);
   }
+
+ private:
+  uint32_t max_frame_size_;
 };
 
 }  // ssf
@@ -31,6 +31,8 @@ class basic_pending_read_stream_operation
  protected:
   typedef size_t (*fill_buffer_func_type)(
       basic_pending_read_stream_operation*, boost::asio::streambuf&);
+  typedef boost::asio::mutable_buffer (*first_buffer_func_type)(
+      basic_pending_read_stream_operation*);
 
  protected:
   /// Constructor
@@ -39,17 +41,26 @@ class basic_pending_read_stream_operation
   */
   basic_pending_read_stream_operation(
       basic_pending_sized_io_operation::func_type func,
-      fill_buffer_func_type fill_buffer_func)
+      fill_buffer_func_type fill_buffer_func,
+      first_buffer_func_type first_buffer_func)
       : basic_pending_sized_io_operation(func),
-        fill_buffer_func_(fill_buffer_func) {}
+        fill_buffer_func_(fill_buffer_func),
+        first_buffer_func_(first_buffer_func) {}
 
  public:
    size_t fill_buffer(boost::asio::streambuf& stream) {
     return fill_buffer_func_(this, stream);
   }
 
+  /// Get the first non empty buffer of the operation (to receive into it
+  /// directly)
+  boost::asio::mutable_buffer first_buffer() {
+    return first_buffer_func_(this);
+  }
+
  private:
   fill_buffer_func_type fill_buffer_func_;
+  first_buffer_func_type first_buffer_func_;
 };
 
 /// Class to store read operations
@@ -70,7 +81,8 @@ class pending_read_stream_operation
                                 Handler handler)
       : basic_pending_read_stream_operation(
             &pending_read_stream_operation::do_complete,
-            &pending_read_stream_operation::do_fill_buffer),
+            &pending_read_stream_operation::do_fill_buffer,
+            &pending_read_stream_operation::do_first_buffer),
         buffers_(buffers),
         handler_(std::move(handler)) {}
 
@@ -125,6 +137,21 @@ class pending_read_stream_operation
     return copied;
   }
 
+  static boost::asio::mutable_buffer do_first_buffer(
+      basic_pending_read_stream_operation* base) {
+    pending_read_stream_operation* o(
+        static_cast<pending_read_stream_operation*>(base));
+
+    for (auto it = o->buffers_.begin(); it != o->buffers_.end(); ++it) {
+      boost::asio::mutable_buffer buffer(*it);
+      if (boost::asio::buffer_size(buffer)) {
+        return buffer;
+      }
+    }
+
+    return boost::asio::mutable_buffer();
+  }
+
  private:
   MutableBufferSequence buffers_;
   Handler handler_;
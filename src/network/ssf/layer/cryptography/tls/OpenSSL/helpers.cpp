@@ -1,5 +1,15 @@
 #include "ssf/layer/cryptography/tls/OpenSSL/helpers.h"
 
+#include <cstring>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
 #include "ssf/error/error.h"
 #include "ssf/log/log.h"
 #include "ssf/utils/cleaner.h"
@@ -10,12 +20,257 @@ namespace layer {
 namespace cryptography {
 namespace detail {
 
+namespace {
+
+int GetSessionResumptionIndex() {
+  static int index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+int GetPeerIndex() {
+  static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+// OpenSSL marks the session of a connection freed without a TLS shutdown as
+// not resumable: the connections work on copies of the kept sessions
+SSL_SESSION* DuplicateSession(SSL_SESSION* p_session) {
+#if OPENSSL_VERSION_NUMBER < 0x10101000L
+  int size = i2d_SSL_SESSION(p_session, nullptr);
+  if (size <= 0) {
+    return nullptr;
+  }
+  std::vector<unsigned char> der(static_cast<std::size_t>(size));
+  unsigned char* p_der_out = der.data();
+  i2d_SSL_SESSION(p_session, &p_der_out);
+  const unsigned char* p_der_in = der.data();
+  return d2i_SSL_SESSION(nullptr, &p_der_in, size);
+#else
+  return SSL_SESSION_dup(p_session);
+#endif
+}
+
+// Contexts with session resumption enabled are shared by all the endpoints
+// with the same parameters so that the sessions outlive the connections
+const std::size_t kMaxResumableContexts = 16;
+
+struct ResumableContext {
+  ExtendedTLSContext context;
+  std::chrono::steady_clock::time_point creation;
+};
+
+std::mutex resumable_contexts_mutex;
+std::map<LayerParameters, ResumableContext> resumable_contexts;
+
+// Endpoint copy of a shared context
+ExtendedTLSContext WithPeer(ExtendedTLSContext context,
+                            const std::string& peer) {
+  context.p_peer_ = std::make_shared<const std::string>(peer);
+  return context;
+}
+
+}  // unnamed namespace
+
+TLSSessionResumption::TLSSessionResumption(std::chrono::seconds session_lifetime)
+    : session_lifetime_(session_lifetime),
+      mutex_(),
+      current_key_(),
+      previous_key_(),
+      has_current_key_(false),
+      has_previous_key_(false),
+      current_key_creation_(),
+      client_sessions_(),
+      client_session_uses_(0) {}
+
+TLSSessionResumption::~TLSSessionResumption() {
+  for (auto& client_session : client_sessions_) {
+    SSL_SESSION_free(client_session.second.p_session);
+  }
+}
+
+void TLSSessionResumption::Enable(SSL_CTX* p_ctx) {
+  SSL_CTX_set_ex_data(p_ctx, GetSessionResumptionIndex(), this);
+
+  SSL_CTX_clear_options(p_ctx, SSL_OP_NO_TICKET);
+  SSL_CTX_set_session_cache_mode(p_ctx, SSL_SESS_CACHE_BOTH);
+
+  // Mandatory for the server to resume sessions with verified peers
+  static const unsigned char session_id_context[] = "ssf";
+  SSL_CTX_set_session_id_context(p_ctx, session_id_context,
+                                 sizeof(session_id_context) - 1);
+  SSL_CTX_set_timeout(p_ctx, static_cast<long>(session_lifetime_.count()));
+
+  SSL_CTX_set_tlsext_ticket_key_cb(p_ctx,
+                                   &TLSSessionResumption::TicketKeyCallback);
+  SSL_CTX_sess_set_new_cb(p_ctx, &TLSSessionResumption::NewSessionCallback);
+}
+
+void TLSSessionResumption::ResumeSession(SSL* p_ssl,
+                                         const std::string* p_peer) {
+  SSL_set_ex_data(p_ssl, GetPeerIndex(),
+                  const_cast<void*>(static_cast<const void*>(p_peer)));
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto session_it = client_sessions_.find(*p_peer);
+  if (session_it != client_sessions_.end()) {
+    session_it->second.last_use = ++client_session_uses_;
+    auto p_session = DuplicateSession(session_it->second.p_session);
+    if (p_session) {
+      SSL_set_session(p_ssl, p_session);
+      SSL_SESSION_free(p_session);
+    }
+  }
+}
+
+TLSSessionResumption* TLSSessionResumption::Get(SSL* p_ssl) {
+  return static_cast<TLSSessionResumption*>(SSL_CTX_get_ex_data(
+      SSL_get_SSL_CTX(p_ssl), GetSessionResumptionIndex()));
+}
+
+int TLSSessionResumption::TicketKeyCallback(SSL* p_ssl, unsigned char* key_name,
+                                            unsigned char* iv,
+                                            EVP_CIPHER_CTX* p_cipher_ctx,
+                                            HMAC_CTX* p_hmac_ctx, int enc) {
+  auto p_self = Get(p_ssl);
+  if (!p_self) {
+    return -1;
+  }
+
+  std::unique_lock<std::mutex> lock(p_self->mutex_);
+  p_self->RotateKeys();
+  if (!p_self->has_current_key_) {
+    return -1;
+  }
+
+  if (enc) {
+    // New ticket: always encrypted with the current key
+    const auto& key = p_self->current_key_;
+    if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) {
+      return -1;
+    }
+    std::memcpy(key_name, key.name, sizeof(key.name));
+    EVP_EncryptInit_ex(p_cipher_ctx, EVP_aes_256_cbc(), nullptr, key.aes_key,
+                       iv);
+    HMAC_Init_ex(p_hmac_ctx, key.hmac_key, sizeof(key.hmac_key), EVP_sha256(),
+                 nullptr);
+    return 1;
+  }
+
+  const TicketKey* p_key = nullptr;
+  int result = 0;
+  if (!std::memcmp(key_name, p_self->current_key_.name,
+                   sizeof(p_self->current_key_.name))) {
+    p_key = &p_self->current_key_;
+    result = 1;
+  } else if (p_self->has_previous_key_ &&
+             !std::memcmp(key_name, p_self->previous_key_.name,
+                          sizeof(p_self->previous_key_.name))) {
+    // Valid ticket but the client should get a new one
+    p_key = &p_self->previous_key_;
+    result = 2;
+  }
+
+  if (!p_key) {
+    // Unknown key: fall back to a full handshake
+    return 0;
+  }
+
+  HMAC_Init_ex(p_hmac_ctx, p_key->hmac_key, sizeof(p_key->hmac_key),
+               EVP_sha256(), nullptr);
+  EVP_DecryptInit_ex(p_cipher_ctx, EVP_aes_256_cbc(), nullptr, p_key->aes_key,
+                     iv);
+  return result;
+}
+
+int TLSSessionResumption::NewSessionCallback(SSL* p_ssl,
+                                             SSL_SESSION* p_session) {
+  if (SSL_is_server(p_ssl)) {
+    return 0;
+  }
+
+  auto p_self = Get(p_ssl);
+  auto p_peer =
+      static_cast<const std::string*>(SSL_get_ex_data(p_ssl, GetPeerIndex()));
+  if (!p_self || !p_peer) {
+    return 0;
+  }
+
+  auto p_kept_session = DuplicateSession(p_session);
+  if (!p_kept_session) {
+    return 0;
+  }
+
+  std::unique_lock<std::mutex> lock(p_self->mutex_);
+  auto& sessions = p_self->client_sessions_;
+  auto session_it = sessions.find(*p_peer);
+  if (session_it != sessions.end()) {
+    SSL_SESSION_free(session_it->second.p_session);
+  } else if (sessions.size() >= kMaxClientSessions) {
+    auto oldest_it = std::min_element(
+        sessions.begin(), sessions.end(),
+        [](const std::pair<const std::string, ClientSession>& lhs,
+           const std::pair<const std::string, ClientSession>& rhs) {
+          return lhs.second.last_use < rhs.second.last_use;
+        });
+    SSL_SESSION_free(oldest_it->second.p_session);
+    sessions.erase(oldest_it);
+  }
+
+  sessions[*p_peer] = {p_kept_session, ++p_self->client_session_uses_};
+  return 0;
+}
+
+bool TLSSessionResumption::GenerateKey(TicketKey* p_key) {
+  return RAND_bytes(p_key->name, sizeof(p_key->name)) == 1 &&
+         RAND_bytes(p_key->aes_key, sizeof(p_key->aes_key)) == 1 &&
+         RAND_bytes(p_key->hmac_key, sizeof(p_key->hmac_key)) == 1;
+}
+
+void TLSSessionResumption::RotateKeys() {
+  auto now = std::chrono::steady_clock::now();
+  if (has_current_key_ && now - current_key_creation_ < session_lifetime_) {
+    return;
+  }
+
+  TicketKey new_key;
+  if (!GenerateKey(&new_key)) {
+    SSF_LOG("network_crypto", error, "could not generate session ticket key");
+    return;
+  }
+
+  // A previous key older than two lifetimes only protects expired sessions
+  has_previous_key_ =
+      has_current_key_ && now - current_key_creation_ < 2 * session_lifetime_;
+  previous_key_ = current_key_;
+  current_key_ = new_key;
+  has_current_key_ = true;
+  current_key_creation_ = now;
+}
+
 ExtendedTLSContext::ExtendedTLSContext(
     std::shared_ptr<boost::asio::ssl::context> p_ctx)
-    : p_ctx_(std::move(p_ctx)) {}
+    : p_ctx_(std::move(p_ctx)),
+      p_session_resumption_(nullptr),
+      p_peer_(nullptr),
+      kernel_tls_(false) {}
+
+ExtendedTLSContext::ExtendedTLSContext(
+    std::shared_ptr<boost::asio::ssl::context> p_ctx,
+    std::shared_ptr<TLSSessionResumption> p_session_resumption)
+    : p_ctx_(std::move(p_ctx)),
+      p_session_resumption_(std::move(p_session_resumption)),
+      p_peer_(nullptr),
+      kernel_tls_(false) {}
 
 ExtendedTLSContext::~ExtendedTLSContext() {}
 
+void ExtendedTLSContext::ResumeSession(SSL* p_ssl) {
+  if (p_session_resumption_ && p_peer_) {
+    p_session_resumption_->ResumeSession(p_ssl, p_peer_.get());
+  }
+}
+
 boost::asio::ssl::context& ExtendedTLSContext::operator*() { return *p_ctx_; }
 std::shared_ptr<boost::asio::ssl::context> ExtendedTLSContext::operator->() {
   return p_ctx_;
@@ -36,7 +291,39 @@ bool ExtendedTLSContext::operator<(const ExtendedTLSContext& other) const {
 bool ExtendedTLSContext::operator!() const { return !p_ctx_; }
 
 ExtendedTLSContext make_tls_context(boost::asio::io_service& io_service,
-                                    const LayerParameters& parameters) {
+                                    const LayerParameters& parameters,
+                                    const std::string& peer) {
+  bool resumable =
+      helpers::GetField<std::string>("session_resumption", parameters) ==
+      "true";
+
+  std::unique_lock<std::mutex> resumable_lock(resumable_contexts_mutex,
+                                              std::defer_lock);
+  if (resumable) {
+    resumable_lock.lock();
+    auto now = std::chrono::steady_clock::now();
+    auto context_it = resumable_contexts.find(parameters);
+    if (context_it != resumable_contexts.end()) {
+      const auto& resumable_context = context_it->second;
+      if (now - resumable_context.creation <
+          resumable_context.context.p_session_resumption_->session_lifetime()) {
+        return WithPeer(resumable_context.context, peer);
+      }
+      // Expired: the sessions are too old and the certificates are reloaded
+      resumable_contexts.erase(context_it);
+    }
+
+    if (resumable_contexts.size() >= kMaxResumableContexts) {
+      auto oldest_it = std::min_element(
+          resumable_contexts.begin(), resumable_contexts.end(),
+          [](const std::pair<const LayerParameters, ResumableContext>& lhs,
+             const std::pair<const LayerParameters, ResumableContext>& rhs) {
+            return lhs.second.creation < rhs.second.creation;
+          });
+      resumable_contexts.erase(oldest_it);
+    }
+  }
+
   auto p_ctx = std::make_shared<boost::asio::ssl::context>(
       boost::asio::ssl::context::tlsv12);
 
@@ -105,12 +392,37 @@ ExtendedTLSContext make_tls_context(boost::asio::io_service& io_service,
 
   success |= SetCtxDhparam(ctx, parameters, ec);
 
+  ExtendedTLSContext context(p_ctx);
+
+  if (!SetCtxSessionResumption(context, parameters, ec)) {
+    SSF_LOG("network_crypto", error, "set context session resumption failed");
+    success = false;
+  }
+  if (!SetBufferingSettings(context, parameters, ec)) {
+    SSF_LOG("network_crypto", error, "invalid receive buffering settings");
+    success = false;
+  }
+
+  context.kernel_tls_ =
+      helpers::GetField<std::string>("kernel_tls", parameters) == "true";
+#ifdef SSL_OP_NO_RENEGOTIATION
+  if (context.kernel_tls_) {
+    // The user space engine must not write records once the kernel encrypts
+    SSL_CTX_set_options(ctx.native_handle(), SSL_OP_NO_RENEGOTIATION);
+  }
+#endif
+
   if (!success) {
     SSF_LOG("network_crypto", error, "context init failed");
     return ExtendedTLSContext(nullptr);
   }
 
-  return ExtendedTLSContext(p_ctx);
+  if (resumable) {
+    resumable_contexts[parameters] = {context,
+                                      std::chrono::steady_clock::now()};
+  }
+
+  return WithPeer(context, peer);
 }
 
 bool SetCtxCipher(boost::asio::ssl::context& ctx,
@@ -190,6 +502,69 @@ bool SetCtxKey(boost::asio::ssl::context& ctx,
   }
 }
 
+bool SetCtxSessionResumption(ExtendedTLSContext& context,
+                             const LayerParameters& parameters,
+                             boost::system::error_code& ec) {
+  if (helpers::GetField<std::string>("session_resumption", parameters) !=
+      "true") {
+    return true;
+  }
+
+  uint32_t session_lifetime = 3600;
+  if (parameters.count("session_lifetime") > 0) {
+    try {
+      session_lifetime = std::stoul(
+          helpers::GetField<std::string>("session_lifetime", parameters));
+    } catch (const std::exception&) {
+      session_lifetime = 0;
+    }
+  }
+
+  if (session_lifetime == 0) {
+    ec.assign(ssf::error::invalid_argument, ssf::error::get_ssf_category());
+    return false;
+  }
+
+  context.p_session_resumption_ = std::make_shared<TLSSessionResumption>(
+      std::chrono::seconds(session_lifetime));
+  context.p_session_resumption_->Enable(context->native_handle());
+
+  return true;
+}
+
+bool SetBufferingSettings(ExtendedTLSContext& context,
+                          const LayerParameters& parameters,
+                          boost::system::error_code& ec) {
+  auto& settings = context.buffering_settings_;
+
+  settings.direct_read =
+      helpers::GetField<std::string>("direct_read", parameters) == "true";
+
+  auto get_size = [&parameters](const std::string& field,
+                                std::size_t* p_size) -> bool {
+    if (parameters.count(field) == 0) {
+      return true;
+    }
+    try {
+      *p_size = std::stoull(helpers::GetField<std::string>(field, parameters));
+    } catch (const std::exception&) {
+      return false;
+    }
+    return *p_size > 0;
+  };
+
+  if (!get_size("receive_buffer_size", &settings.receive_buffer_size) ||
+      !get_size("receive_queue_low_bound", &settings.queue_low_bound) ||
+      !get_size("receive_queue_high_bound", &settings.queue_high_bound) ||
+      !get_size("direct_read_threshold", &settings.direct_read_threshold) ||
+      settings.queue_low_bound > settings.queue_high_bound) {
+    ec.assign(ssf::error::invalid_argument, ssf::error::get_ssf_category());
+    return false;
+  }
+
+  return true;
+}
+
 bool SetCtxDhparam(boost::asio::ssl::context& ctx,
                    const LayerParameters& parameters,
                    boost::system::error_code& ec) {
@@ -3,8 +3,10 @@
 
 #include <cstdint>
 
+#include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include <boost/asio/io_service.hpp>
@@ -17,13 +19,120 @@ namespace layer {
 namespace cryptography {
 namespace detail {
 
+/// Session resumption state shared by the connections of a TLS context
+/**
+* Servers issue session tickets encrypted with in memory keys. The key is
+* rotated every session lifetime and the previous key is still accepted (and
+* its tickets renewed) during one more lifetime. Clients keep the last session
+* established with each peer (up to kMaxClientSessions peers) and offer it on
+* the next handshake with the same peer.
+*/
+class TLSSessionResumption {
+ public:
+  enum : std::size_t { kMaxClientSessions = 64 };
+
+ public:
+  explicit TLSSessionResumption(std::chrono::seconds session_lifetime);
+  ~TLSSessionResumption();
+
+  TLSSessionResumption(const TLSSessionResumption&) = delete;
+  TLSSessionResumption& operator=(const TLSSessionResumption&) = delete;
+
+  /// Enable session tickets and session caching on the given context
+  void Enable(SSL_CTX* p_ctx);
+
+  /// Offer the last session established with the peer on a client connection
+  /**
+  * @param p_ssl The client connection
+  * @param p_peer The peer of the connection: the session established by the
+  *   connection is kept for it. It must outlive the handshake.
+  */
+  void ResumeSession(SSL* p_ssl, const std::string* p_peer);
+
+  std::chrono::seconds session_lifetime() const { return session_lifetime_; }
+
+ private:
+  struct TicketKey {
+    unsigned char name[16];
+    unsigned char aes_key[32];
+    unsigned char hmac_key[32];
+  };
+
+  struct ClientSession {
+    SSL_SESSION* p_session;
+    uint64_t last_use;
+  };
+
+  static TLSSessionResumption* Get(SSL* p_ssl);
+
+  static int TicketKeyCallback(SSL* p_ssl, unsigned char* key_name,
+                               unsigned char* iv, EVP_CIPHER_CTX* p_cipher_ctx,
+                               HMAC_CTX* p_hmac_ctx, int enc);
+
+  static int NewSessionCallback(SSL* p_ssl, SSL_SESSION* p_session);
+
+  bool GenerateKey(TicketKey* p_key);
+  void RotateKeys();
+
+ private:
+  std::chrono::seconds session_lifetime_;
+  std::mutex mutex_;
+  TicketKey current_key_;
+  TicketKey previous_key_;
+  bool has_current_key_;
+  bool has_previous_key_;
+  std::chrono::steady_clock::time_point current_key_creation_;
+  // last session by peer, the least recently used is dropped first
+  std::map<std::string, ClientSession> client_sessions_;
+  uint64_t client_session_uses_;
+};
+
+/// Bounds of the receive buffering of a TLS stream
+struct TLSBufferingSettings {
+  enum {
+    kDefaultQueueLowBound = 1 * 1024 * 1024,
+    kDefaultQueueHighBound = 16 * 1024 * 1024,
+    kDefaultReceiveBufferSize = 50 * 1024,
+    kDefaultDirectReadThreshold = 4 * 1024
+  };
+
+  TLSBufferingSettings()
+      : queue_low_bound(kDefaultQueueLowBound),
+        queue_high_bound(kDefaultQueueHighBound),
+        receive_buffer_size(kDefaultReceiveBufferSize),
+        direct_read(false),
+        direct_read_threshold(kDefaultDirectReadThreshold) {}
+
+  // Restart pulling when less data is queued
+  std::size_t queue_low_bound;
+  // Stop pulling when more data is queued
+  std::size_t queue_high_bound;
+  // Size of the buffered reads
+  std::size_t receive_buffer_size;
+  // Decrypt into the user buffers when no data is queued
+  bool direct_read;
+  // Smaller user reads are buffered
+  std::size_t direct_read_threshold;
+};
+
 struct ExtendedTLSContext {
-  ExtendedTLSContext() : p_ctx_(nullptr) {}
+  ExtendedTLSContext()
+      : p_ctx_(nullptr),
+        p_session_resumption_(nullptr),
+        p_peer_(nullptr),
+        kernel_tls_(false) {}
 
   explicit ExtendedTLSContext(std::shared_ptr<boost::asio::ssl::context> p_ctx);
 
+  ExtendedTLSContext(
+      std::shared_ptr<boost::asio::ssl::context> p_ctx,
+      std::shared_ptr<TLSSessionResumption> p_session_resumption);
+
   ~ExtendedTLSContext();
 
+  /// Offer a previous session on a client connection (if resumption enabled)
+  void ResumeSession(SSL* p_ssl);
+
   boost::asio::ssl::context& operator*();
   std::shared_ptr<boost::asio::ssl::context> operator->();
 
@@ -33,10 +142,26 @@ struct ExtendedTLSContext {
   bool operator!() const;
 
   std::shared_ptr<boost::asio::ssl::context> p_ctx_;
+  std::shared_ptr<TLSSessionResumption> p_session_resumption_;
+  // Lower layers of the endpoint: the client sessions are resumed by peer
+  std::shared_ptr<const std::string> p_peer_;
+  TLSBufferingSettings buffering_settings_;
+  bool kernel_tls_;
 };
 
+/// Make the TLS context of an endpoint
+/**
+* With session resumption, the contexts are shared by the endpoints with the
+* same parameters (up to kMaxResumableContexts) during one session lifetime,
+* after which the certificates are loaded again.
+*
+* @param parameters The parameters of the TLS layer
+* @param peer The parameters of the layers below, identifying the peer of a
+*   client endpoint
+*/
 ExtendedTLSContext make_tls_context(boost::asio::io_service& io_service,
-                                    const LayerParameters& parameters);
+                                    const LayerParameters& parameters,
+                                    const std::string& peer = "");
 bool SetCtxCipher(boost::asio::ssl::context& ctx,
                   const LayerParameters& parameters,
                   boost::system::error_code& ec);
@@ -52,6 +177,14 @@ bool SetCtxKey(boost::asio::ssl::context& ctx,
                const LayerParameters& parameters,
                boost::system::error_code& ec);
 
+bool SetCtxSessionResumption(ExtendedTLSContext& context,
+                             const LayerParameters& parameters,
+                             boost::system::error_code& ec);
+
+bool SetBufferingSettings(ExtendedTLSContext& context,
+                          const LayerParameters& parameters,
+                          boost::system::error_code& ec);
+
 bool SetCtxDhparam(boost::asio::ssl::context& ctx,
                    const LayerParameters& parameters,
                    boost::system::error_code& ec);
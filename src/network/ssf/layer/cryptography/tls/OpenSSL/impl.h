@@ -3,6 +3,7 @@
 
 #include <cstdint>
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -19,6 +20,7 @@
 #include <boost/system/error_code.hpp>
 
 #include "ssf/layer/cryptography/tls/OpenSSL/helpers.h"
+#include "ssf/layer/cryptography/tls/OpenSSL/ktls.h"
 
 #include "ssf/error/error.h"
 #include "ssf/io/read_stream_op.h"
@@ -28,6 +30,7 @@
 #include "ssf/layer/protocol_attributes.h"
 
 #include "ssf/log/log.h"
+#include "ssf/metrics/metrics.h"
 
 namespace ssf {
 namespace layer {
@@ -35,17 +38,33 @@ namespace cryptography {
 
 namespace detail {
 
+/// Record the duration of a successful handshake or count the failure
+inline void RecordHandshake(std::chrono::steady_clock::time_point start,
+                            const boost::system::error_code& ec) {
+  if (!ssf::metrics::Enabled()) {
+    return;
+  }
+
+  if (ec) {
+    SSF_METRICS_COUNT("tls.handshake_errors", 1);
+    return;
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  SSF_METRICS_RECORD("tls.handshake_time_us", duration.count());
+}
+
 /// The class in charge of receiving data from a TLS stream into a buffer
+/**
+* With direct reads enabled, a user read pending while no data is queued
+* decrypts straight into the user buffer. Data is buffered for the reads
+* smaller than the direct read threshold and while no read is pending,
+* bounded by the queue bounds of the settings.
+*/
 template <typename NextLayerStreamSocket>
 class TLSStreamBufferer : public std::enable_shared_from_this<
                               TLSStreamBufferer<NextLayerStreamSocket>> {
- private:
-  enum {
-    lower_queue_size_bound = 1 * 1024 * 1024,
-    higher_queue_size_bound = 16 * 1024 * 1024,
-    receive_buffer_size = 50 * 1024
-  };
-
  private:
   typedef boost::asio::ssl::stream<NextLayerStreamSocket> tls_stream_type;
   typedef std::shared_ptr<tls_stream_type> p_tls_stream_type;
@@ -63,19 +82,22 @@ class TLSStreamBufferer : public std::enable_shared_from_this<
   TLSStreamBufferer(const TLSStreamBufferer&) = delete;
   TLSStreamBufferer& operator=(const TLSStreamBufferer&) = delete;
 
-  ~TLSStreamBufferer() {}
+  ~TLSStreamBufferer() {
+    SSF_METRICS_GAUGE_ADD("tls.buffered_bytes",
+                          -static_cast<int64_t>(reported_size_));
+  }
 
-  static p_puller_type create(p_tls_stream_type p_socket,
-                              p_strand_type p_strand) {
-    return p_puller_type(new puller_type(p_socket, p_strand));
+  static p_puller_type create(
+      p_tls_stream_type p_socket, p_strand_type p_strand,
+      const TLSBufferingSettings& settings = TLSBufferingSettings()) {
+    return p_puller_type(new puller_type(p_socket, p_strand, settings));
   }
 
   /// Start receiving data
   void start_pulling() {
-    std::unique_lock<std::recursive_mutex> lock(pulling_mutex_);
+    std::unique_lock<std::recursive_mutex> lock(mutex_);
     if (!pulling_) {
       pulling_ = true;
-      SSF_LOG("network_crypto", debug, "pulling");
       io_service_.post(std::bind(&TLSStreamBufferer::async_pull_packets,
                                  this->shared_from_this()));
     }
@@ -104,14 +126,14 @@ class TLSStreamBufferer : public std::enable_shared_from_this<
       p.p = new (p.v) op(buffers, init.handler);
 
       {
-        std::unique_lock<std::recursive_mutex> lock(op_queue_mutex_);
+        std::unique_lock<std::recursive_mutex> lock(mutex_);
         op_queue_.push(p.p);
       }
 
       p.v = p.p = 0;
 
-      io_service_.post(std::bind(&TLSStreamBufferer::handle_data_n_ops,
-                                 this->shared_from_this()));
+      // Completions are posted: no user handler is called from here
+      handle_data_n_ops();
     } else {
       io_service_.post(std::bind(init.handler, boost::system::error_code(), 0));
     }
@@ -120,14 +142,10 @@ class TLSStreamBufferer : public std::enable_shared_from_this<
   }
 
   boost::system::error_code cancel(boost::system::error_code& ec) {
-    {
-      std::unique_lock<std::recursive_mutex> lock(pulling_mutex_);
-      pulling_ = false;
-    }
-
-    std::unique_lock<std::recursive_mutex> lock1(data_queue_mutex_);
-    std::unique_lock<std::recursive_mutex> lock2(op_queue_mutex_);
+    std::unique_lock<std::recursive_mutex> lock(mutex_);
+    pulling_ = false;
     data_queue_.consume(data_queue_.size());
+    report_buffered_size();
     while (!op_queue_.empty()) {
       auto op = op_queue_.front();
       op_queue_.pop();
@@ -144,30 +162,29 @@ class TLSStreamBufferer : public std::enable_shared_from_this<
   }
 
  private:
-  TLSStreamBufferer(p_tls_stream_type p_socket, p_strand_type p_strand)
+  TLSStreamBufferer(p_tls_stream_type p_socket, p_strand_type p_strand,
+                    const TLSBufferingSettings& settings)
       : socket_(*p_socket),
         p_socket_(p_socket),
         strand_(*p_strand),
         p_strand_(p_strand),
         io_service_(strand_.get_io_service()),
+        settings_(settings),
         status_(boost::system::error_code()),
-        pulling_(false) {}
+        pulling_(false),
+        reported_size_(0) {}
 
   /// Check if data is available for user requests
   void handle_data_n_ops() {
     auto self = this->shared_from_this();
 
+    std::unique_lock<std::recursive_mutex> lock(mutex_);
     if (!status_) {
-      {
-        std::unique_lock<std::recursive_mutex> lock(pulling_mutex_);
-        if ((data_queue_.size() < lower_queue_size_bound) && !pulling_) {
-          start_pulling();
-        }
+      if ((data_queue_.size() < settings_.queue_low_bound) && !pulling_) {
+        start_pulling();
       }
 
-      std::unique_lock<std::recursive_mutex> lock1(data_queue_mutex_);
-      std::unique_lock<std::recursive_mutex> lock2(op_queue_mutex_);
-      if (!op_queue_.empty() && data_queue_.size()) {
+      while (!op_queue_.empty() && data_queue_.size()) {
         auto op = op_queue_.front();
         op_queue_.pop();
 
@@ -177,21 +194,15 @@ class TLSStreamBufferer : public std::enable_shared_from_this<
           op->complete(boost::system::error_code(), copied);
         };
         io_service_.post(do_complete);
-
-        io_service_.dispatch(std::bind(&TLSStreamBufferer::handle_data_n_ops,
-                                       this->shared_from_this()));
       }
+      report_buffered_size();
     } else {
-      std::unique_lock<std::recursive_mutex> lock1(data_queue_mutex_);
-      std::unique_lock<std::recursive_mutex> lock2(op_queue_mutex_);
-      if (!op_queue_.empty()) {
+      while (!op_queue_.empty()) {
         auto op = op_queue_.front();
         op_queue_.pop();
-        auto do_complete = [this, self, op]() { op->complete(status_, 0); };
+        auto status = status_;
+        auto do_complete = [self, op, status]() { op->complete(status, 0); };
         io_service_.post(do_complete);
-
-        io_service_.dispatch(std::bind(&TLSStreamBufferer::handle_data_n_ops,
-                                       this->shared_from_this()));
       }
     }
   }
@@ -200,50 +211,112 @@ class TLSStreamBufferer : public std::enable_shared_from_this<
   void async_pull_packets() {
     auto self = this->shared_from_this();
 
-    auto handler = [this, self](const boost::system::error_code& ec,
-                                size_t length) {
-      if (!ec) {
-        {
-          std::unique_lock<std::recursive_mutex> lock1(this->data_queue_mutex_);
-          this->data_queue_.commit(length);
-        }
-
-        if (!this->status_) {
-          this->io_service_.dispatch(
-              std::bind(&TLSStreamBufferer::async_pull_packets,
-                        this->shared_from_this()));
-        }
-      } else {
-        if (ec.value() == boost::asio::error::operation_aborted) {
-          boost::system::error_code cancel_ec;
-          cancel(cancel_ec);
-        } else {
-          data_queue_.consume(data_queue_.size());
-          this->status_ = ec;
-          SSF_LOG("network_crypto", debug, "TLS connection terminated ({}: {})",
-                  ec.value(), ec.message());
-        }
+    std::unique_lock<std::recursive_mutex> lock(mutex_);
+    if (settings_.direct_read && !data_queue_.size() && !op_queue_.empty()) {
+      auto op = op_queue_.front();
+      auto buffer = op->first_buffer();
+      if (boost::asio::buffer_size(buffer) >= settings_.direct_read_threshold) {
+        op_queue_.pop();
+        auto handler = [this, self, op](const boost::system::error_code& ec,
+                                        size_t length) {
+          this->handle_direct_read(op, ec, length);
+        };
+        auto async_read_some = [this, self, buffer, handler]() {
+          socket_.async_read_some(boost::asio::mutable_buffers_1(buffer),
+                                  strand_.wrap(handler));
+        };
+        strand_.dispatch(async_read_some);
+        return;
       }
+    }
 
-      this->io_service_.dispatch(std::bind(
-          &TLSStreamBufferer::handle_data_n_ops, this->shared_from_this()));
-    };
-
-    {
-      std::unique_lock<std::recursive_mutex> lock(data_queue_mutex_);
+    if (data_queue_.size() < settings_.queue_high_bound) {
       boost::asio::streambuf::mutable_buffers_type bufs =
-          data_queue_.prepare(receive_buffer_size);
+          data_queue_.prepare(settings_.receive_buffer_size);
+      auto handler = [this, self](const boost::system::error_code& ec,
+                                  size_t length) {
+        this->handle_buffered_read(ec, length);
+      };
+      auto async_read_some = [this, self, bufs, handler]() {
+        socket_.async_read_some(bufs, strand_.wrap(handler));
+      };
+      strand_.dispatch(async_read_some);
+    } else {
+      pulling_ = false;
+      SSF_LOG("network_crypto", debug, "not pulling");
+    }
+  }
 
-      if (data_queue_.size() < higher_queue_size_bound) {
-        auto async_read_some = [this, self, bufs, handler]() {
-          socket_.async_read_some(bufs, strand_.wrap(handler));
-        };
-        strand_.dispatch(async_read_some);
-      } else {
-        pulling_ = false;
-        SSF_LOG("network_crypto", debug, "not pulling");
+  /// Complete the user read which received data directly
+  void handle_direct_read(io::basic_pending_read_stream_operation* op,
+                          const boost::system::error_code& ec, size_t length) {
+    auto self = this->shared_from_this();
+    if (!ec) {
+      SSF_METRICS_COUNT("tls.direct_reads", 1);
+      SSF_METRICS_COUNT("tls.direct_read_bytes", length);
+    }
+    auto do_complete = [self, op, ec, length]() { op->complete(ec, length); };
+    io_service_.post(do_complete);
+
+    if (!ec) {
+      io_service_.dispatch(std::bind(&TLSStreamBufferer::async_pull_packets,
+                                     this->shared_from_this()));
+      return;
+    }
+
+    if (ec.value() == boost::asio::error::operation_aborted) {
+      boost::system::error_code cancel_ec;
+      cancel(cancel_ec);
+      return;
+    }
+
+    set_status(ec);
+    handle_data_n_ops();
+  }
+
+  /// Queue the data received while no user read could receive it directly
+  void handle_buffered_read(const boost::system::error_code& ec,
+                            size_t length) {
+    if (!ec) {
+      std::unique_lock<std::recursive_mutex> lock(mutex_);
+      data_queue_.commit(length);
+      report_buffered_size();
+      SSF_METRICS_COUNT("tls.buffered_reads", 1);
+      SSF_METRICS_COUNT("tls.buffered_read_bytes", length);
+
+      if (!status_) {
+        io_service_.dispatch(std::bind(&TLSStreamBufferer::async_pull_packets,
+                                       this->shared_from_this()));
       }
+    } else if (ec.value() == boost::asio::error::operation_aborted) {
+      boost::system::error_code cancel_ec;
+      cancel(cancel_ec);
+    } else {
+      set_status(ec);
     }
+
+    handle_data_n_ops();
+  }
+
+  void set_status(const boost::system::error_code& ec) {
+    std::unique_lock<std::recursive_mutex> lock(mutex_);
+    data_queue_.consume(data_queue_.size());
+    report_buffered_size();
+    status_ = ec;
+    SSF_LOG("network_crypto", debug, "TLS connection terminated ({}: {})",
+            ec.value(), ec.message());
+  }
+
+  /// Move the buffered bytes gauge by the change of the data queue size
+  /**
+  * Must be called with the mutex held
+  */
+  void report_buffered_size() {
+    auto size = data_queue_.size();
+    SSF_METRICS_GAUGE_ADD("tls.buffered_bytes",
+                          static_cast<int64_t>(size) -
+                              static_cast<int64_t>(reported_size_));
+    reported_size_ = size;
   }
 
   /// The TLS stream to receive from
@@ -257,19 +330,25 @@ class TLSStreamBufferer : public std::enable_shared_from_this<
   /// The io_service handling asynchronous operations
   boost::asio::io_service& io_service_;
 
+  /// The buffering bounds and the direct read mode
+  TLSBufferingSettings settings_;
+
+  /// Protect the status, the data queue, the op queue and the pulling state
+  std::recursive_mutex mutex_;
+
   /// Errors during async_read are saved here
   boost::system::error_code status_;
 
   /// Handle the data received
-  std::recursive_mutex data_queue_mutex_;
   boost::asio::streambuf data_queue_;
 
   /// Handle pending user operations
-  std::recursive_mutex op_queue_mutex_;
   op_queue_type op_queue_;
 
-  std::recursive_mutex pulling_mutex_;
   bool pulling_;
+
+  /// Data queue size last added to the buffered bytes gauge
+  std::size_t reported_size_;
 };
 
 }  // detail
@@ -299,7 +378,8 @@ class basic_buffered_tls_socket {
         p_socket_(nullptr),
         socket_(),
         p_strand_(nullptr),
-        p_puller_(nullptr) {}
+        p_puller_(nullptr),
+        p_ktls_socket_(nullptr) {}
 
   basic_buffered_tls_socket(p_tls_stream_type p_socket, p_context_type p_ctx)
       : p_ctx_(p_ctx),
@@ -307,7 +387,9 @@ class basic_buffered_tls_socket {
         socket_(*p_socket_),
         p_strand_(std::make_shared<strand_type>(
             socket_.get().lowest_layer().get_io_service())),
-        p_puller_(puller_type::create(p_socket_, p_strand_)) {}
+        p_puller_(puller_type::create(p_socket_, p_strand_,
+                                      p_ctx_.buffering_settings_)),
+        p_ktls_socket_(nullptr) {}
 
   basic_buffered_tls_socket(boost::asio::io_service& io_service,
                             p_context_type p_ctx)
@@ -315,14 +397,17 @@ class basic_buffered_tls_socket {
         p_socket_(new tls_stream_type(io_service, *p_ctx)),
         socket_(*p_socket_),
         p_strand_(std::make_shared<strand_type>(io_service)),
-        p_puller_(puller_type::create(p_socket_, p_strand_)) {}
+        p_puller_(puller_type::create(p_socket_, p_strand_,
+                                      p_ctx_.buffering_settings_)),
+        p_ktls_socket_(nullptr) {}
 
   basic_buffered_tls_socket(basic_buffered_tls_socket&& other)
       : p_ctx_(std::move(other.p_ctx_)),
         p_socket_(std::move(other.p_socket_)),
         socket_(*p_socket_),
         p_strand_(std::move(other.p_strand_)),
-        p_puller_(std::move(other.p_puller_)) {
+        p_puller_(std::move(other.p_puller_)),
+        p_ktls_socket_(other.p_ktls_socket_) {
     other.socket_ = *(other.p_socket_);
   }
 
@@ -341,9 +426,13 @@ class basic_buffered_tls_socket {
 
   boost::system::error_code handshake(handshake_type type,
                                       boost::system::error_code& ec) {
+    prepare_handshake(type);
+    auto start = std::chrono::steady_clock::now();
     socket_.get().handshake(type, ec);
+    detail::RecordHandshake(start, ec);
 
     if (!ec) {
+      p_ktls_socket_ = detail::TryKernelTLSTx(p_ctx_, socket_.get());
       p_puller_->start_pulling();
     }
 
@@ -354,18 +443,22 @@ class basic_buffered_tls_socket {
   /// completion
   template <typename Handler>
   void async_handshake(handshake_type type, Handler handler) {
+    prepare_handshake(type);
     auto p_puller = p_puller_;
     auto p_socket = p_socket_;
     auto p_strand = p_strand_;
-    auto do_user_handler =
-        [this, p_puller, handler](const boost::system::error_code& ec) mutable {
-          if (!ec) {
-            p_puller->start_pulling();
-          } else {
-            SSF_LOG("network_crypto", debug, "TLS handshake failed");
-          }
-          handler(ec);
-        };
+    auto start = std::chrono::steady_clock::now();
+    auto do_user_handler = [this, p_puller, start, handler](
+        const boost::system::error_code& ec) mutable {
+      detail::RecordHandshake(start, ec);
+      if (!ec) {
+        p_ktls_socket_ = detail::TryKernelTLSTx(p_ctx_, socket_.get());
+        p_puller->start_pulling();
+      } else {
+        SSF_LOG("network_crypto", debug, "TLS handshake failed");
+      }
+      handler(ec);
+    };
 
     auto async_handshake = [p_socket, p_strand, type, do_user_handler]() {
       p_socket->async_handshake(type, p_strand->wrap(do_user_handler));
@@ -398,10 +491,14 @@ class basic_buffered_tls_socket {
   template <typename ConstBufferSequence>
   std::size_t write_some(const ConstBufferSequence& buffers,
                          boost::system::error_code& ec) {
+    if (p_ktls_socket_) {
+      return p_ktls_socket_->write_some(buffers, ec);
+    }
     return socket_.get().write_some(buffers, ec);
   }
 
-  /// Forward the call directly to the TLS stream (wrapped in an strand)
+  /// Forward the call directly to the TLS stream (wrapped in an strand), or
+  /// to the TCP socket when the kernel encrypts
   template <typename ConstBufferSequence, typename WriteHandler>
   BOOST_ASIO_INITFN_RESULT_TYPE(WriteHandler,
                                 void(boost::system::error_code, std::size_t))
@@ -410,7 +507,13 @@ class basic_buffered_tls_socket {
         WriteHandler, void(boost::system::error_code, std::size_t)>
         init(std::forward<WriteHandler>(handler));
     auto p_socket = p_socket_;
-    auto async_write_some = [this, p_socket, buffers, init]() {
+    auto p_ktls_socket = p_ktls_socket_;
+    auto async_write_some = [this, p_socket, p_ktls_socket, buffers, init]() {
+      if (p_ktls_socket) {
+        p_ktls_socket->async_write_some(buffers,
+                                        p_strand_->wrap(init.handler));
+        return;
+      }
       socket_.get().async_write_some(buffers, p_strand_->wrap(init.handler));
     };
     p_strand_->dispatch(async_write_some);
@@ -445,6 +548,13 @@ class basic_buffered_tls_socket {
   strand_type& strand() { return *p_strand_; }
 
  private:
+  /// Offer a previous session to the server if resumption is enabled
+  void prepare_handshake(handshake_type type) {
+    if (type == boost::asio::ssl::stream_base::client) {
+      p_ctx_.ResumeSession(socket_.get().native_handle());
+    }
+  }
+
   /// The TLS ctx in a shared_ptr to be able to move it
   p_context_type p_ctx_;
 
@@ -459,6 +569,9 @@ class basic_buffered_tls_socket {
 
   /// The TLSStreamBufferer in a shared_ptr to be able to move it
   p_puller_type p_puller_;
+
+  /// The TCP socket to write to when the kernel encrypts (kernel TLS)
+  boost::asio::ip::tcp::socket* p_ktls_socket_;
 };
 
 template <typename NextLayerStreamSocket>
@@ -478,26 +591,33 @@ class basic_tls_socket {
 
  public:
   basic_tls_socket()
-      : p_ctx_(nullptr), p_socket_(nullptr), socket_(), p_strand_(nullptr) {}
+      : p_ctx_(nullptr),
+        p_socket_(nullptr),
+        socket_(),
+        p_strand_(nullptr),
+        p_ktls_socket_(nullptr) {}
 
   basic_tls_socket(p_tls_stream_type p_socket, p_context_type p_ctx)
       : p_ctx_(p_ctx),
         p_socket_(p_socket),
         socket_(*p_socket_),
         p_strand_(std::make_shared<strand_type>(
-            socket_.get().lowest_layer().get_io_service())) {}
+            socket_.get().lowest_layer().get_io_service())),
+        p_ktls_socket_(nullptr) {}
 
   basic_tls_socket(boost::asio::io_service& io_service, p_context_type p_ctx)
       : p_ctx_(p_ctx),
         p_socket_(new tls_stream_type(io_service, *p_ctx)),
         socket_(*p_socket_),
-        p_strand_(std::make_shared<strand_type>(io_service)) {}
+        p_strand_(std::make_shared<strand_type>(io_service)),
+        p_ktls_socket_(nullptr) {}
 
   basic_tls_socket(basic_tls_socket&& other)
       : p_ctx_(std::move(other.p_ctx_)),
         p_socket_(std::move(other.p_socket_)),
         socket_(*p_socket_),
-        p_strand_(std::move(other.p_strand_)) {
+        p_strand_(std::move(other.p_strand_)),
+        p_ktls_socket_(other.p_ktls_socket_) {
     other.socket_ = *(other.p_socket_);
   }
 
@@ -515,7 +635,13 @@ class basic_tls_socket {
 
   boost::system::error_code handshake(handshake_type type,
                                       boost::system::error_code ec) {
+    prepare_handshake(type);
+    auto start = std::chrono::steady_clock::now();
     socket_.get().handshake(type, ec);
+    detail::RecordHandshake(start, ec);
+    if (!ec) {
+      p_ktls_socket_ = detail::TryKernelTLSTx(p_ctx_, socket_.get());
+    }
     return ec;
   }
 
@@ -523,8 +649,18 @@ class basic_tls_socket {
   /// completion
   template <typename Handler>
   void async_handshake(handshake_type type, Handler handler) {
-    auto lambda = [this, type, handler]() {
-      socket_.get().async_handshake(type, p_strand_->wrap(handler));
+    prepare_handshake(type);
+    auto start = std::chrono::steady_clock::now();
+    auto do_user_handler =
+        [this, start, handler](const boost::system::error_code& ec) mutable {
+          detail::RecordHandshake(start, ec);
+          if (!ec) {
+            p_ktls_socket_ = detail::TryKernelTLSTx(p_ctx_, socket_.get());
+          }
+          handler(ec);
+        };
+    auto lambda = [this, type, do_user_handler]() {
+      socket_.get().async_handshake(type, p_strand_->wrap(do_user_handler));
     };
 
     p_strand_->dispatch(lambda);
@@ -549,13 +685,21 @@ class basic_tls_socket {
   template <typename ConstBufferSequence>
   std::size_t write_some(const ConstBufferSequence& buffers,
                          boost::system::error_code& ec) {
+    if (p_ktls_socket_) {
+      return p_ktls_socket_->write_some(buffers, ec);
+    }
     return socket_.get().write_some(buffers, ec);
   }
 
-  /// Forward the call directly to the TLS stream (wrapped in an strand)
+  /// Forward the call directly to the TLS stream (wrapped in an strand), or
+  /// to the TCP socket when the kernel encrypts
   template <typename ConstBufferSequence, typename Handler>
   void async_write_some(const ConstBufferSequence& buffers, Handler&& handler) {
     auto lambda = [this, buffers, handler]() {
+      if (p_ktls_socket_) {
+        p_ktls_socket_->async_write_some(buffers, p_strand_->wrap(handler));
+        return;
+      }
       socket_.get().async_write_some(buffers, p_strand_->wrap(handler));
     };
     p_strand_->dispatch(lambda);
@@ -583,6 +727,13 @@ class basic_tls_socket {
   strand_type& strand() { return *p_strand_; }
 
  private:
+  /// Offer a previous session to the server if resumption is enabled
+  void prepare_handshake(handshake_type type) {
+    if (type == boost::asio::ssl::stream_base::client) {
+      p_ctx_.ResumeSession(socket_.get().native_handle());
+    }
+  }
+
   /// The TLS ctx in a shared_ptr to be able to move it
   p_context_type p_ctx_;
 
@@ -594,6 +745,9 @@ class basic_tls_socket {
 
   /// The strand in a shared_ptr to be able to move it
   p_strand_type p_strand_;
+
+  /// The TCP socket to write to when the kernel encrypts (kernel TLS)
+  boost::asio::ip::tcp::socket* p_ktls_socket_;
 };
 
 template <class NextLayer, template <class> class TLSStreamSocket>
@@ -625,7 +779,16 @@ class basic_tls {
       boost::asio::io_service& io_service,
       typename query::const_iterator parameters_it, uint32_t lower_id,
       boost::system::error_code& ec) {
-    auto context = detail::make_tls_context(io_service, *parameters_it);
+    // The parameters of the lower layers identify the peer
+    ParameterStack next_layers_parameters;
+    auto next_parameters_it = parameters_it;
+    for (int i = 0; i < NextLayer::endpoint_stack_size; ++i) {
+      next_layers_parameters.push_back(*++next_parameters_it);
+    }
+
+    auto context = detail::make_tls_context(
+        io_service, *parameters_it,
+        serialize_parameter_stack(next_layers_parameters));
     if (!context) {
       SSF_LOG("network_crypto", error, "could not generate context");
       ec.assign(ssf::error::invalid_argument, ssf::error::get_ssf_category());
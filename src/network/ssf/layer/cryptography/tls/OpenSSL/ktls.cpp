@@ -0,0 +1,292 @@
+#include "ssf/layer/cryptography/tls/OpenSSL/ktls.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/opensslv.h>
+
+#if defined(SSF_KERNEL_TLS)
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef TLS_SET_RECORD_TYPE
+#define TLS_SET_RECORD_TYPE 1
+#endif
+#endif
+
+#include "ssf/error/error.h"
+#include "ssf/log/log.h"
+
+namespace ssf {
+namespace layer {
+namespace cryptography {
+namespace detail {
+
+#if defined(SSF_KERNEL_TLS)
+
+namespace {
+
+// TLS 1.2 PRF (RFC 5246, section 5)
+bool TLS12PRF(const EVP_MD* p_md, const std::vector<unsigned char>& secret,
+              const std::string& label, const std::vector<unsigned char>& seed,
+              std::vector<unsigned char>* p_output) {
+  std::vector<unsigned char> label_seed(label.begin(), label.end());
+  label_seed.insert(label_seed.end(), seed.begin(), seed.end());
+
+  unsigned char a[EVP_MAX_MD_SIZE];
+  unsigned int a_size = 0;
+  if (!HMAC(p_md, secret.data(), static_cast<int>(secret.size()),
+            label_seed.data(), label_seed.size(), a, &a_size)) {
+    return false;
+  }
+
+  std::size_t generated = 0;
+  while (generated < p_output->size()) {
+    std::vector<unsigned char> input(a, a + a_size);
+    input.insert(input.end(), label_seed.begin(), label_seed.end());
+
+    unsigned char block[EVP_MAX_MD_SIZE];
+    unsigned int block_size = 0;
+    if (!HMAC(p_md, secret.data(), static_cast<int>(secret.size()),
+              input.data(), input.size(), block, &block_size)) {
+      return false;
+    }
+
+    auto to_copy = std::min<std::size_t>(block_size,
+                                         p_output->size() - generated);
+    std::memcpy(p_output->data() + generated, block, to_copy);
+    generated += to_copy;
+
+    if (!HMAC(p_md, secret.data(), static_cast<int>(secret.size()), a, a_size,
+              a, &a_size)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+// Accessors added in OpenSSL 1.1.0
+std::size_t SSL_SESSION_get_master_key(const SSL_SESSION* p_session,
+                                       unsigned char* out, std::size_t size) {
+  if (!p_session) {
+    return 0;
+  }
+  auto key_size = std::min<std::size_t>(
+      size, static_cast<std::size_t>(p_session->master_key_length));
+  std::memcpy(out, p_session->master_key, key_size);
+  return key_size;
+}
+
+std::size_t SSL_get_server_random(const SSL* p_ssl, unsigned char* out,
+                                  std::size_t size) {
+  auto random_size = std::min<std::size_t>(size, SSL3_RANDOM_SIZE);
+  std::memcpy(out, p_ssl->s3->server_random, random_size);
+  return random_size;
+}
+
+std::size_t SSL_get_client_random(const SSL* p_ssl, unsigned char* out,
+                                  std::size_t size) {
+  auto random_size = std::min<std::size_t>(size, SSL3_RANDOM_SIZE);
+  std::memcpy(out, p_ssl->s3->client_random, random_size);
+  return random_size;
+}
+#endif
+
+template <class CryptoInfo>
+bool InstallTxState(int fd, uint16_t cipher_type, const unsigned char* key,
+                    const unsigned char* salt) {
+  CryptoInfo crypto_info;
+  std::memset(&crypto_info, 0, sizeof(crypto_info));
+  crypto_info.info.version = TLS_1_2_VERSION;
+  crypto_info.info.cipher_type = cipher_type;
+  std::memcpy(crypto_info.key, key, sizeof(crypto_info.key));
+  std::memcpy(crypto_info.salt, salt, sizeof(crypto_info.salt));
+
+  // Only the Finished message was encrypted before: next record is number 1.
+  // The explicit nonce follows the record sequence number as in OpenSSL.
+  crypto_info.rec_seq[sizeof(crypto_info.rec_seq) - 1] = 1;
+  std::memcpy(crypto_info.iv, crypto_info.rec_seq, sizeof(crypto_info.iv));
+
+  int result =
+      setsockopt(fd, SOL_TLS, TLS_TX, &crypto_info, sizeof(crypto_info));
+  std::memset(&crypto_info, 0, sizeof(crypto_info));
+
+  return result == 0;
+}
+
+// Send a record of the given type with the kernel TX state
+bool SendKernelRecord(int fd, unsigned char record_type, const void* data,
+                      std::size_t size) {
+  char control[CMSG_SPACE(sizeof(record_type))];
+  std::memset(control, 0, sizeof(control));
+
+  iovec iov;
+  iov.iov_base = const_cast<void*>(data);
+  iov.iov_len = size;
+
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  cmsghdr* p_cmsg = CMSG_FIRSTHDR(&message);
+  p_cmsg->cmsg_level = SOL_TLS;
+  p_cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  p_cmsg->cmsg_len = CMSG_LEN(sizeof(record_type));
+  std::memcpy(CMSG_DATA(p_cmsg), &record_type, sizeof(record_type));
+
+  return sendmsg(fd, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+}
+
+// Called by OpenSSL for each protocol message it writes itself (alerts,
+// handshake messages). Once the kernel encrypts, the record OpenSSL encrypted
+// must not reach the TCP socket: the kernel would send it as application
+// data. Alerts are sent again by the kernel and the sending direction is shut
+// down, so that the copy written by the TLS stream fails.
+void OnKernelTLSMessage(int write_p, int version, int content_type,
+                        const void* buf, std::size_t len, SSL* p_ssl,
+                        void* arg) {
+  // Record headers are reported with pseudo content types (above 255)
+  if (!write_p || content_type == SSL3_RT_APPLICATION_DATA ||
+      content_type > 0xff) {
+    return;
+  }
+
+  auto& socket = *static_cast<boost::asio::ip::tcp::socket*>(arg);
+  if (!socket.is_open()) {
+    return;
+  }
+
+  if (content_type == SSL3_RT_ALERT &&
+      !SendKernelRecord(socket.native_handle(),
+                        static_cast<unsigned char>(content_type), buf, len)) {
+    SSF_LOG("network_crypto", debug, "kernel TLS alert not sent ({})",
+            std::strerror(errno));
+  }
+
+  SSF_LOG("network_crypto", debug,
+          "TLS record of type {} written after kernel TLS: stop sending",
+          content_type);
+  boost::system::error_code ec;
+  socket.shutdown(boost::asio::ip::tcp::socket::shutdown_send, ec);
+}
+
+}  // unnamed namespace
+
+bool EnableKernelTLSTx(SSL* p_ssl, boost::asio::ip::tcp::socket& socket,
+                       boost::system::error_code& ec) {
+  ec.assign(ssf::error::function_not_supported, ssf::error::get_ssf_category());
+
+  if (SSL_version(p_ssl) != TLS1_2_VERSION) {
+    return false;
+  }
+
+  const SSL_CIPHER* p_cipher = SSL_get_current_cipher(p_ssl);
+  if (!p_cipher) {
+    return false;
+  }
+
+  std::string cipher_name(SSL_CIPHER_get_name(p_cipher));
+  std::size_t key_size = 0;
+  if (cipher_name.find("AES256-GCM") != std::string::npos) {
+    key_size = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+  } else if (cipher_name.find("AES128-GCM") != std::string::npos) {
+    key_size = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+  } else {
+    SSF_LOG("network_crypto", debug, "no kernel TLS for cipher {}",
+            cipher_name);
+    return false;
+  }
+
+  const EVP_MD* p_md = cipher_name.find("SHA384") != std::string::npos
+                           ? EVP_sha384()
+                           : EVP_sha256();
+
+  std::vector<unsigned char> master_key(SSL_MAX_MASTER_KEY_LENGTH);
+  master_key.resize(SSL_SESSION_get_master_key(
+      SSL_get_session(p_ssl), master_key.data(), master_key.size()));
+
+  std::vector<unsigned char> seed(2 * SSL3_RANDOM_SIZE);
+  SSL_get_server_random(p_ssl, seed.data(), SSL3_RANDOM_SIZE);
+  SSL_get_client_random(p_ssl, seed.data() + SSL3_RANDOM_SIZE,
+                        SSL3_RANDOM_SIZE);
+
+  // AEAD key block: client key, server key, client salt, server salt
+  const std::size_t salt_size = TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+  std::vector<unsigned char> key_block(2 * key_size + 2 * salt_size);
+  bool derived = !master_key.empty() &&
+                 TLS12PRF(p_md, master_key, "key expansion", seed, &key_block);
+  std::memset(master_key.data(), 0, master_key.size());
+  if (!derived) {
+    return false;
+  }
+
+  bool is_server = SSL_is_server(p_ssl) == 1;
+  const unsigned char* key = key_block.data() + (is_server ? key_size : 0);
+  const unsigned char* salt =
+      key_block.data() + 2 * key_size + (is_server ? salt_size : 0);
+
+  int fd = socket.native_handle();
+  static const char ulp_name[] = "tls";
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, ulp_name, sizeof(ulp_name)) != 0) {
+    SSF_LOG("network_crypto", debug, "kernel TLS not available ({})",
+            std::strerror(errno));
+    std::memset(key_block.data(), 0, key_block.size());
+    return false;
+  }
+
+  // Without TX state, the ULP passes the data through unchanged
+  bool installed =
+      key_size == TLS_CIPHER_AES_GCM_256_KEY_SIZE
+          ? InstallTxState<tls12_crypto_info_aes_gcm_256>(
+                fd, TLS_CIPHER_AES_GCM_256, key, salt)
+          : InstallTxState<tls12_crypto_info_aes_gcm_128>(
+                fd, TLS_CIPHER_AES_GCM_128, key, salt);
+  std::memset(key_block.data(), 0, key_block.size());
+
+  if (!installed) {
+    SSF_LOG("network_crypto", debug, "kernel TLS TX setup failed ({})",
+            std::strerror(errno));
+    return false;
+  }
+
+  SSL_set_msg_callback(p_ssl, &OnKernelTLSMessage);
+  SSL_set_msg_callback_arg(p_ssl, &socket);
+
+  ec.assign(ssf::error::success, ssf::error::get_ssf_category());
+  return true;
+}
+
+#else
+
+bool EnableKernelTLSTx(SSL* p_ssl, boost::asio::ip::tcp::socket& socket,
+                       boost::system::error_code& ec) {
+  ec.assign(ssf::error::function_not_supported, ssf::error::get_ssf_category());
+  return false;
+}
+
+#endif
+
+}  // detail
+}  // cryptography
+}  // layer
+}  // ssf
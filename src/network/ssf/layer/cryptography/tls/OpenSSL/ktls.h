@@ -0,0 +1,100 @@
+#ifndef SSF_LAYER_CRYPTOGRAPHY_TLS_OPENSSL_KTLS_H_
+#define SSF_LAYER_CRYPTOGRAPHY_TLS_OPENSSL_KTLS_H_
+
+#include <memory>
+#include <type_traits>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "ssf/layer/cryptography/tls/OpenSSL/helpers.h"
+
+#include "ssf/log/log.h"
+
+// Kernel TLS needs the Linux TLS ULP headers (Linux 4.13+)
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#define SSF_KERNEL_TLS 1
+#endif
+#endif
+
+namespace ssf {
+namespace layer {
+namespace cryptography {
+namespace detail {
+
+/// Hand the transmit direction of an established TLS connection to the kernel
+/**
+* Only TLS 1.2 (the only version of the TLS layer) with AES-GCM on Linux (tls
+* kernel module, 4.13+) is supported, with OpenSSL 1.0.2 or later. The record
+* keys are derived from the session master secret and installed on the TCP
+* socket: data written in plain text on the socket is then encrypted by the
+* kernel. The TLS stream must not write any record afterwards: if OpenSSL
+* still writes one (e.g. an alert while reading), alerts are sent again by the
+* kernel and the sending direction of the TCP socket is shut down.
+*
+* On failure, nothing changed and the TLS stream keeps encrypting.
+*
+* @param p_ssl The TLS connection (handshake completed, nothing written yet)
+* @param socket The TCP socket carrying the connection
+* @param ec Set to the reason of the failure
+* @return true if the kernel encrypts the data written on the socket
+*/
+bool EnableKernelTLSTx(SSL* p_ssl, boost::asio::ip::tcp::socket& socket,
+                       boost::system::error_code& ec);
+
+/// Find the TCP socket at the bottom of a layer stack (nullptr if none)
+/**
+* The search goes down through the layers exposing their implementation. TLS
+* sockets do not: a stream over another TLS layer (e.g. a circuit) finds none.
+*/
+inline boost::asio::ip::tcp::socket* GetTCPSocket(
+    boost::asio::ip::tcp::socket& socket) {
+  return &socket;
+}
+
+template <class Socket>
+auto GetTCPSocket(Socket& socket)
+    -> decltype(GetTCPSocket(*socket.native_handle().p_next_layer_socket)) {
+  auto& impl = socket.native_handle();
+  if (!impl.p_next_layer_socket) {
+    return nullptr;
+  }
+  return GetTCPSocket(*impl.p_next_layer_socket);
+}
+
+inline boost::asio::ip::tcp::socket* GetTCPSocket(...) { return nullptr; }
+
+/// Enable kernel TLS for sending if the context asks for it
+/**
+* @return The TCP socket to write the plain text to, nullptr to keep writing
+* through the TLS stream
+*/
+template <class TLSStream>
+boost::asio::ip::tcp::socket* TryKernelTLSTx(const ExtendedTLSContext& context,
+                                             TLSStream& stream) {
+  if (!context.kernel_tls_) {
+    return nullptr;
+  }
+
+  auto p_tcp_socket = GetTCPSocket(stream.next_layer());
+  if (!p_tcp_socket) {
+    return nullptr;
+  }
+
+  boost::system::error_code ec;
+  if (!EnableKernelTLSTx(stream.native_handle(), *p_tcp_socket, ec)) {
+    return nullptr;
+  }
+
+  SSF_LOG("network_crypto", debug, "kernel TLS enabled for sending");
+  return p_tcp_socket;
+}
+
+}  // detail
+}  // cryptography
+}  // layer
+}  // ssf
+
+#endif  // SSF_LAYER_CRYPTOGRAPHY_TLS_OPENSSL_KTLS_H_
@@ -0,0 +1,246 @@
+#include "ssf/log/async_sink.h"
+
+#ifndef SSF_DISABLE_LOGS
+
+#include <chrono>
+
+namespace ssf {
+namespace log {
+
+AsyncSink::AsyncSink(std::vector<spdlog::sink_ptr> sinks,
+                     const std::string& pattern)
+    : sinks_(std::move(sinks)),
+      p_formatter_(std::make_shared<spdlog::pattern_formatter>(pattern)),
+      async_(false),
+      producers_(0),
+      draining_(false),
+      blocked_producers_(0),
+      policy_(OverflowPolicy::kDrop),
+      p_records_(nullptr),
+      mask_(0),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      dropped_(0),
+      reported_dropped_(0),
+      sleeping_(false),
+      stopping_(false) {}
+
+AsyncSink::~AsyncSink() { Stop(); }
+
+void AsyncSink::Start(std::size_t queue_size, OverflowPolicy policy) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (flusher_.joinable()) {
+    return;
+  }
+
+  std::size_t capacity = 2;
+  while (capacity < queue_size) {
+    capacity <<= 1;
+  }
+
+  p_records_.reset(new Record[capacity]);
+  for (std::size_t i = 0; i < capacity; ++i) {
+    p_records_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  mask_ = capacity - 1;
+  enqueue_pos_.store(0, std::memory_order_relaxed);
+  dequeue_pos_ = 0;
+  policy_ = policy;
+  stopping_ = false;
+
+  flusher_ = std::thread([this]() {
+    while (true) {
+      if (WriteBatch() > 0) {
+        continue;
+      }
+      if (stopping_) {
+        break;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleeping_ = true;
+      flusher_cv_.wait_for(lock, std::chrono::milliseconds(100),
+                           [this]() { return stopping_ || HasRecord(); });
+      sleeping_ = false;
+    }
+  });
+  async_ = true;
+}
+
+void AsyncSink::Stop() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!flusher_.joinable()) {
+      return;
+    }
+    async_ = false;
+    draining_ = true;
+
+    // Let the logging threads which saw the asynchronous mode push their
+    // message (the flusher keeps freeing records for the blocked ones)
+    producers_cv_.wait(lock, [this]() { return producers_ == 0; });
+    draining_ = false;
+
+    stopping_ = true;
+    flusher_cv_.notify_one();
+  }
+  flusher_.join();
+}
+
+void AsyncSink::log(const spdlog::details::log_msg& msg) {
+  ++producers_;
+  if (!async_) {
+    ReleaseProducer();
+    WriteSync(msg);
+    return;
+  }
+
+  while (!TryPush(msg)) {
+    if (policy_ == OverflowPolicy::kDrop) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    WaitForFreeRecord();
+  }
+  ReleaseProducer();
+
+  WakeUpFlusher();
+}
+
+void AsyncSink::flush() {
+  if (async_) {
+    WakeUpFlusher();
+    return;
+  }
+  Flush();
+}
+
+void AsyncSink::WriteSync(const spdlog::details::log_msg& msg) {
+  for (auto& p_sink : sinks_) {
+    p_sink->log(msg);
+  }
+}
+
+bool AsyncSink::TryPush(const spdlog::details::log_msg& msg) {
+  Record* p_record = nullptr;
+  auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    p_record = &p_records_[pos & mask_];
+    auto sequence = p_record->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // full
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // The record strings keep their capacity: no allocation once warmed up
+  p_record->level = msg.level;
+  p_record->time = msg.time;
+  p_record->thread_id = msg.thread_id;
+  p_record->logger_name.assign(msg.logger_name ? *msg.logger_name : "");
+  p_record->raw.assign(msg.raw.data(), msg.raw.size());
+  p_record->formatted.assign(msg.formatted.data(), msg.formatted.size());
+  p_record->sequence.store(pos + 1, std::memory_order_release);
+
+  return true;
+}
+
+bool AsyncSink::HasRecord() const {
+  const auto& record = p_records_[dequeue_pos_ & mask_];
+  return record.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+}
+
+bool AsyncSink::HasFreeRecord() const {
+  auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+  const auto& record = p_records_[pos & mask_];
+  return record.sequence.load(std::memory_order_acquire) == pos;
+}
+
+void AsyncSink::WaitForFreeRecord() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ++blocked_producers_;
+  flusher_cv_.notify_one();
+  // Bounded: a record freed between the check and the wait is seen at the
+  // next check
+  producers_cv_.wait_for(lock, std::chrono::milliseconds(kMaxBlockedWaitMs),
+                         [this]() { return HasFreeRecord(); });
+  --blocked_producers_;
+}
+
+void AsyncSink::ReleaseProducer() {
+  if (--producers_ == 0 && draining_) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    producers_cv_.notify_all();
+  }
+}
+
+std::size_t AsyncSink::WriteBatch() {
+  std::size_t count = 0;
+  while (count < kMaxBatchSize && HasRecord()) {
+    auto& record = p_records_[dequeue_pos_ & mask_];
+
+    spdlog::details::log_msg msg(&record.logger_name, record.level);
+    msg.time = record.time;
+    msg.thread_id = record.thread_id;
+    msg.raw << record.raw;
+    msg.formatted << record.formatted;
+    WriteSync(msg);
+
+    record.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_pos_;
+    ++count;
+
+    if (blocked_producers_ > 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      producers_cv_.notify_all();
+    }
+  }
+
+  auto dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != reported_dropped_) {
+    WriteDropped(dropped - reported_dropped_);
+    reported_dropped_ = dropped;
+    ++count;
+  }
+
+  if (count > 0) {
+    Flush();
+  }
+
+  return count;
+}
+
+void AsyncSink::WriteDropped(uint64_t count) {
+  static const std::string name("log");
+  spdlog::details::log_msg msg(&name, spdlog::level::warn);
+  msg.raw << count << " messages dropped (log queue full)";
+  p_formatter_->format(msg);
+  WriteSync(msg);
+}
+
+void AsyncSink::WakeUpFlusher() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flusher_cv_.notify_one();
+  }
+}
+
+void AsyncSink::Flush() {
+  for (auto& p_sink : sinks_) {
+    p_sink->flush();
+  }
+}
+
+}  // log
+}  // ssf
+
+#endif  // SSF_DISABLE_LOGS
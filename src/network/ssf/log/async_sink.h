@@ -0,0 +1,114 @@
+#ifndef SSF_LOG_ASYNC_SINK_H_
+#define SSF_LOG_ASYNC_SINK_H_
+
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "ssf/log/log.h"
+
+namespace ssf {
+namespace log {
+
+/// Sink writing formatted messages to other sinks, either directly or from a
+/// dedicated flusher thread
+/**
+* In asynchronous mode, the logging threads only copy the messages into a
+* bounded lock-free ring (multiple producers, single consumer). The flusher
+* thread writes them by batches and flushes the sinks once per batch.
+*
+* When the ring is full, messages are dropped and counted (OverflowPolicy::kDrop)
+* or the logging thread sleeps until the flusher frees a record
+* (OverflowPolicy::kBlock).
+*/
+class AsyncSink : public spdlog::sinks::sink {
+ public:
+  AsyncSink(std::vector<spdlog::sink_ptr> sinks, const std::string& pattern);
+  ~AsyncSink();
+
+  AsyncSink(const AsyncSink&) = delete;
+  AsyncSink& operator=(const AsyncSink&) = delete;
+
+  /// Switch to asynchronous mode (no-op if already started)
+  /**
+  * @param queue_size Ring capacity in messages (rounded up to a power of 2)
+  * @param policy Behavior when the ring is full
+  */
+  void Start(std::size_t queue_size, OverflowPolicy policy);
+
+  /// Write the queued messages and switch back to synchronous mode
+  void Stop();
+
+  void log(const spdlog::details::log_msg& msg) override;
+  void flush() override;
+
+  /// Number of messages dropped because the ring was full
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Record {
+    std::atomic<std::size_t> sequence;
+    spdlog::level::level_enum level;
+    spdlog::log_clock::time_point time;
+    std::size_t thread_id;
+    std::string logger_name;
+    std::string raw;
+    std::string formatted;
+  };
+
+  // Maximum number of messages written between two flushes
+  enum { kMaxBatchSize = 256 };
+  // Longest sleep of a blocked logging thread between two checks of the ring
+  enum { kMaxBlockedWaitMs = 10 };
+
+ private:
+  void WriteSync(const spdlog::details::log_msg& msg);
+  bool TryPush(const spdlog::details::log_msg& msg);
+  bool HasRecord() const;
+  bool HasFreeRecord() const;
+  void WaitForFreeRecord();
+  void ReleaseProducer();
+  std::size_t WriteBatch();
+  void WriteDropped(uint64_t count);
+  void WakeUpFlusher();
+  void Flush();
+
+ private:
+  std::vector<spdlog::sink_ptr> sinks_;
+  spdlog::formatter_ptr p_formatter_;
+
+  std::atomic<bool> async_;
+  std::atomic<std::size_t> producers_;
+  // Set while Stop waits for the logging threads
+  std::atomic<bool> draining_;
+  std::atomic<std::size_t> blocked_producers_;
+  OverflowPolicy policy_;
+  std::unique_ptr<Record[]> p_records_;
+  std::size_t mask_;
+  std::atomic<std::size_t> enqueue_pos_;
+  // Only used by the flusher thread
+  std::size_t dequeue_pos_;
+
+  std::atomic<uint64_t> dropped_;
+  uint64_t reported_dropped_;
+
+  std::mutex mutex_;
+  std::condition_variable flusher_cv_;
+  std::condition_variable producers_cv_;
+  std::atomic<bool> sleeping_;
+  std::atomic<bool> stopping_;
+  std::thread flusher_;
+};
+
+}  // log
+}  // ssf
+
+#endif  // SSF_LOG_ASYNC_SINK_H_
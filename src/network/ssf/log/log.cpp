@@ -4,8 +4,12 @@
 
 void SetLogLevel(spdlog::level::level_enum level) {}
 
+void SetAsyncLog(std::size_t queue_size, ssf::log::OverflowPolicy policy) {}
+
 #else
 
+#include "ssf/log/async_sink.h"
+
 #if defined(_MSC_VER)
 #include "spdlog/sinks/msvc_sink.h"
 #elif defined(__unix__) || defined(__APPLE__)
@@ -20,19 +24,50 @@ void SetLogLevel(spdlog::level::level_enum level) {
   ssf::log::GetManager().SetLevel(level);
 }
 
+void SetAsyncLog(std::size_t queue_size, ssf::log::OverflowPolicy policy) {
+  ssf::log::GetManager().SetAsync(queue_size, policy);
+}
+
 namespace ssf {
 namespace log {
 
+namespace {
+
+const char* kPattern = "[%Y-%m-%dT%H:%M:%S%z] [%l] [%n] %v";
+
+std::vector<spdlog::sink_ptr> CreateSinks() {
+  std::vector<spdlog::sink_ptr> sinks;
+
+#if defined(_MSC_VER)
+  sinks.push_back(std::make_shared<spdlog::sinks::wincolor_stderr_sink_mt>());
+  sinks.push_back(std::make_shared<spdlog::sinks::msvc_sink_mt>());
+#elif defined(__unix__) || defined(__APPLE__)
+  sinks.push_back(std::make_shared<spdlog::sinks::ansicolor_stderr_sink_mt>());
+#if defined(SSF_ENABLE_SYSLOG)
+  sinks.push_back(std::make_shared<spdlog::sinks::syslog_sink>());
+#endif  // defined(SSF_ENABLE_SYSLOG)
+#endif  // defined(_MSC_VER)
+
+  return sinks;
+}
+
+}  // anonymous namespace
+
+std::atomic<int> Manager::level_(spdlog::level::info);
+
 Manager& GetManager() {
   static Manager manager;
   return manager;
 }
 
-Manager::Manager() {
-  spdlog::set_level(spdlog::level::info);
-  spdlog::set_pattern("[%Y-%m-%dT%H:%M:%S%z] [%l] [%n] %v");
+Manager::Manager()
+    : p_sink_(std::make_shared<AsyncSink>(CreateSinks(), kPattern)) {
+  spdlog::set_level(static_cast<spdlog::level::level_enum>(level_.load()));
+  spdlog::set_pattern(kPattern);
 }
 
+Manager::~Manager() { p_sink_->Stop(); }
+
 std::shared_ptr<spdlog::logger> Manager::GetChannel(const std::string& name) {
   auto channel = spdlog::get(name);
   if (!channel) {
@@ -42,26 +77,23 @@ std::shared_ptr<spdlog::logger> Manager::GetChannel(const std::string& name) {
 }
 
 void Manager::SetLevel(spdlog::level::level_enum level) {
+  level_.store(level, std::memory_order_relaxed);
   spdlog::set_level(level);
 }
 
-std::shared_ptr<spdlog::logger> Manager::CreateChannel(
-    const std::string& name) {
-  std::vector<spdlog::sink_ptr> sinks;
+void Manager::SetAsync(std::size_t queue_size, OverflowPolicy policy) {
+  p_sink_->Start(queue_size, policy);
+}
 
-#if defined(_MSC_VER)
-  sinks.push_back(std::make_shared<spdlog::sinks::wincolor_stderr_sink_mt>());
-  sinks.push_back(std::make_shared<spdlog::sinks::msvc_sink_mt>());
-#elif defined(__unix__) || defined(__APPLE__)
-  sinks.push_back(std::make_shared<spdlog::sinks::ansicolor_stderr_sink_mt>());
-#if defined(SSF_ENABLE_SYSLOG)
-  sinks.push_back(std::make_shared<spdlog::sinks::syslog_sink>());
-#endif  // defined(SSF_ENABLE_SYSLOG)
-#endif  // defined(_MSC_VER)
+void Manager::SetSync() { p_sink_->Stop(); }
+
+uint64_t Manager::dropped_messages() const { return p_sink_->dropped(); }
 
+std::shared_ptr<spdlog::logger> Manager::CreateChannel(
+    const std::string& name) {
   std::shared_ptr<spdlog::logger> logger;
   try {
-    logger = spdlog::create(name, sinks.cbegin(), sinks.cend());
+    logger = spdlog::create(name, {p_sink_});
   } catch (const std::exception&) {
     logger = spdlog::get(name);
   }
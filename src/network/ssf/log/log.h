@@ -1,37 +1,98 @@
 #ifndef SSF_LOG_LOG_H_
 #define SSF_LOG_LOG_H_
 
+#include <cstddef>
+
 #include <spdlog/spdlog.h>
 
+namespace ssf {
+namespace log {
+
+/// Behavior of the asynchronous log when its queue is full
+enum class OverflowPolicy { kDrop, kBlock };
+
+}  // log
+}  // ssf
+
 void SetLogLevel(spdlog::level::level_enum level = spdlog::level::info);
 
+/// Write the logs from a dedicated thread through a bounded queue
+void SetAsyncLog(std::size_t queue_size,
+                 ssf::log::OverflowPolicy policy = ssf::log::OverflowPolicy::kDrop);
+
 #ifdef SSF_DISABLE_LOGS
 #define SSF_LOG(...)
 #else
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
+// Level of a SSF_LOG level token (the spdlog::logger method name)
+#define SSF_LOG_LEVEL_trace spdlog::level::trace
+#define SSF_LOG_LEVEL_debug spdlog::level::debug
+#define SSF_LOG_LEVEL_info spdlog::level::info
+#define SSF_LOG_LEVEL_warn spdlog::level::warn
+#define SSF_LOG_LEVEL_error spdlog::level::err
+#define SSF_LOG_LEVEL_critical spdlog::level::critical
+#define SSF_LOG_LEVEL_IMPL(level) SSF_LOG_LEVEL_##level
+#define SSF_LOG_LEVEL(level) SSF_LOG_LEVEL_IMPL(level)
+
+// Messages below this level are compiled out (see LOG_MIN_LEVEL in CMake)
+#ifndef SSF_LOG_MIN_LEVEL
+#define SSF_LOG_MIN_LEVEL trace
+#endif
+
 namespace ssf {
 namespace log {
 
+class AsyncSink;
+
 class Manager {
  public:
   Manager();
+  ~Manager();
 
   std::shared_ptr<spdlog::logger> GetChannel(const std::string& channel);
   void SetLevel(spdlog::level::level_enum level);
+  void SetAsync(std::size_t queue_size, OverflowPolicy policy);
+
+  /// Write the queued messages and switch back to synchronous mode
+  void SetSync();
+
+  /// Number of messages dropped by the asynchronous log
+  uint64_t dropped_messages() const;
+
+  /// Check the runtime level without locking nor looking up any channel
+  inline static bool ShouldLog(spdlog::level::level_enum level) {
+    return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+  }
 
  private:
   std::shared_ptr<spdlog::logger> CreateChannel(const std::string& channel);
+
+ private:
+  static std::atomic<int> level_;
+  // Sink shared by all the channels
+  std::shared_ptr<AsyncSink> p_sink_;
 };
 
 Manager& GetManager();
 
-#define SSF_LOG(channel, level, ...) \
-  ssf::log::GetManager().GetChannel(channel)->level(__VA_ARGS__);
+// The level is checked before evaluating the arguments. The channel is looked
+// up once per call site: channel names are string literals.
+#define SSF_LOG(channel, level, ...)                                         \
+  do {                                                                       \
+    if (SSF_LOG_LEVEL(level) >= SSF_LOG_LEVEL(SSF_LOG_MIN_LEVEL) &&          \
+        ssf::log::Manager::ShouldLog(SSF_LOG_LEVEL(level))) {                \
+      static const std::shared_ptr<spdlog::logger> ssf_log_channel =         \
+          ssf::log::GetManager().GetChannel(channel);                        \
+      ssf_log_channel->level(__VA_ARGS__);                                   \
+    }                                                                        \
+  } while (false)
 
 }  // log
 }  // ssf
@@ -0,0 +1,73 @@
+#include "ssf/metrics/exporter.h"
+
+#include <boost/system/error_code.hpp>
+
+#include "ssf/metrics/metrics.h"
+
+namespace ssf {
+namespace metrics {
+
+Exporter::Exporter()
+    : mutex_(),
+      exporter_cv_(),
+      stopping_(false),
+      period_(0),
+      file_(),
+      exporter_() {}
+
+Exporter::~Exporter() { Stop(); }
+
+void Exporter::Start(const std::string& filepath,
+                     std::chrono::milliseconds period,
+                     boost::system::error_code& ec) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (exporter_.joinable()) {
+    return;
+  }
+
+  file_.open(filepath, std::ofstream::out | std::ofstream::app);
+  if (!file_.is_open()) {
+    ec.assign(::boost::system::errc::no_such_file_or_directory,
+              ::boost::system::system_category());
+    return;
+  }
+
+  period_ = period;
+  stopping_ = false;
+  exporter_ = std::thread([this]() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+      exporter_cv_.wait_for(lock, period_, [this]() { return stopping_; });
+      WriteLine();
+    }
+  });
+}
+
+void Exporter::Stop() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!exporter_.joinable()) {
+      return;
+    }
+    stopping_ = true;
+  }
+  exporter_cv_.notify_one();
+  exporter_.join();
+  file_.close();
+}
+
+void Exporter::Write(const std::string& line) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!exporter_.joinable() || stopping_) {
+    return;
+  }
+
+  file_ << line << std::endl;
+}
+
+void Exporter::WriteLine() {
+  file_ << GetRegistry().ToJson() << std::endl;
+}
+
+}  // metrics
+}  // ssf
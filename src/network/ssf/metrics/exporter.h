@@ -0,0 +1,62 @@
+#ifndef SSF_METRICS_EXPORTER_H_
+#define SSF_METRICS_EXPORTER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/system/error_code.hpp>
+
+namespace ssf {
+namespace metrics {
+
+/// Append the metrics of the registry to a file as JSON lines
+/**
+* A dedicated thread writes one line (see Registry::ToJson) per period, and a
+* last line when stopped. Recording metrics never waits for the exporter.
+*/
+class Exporter {
+ public:
+  Exporter();
+  ~Exporter();
+
+  Exporter(const Exporter&) = delete;
+  Exporter& operator=(const Exporter&) = delete;
+
+  /// Start the exporter thread (no-op if already started)
+  /**
+  * @param filepath File the lines are appended to
+  * @param period Time between two lines
+  * @param ec Set if the file cannot be opened
+  */
+  void Start(const std::string& filepath, std::chrono::milliseconds period,
+             boost::system::error_code& ec);
+
+  /// Write a last line and stop the exporter thread
+  void Stop();
+
+  /// Append a line from another source (e.g. the metrics of the remote end)
+  /**
+  * No-op if the exporter is not started
+  */
+  void Write(const std::string& line);
+
+ private:
+  void WriteLine();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable exporter_cv_;
+  bool stopping_;
+  std::chrono::milliseconds period_;
+  std::ofstream file_;
+  std::thread exporter_;
+};
+
+}  // metrics
+}  // ssf
+
+#endif  // SSF_METRICS_EXPORTER_H_
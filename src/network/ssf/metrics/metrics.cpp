@@ -0,0 +1,153 @@
+#include "ssf/metrics/metrics.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace ssf {
+namespace metrics {
+
+namespace {
+
+template <class Metric>
+Metric& GetMetric(std::map<std::string, std::unique_ptr<Metric>>* p_metrics,
+                  const std::string& name) {
+  auto& p_metric = (*p_metrics)[name];
+  if (!p_metric) {
+    p_metric.reset(new Metric());
+  }
+  return *p_metric;
+}
+
+bool HasPrefix(const std::string& name, const std::string& prefix) {
+  return name.compare(0, prefix.size(), prefix) == 0;
+}
+
+void WriteName(std::ostream& os, const std::string& name) {
+  os << '"';
+  for (auto c : name) {
+    if (c == '"' || c == '\\') {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << "\": ";
+}
+
+}  // anonymous namespace
+
+uint64_t Histogram::Snapshot::Percentile(double fraction) const {
+  if (count == 0) {
+    return 0;
+  }
+
+  auto rank = static_cast<uint64_t>(fraction * count);
+  if (rank >= count) {
+    rank = count - 1;
+  }
+
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen > rank) {
+      // upper bound of the bucket: largest value with i significant bits
+      uint64_t upper_bound = i == 0 ? 0 : (i == 64 ? ~uint64_t(0)
+                                                   : (uint64_t(1) << i) - 1);
+      return upper_bound < max ? upper_bound : max;
+    }
+  }
+
+  return max;
+}
+
+Histogram::Snapshot Histogram::GetSnapshot() const {
+  Snapshot snapshot;
+  for (const auto& shard : shards_) {
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+      auto count = shard.buckets[i].load(std::memory_order_relaxed);
+      snapshot.buckets[i] += count;
+      snapshot.count += count;
+    }
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    auto max = shard.max.load(std::memory_order_relaxed);
+    if (max > snapshot.max) {
+      snapshot.max = max;
+    }
+  }
+  return snapshot;
+}
+
+Registry::Registry() : mutex_(), counters_(), gauges_(), histograms_() {}
+
+Counter& Registry::GetCounter(const std::string& name) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return GetMetric(&counters_, name);
+}
+
+Gauge& Registry::GetGauge(const std::string& name) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return GetMetric(&gauges_, name);
+}
+
+Histogram& Registry::GetHistogram(const std::string& name) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return GetMetric(&histograms_, name);
+}
+
+std::string Registry::ToJson(const std::string& prefix) const {
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::ostringstream os;
+  os << "{\"time\": " << now.count() << ", \"counters\": {";
+  bool first = true;
+  for (const auto& counter : counters_) {
+    if (!HasPrefix(counter.first, prefix)) {
+      continue;
+    }
+    os << (first ? "" : ", ");
+    WriteName(os, counter.first);
+    os << counter.second->value();
+    first = false;
+  }
+
+  os << "}, \"gauges\": {";
+  first = true;
+  for (const auto& gauge : gauges_) {
+    if (!HasPrefix(gauge.first, prefix)) {
+      continue;
+    }
+    os << (first ? "" : ", ");
+    WriteName(os, gauge.first);
+    os << gauge.second->value();
+    first = false;
+  }
+
+  os << "}, \"histograms\": {";
+  first = true;
+  for (const auto& histogram : histograms_) {
+    if (!HasPrefix(histogram.first, prefix)) {
+      continue;
+    }
+    auto snapshot = histogram.second->GetSnapshot();
+    os << (first ? "" : ", ");
+    WriteName(os, histogram.first);
+    os << "{\"count\": " << snapshot.count << ", \"sum\": " << snapshot.sum
+       << ", \"max\": " << snapshot.max
+       << ", \"p50\": " << snapshot.Percentile(0.50)
+       << ", \"p90\": " << snapshot.Percentile(0.90)
+       << ", \"p99\": " << snapshot.Percentile(0.99) << "}";
+    first = false;
+  }
+  os << "}}";
+
+  return os.str();
+}
+
+Registry& GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+}  // metrics
+}  // ssf
@@ -0,0 +1,234 @@
+#ifndef SSF_METRICS_METRICS_H_
+#define SSF_METRICS_METRICS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace ssf {
+namespace metrics {
+
+/// Number of shards of a metric (threads are spread over the shards)
+enum : std::size_t { kShards = 16 };
+
+/// Recording switch of the process (off by default)
+/**
+* The SSF_METRICS_* macros and the item managers record nothing until the
+* metrics are enabled. Gauges move by deltas: enable the metrics before the
+* first recording.
+*/
+inline std::atomic<bool>& EnabledFlag() {
+  static std::atomic<bool> enabled(false);
+  return enabled;
+}
+
+inline bool Enabled() {
+  return EnabledFlag().load(std::memory_order_relaxed);
+}
+
+inline void Enable(bool enabled = true) {
+  EnabledFlag().store(enabled, std::memory_order_relaxed);
+}
+
+/// Shard of the calling thread
+inline std::size_t ThreadShard() {
+  static std::atomic<std::size_t> next_shard(0);
+  thread_local std::size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+  return shard;
+}
+
+/// Monotonic counter
+/**
+* Each thread adds to its own shard (no lock, no shared cache line in the
+* common case). Reading sums the shards.
+*/
+class Counter {
+ public:
+  Counter() : shards_() {
+    for (auto& shard : shards_) {
+      shard.value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  Counter(const Counter&) = delete;
+  Counter& operator=(const Counter&) = delete;
+
+  void Add(int64_t value) {
+    shards_[ThreadShard()].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  void Increment() { Add(1); }
+
+  int64_t value() const {
+    int64_t total = 0;
+    for (const auto& shard : shards_) {
+      total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+ private:
+  // one cache line per shard
+  struct Shard {
+    std::atomic<int64_t> value;
+    char padding[64 - sizeof(std::atomic<int64_t>)];
+  };
+
+  std::array<Shard, kShards> shards_;
+};
+
+/// Current level of a quantity (queue size, open sessions...)
+/**
+* The level moves by deltas: the sum of the deltas is the current value.
+*/
+class Gauge : public Counter {};
+
+/// Distribution of sampled values
+/**
+* Values are counted in power of two buckets (bucket i holds the values of i
+* significant bits): percentiles are approximated by the upper bound of their
+* bucket.
+*/
+class Histogram {
+ public:
+  enum : std::size_t { kBuckets = 65 };
+
+  struct Snapshot {
+    Snapshot() : count(0), sum(0), max(0), buckets() {}
+
+    /// Approximate value below which the given fraction of samples falls
+    uint64_t Percentile(double fraction) const;
+
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    std::array<uint64_t, kBuckets> buckets;
+  };
+
+ public:
+  Histogram() : shards_() {
+    for (auto& shard : shards_) {
+      for (auto& bucket : shard.buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+      shard.sum.store(0, std::memory_order_relaxed);
+      shard.max.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+  void Record(uint64_t value) {
+    auto& shard = shards_[ThreadShard()];
+    shard.buckets[Bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+    auto max = shard.max.load(std::memory_order_relaxed);
+    while (value > max &&
+           !shard.max.compare_exchange_weak(max, value,
+                                            std::memory_order_relaxed)) {
+    }
+  }
+
+  Snapshot GetSnapshot() const;
+
+  /// Bucket of a value (its number of significant bits)
+  static std::size_t Bucket(uint64_t value) {
+#if defined(__GNUC__)
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+#else
+    std::size_t bucket = 0;
+    while (value != 0) {
+      value >>= 1;
+      ++bucket;
+    }
+    return bucket;
+#endif
+  }
+
+ private:
+  // the shards do not share cache lines
+  struct Shard {
+    std::array<std::atomic<uint64_t>, kBuckets> buckets;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+    char padding[64];
+  };
+
+  std::array<Shard, kShards> shards_;
+};
+
+/// Named metrics of the process
+/**
+* Metrics are created on first use and live until the end of the process:
+* references can be kept by the recording sites (see the SSF_METRICS_* macros).
+*/
+class Registry {
+ public:
+  Registry();
+
+  Registry(const Registry&) = delete;
+  Registry& operator=(const Registry&) = delete;
+
+  Counter& GetCounter(const std::string& name);
+  Gauge& GetGauge(const std::string& name);
+  Histogram& GetHistogram(const std::string& name);
+
+  /// Current values as a single line JSON object
+  /**
+  * {"time": <ms since epoch>, "counters": {...}, "gauges": {...},
+  *  "histograms": {"<name>": {"count", "sum", "max", "p50", "p90", "p99"}}}
+  *
+  * @param prefix Only the metrics whose name starts with prefix are written
+  */
+  std::string ToJson(const std::string& prefix = "") const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Counter>> counters_;
+  std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+  std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+};
+
+Registry& GetRegistry();
+
+}  // metrics
+}  // ssf
+
+// The metric is looked up once per call site: metric names are string
+// literals. Nothing is recorded while the metrics are disabled.
+#define SSF_METRICS_COUNT(name, value)                                  \
+  do {                                                                  \
+    if (ssf::metrics::Enabled()) {                                      \
+      static ssf::metrics::Counter& ssf_metrics_counter =               \
+          ssf::metrics::GetRegistry().GetCounter(name);                 \
+      ssf_metrics_counter.Add(static_cast<int64_t>(value));             \
+    }                                                                   \
+  } while (false)
+
+#define SSF_METRICS_GAUGE_ADD(name, delta)                              \
+  do {                                                                  \
+    if (ssf::metrics::Enabled()) {                                      \
+      static ssf::metrics::Gauge& ssf_metrics_gauge =                   \
+          ssf::metrics::GetRegistry().GetGauge(name);                   \
+      ssf_metrics_gauge.Add(static_cast<int64_t>(delta));               \
+    }                                                                   \
+  } while (false)
+
+#define SSF_METRICS_RECORD(name, value)                                 \
+  do {                                                                  \
+    if (ssf::metrics::Enabled()) {                                      \
+      static ssf::metrics::Histogram& ssf_metrics_histogram =           \
+          ssf::metrics::GetRegistry().GetHistogram(name);               \
+      ssf_metrics_histogram.Record(static_cast<uint64_t>(value));       \
+    }                                                                   \
+  } while (false)
+
+#endif  // SSF_METRICS_METRICS_H_
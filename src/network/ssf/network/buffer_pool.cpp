@@ -0,0 +1,147 @@
+#include "ssf/network/buffer_pool.h"
+
+#include <algorithm>
+
+namespace ssf {
+
+BufferPool::Buffer::Buffer(Buffer&& other)
+    : p_pool_(other.p_pool_), p_data_(other.p_data_), size_(other.size_) {
+  other.p_pool_ = nullptr;
+  other.p_data_ = nullptr;
+  other.size_ = 0;
+}
+
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& other) {
+  if (this != &other) {
+    Reset();
+    p_pool_ = other.p_pool_;
+    p_data_ = other.p_data_;
+    size_ = other.size_;
+    other.p_pool_ = nullptr;
+    other.p_data_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+void BufferPool::Buffer::Reset() {
+  if (p_data_ != nullptr) {
+    if (p_pool_ != nullptr) {
+      p_pool_->Release(p_data_, size_);
+    } else {
+      delete[] p_data_;
+    }
+  }
+  p_pool_ = nullptr;
+  p_data_ = nullptr;
+  size_ = 0;
+}
+
+BufferPool& BufferPool::Get() {
+  // Never destroyed: buffers may be released during the static destruction
+  static BufferPool* p_pool = new BufferPool();
+  return *p_pool;
+}
+
+BufferPool::BufferPool() : mutex_(), free_buffers_(), cached_bytes_(0) {}
+
+BufferPool::~BufferPool() {
+  for (auto& buffers : free_buffers_) {
+    for (auto p_data : buffers) {
+      delete[] p_data;
+    }
+  }
+}
+
+BufferPool::Buffer BufferPool::Acquire(std::size_t size) {
+  auto class_size = ClassSize(size);
+  if (class_size > kMaxClassSize) {
+    return Buffer(nullptr, new char[class_size], class_size);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& buffers = free_buffers_[ClassIndex(class_size)];
+    if (!buffers.empty()) {
+      auto p_data = buffers.back();
+      buffers.pop_back();
+      cached_bytes_ -= class_size;
+      return Buffer(this, p_data, class_size);
+    }
+  }
+
+  return Buffer(this, new char[class_size], class_size);
+}
+
+std::size_t BufferPool::ClassSize(std::size_t size) {
+  std::size_t class_size = kMinClassSize;
+  while (class_size < size) {
+    class_size <<= 1;
+  }
+  return class_size;
+}
+
+std::size_t BufferPool::cached_bytes() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+void BufferPool::Release(char* p_data, std::size_t size) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cached_bytes_ + size <= kMaxCachedBytes) {
+      free_buffers_[ClassIndex(size)].push_back(p_data);
+      cached_bytes_ += size;
+      return;
+    }
+  }
+
+  delete[] p_data;
+}
+
+std::size_t BufferPool::ClassIndex(std::size_t class_size) {
+  std::size_t index = 0;
+  while ((static_cast<std::size_t>(kMinClassSize) << index) < class_size) {
+    ++index;
+  }
+  return index;
+}
+
+AdaptiveBuffer::AdaptiveBuffer(const BufferLimits& limits)
+    : min_size_(BufferPool::ClassSize(limits.min_size)),
+      max_size_(BufferPool::ClassSize(
+          std::max(limits.min_size, limits.max_size))),
+      size_(min_size_),
+      idle_delay_(limits.idle_delay),
+      wait_start_(std::chrono::steady_clock::now()),
+      small_reads_(0),
+      idle_(true),
+      buffer_() {}
+
+boost::asio::mutable_buffers_1 AdaptiveBuffer::Prepare() {
+  if (!buffer_ || buffer_.size() != size_) {
+    // Release the current buffer first to let the pool reuse it
+    buffer_.Reset();
+    buffer_ = BufferPool::Get().Acquire(size_);
+  }
+  return boost::asio::buffer(buffer_.data(), size_);
+}
+
+void AdaptiveBuffer::Adapt(std::size_t n) {
+  idle_ = n < size_ &&
+          std::chrono::steady_clock::now() - wait_start_ >= idle_delay_;
+  if (n == size_) {
+    small_reads_ = 0;
+    size_ = std::min(size_ * 2, max_size_);
+  } else if (n < size_ / 4) {
+    // Keep the buffer through bursts of small reads
+    if (idle_ || ++small_reads_ >= kShrinkReads) {
+      small_reads_ = 0;
+      size_ = std::max(size_ / 2, min_size_);
+    }
+  } else {
+    small_reads_ = 0;
+  }
+}
+
+}  // ssf
@@ -0,0 +1,153 @@
+#ifndef SSF_NETWORK_BUFFER_POOL_H_
+#define SSF_NETWORK_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+namespace ssf {
+
+/// Bounds of the working buffers of a forwarding link
+struct BufferLimits {
+  /// Default bounds: 4 KB when idle up to 64 KB under load, idle after 1 s
+  /// without data
+  BufferLimits()
+      : min_size(4 * 1024), max_size(64 * 1024), idle_delay(1000) {}
+  BufferLimits(std::size_t min, std::size_t max,
+               std::chrono::milliseconds idle = std::chrono::milliseconds(1000))
+      : min_size(min), max_size(max), idle_delay(idle) {}
+
+  std::size_t min_size;
+  std::size_t max_size;
+  std::chrono::milliseconds idle_delay;
+};
+
+/// Process wide pool of working buffers
+/**
+* Buffers are allocated by size classes (powers of 2 from kMinClassSize to
+* kMaxClassSize). Released buffers are kept for reuse up to kMaxCachedBytes,
+* larger buffers are never pooled.
+*/
+class BufferPool {
+ public:
+  enum : std::size_t {
+    kMinClassSize = 1024,
+    kMaxClassSize = 1024 * 1024,
+    kMaxCachedBytes = 32 * 1024 * 1024
+  };
+
+  /// Buffer returning to its pool when destroyed
+  class Buffer {
+   public:
+    Buffer() : p_pool_(nullptr), p_data_(nullptr), size_(0) {}
+    Buffer(Buffer&& other);
+    Buffer& operator=(Buffer&& other);
+    ~Buffer() { Reset(); }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    char* data() const { return p_data_; }
+    std::size_t size() const { return size_; }
+    explicit operator bool() const { return p_data_ != nullptr; }
+
+    void Reset();
+
+   private:
+    friend class BufferPool;
+    Buffer(BufferPool* p_pool, char* p_data, std::size_t size)
+        : p_pool_(p_pool), p_data_(p_data), size_(size) {}
+
+   private:
+    BufferPool* p_pool_;
+    char* p_data_;
+    std::size_t size_;
+  };
+
+ public:
+  /// The pool shared by all the forwarding links
+  static BufferPool& Get();
+
+  BufferPool();
+  ~BufferPool();
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  /// Get a buffer of at least size bytes (size rounded up to its class)
+  Buffer Acquire(std::size_t size);
+
+  /// Size class of a buffer of size bytes
+  static std::size_t ClassSize(std::size_t size);
+
+  /// Bytes held by released buffers
+  std::size_t cached_bytes() const;
+
+ private:
+  void Release(char* p_data, std::size_t size);
+  static std::size_t ClassIndex(std::size_t class_size);
+
+ private:
+  enum : std::size_t { kClassCount = 11 };
+
+  mutable std::mutex mutex_;
+  std::array<std::vector<char*>, kClassCount> free_buffers_;
+  std::size_t cached_bytes_;
+};
+
+/// Working buffer of a half duplex link sized after the traffic
+/**
+* The buffer starts at the minimum size and doubles each time a read fills it.
+* It is kept between partial reads: it halves after kShrinkReads reads in a
+* row using less than a quarter of it, or after a read which waited the idle
+* delay. Such a read makes the link idle: it may give the buffer back to the
+* pool while it waits for more data.
+*/
+class AdaptiveBuffer {
+ public:
+  enum : uint32_t { kShrinkReads = 8 };
+
+ public:
+  explicit AdaptiveBuffer(const BufferLimits& limits);
+
+  /// Mark the start of a wait for data (the read or the readiness wait)
+  void StartWait() { wait_start_ = std::chrono::steady_clock::now(); }
+
+  /// Buffer to read into (acquired from the pool if needed)
+  boost::asio::mutable_buffers_1 Prepare();
+
+  /// Data read in the buffer returned by Prepare
+  boost::asio::const_buffers_1 Data(std::size_t n) const {
+    return boost::asio::buffer(static_cast<const char*>(buffer_.data()), n);
+  }
+
+  /// Update the size after a read of n bytes
+  void Adapt(std::size_t n);
+
+  /// Give the buffer back to the pool
+  void Release() { buffer_.Reset(); }
+
+  bool idle() const { return idle_; }
+  std::size_t size() const { return size_; }
+
+ private:
+  std::size_t min_size_;
+  std::size_t max_size_;
+  std::size_t size_;
+  std::chrono::milliseconds idle_delay_;
+  std::chrono::steady_clock::time_point wait_start_;
+  uint32_t small_reads_;
+  bool idle_;
+  BufferPool::Buffer buffer_;
+};
+
+}  // ssf
+
+#endif  // SSF_NETWORK_BUFFER_POOL_H_
@@ -6,10 +6,12 @@
 #include <limits>
 #include <map>
 #include <set>
+#include <string>
 
 #include <boost/system/error_code.hpp>
 
 #include "ssf/error/error.h"
+#include "ssf/metrics/metrics.h"
 
 namespace ssf {
 
@@ -24,7 +26,22 @@ class ItemManager : private boost::noncopyable {
   typedef uint32_t instance_id_type;
 
  public:
-  ItemManager() : id_map_mutex_(), id_map_() {}
+  ItemManager()
+      : id_map_mutex_(),
+        id_map_(),
+        p_items_gauge_(nullptr),
+        p_errors_counter_(nullptr) {}
+
+  // The number of active items and of items which failed to start are
+  // published as the <metrics_prefix>.sessions gauge and the
+  // <metrics_prefix>.errors counter
+  explicit ItemManager(const std::string& metrics_prefix)
+      : id_map_mutex_(),
+        id_map_(),
+        p_items_gauge_(
+            &metrics::GetRegistry().GetGauge(metrics_prefix + ".sessions")),
+        p_errors_counter_(
+            &metrics::GetRegistry().GetCounter(metrics_prefix + ".errors")) {}
 
   virtual ~ItemManager() { stop_all(); }
 
@@ -74,13 +91,16 @@ class ItemManager : private boost::noncopyable {
     if (!new_id) {
       ec.assign(ssf::error::device_or_resource_busy,
                 ssf::error::get_ssf_category());
+      count_error();
       return 0;
     } else {
       item->start(ec);
       if (!ec) {
         id_map_.insert(std::make_pair(new_id, std::move(item)));
+        update_items_gauge(1);
         return new_id;
       } else {
+        count_error();
         return 0;
       }
     }
@@ -94,6 +114,7 @@ class ItemManager : private boost::noncopyable {
       it->second->stop(ec);
       if (!ec) {
         id_map_.erase(id);
+        update_items_gauge(-1);
       }
     } else {
       ec.assign(ssf::error::invalid_argument, ssf::error::get_ssf_category());
@@ -106,9 +127,22 @@ class ItemManager : private boost::noncopyable {
     for (auto& item : id_map_) {
       item.second->stop(ec);
     }
+    update_items_gauge(-static_cast<int64_t>(id_map_.size()));
     id_map_.clear();
   }
 
+  void update_items_gauge(int64_t delta) {
+    if (p_items_gauge_ && metrics::Enabled()) {
+      p_items_gauge_->Add(delta);
+    }
+  }
+
+  void count_error() {
+    if (p_errors_counter_ && metrics::Enabled()) {
+      p_errors_counter_->Increment();
+    }
+  }
+
   // Return the next available ID and 0 if no ID is available
   instance_id_type get_available_id() {
     for (instance_id_type i = 1; i < std::numeric_limits<uint32_t>::max();
@@ -123,6 +157,8 @@ class ItemManager : private boost::noncopyable {
  private:
   std::recursive_mutex id_map_mutex_;
   std::map<instance_id_type, ActionableItem> id_map_;
+  metrics::Gauge* p_items_gauge_;
+  metrics::Counter* p_errors_counter_;
 };
 
 }  // ssf
@@ -1,7 +1,6 @@
 #ifndef SSF_NETWORK_SESSION_FORWARDER_H
 #define SSF_NETWORK_SESSION_FORWARDER_H
 
-#include <array>
 #include <functional>
 #include <memory>
 
@@ -12,6 +11,7 @@
 #include <ssf/log/log.h>
 
 #include "ssf/network/base_session.h"  // NOLINT
+#include "ssf/network/buffer_pool.h"
 #include "ssf/network/manager.h"
 #include "ssf/network/socket_link.h"
 
@@ -21,9 +21,6 @@ namespace ssf {
 template <typename InwardStream, typename ForwardStream>
 class SessionForwarder : public ssf::BaseSession {
  private:
-  /// Buffer type for the transiting data
-  using StreamBuf = std::array<char, 50 * 1024>;
-
   /// Type for the class managing the different forwarding links
   using SessionManager = ItemManager<BaseSessionPtr>;
 
@@ -75,23 +72,23 @@ class SessionForwarder : public ssf::BaseSession {
  private:
   /// The constructor is made private to ensure users only use create()
   SessionForwarder(SessionManager* manager, InwardStream inbound,
-                   ForwardStream outbound)
+                   ForwardStream outbound,
+                   const BufferLimits& buffer_limits = BufferLimits())
       : inbound_(std::move(inbound)),
         outbound_(std::move(outbound)),
-        manager_(manager) {}
+        manager_(manager),
+        buffer_limits_(buffer_limits) {}
 
   /// Start forwarding
   void DoForward() {
     // Make two Half Duplex links to have a Full Duplex Link
     AsyncEstablishHDLink(
-        ReadFrom(inbound_), WriteTo(outbound_),
-        boost::asio::buffer(inwardBuffer_),
+        ReadFrom(inbound_), WriteTo(outbound_), buffer_limits_,
         std::bind(&SessionForwarder::OnStop, this,
                   this->shared_from_this(), std::placeholders::_1));
 
     AsyncEstablishHDLink(
-        ReadFrom(outbound_), WriteTo(inbound_),
-        boost::asio::buffer(forwardBuffer_),
+        ReadFrom(outbound_), WriteTo(inbound_), buffer_limits_,
         std::bind(&SessionForwarder::OnStop, this,
                   this->shared_from_this(), std::placeholders::_1));
   }
@@ -110,9 +107,8 @@ class SessionForwarder : public ssf::BaseSession {
   /// The manager handling multiple SessionForwarder
   SessionManager* manager_;
 
-  // One buffer for each Half Duplex Link
-  StreamBuf inwardBuffer_;
-  StreamBuf forwardBuffer_;
+  // Bounds of the pooled buffer of each Half Duplex Link
+  BufferLimits buffer_limits_;
 };
 
 }  // ssf
@@ -1,14 +1,20 @@
 #ifndef SSF_NETWORK_SOCKET_LINK_H_
 #define SSF_NETWORK_SOCKET_LINK_H_
 
+#include <memory>
+
 #include <boost/tuple/tuple.hpp>  // NOLINT
 
 #include <boost/asio/coroutine.hpp>  // NOLINT
 #include <boost/asio/buffer.hpp>  // NOLINT
+#include <boost/asio/ip/tcp.hpp>  // NOLINT
 #include <boost/asio/write.hpp>  // NOLINT
 
 #include <boost/system/error_code.hpp>   // NOLINT
 
+#include "ssf/network/buffer_pool.h"
+#include "ssf/network/splice_link.h"
+
 namespace ssf {
 
 /// Async Half Duplex Stream Socket Forwarder
@@ -81,6 +87,112 @@ struct AsyncHDSocketLinker : boost::asio::coroutine {
   size_t transfered_bytes_;
 };
 
+namespace detail {
+
+/// Wait for a socket to be readable without holding a buffer
+/**
+* Only available for TCP sockets (reactor based readiness); the other streams
+* keep a minimum size buffer in their pending read.
+*/
+template <class SocketType>
+struct ReadinessWait {
+  static const bool supported = false;
+
+  template <class Handler>
+  static void async_wait(SocketType&, Handler&&) {}
+};
+
+template <>
+struct ReadinessWait<boost::asio::ip::tcp::socket> {
+  static const bool supported = true;
+
+  template <class Handler>
+  static void async_wait(boost::asio::ip::tcp::socket& socket,
+                         Handler&& handler) {
+    socket.async_read_some(boost::asio::null_buffers(),
+                           std::forward<Handler>(handler));
+  }
+};
+
+}  // detail
+
+/// Async Half Duplex Stream Socket Forwarder with a pooled adaptive buffer
+/**
+* Same forwarding as AsyncHDSocketLinker, but the working buffer comes from
+* the BufferPool and follows the traffic (see AdaptiveBuffer). The buffer is
+* kept while reading; a TCP input idle for the idle delay gives it back while
+* waiting for data.
+*
+* @tparam Handler type of the callback handler
+* @tparam ReadFromSocketType type of the input socket
+* @tparam WriteToSocketType type od the output socket
+*/
+template<class Handler,
+         class ReadFromSocketType,
+         class WriteToSocketType = ReadFromSocketType>
+struct AsyncAdaptiveHDSocketLinker : boost::asio::coroutine {
+ public:
+  using ReadinessWait = detail::ReadinessWait<ReadFromSocketType>;
+
+ public:
+  /// Constructor
+  /**
+  * @param read_from input socket
+  * @param write_to output socket
+  * @param limits the working buffer size bounds
+  * @param handler the callback to call when the transfer stops
+  */
+  AsyncAdaptiveHDSocketLinker(ReadFromSocketType& read_from,
+                              WriteToSocketType& write_to,
+                              const BufferLimits& limits, Handler handler)
+      : r_(read_from),
+        w_(write_to),
+        p_buffer_(std::make_shared<AdaptiveBuffer>(limits)),
+        handler_(handler),
+        transfered_bytes_(0) { }
+
+#include <boost/asio/yield.hpp>  // NOLINT
+
+  void operator() (const boost::system::error_code& ec, std::size_t n) {
+    if (ec || !r_.is_open() || !w_.is_open()) {
+      p_buffer_->Release();
+      handler_(ec, 0);
+      return;
+    }
+
+    reenter(this) {
+      for (;;) {
+        p_buffer_->StartWait();
+        if (ReadinessWait::supported && p_buffer_->idle()) {
+          p_buffer_->Release();
+          yield ReadinessWait::async_wait(r_, std::move(*this));
+        }
+
+        // Receive some data
+        yield r_.async_read_some(p_buffer_->Prepare(), std::move(*this));
+        transfered_bytes_ = n;
+
+        // Keep sending until the number of sent bytes is not null (if some
+        // bytes were received previously).
+        do {
+          // Send the received data
+          yield boost::asio::async_write(
+              w_, p_buffer_->Data(transfered_bytes_), std::move(*this));
+        } while (!n && transfered_bytes_);
+
+        p_buffer_->Adapt(transfered_bytes_);
+      }
+    }
+  }
+#include <boost/asio/unyield.hpp>  // NOLINT
+
+  ReadFromSocketType& r_;
+  WriteToSocketType& w_;
+  std::shared_ptr<AdaptiveBuffer> p_buffer_;
+  Handler handler_;
+  size_t transfered_bytes_;
+};
+
 /// Wrapper for the Stream Socket to read from
 template<class SocketType>
 struct ReadFromHelper {
@@ -115,15 +227,83 @@ WriteToHelper<SocketType> WriteTo(SocketType& s) {
   return WriteToHelper<SocketType>(s);
 }
 
+namespace detail {
+
+/// Copy the data through the working buffer
+template<typename Handler, class ReadFromSocketType, class WriteToSocketType>
+void AsyncEstablishHDLink(ReadFromSocketType& read_from,
+                          WriteToSocketType& write_to,
+                          boost::asio::mutable_buffers_1 working_buffer,
+                          Handler handler) {
+  AsyncHDSocketLinker<Handler, ReadFromSocketType, WriteToSocketType>
+      AsyncTransfer(read_from, write_to, working_buffer, handler);
+
+  AsyncTransfer(boost::system::error_code(), 0);
+}
+
+#if defined(SSF_SPLICE_LINK)
+/// Relay the data between two TCP sockets in the kernel when possible
+template<typename Handler>
+void AsyncEstablishHDLink(boost::asio::ip::tcp::socket& read_from,
+                          boost::asio::ip::tcp::socket& write_to,
+                          boost::asio::mutable_buffers_1 working_buffer,
+                          Handler handler) {
+  if (AsyncEstablishSpliceLink(read_from, write_to, handler)) {
+    return;
+  }
+
+  AsyncHDSocketLinker<Handler, boost::asio::ip::tcp::socket>
+      AsyncTransfer(read_from, write_to, working_buffer, handler);
+
+  AsyncTransfer(boost::system::error_code(), 0);
+}
+#endif  // defined(SSF_SPLICE_LINK)
+
+/// Forward the data through a pooled adaptive buffer
+template<typename Handler, class ReadFromSocketType, class WriteToSocketType>
+void AsyncEstablishHDLink(ReadFromSocketType& read_from,
+                          WriteToSocketType& write_to,
+                          const BufferLimits& limits,
+                          Handler handler) {
+  AsyncAdaptiveHDSocketLinker<Handler, ReadFromSocketType, WriteToSocketType>
+      AsyncTransfer(read_from, write_to, limits, handler);
+
+  AsyncTransfer(boost::system::error_code(), 0);
+}
+
+#if defined(SSF_SPLICE_LINK)
+template<typename Handler>
+void AsyncEstablishHDLink(boost::asio::ip::tcp::socket& read_from,
+                          boost::asio::ip::tcp::socket& write_to,
+                          const BufferLimits& limits,
+                          Handler handler) {
+  if (AsyncEstablishSpliceLink(read_from, write_to, handler)) {
+    return;
+  }
+
+  AsyncAdaptiveHDSocketLinker<Handler, boost::asio::ip::tcp::socket>
+      AsyncTransfer(read_from, write_to, limits, handler);
+
+  AsyncTransfer(boost::system::error_code(), 0);
+}
+#endif  // defined(SSF_SPLICE_LINK)
+
+}  // detail
+
 /// Establish a Half Duplex Link
 template<typename Handler, class ReadFrom, class WriteTo>
 void AsyncEstablishHDLink(ReadFrom rf, WriteTo wt,
                           boost::asio::mutable_buffers_1 working_buffer,
                           Handler handler) {
-  AsyncHDSocketLinker<Handler, typename ReadFrom::type, typename WriteTo::type>
-      AsyncTransfer(rf.read_from_, wt.write_to_, working_buffer, handler);
+  detail::AsyncEstablishHDLink(rf.read_from_, wt.write_to_, working_buffer,
+                               handler);
+}
 
-  AsyncTransfer(boost::system::error_code(), 0);
+/// Establish a Half Duplex Link working with pooled buffers
+template<typename Handler, class ReadFrom, class WriteTo>
+void AsyncEstablishHDLink(ReadFrom rf, WriteTo wt, const BufferLimits& limits,
+                          Handler handler) {
+  detail::AsyncEstablishHDLink(rf.read_from_, wt.write_to_, limits, handler);
 }
 
 }  // ssf
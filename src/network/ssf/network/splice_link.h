@@ -0,0 +1,313 @@
+#ifndef SSF_NETWORK_SPLICE_LINK_H_
+#define SSF_NETWORK_SPLICE_LINK_H_
+
+#if defined(__linux__)
+
+#define SSF_SPLICE_LINK
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <boost/system/error_code.hpp>
+
+namespace ssf {
+namespace detail {
+
+/// Kernel pipe carrying the data of a splice link
+class SplicePipe {
+ public:
+  static std::unique_ptr<SplicePipe> Create(boost::system::error_code& ec) {
+    std::unique_ptr<SplicePipe> p_pipe(new SplicePipe());
+    if (::pipe2(p_pipe->fds_, O_NONBLOCK | O_CLOEXEC) != 0) {
+      ec.assign(errno, boost::system::system_category());
+      return nullptr;
+    }
+    ec.assign(0, boost::system::system_category());
+    return p_pipe;
+  }
+
+  ~SplicePipe() {
+    if (fds_[0] != -1) {
+      ::close(fds_[0]);
+      ::close(fds_[1]);
+    }
+  }
+
+  int read_fd() const { return fds_[0]; }
+  int write_fd() const { return fds_[1]; }
+
+  /// Check if the pipe holds no data
+  bool empty() const {
+    int size = 0;
+    return ::ioctl(fds_[0], FIONREAD, &size) == 0 && size == 0;
+  }
+
+ private:
+  SplicePipe() : fds_{-1, -1} {}
+
+ private:
+  int fds_[2];
+};
+
+/// Process wide pool of the splice pipes
+/**
+* A link takes a pipe when its first data arrives and gives it back when it
+* ends: idle links hold no pipe. Only empty pipes are kept for reuse, up to
+* kMaxIdlePipes.
+*/
+class SplicePipePool {
+ public:
+  enum : std::size_t { kMaxIdlePipes = 64 };
+
+ public:
+  static SplicePipePool& Get() {
+    // Never destroyed: pipes may be released during the static destruction
+    static SplicePipePool* p_pool = new SplicePipePool();
+    return *p_pool;
+  }
+
+  SplicePipePool() : mutex_(), idle_pipes_() {}
+
+  SplicePipePool(const SplicePipePool&) = delete;
+  SplicePipePool& operator=(const SplicePipePool&) = delete;
+
+  /// Get a pipe going back to the pool when the last reference is dropped
+  std::shared_ptr<SplicePipe> Acquire(boost::system::error_code& ec) {
+    std::unique_ptr<SplicePipe> p_pipe;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!idle_pipes_.empty()) {
+        p_pipe = std::move(idle_pipes_.back());
+        idle_pipes_.pop_back();
+      }
+    }
+
+    if (!p_pipe) {
+      p_pipe = SplicePipe::Create(ec);
+      if (ec) {
+        return nullptr;
+      }
+    }
+
+    ec.assign(0, boost::system::system_category());
+    return std::shared_ptr<SplicePipe>(
+        p_pipe.release(), [this](SplicePipe* p_released) {
+          Release(std::unique_ptr<SplicePipe>(p_released));
+        });
+  }
+
+  std::size_t idle_count() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_pipes_.size();
+  }
+
+ private:
+  void Release(std::unique_ptr<SplicePipe> p_pipe) {
+    // A link ended by an error may leave data in its pipe
+    if (!p_pipe->empty()) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (idle_pipes_.size() < kMaxIdlePipes) {
+      idle_pipes_.push_back(std::move(p_pipe));
+    }
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<SplicePipe>> idle_pipes_;
+};
+
+/// Move up to len bytes from fd_in to fd_out without copying them
+inline std::size_t Splice(int fd_in, int fd_out, std::size_t len,
+                          boost::system::error_code& ec) {
+  ssize_t n;
+  do {
+    n = ::splice(fd_in, nullptr, fd_out, nullptr, len,
+                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0) {
+    ec.assign(errno, boost::system::system_category());
+    return 0;
+  }
+
+  ec.assign(0, boost::system::system_category());
+  return static_cast<std::size_t>(n);
+}
+
+/// Splice to a socket without raising SIGPIPE
+/**
+* splice() has no MSG_NOSIGNAL: a socket whose peer is gone raises SIGPIPE.
+* The signal is blocked during the call and the one it raised is discarded.
+*/
+inline std::size_t SpliceToSocket(int fd_in, int socket, std::size_t len,
+                                  boost::system::error_code& ec) {
+  sigset_t pipe_set;
+  sigemptyset(&pipe_set);
+  sigaddset(&pipe_set, SIGPIPE);
+
+  sigset_t pending_set;
+  sigemptyset(&pending_set);
+  sigpending(&pending_set);
+  bool was_pending = sigismember(&pending_set, SIGPIPE) == 1;
+
+  sigset_t old_set;
+  pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+  auto n = Splice(fd_in, socket, len, ec);
+
+  if (ec == boost::asio::error::broken_pipe && !was_pending) {
+    struct timespec no_wait = {0, 0};
+    while (::sigtimedwait(&pipe_set, nullptr, &no_wait) < 0 && errno == EINTR) {
+    }
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+  return n;
+}
+
+/// Async Half Duplex TCP Socket Forwarder relaying through a kernel pipe
+/**
+* Equivalent to AsyncHDSocketLinker for two TCP sockets: the data is moved
+* from the input socket to the pipe then from the pipe to the output socket
+* with splice() and never reaches user space. The sockets readiness is waited
+* for with null_buffers operations. The pipe comes from the SplicePipePool
+* once the first data is available.
+*
+* @tparam Handler type of the callback handler
+*/
+template <class Handler>
+struct AsyncSpliceLinker : boost::asio::coroutine {
+ public:
+  using socket_type = boost::asio::ip::tcp::socket;
+
+  // Bytes moved by a single splice call (default pipe capacity)
+  enum { kChunkSize = 64 * 1024 };
+
+ public:
+  AsyncSpliceLinker(socket_type& read_from, socket_type& write_to,
+                    Handler handler)
+      : r_(read_from),
+        w_(write_to),
+        p_pipe_(nullptr),
+        handler_(handler),
+        pending_bytes_(0) {}
+
+#include <boost/asio/yield.hpp>  // NOLINT
+
+  void operator()(const boost::system::error_code& ec, std::size_t) {
+    if (ec || !r_.is_open() || !w_.is_open()) {
+      End(ec);
+      return;
+    }
+
+    boost::system::error_code splice_ec;
+    std::size_t n = 0;
+
+    reenter(this) {
+      for (;;) {
+        // Wait for some data
+        yield r_.async_read_some(boost::asio::null_buffers(), std::move(*this));
+
+        if (!p_pipe_) {
+          p_pipe_ = SplicePipePool::Get().Acquire(splice_ec);
+          if (splice_ec) {
+            End(splice_ec);
+            return;
+          }
+        }
+
+        pending_bytes_ = Splice(r_.native_handle(), p_pipe_->write_fd(),
+                                kChunkSize, splice_ec);
+        if (splice_ec == boost::asio::error::would_block) {
+          continue;
+        }
+        if (splice_ec) {
+          End(splice_ec);
+          return;
+        }
+        if (pending_bytes_ == 0) {
+          End(boost::asio::error::eof);
+          return;
+        }
+
+        // Send everything the pipe holds
+        while (pending_bytes_ > 0) {
+          n = SpliceToSocket(p_pipe_->read_fd(), w_.native_handle(),
+                             pending_bytes_, splice_ec);
+          if (splice_ec == boost::asio::error::would_block) {
+            yield w_.async_write_some(boost::asio::null_buffers(),
+                                      std::move(*this));
+            continue;
+          }
+          if (splice_ec) {
+            End(splice_ec);
+            return;
+          }
+          pending_bytes_ -= n;
+        }
+      }
+    }
+  }
+
+#include <boost/asio/unyield.hpp>  // NOLINT
+
+  // Give the pipe back before calling the handler
+  void End(const boost::system::error_code& ec) {
+    p_pipe_.reset();
+    handler_(ec, 0);
+  }
+
+  socket_type& r_;
+  socket_type& w_;
+  std::shared_ptr<SplicePipe> p_pipe_;
+  Handler handler_;
+  std::size_t pending_bytes_;
+};
+
+/// Establish a Half Duplex splice link between two TCP sockets
+/**
+* @return false if the link could not be set up (nothing was started)
+*/
+template <typename Handler>
+bool AsyncEstablishSpliceLink(boost::asio::ip::tcp::socket& read_from,
+                              boost::asio::ip::tcp::socket& write_to,
+                              Handler handler) {
+  boost::system::error_code ec;
+  read_from.native_non_blocking(true, ec);
+  if (!ec) {
+    write_to.native_non_blocking(true, ec);
+  }
+  if (ec) {
+    return false;
+  }
+
+  AsyncSpliceLinker<Handler> splice_transfer(read_from, write_to, handler);
+  splice_transfer(boost::system::error_code(), 0);
+
+  return true;
+}
+
+}  // detail
+}  // ssf
+
+#endif  // defined(__linux__)
+
+#endif  // SSF_NETWORK_SPLICE_LINK_H_
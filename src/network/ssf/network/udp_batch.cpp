@@ -0,0 +1,269 @@
+#include "ssf/network/udp_batch.h"
+
+#if defined(SSF_UDP_BATCH)
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+
+namespace ssf {
+
+namespace {
+
+// Room for the UDP_GRO / UDP_SEGMENT control message of a message
+const std::size_t kControlSize = CMSG_SPACE(sizeof(int));
+
+// Largest payload given to the kernel in a single segmented message
+const std::size_t kMaxOffloadBytes = 60000;
+
+// Largest segment: a segmented message must not need IP fragmentation on a
+// 1500 bytes MTU (IP and UDP headers removed), the kernel rejects larger ones
+const std::size_t kMaxOffloadSegmentSizeV4 = 1500 - 20 - 8;
+const std::size_t kMaxOffloadSegmentSizeV6 = 1500 - 40 - 8;
+
+// Segments in a segmented message (UDP_MAX_SEGMENTS)
+const std::size_t kMaxOffloadSegments = 64;
+
+}  // unnamed namespace
+
+UdpReceiveBatch::UdpReceiveBatch(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1)),
+      buffer_(),
+      senders_(capacity_),
+      iovs_(capacity_),
+      messages_(capacity_),
+      control_(capacity_ * kControlSize),
+      datagrams_() {
+  datagrams_.reserve(capacity_);
+}
+
+UdpReceiveBatch& UdpReceiveBatch::ForThread() {
+  thread_local UdpReceiveBatch batch;
+  return batch;
+}
+
+bool UdpReceiveBatch::EnableReceiveOffload(int fd) {
+#if defined(UDP_GRO)
+  int enabled = 1;
+  return ::setsockopt(fd, IPPROTO_UDP, UDP_GRO, &enabled, sizeof(enabled)) ==
+         0;
+#else
+  return false;
+#endif
+}
+
+std::size_t UdpReceiveBatch::Receive(int fd, boost::system::error_code& ec) {
+  datagrams_.clear();
+  if (!buffer_) {
+    buffer_ = BufferPool::Get().Acquire(capacity_ * kSlotSize);
+  }
+
+  for (std::size_t i = 0; i < capacity_; ++i) {
+    iovs_[i].iov_base = buffer_.data() + i * kSlotSize;
+    iovs_[i].iov_len = kSlotSize;
+
+    auto& header = messages_[i].msg_hdr;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_name = senders_[i].data();
+    header.msg_namelen = static_cast<socklen_t>(senders_[i].capacity());
+    header.msg_iov = &iovs_[i];
+    header.msg_iovlen = 1;
+    header.msg_control = control_.data() + i * kControlSize;
+    header.msg_controllen = kControlSize;
+    messages_[i].msg_len = 0;
+  }
+
+  int count;
+  do {
+    count = ::recvmmsg(fd, messages_.data(), static_cast<unsigned>(capacity_),
+                       MSG_DONTWAIT, nullptr);
+  } while (count < 0 && errno == EINTR);
+
+  if (count < 0) {
+    ec.assign(errno, boost::system::system_category());
+    return 0;
+  }
+
+  for (std::size_t i = 0; i < static_cast<std::size_t>(count); ++i) {
+    auto& header = messages_[i].msg_hdr;
+    senders_[i].resize(header.msg_namelen);
+
+    std::size_t length = messages_[i].msg_len;
+    std::size_t segment_size = length;
+#if defined(UDP_GRO)
+    for (auto p_cmsg = CMSG_FIRSTHDR(&header); p_cmsg != nullptr;
+         p_cmsg = CMSG_NXTHDR(&header, p_cmsg)) {
+      if (p_cmsg->cmsg_level == IPPROTO_UDP && p_cmsg->cmsg_type == UDP_GRO) {
+        int gro_size;
+        std::memcpy(&gro_size, CMSG_DATA(p_cmsg), sizeof(gro_size));
+        if (gro_size > 0) {
+          segment_size = static_cast<std::size_t>(gro_size);
+        }
+      }
+    }
+#endif
+
+    const char* p_data = static_cast<const char*>(iovs_[i].iov_base);
+    std::size_t offset = 0;
+    do {
+      auto size = std::min(segment_size, length - offset);
+      datagrams_.push_back({boost::asio::buffer(p_data + offset, size), i});
+      offset += size;
+    } while (offset < length);
+  }
+
+  ec.assign(0, boost::system::system_category());
+  return datagrams_.size();
+}
+
+void UdpReceiveBatch::CopyOut(
+    BufferPool::Buffer* p_buffer,
+    std::vector<boost::asio::const_buffer>* p_datagrams) const {
+  p_datagrams->clear();
+  std::size_t total_size = 0;
+  for (const auto& datagram : datagrams_) {
+    total_size += boost::asio::buffer_size(datagram.buffer);
+  }
+  if (p_buffer->size() < total_size) {
+    *p_buffer = BufferPool::Get().Acquire(total_size);
+  }
+
+  std::size_t offset = 0;
+  for (const auto& datagram : datagrams_) {
+    auto size = boost::asio::buffer_copy(
+        boost::asio::buffer(p_buffer->data() + offset, total_size - offset),
+        datagram.buffer);
+    p_datagrams->push_back(boost::asio::buffer(p_buffer->data() + offset, size));
+    offset += size;
+  }
+}
+
+void UdpReceiveBatch::Clear() {
+  datagrams_.clear();
+  buffer_.Reset();
+}
+
+UdpSendBatch::UdpSendBatch(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1)),
+#if defined(UDP_SEGMENT)
+      segmentation_offload_(true),
+#else
+      segmentation_offload_(false),
+#endif
+      iovs_(capacity_),
+      messages_(capacity_),
+      message_datagrams_(capacity_),
+      control_(capacity_ * kControlSize) {
+}
+
+std::size_t UdpSendBatch::Send(
+    int fd, const endpoint_type& to,
+    const std::vector<boost::asio::const_buffer>& datagrams,
+    boost::system::error_code& ec) {
+  for (;;) {
+    auto message_count = Prepare(to, datagrams);
+    if (message_count == 0) {
+      ec.assign(0, boost::system::system_category());
+      return 0;
+    }
+
+    int sent;
+    do {
+      sent = ::sendmmsg(fd, messages_.data(),
+                        static_cast<unsigned>(message_count), MSG_DONTWAIT);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent < 0) {
+      // The route or the device cannot segment: send plain datagrams
+      if (segmentation_offload_ && (errno == EIO || errno == EINVAL) &&
+          message_datagrams_[0] > 1) {
+        segmentation_offload_ = false;
+        continue;
+      }
+      ec.assign(errno, boost::system::system_category());
+      return 0;
+    }
+
+    std::size_t datagram_count = 0;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(sent); ++i) {
+      datagram_count += message_datagrams_[i];
+    }
+
+    ec.assign(0, boost::system::system_category());
+    return datagram_count;
+  }
+}
+
+std::size_t UdpSendBatch::Prepare(
+    const endpoint_type& to,
+    const std::vector<boost::asio::const_buffer>& datagrams) {
+  auto datagram_count = std::min(datagrams.size(), capacity_);
+  auto max_segment_size = to.address().is_v6() ? kMaxOffloadSegmentSizeV6
+                                               : kMaxOffloadSegmentSizeV4;
+  std::size_t message_count = 0;
+  std::size_t i = 0;
+
+  while (i < datagram_count) {
+    auto segment_size = boost::asio::buffer_size(datagrams[i]);
+
+    // A run holds datagrams of the same size, the last one may be shorter
+    std::size_t run = 1;
+    std::size_t run_bytes = segment_size;
+    if (segmentation_offload_ && segment_size > 0 &&
+        segment_size <= max_segment_size) {
+      while (i + run < datagram_count && run < kMaxOffloadSegments) {
+        auto size = boost::asio::buffer_size(datagrams[i + run]);
+        if (size == 0 || size > segment_size ||
+            run_bytes + size > kMaxOffloadBytes) {
+          break;
+        }
+        ++run;
+        run_bytes += size;
+        if (size < segment_size) {
+          break;
+        }
+      }
+    }
+
+    for (std::size_t j = 0; j < run; ++j) {
+      iovs_[i + j].iov_base = const_cast<void*>(
+          boost::asio::buffer_cast<const void*>(datagrams[i + j]));
+      iovs_[i + j].iov_len = boost::asio::buffer_size(datagrams[i + j]);
+    }
+
+    auto& header = messages_[message_count].msg_hdr;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_name = const_cast<void*>(static_cast<const void*>(to.data()));
+    header.msg_namelen = static_cast<socklen_t>(to.size());
+    header.msg_iov = &iovs_[i];
+    header.msg_iovlen = run;
+
+#if defined(UDP_SEGMENT)
+    if (run > 1) {
+      header.msg_control = control_.data() + message_count * kControlSize;
+      header.msg_controllen = kControlSize;
+      auto p_cmsg = CMSG_FIRSTHDR(&header);
+      p_cmsg->cmsg_level = IPPROTO_UDP;
+      p_cmsg->cmsg_type = UDP_SEGMENT;
+      p_cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      auto gso_size = static_cast<uint16_t>(segment_size);
+      std::memcpy(CMSG_DATA(p_cmsg), &gso_size, sizeof(gso_size));
+    }
+#endif
+
+    message_datagrams_[message_count] = run;
+    ++message_count;
+    i += run;
+  }
+
+  return message_count;
+}
+
+}  // ssf
+
+#endif  // defined(SSF_UDP_BATCH)
@@ -0,0 +1,153 @@
+#ifndef SSF_NETWORK_UDP_BATCH_H_
+#define SSF_NETWORK_UDP_BATCH_H_
+
+#if defined(__linux__)
+
+#define SSF_UDP_BATCH
+
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <boost/system/error_code.hpp>
+
+#include "ssf/network/buffer_pool.h"
+
+namespace ssf {
+
+/// Datagrams read from a UDP socket with a single recvmmsg() call
+/**
+* Each message has a slot large enough for any UDP datagram. The slots are
+* taken from the BufferPool when Receive is called and given back by Clear,
+* so that a socket waiting for data holds no memory.
+*
+* Sockets which keep the datagrams while forwarding them share the batch of
+* their thread (ForThread) and copy out only the bytes received (CopyOut):
+* the slots are reused by the next Receive instead of being held per socket.
+*
+* When UDP GRO is enabled on the socket (EnableReceiveOffload), the kernel may
+* coalesce several datagrams of the same flow in one message: they are split
+* back into datagrams.
+*/
+class UdpReceiveBatch {
+ public:
+  using endpoint_type = boost::asio::ip::udp::endpoint;
+
+  enum : std::size_t {
+    kSlotSize = 64 * 1024,
+    kDefaultCapacity = BufferPool::kMaxClassSize / kSlotSize
+  };
+
+ public:
+  explicit UdpReceiveBatch(std::size_t capacity = kDefaultCapacity);
+
+  UdpReceiveBatch(const UdpReceiveBatch&) = delete;
+  UdpReceiveBatch& operator=(const UdpReceiveBatch&) = delete;
+
+  /// Batch shared by the sockets read in the calling thread (never cleared)
+  static UdpReceiveBatch& ForThread();
+
+  /// Ask the kernel to coalesce received datagrams (UDP GRO)
+  /**
+  * @return false if the kernel does not support it
+  */
+  static bool EnableReceiveOffload(int fd);
+
+  /// Read the pending datagrams without blocking
+  /**
+  * @return the number of datagrams read. ec is set to would_block if no
+  *   datagram was pending
+  */
+  std::size_t Receive(int fd, boost::system::error_code& ec);
+
+  /// Number of datagrams read by the last Receive call
+  std::size_t size() const { return datagrams_.size(); }
+
+  boost::asio::const_buffer datagram(std::size_t i) const {
+    return datagrams_[i].buffer;
+  }
+
+  const endpoint_type& sender(std::size_t i) const {
+    return senders_[datagrams_[i].message];
+  }
+
+  /// Copy the datagrams read in a pooled buffer sized after them
+  /**
+  * @param p_buffer Buffer receiving the datagrams (acquired from the pool)
+  * @param p_datagrams The datagrams in the buffer
+  */
+  void CopyOut(BufferPool::Buffer* p_buffer,
+               std::vector<boost::asio::const_buffer>* p_datagrams) const;
+
+  /// Forget the datagrams and give the slots back to the pool
+  void Clear();
+
+ private:
+  struct Datagram {
+    boost::asio::const_buffer buffer;
+    std::size_t message;
+  };
+
+ private:
+  std::size_t capacity_;
+  BufferPool::Buffer buffer_;
+  std::vector<endpoint_type> senders_;
+  std::vector<struct iovec> iovs_;
+  std::vector<struct mmsghdr> messages_;
+  std::vector<char> control_;
+  std::vector<Datagram> datagrams_;
+};
+
+/// Datagrams written to a UDP socket with a single sendmmsg() call
+/**
+* When UDP GSO is available, runs of datagrams of the same size are given to
+* the kernel as a single message which is segmented back into datagrams as
+* late as possible (by the NIC when it supports it).
+*/
+class UdpSendBatch {
+ public:
+  using endpoint_type = boost::asio::ip::udp::endpoint;
+
+  enum : std::size_t { kDefaultCapacity = 64 };
+
+ public:
+  explicit UdpSendBatch(std::size_t capacity = kDefaultCapacity);
+
+  UdpSendBatch(const UdpSendBatch&) = delete;
+  UdpSendBatch& operator=(const UdpSendBatch&) = delete;
+
+  /// Maximum number of datagrams sent by a Send call
+  std::size_t capacity() const { return capacity_; }
+
+  /// Send datagrams to an endpoint without blocking
+  /**
+  * @return the number of datagrams sent, starting from the first one. ec is
+  *   set to would_block if none could be sent
+  */
+  std::size_t Send(int fd, const endpoint_type& to,
+                   const std::vector<boost::asio::const_buffer>& datagrams,
+                   boost::system::error_code& ec);
+
+ private:
+  // Group the datagrams in messages and return the number of messages
+  std::size_t Prepare(const endpoint_type& to,
+                      const std::vector<boost::asio::const_buffer>& datagrams);
+
+ private:
+  std::size_t capacity_;
+  bool segmentation_offload_;
+  std::vector<struct iovec> iovs_;
+  std::vector<struct mmsghdr> messages_;
+  std::vector<std::size_t> message_datagrams_;
+  std::vector<char> control_;
+};
+
+}  // ssf
+
+#endif  // defined(__linux__)
+
+#endif  // SSF_NETWORK_UDP_BATCH_H_
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "ssf/network/buffer_pool.h"
+
+TEST(BufferPoolTests, AcquireRelease) {
+  ssf::BufferPool pool;
+
+  auto buffer = pool.Acquire(3000);
+  ASSERT_TRUE(static_cast<bool>(buffer));
+  ASSERT_EQ(buffer.size(), 4096u);
+  auto p_data = buffer.data();
+  ASSERT_EQ(pool.cached_bytes(), 0u);
+
+  buffer.Reset();
+  ASSERT_FALSE(static_cast<bool>(buffer));
+  ASSERT_EQ(pool.cached_bytes(), 4096u);
+
+  auto reused = pool.Acquire(4096);
+  ASSERT_EQ(reused.data(), p_data);
+  ASSERT_EQ(pool.cached_bytes(), 0u);
+}
+
+TEST(BufferPoolTests, AdaptiveBufferSize) {
+  // Every read is idle
+  ssf::AdaptiveBuffer buffer(
+      ssf::BufferLimits(4096, 16384, std::chrono::milliseconds(0)));
+  ASSERT_TRUE(buffer.idle());
+  ASSERT_EQ(boost::asio::buffer_size(buffer.Prepare()), 4096u);
+
+  // Full reads grow the buffer up to the maximum size
+  buffer.Adapt(4096);
+  ASSERT_FALSE(buffer.idle());
+  ASSERT_EQ(boost::asio::buffer_size(buffer.Prepare()), 8192u);
+  buffer.Adapt(8192);
+  buffer.Adapt(16384);
+  ASSERT_EQ(boost::asio::buffer_size(buffer.Prepare()), 16384u);
+
+  // Small reads shrink it down to the minimum size
+  buffer.Adapt(100);
+  ASSERT_TRUE(buffer.idle());
+  ASSERT_EQ(buffer.size(), 8192u);
+  buffer.Adapt(100);
+  buffer.Adapt(100);
+  ASSERT_EQ(buffer.size(), 4096u);
+}
+
+TEST(BufferPoolTests, AdaptiveBufferKeptWhileReading) {
+  ssf::AdaptiveBuffer buffer(
+      ssf::BufferLimits(4096, 16384, std::chrono::hours(1)));
+  buffer.StartWait();
+  buffer.Prepare();
+  buffer.Adapt(4096);
+  ASSERT_EQ(buffer.size(), 8192u);
+
+  // Partial reads keep the same buffer and do not make the link idle
+  auto p_data = boost::asio::buffer_cast<char*>(buffer.Prepare());
+  for (uint32_t i = 1; i < ssf::AdaptiveBuffer::kShrinkReads; ++i) {
+    buffer.StartWait();
+    buffer.Adapt(100);
+    ASSERT_FALSE(buffer.idle());
+    ASSERT_EQ(buffer.size(), 8192u);
+    ASSERT_EQ(boost::asio::buffer_cast<char*>(buffer.Prepare()), p_data);
+  }
+  // A read using more than a quarter of the buffer breaks the run
+  buffer.Adapt(4000);
+  ASSERT_EQ(buffer.size(), 8192u);
+
+  // Only a sustained run of small reads shrinks it
+  for (uint32_t i = 0; i < ssf::AdaptiveBuffer::kShrinkReads; ++i) {
+    buffer.Adapt(100);
+  }
+  ASSERT_FALSE(buffer.idle());
+  ASSERT_EQ(buffer.size(), 4096u);
+}
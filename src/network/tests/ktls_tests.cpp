@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/write.hpp>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "tests/virtual_network_helpers.h"
+
+#include "ssf/layer/cryptography/tls/OpenSSL/helpers.h"
+#include "ssf/layer/cryptography/tls/OpenSSL/ktls.h"
+
+#if defined(SSF_KERNEL_TLS)
+
+namespace detail = ssf::layer::cryptography::detail;
+
+class KernelTLSTest : public ::testing::Test {
+ protected:
+  using Tcp = boost::asio::ip::tcp;
+  using TLSStream = boost::asio::ssl::stream<Tcp::socket>;
+
+  KernelTLSTest()
+      : io_service_(),
+        server_context_(detail::make_tls_context(
+            io_service_,
+            tests::virtual_network_helpers::GetServerTLSParametersAsBuffer())),
+        client_context_(detail::make_tls_context(
+            io_service_,
+            tests::virtual_network_helpers::GetClientTLSParametersAsBuffer())),
+        server_(io_service_, *server_context_),
+        client_(io_service_, *client_context_) {}
+
+  // Connect the TLS streams on the loopback then let the kernel encrypt the
+  // data sent by the client
+  void SetUp() override {
+    Tcp::acceptor acceptor(
+        io_service_, Tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    client_.next_layer().connect(acceptor.local_endpoint());
+    acceptor.accept(server_.next_layer());
+
+    boost::system::error_code server_ec;
+    std::thread server_handshake([this, &server_ec]() {
+      server_.handshake(boost::asio::ssl::stream_base::server, server_ec);
+    });
+    boost::system::error_code client_ec;
+    client_.handshake(boost::asio::ssl::stream_base::client, client_ec);
+    server_handshake.join();
+    ASSERT_FALSE(server_ec) << server_ec.message();
+    ASSERT_FALSE(client_ec) << client_ec.message();
+
+    boost::system::error_code ec;
+    if (!detail::EnableKernelTLSTx(client_.native_handle(),
+                                   client_.next_layer(), ec)) {
+      GTEST_SKIP() << "kernel TLS not available (tls module not loaded)";
+    }
+  }
+
+ protected:
+  boost::asio::io_service io_service_;
+  detail::ExtendedTLSContext server_context_;
+  detail::ExtendedTLSContext client_context_;
+  TLSStream server_;
+  TLSStream client_;
+};
+
+TEST_F(KernelTLSTest, PeerDecryptsKernelRecords) {
+  // Larger than a record: the kernel splits the data in several records
+  std::string sent;
+  for (std::size_t i = 0; sent.size() < 100 * 1024; ++i) {
+    sent += std::to_string(i) + ' ';
+  }
+
+  boost::system::error_code ec;
+  boost::asio::write(client_.next_layer(), boost::asio::buffer(sent), ec);
+  ASSERT_FALSE(ec) << ec.message();
+
+  std::string received(sent.size(), '\0');
+  boost::asio::read(server_, boost::asio::buffer(&received[0], received.size()),
+                    ec);
+  ASSERT_FALSE(ec) << ec.message();
+  ASSERT_EQ(received, sent);
+}
+
+TEST_F(KernelTLSTest, OpenSSLAlertIsSentByTheKernel) {
+  boost::system::error_code ec;
+  boost::asio::write(client_.next_layer(), boost::asio::buffer("data", 4), ec);
+  ASSERT_FALSE(ec) << ec.message();
+
+  // A record the client cannot decrypt: OpenSSL writes a fatal alert while
+  // reading
+  std::vector<unsigned char> forged_record = {0x17, 0x03, 0x03, 0x00, 0x20};
+  forged_record.resize(forged_record.size() + 0x20, 0);
+  boost::asio::write(server_.next_layer(), boost::asio::buffer(forged_record),
+                     ec);
+  ASSERT_FALSE(ec) << ec.message();
+
+  char byte;
+  client_.read_some(boost::asio::buffer(&byte, 1), ec);
+  ASSERT_TRUE(!!ec);
+
+  // The data sent before is intact and the alert follows it, encrypted by
+  // the kernel as an alert record
+  std::string received(4, '\0');
+  boost::asio::read(server_, boost::asio::buffer(&received[0], received.size()),
+                    ec);
+  ASSERT_FALSE(ec) << ec.message();
+  ASSERT_EQ(received, "data");
+
+  server_.read_some(boost::asio::buffer(&byte, 1), ec);
+  ASSERT_EQ(ec.category(), boost::asio::error::get_ssl_category());
+  ASSERT_EQ(ERR_GET_REASON(ec.value()), SSL_R_SSLV3_ALERT_BAD_RECORD_MAC);
+}
+
+#endif  // defined(SSF_KERNEL_TLS)
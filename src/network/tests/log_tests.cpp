@@ -1,7 +1,20 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "ssf/log/log.h"
 
+#ifndef SSF_DISABLE_LOGS
+#include "ssf/log/async_sink.h"
+#endif  // SSF_DISABLE_LOGS
+
 TEST(LogTests, DefaultLog) {
   SSF_LOG("test", critical, "critical");
   SSF_LOG("test", error, "error");
@@ -39,4 +52,124 @@ TEST(LogTests, NoLog) {
   SSF_LOG("test", info, "info");
   SSF_LOG("test", debug, "debug");
   SSF_LOG("test", trace, "trace");
-}
\ No newline at end of file
+}
+
+#ifndef SSF_DISABLE_LOGS
+namespace {
+
+/// Sink stalling the flusher thread on the first message until released
+class StalledSink : public spdlog::sinks::sink {
+ public:
+  StalledSink() : mutex_(), cv_(), stalled_(true), messages_() {}
+
+  void log(const spdlog::details::log_msg& msg) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    messages_.emplace_back(msg.formatted.data(), msg.formatted.size());
+    cv_.notify_all();
+    cv_.wait(lock, [this]() { return !stalled_; });
+  }
+
+  void flush() override {}
+
+  void WaitStalled() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !messages_.empty(); });
+  }
+
+  void Release() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stalled_ = false;
+    cv_.notify_all();
+  }
+
+  std::vector<std::string> messages() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return messages_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stalled_;
+  std::vector<std::string> messages_;
+};
+
+void Log(ssf::log::AsyncSink* p_sink, int i) {
+  static const std::string name("test");
+  spdlog::details::log_msg msg(&name, spdlog::level::info);
+  msg.formatted << "async " << i;
+  p_sink->log(msg);
+}
+
+}  // namespace
+
+TEST(LogTests, AsyncLogDrop) {
+  auto p_stalled_sink = std::make_shared<StalledSink>();
+  ssf::log::AsyncSink sink({p_stalled_sink}, "%v");
+  sink.Start(16, ssf::log::OverflowPolicy::kDrop);
+
+  // The flusher holds the record of the first message while stalled: the
+  // ring has room for 15 more
+  Log(&sink, 0);
+  p_stalled_sink->WaitStalled();
+  for (int i = 1; i < 21; ++i) {
+    Log(&sink, i);
+  }
+  ASSERT_EQ(5u, sink.dropped());
+
+  p_stalled_sink->Release();
+  sink.Stop();
+
+  auto messages = p_stalled_sink->messages();
+  ASSERT_EQ(17u, messages.size());
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_EQ("async " + std::to_string(i), messages[i]);
+  }
+  ASSERT_NE(std::string::npos, messages.back().find("5 messages dropped"));
+}
+
+TEST(LogTests, AsyncLogBlockWaitsForTheFlusher) {
+  auto p_stalled_sink = std::make_shared<StalledSink>();
+  ssf::log::AsyncSink sink({p_stalled_sink}, "%v");
+  sink.Start(16, ssf::log::OverflowPolicy::kBlock);
+
+  Log(&sink, 0);
+  p_stalled_sink->WaitStalled();
+  for (int i = 1; i < 16; ++i) {
+    Log(&sink, i);
+  }
+
+  // The ring is full: the next message waits for the flusher
+  std::atomic<bool> logged(false);
+  std::thread blocked_thread([&sink, &logged]() {
+    Log(&sink, 16);
+    logged = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(logged);
+
+  p_stalled_sink->Release();
+  blocked_thread.join();
+  sink.Stop();
+
+  ASSERT_EQ(0u, sink.dropped());
+  auto messages = p_stalled_sink->messages();
+  ASSERT_EQ(17u, messages.size());
+  for (int i = 0; i < 17; ++i) {
+    ASSERT_EQ("async " + std::to_string(i), messages[i]);
+  }
+}
+
+TEST(LogTests, AsyncLogBlock) {
+  SetLogLevel(spdlog::level::info);
+  auto dropped = ssf::log::GetManager().dropped_messages();
+
+  SetAsyncLog(16, ssf::log::OverflowPolicy::kBlock);
+  for (int i = 0; i < 256; ++i) {
+    SSF_LOG("test", info, "async {}", i);
+  }
+  ssf::log::GetManager().SetSync();
+
+  ASSERT_EQ(dropped, ssf::log::GetManager().dropped_messages());
+}
+#endif  // SSF_DISABLE_LOGS
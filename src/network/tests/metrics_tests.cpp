@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ssf/metrics/metrics.h"
+
+namespace metrics = ssf::metrics;
+
+TEST(MetricsTests, CounterSumsTheThreadShards) {
+  metrics::Counter counter;
+  ASSERT_EQ(0, counter.value());
+
+  const int thread_count = 2 * metrics::kShards;
+  const int increments = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&counter, increments]() {
+      for (int j = 0; j < increments; ++j) {
+        counter.Increment();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(thread_count * increments, counter.value());
+
+  counter.Add(-10);
+  ASSERT_EQ(thread_count * increments - 10, counter.value());
+}
+
+TEST(MetricsTests, HistogramBuckets) {
+  ASSERT_EQ(0u, metrics::Histogram::Bucket(0));
+  ASSERT_EQ(1u, metrics::Histogram::Bucket(1));
+  ASSERT_EQ(2u, metrics::Histogram::Bucket(2));
+  ASSERT_EQ(2u, metrics::Histogram::Bucket(3));
+  ASSERT_EQ(3u, metrics::Histogram::Bucket(4));
+  ASSERT_EQ(10u, metrics::Histogram::Bucket(1023));
+  ASSERT_EQ(11u, metrics::Histogram::Bucket(1024));
+  ASSERT_EQ(64u, metrics::Histogram::Bucket(~uint64_t(0)));
+}
+
+TEST(MetricsTests, HistogramSnapshot) {
+  metrics::Histogram histogram;
+  auto empty = histogram.GetSnapshot();
+  ASSERT_EQ(0u, empty.count);
+  ASSERT_EQ(0u, empty.Percentile(0.5));
+
+  std::thread other_thread([&histogram]() { histogram.Record(1000); });
+  other_thread.join();
+  histogram.Record(1);
+  histogram.Record(5);
+
+  auto snapshot = histogram.GetSnapshot();
+  ASSERT_EQ(3u, snapshot.count);
+  ASSERT_EQ(1006u, snapshot.sum);
+  ASSERT_EQ(1000u, snapshot.max);
+  ASSERT_EQ(1u, snapshot.buckets[1]);
+  ASSERT_EQ(1u, snapshot.buckets[3]);
+  ASSERT_EQ(1u, snapshot.buckets[10]);
+}
+
+TEST(MetricsTests, PercentilesAreBucketUpperBounds) {
+  metrics::Histogram histogram;
+  // 90 samples of 10 (bucket 4, up to 15) and 10 samples of 100 (bucket 7, up
+  // to 127)
+  for (int i = 0; i < 90; ++i) {
+    histogram.Record(10);
+  }
+  for (int i = 0; i < 10; ++i) {
+    histogram.Record(100);
+  }
+
+  auto snapshot = histogram.GetSnapshot();
+  ASSERT_EQ(15u, snapshot.Percentile(0.0));
+  ASSERT_EQ(15u, snapshot.Percentile(0.5));
+  ASSERT_EQ(15u, snapshot.Percentile(0.89));
+  // the upper bound of the last bucket is capped by the max
+  ASSERT_EQ(100u, snapshot.Percentile(0.9));
+  ASSERT_EQ(100u, snapshot.Percentile(0.99));
+  ASSERT_EQ(100u, snapshot.Percentile(1.0));
+}
+
+TEST(MetricsTests, MacrosOnlyRecordWhenEnabled) {
+  auto& counter = metrics::GetRegistry().GetCounter("tests.macro_count");
+  auto& gauge = metrics::GetRegistry().GetGauge("tests.macro_gauge");
+  auto& histogram = metrics::GetRegistry().GetHistogram("tests.macro_record");
+
+  auto record = []() {
+    SSF_METRICS_COUNT("tests.macro_count", 2);
+    SSF_METRICS_GAUGE_ADD("tests.macro_gauge", -3);
+    SSF_METRICS_RECORD("tests.macro_record", 42);
+  };
+
+  metrics::Enable(false);
+  record();
+  ASSERT_EQ(0, counter.value());
+  ASSERT_EQ(0, gauge.value());
+  ASSERT_EQ(0u, histogram.GetSnapshot().count);
+
+  metrics::Enable();
+  record();
+  record();
+  metrics::Enable(false);
+  record();
+  ASSERT_EQ(4, counter.value());
+  ASSERT_EQ(-6, gauge.value());
+  ASSERT_EQ(2u, histogram.GetSnapshot().count);
+  ASSERT_EQ(42u, histogram.GetSnapshot().max);
+}
+
+TEST(MetricsTests, RegistryJsonIsFilteredByPrefix) {
+  auto& registry = metrics::GetRegistry();
+  registry.GetCounter("json.a.count").Add(7);
+  registry.GetGauge("json.a.level").Add(3);
+  registry.GetHistogram("json.a.\"quoted\"").Record(2);
+  registry.GetCounter("json.b.count").Add(1);
+
+  auto json = registry.ToJson("json.a.");
+  ASSERT_EQ(0u, json.find("{\"time\": "));
+  ASSERT_NE(std::string::npos,
+            json.find("\"counters\": {\"json.a.count\": 7}"));
+  ASSERT_NE(std::string::npos, json.find("\"gauges\": {\"json.a.level\": 3}"));
+  ASSERT_NE(std::string::npos,
+            json.find("\"json.a.\\\"quoted\\\"\": {\"count\": 1, \"sum\": 2, "
+                      "\"max\": 2, \"p50\": 2, \"p90\": 2, \"p99\": 2}"));
+  ASSERT_EQ(std::string::npos, json.find("json.b."));
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include "ssf/network/splice_link.h"
+
+#if defined(SSF_SPLICE_LINK)
+
+class SpliceLinkTest : public ::testing::Test {
+ protected:
+  using Tcp = boost::asio::ip::tcp;
+
+  SpliceLinkTest()
+      : io_service_(),
+        input_(io_service_),
+        link_in_(io_service_),
+        link_out_(io_service_),
+        output_(io_service_),
+        link_ended_(false),
+        link_ec_() {}
+
+  // input -> link_in ==splice==> link_out -> output
+  void SetUp() override {
+    Tcp::acceptor acceptor(
+        io_service_, Tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    input_.connect(acceptor.local_endpoint());
+    acceptor.accept(link_in_);
+    output_.connect(acceptor.local_endpoint());
+    acceptor.accept(link_out_);
+
+    ASSERT_TRUE(ssf::detail::AsyncEstablishSpliceLink(
+        link_in_, link_out_,
+        [this](const boost::system::error_code& ec, std::size_t) {
+          link_ended_ = true;
+          link_ec_ = ec;
+        }));
+  }
+
+ protected:
+  boost::asio::io_service io_service_;
+  Tcp::socket input_;
+  Tcp::socket link_in_;
+  Tcp::socket link_out_;
+  Tcp::socket output_;
+  std::atomic<bool> link_ended_;
+  boost::system::error_code link_ec_;
+};
+
+TEST_F(SpliceLinkTest, ForwardsUntilEof) {
+  auto& pool = ssf::detail::SplicePipePool::Get();
+
+  // Nothing received yet: the link does not hold a pipe
+  {
+    boost::system::error_code ec;
+    auto p_pipe = pool.Acquire(ec);
+    ASSERT_FALSE(ec) << ec.message();
+  }
+  auto idle_pipes = pool.idle_count();
+  ASSERT_LE(1u, idle_pipes);
+  io_service_.poll();
+  ASSERT_FALSE(link_ended_);
+  ASSERT_EQ(idle_pipes, pool.idle_count());
+
+  // Larger than a pipe: the link waits for the output several times
+  std::vector<char> sent(4 * 1024 * 1024);
+  for (std::size_t i = 0; i < sent.size(); ++i) {
+    sent[i] = static_cast<char>(i * 7);
+  }
+  std::thread writer([this, &sent]() {
+    boost::system::error_code ec;
+    boost::asio::write(input_, boost::asio::buffer(sent), ec);
+    input_.shutdown(Tcp::socket::shutdown_send, ec);
+  });
+  std::vector<char> received(sent.size());
+  boost::system::error_code read_ec;
+  std::thread reader([this, &received, &read_ec]() {
+    boost::asio::read(output_, boost::asio::buffer(received), read_ec);
+  });
+
+  io_service_.run();
+  writer.join();
+  reader.join();
+
+  ASSERT_FALSE(read_ec) << read_ec.message();
+  ASSERT_EQ(sent, received);
+  ASSERT_TRUE(link_ended_);
+  ASSERT_EQ(boost::asio::error::eof, link_ec_);
+
+  // The empty pipe went back to the pool
+  ASSERT_EQ(idle_pipes, pool.idle_count());
+}
+
+TEST_F(SpliceLinkTest, OutputErrorEndsTheLink) {
+  // The peer of the output is gone: sending fails (without SIGPIPE)
+  boost::system::error_code ec;
+  output_.close(ec);
+
+  std::string data(1024, 'x');
+  std::thread writer([this, &data]() {
+    boost::system::error_code write_ec;
+    for (int i = 0; i < 1024 && !link_ended_; ++i) {
+      boost::asio::write(input_, boost::asio::buffer(data), write_ec);
+      if (write_ec) {
+        break;
+      }
+    }
+  });
+
+  while (!link_ended_ && io_service_.run_one()) {
+  }
+  input_.close(ec);
+  writer.join();
+
+  ASSERT_TRUE(link_ended_);
+  ASSERT_TRUE(!!link_ec_);
+  ASSERT_NE(boost::asio::error::eof, link_ec_) << link_ec_.message();
+}
+
+#endif  // defined(SSF_SPLICE_LINK)
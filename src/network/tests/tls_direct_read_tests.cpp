@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
+
+#include "tests/virtual_network_helpers.h"
+
+#include "ssf/layer/cryptography/tls/OpenSSL/helpers.h"
+#include "ssf/layer/cryptography/tls/OpenSSL/impl.h"
+#include "ssf/metrics/metrics.h"
+
+namespace detail = ssf::layer::cryptography::detail;
+
+class TLSDirectReadTest : public ::testing::Test {
+ protected:
+  using Tcp = boost::asio::ip::tcp;
+  using TLSStream = boost::asio::ssl::stream<Tcp::socket>;
+  using Bufferer = detail::TLSStreamBufferer<Tcp::socket>;
+  using Strand = boost::asio::io_service::strand;
+
+  TLSDirectReadTest()
+      : io_service_(),
+        p_work_(new boost::asio::io_service::work(io_service_)),
+        server_context_(detail::make_tls_context(
+            io_service_,
+            tests::virtual_network_helpers::GetServerTLSParametersAsBuffer())),
+        client_context_(detail::make_tls_context(
+            io_service_,
+            tests::virtual_network_helpers::GetClientTLSParametersAsBuffer())),
+        server_(io_service_, *server_context_),
+        p_client_(std::make_shared<TLSStream>(io_service_, *client_context_)),
+        p_strand_(std::make_shared<Strand>(io_service_)),
+        direct_reads_(
+            ssf::metrics::GetRegistry().GetCounter("tls.direct_reads")),
+        buffered_reads_(
+            ssf::metrics::GetRegistry().GetCounter("tls.buffered_reads")) {
+    // the reads are told apart by the metrics of the TLS layer
+    ssf::metrics::Enable();
+  }
+
+  void SetUp() override {
+    Tcp::acceptor acceptor(
+        io_service_, Tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    p_client_->next_layer().connect(acceptor.local_endpoint());
+    acceptor.accept(server_.next_layer());
+
+    boost::system::error_code server_ec;
+    std::thread server_handshake([this, &server_ec]() {
+      server_.handshake(boost::asio::ssl::stream_base::server, server_ec);
+    });
+    boost::system::error_code client_ec;
+    p_client_->handshake(boost::asio::ssl::stream_base::client, client_ec);
+    server_handshake.join();
+    ASSERT_FALSE(server_ec) << server_ec.message();
+    ASSERT_FALSE(client_ec) << client_ec.message();
+
+    io_thread_ = std::thread([this]() { io_service_.run(); });
+  }
+
+  void TearDown() override {
+    if (p_bufferer_) {
+      boost::system::error_code ec;
+      p_bufferer_->cancel(ec);
+    }
+    p_work_.reset();
+    boost::system::error_code ec;
+    p_client_->next_layer().close(ec);
+    server_.next_layer().close(ec);
+    if (io_thread_.joinable()) {
+      io_thread_.join();
+    }
+  }
+
+  void CreateBufferer(bool direct_read) {
+    detail::TLSBufferingSettings settings;
+    settings.direct_read = direct_read;
+    settings.direct_read_threshold = 4096;
+    p_bufferer_ = Bufferer::create(p_client_, p_strand_, settings);
+  }
+
+  void Send(const std::string& data) {
+    boost::system::error_code ec;
+    boost::asio::write(server_, boost::asio::buffer(data), ec);
+    ASSERT_FALSE(ec) << ec.message();
+  }
+
+  // Read once into a buffer of the given size
+  std::string Read(std::size_t size) {
+    std::string buffer(size, '\0');
+    std::promise<std::size_t> read;
+    p_bufferer_->async_read_some(
+        boost::asio::buffer(&buffer[0], buffer.size()),
+        [&read](const boost::system::error_code& ec, std::size_t length) {
+          read.set_value(ec ? 0 : length);
+        });
+    buffer.resize(read.get_future().get());
+    return buffer;
+  }
+
+ protected:
+  boost::asio::io_service io_service_;
+  std::unique_ptr<boost::asio::io_service::work> p_work_;
+  detail::ExtendedTLSContext server_context_;
+  detail::ExtendedTLSContext client_context_;
+  TLSStream server_;
+  std::shared_ptr<TLSStream> p_client_;
+  std::shared_ptr<Strand> p_strand_;
+  Bufferer::p_puller_type p_bufferer_;
+  std::thread io_thread_;
+  ssf::metrics::Counter& direct_reads_;
+  ssf::metrics::Counter& buffered_reads_;
+};
+
+TEST_F(TLSDirectReadTest, LargeReadReceivesDirectly) {
+  CreateBufferer(true);
+  auto direct_reads = direct_reads_.value();
+  auto buffered_reads = buffered_reads_.value();
+
+  // The read is pending before the data arrives
+  std::thread sender([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    Send("direct");
+  });
+  auto received = Read(64 * 1024);
+  sender.join();
+
+  ASSERT_EQ("direct", received);
+  ASSERT_EQ(direct_reads + 1, direct_reads_.value());
+  ASSERT_EQ(buffered_reads, buffered_reads_.value());
+}
+
+TEST_F(TLSDirectReadTest, SmallReadIsBuffered) {
+  CreateBufferer(true);
+  auto direct_reads = direct_reads_.value();
+
+  Send("buffered");
+  auto received = Read(4);
+  received += Read(1024);
+
+  ASSERT_EQ("buffered", received);
+  ASSERT_EQ(direct_reads, direct_reads_.value());
+}
+
+TEST_F(TLSDirectReadTest, DataWithoutPendingReadIsBuffered) {
+  CreateBufferer(true);
+  auto buffered_reads = buffered_reads_.value();
+
+  // Nothing reads: the puller keeps receiving into its queue
+  p_bufferer_->start_pulling();
+  Send("queued");
+  for (int i = 0; i < 100 && buffered_reads_.value() == buffered_reads; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_LT(buffered_reads, buffered_reads_.value());
+
+  auto direct_reads = direct_reads_.value();
+  ASSERT_EQ("queued", Read(64 * 1024));
+  ASSERT_EQ(direct_reads, direct_reads_.value());
+}
+
+TEST_F(TLSDirectReadTest, DisabledDirectReadBuffersEverything) {
+  CreateBufferer(false);
+  auto direct_reads = direct_reads_.value();
+
+  std::thread sender([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    Send("buffered");
+  });
+  auto received = Read(64 * 1024);
+  sender.join();
+
+  ASSERT_EQ("buffered", received);
+  ASSERT_EQ(direct_reads, direct_reads_.value());
+}
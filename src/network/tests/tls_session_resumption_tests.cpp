@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/write.hpp>
+
+#include <openssl/ssl.h>
+
+#include "tests/virtual_network_helpers.h"
+
+#include "ssf/layer/cryptography/tls/OpenSSL/helpers.h"
+
+namespace detail = ssf::layer::cryptography::detail;
+
+class TLSSessionResumptionTest : public ::testing::Test {
+ protected:
+  using Tcp = boost::asio::ip::tcp;
+  using TLSStream = boost::asio::ssl::stream<Tcp::socket>;
+
+  TLSSessionResumptionTest()
+      : io_service_(),
+        server_parameters_(
+            tests::virtual_network_helpers::GetServerTLSParametersAsBuffer()),
+        client_parameters_(
+            tests::virtual_network_helpers::GetClientTLSParametersAsBuffer()),
+        acceptor_(io_service_,
+                  Tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+    server_parameters_["session_resumption"] = "true";
+    client_parameters_["session_resumption"] = "true";
+  }
+
+  // Connect a client endpoint to the given peer, exchange one byte (the
+  // TLS 1.3 tickets follow the handshake) and return whether the session was
+  // resumed
+  bool Connect(const std::string& peer) {
+    auto server_context =
+        detail::make_tls_context(io_service_, server_parameters_);
+    auto client_context =
+        detail::make_tls_context(io_service_, client_parameters_, peer);
+    EXPECT_TRUE(!!server_context.p_session_resumption_);
+    EXPECT_TRUE(!!client_context.p_session_resumption_);
+
+    TLSStream server(io_service_, *server_context);
+    TLSStream client(io_service_, *client_context);
+    client.next_layer().connect(acceptor_.local_endpoint());
+    acceptor_.accept(server.next_layer());
+
+    boost::system::error_code server_ec;
+    std::thread server_side([&server, &server_ec]() {
+      server.handshake(boost::asio::ssl::stream_base::server, server_ec);
+      if (!server_ec) {
+        boost::asio::write(server, boost::asio::buffer("s", 1), server_ec);
+      }
+    });
+    client_context.ResumeSession(client.native_handle());
+    boost::system::error_code client_ec;
+    client.handshake(boost::asio::ssl::stream_base::client, client_ec);
+    char byte = 0;
+    if (!client_ec) {
+      boost::asio::read(client, boost::asio::buffer(&byte, 1), client_ec);
+    }
+    server_side.join();
+    EXPECT_FALSE(server_ec) << server_ec.message();
+    EXPECT_FALSE(client_ec) << client_ec.message();
+    EXPECT_EQ('s', byte);
+
+    return SSL_session_reused(client.native_handle()) == 1;
+  }
+
+ protected:
+  boost::asio::io_service io_service_;
+  ssf::layer::LayerParameters server_parameters_;
+  ssf::layer::LayerParameters client_parameters_;
+  Tcp::acceptor acceptor_;
+};
+
+TEST_F(TLSSessionResumptionTest, SecondConnectResumesTheSession) {
+  ASSERT_FALSE(Connect("peer-a"));
+  ASSERT_TRUE(Connect("peer-a"));
+}
+
+TEST_F(TLSSessionResumptionTest, SessionIsOnlyOfferedToItsPeer) {
+  ASSERT_FALSE(Connect("peer-b"));
+  // Another hop sharing the same TLS parameters starts a full handshake
+  ASSERT_FALSE(Connect("peer-c"));
+  ASSERT_TRUE(Connect("peer-b"));
+  ASSERT_TRUE(Connect("peer-c"));
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include "ssf/network/udp_batch.h"
+
+#if defined(SSF_UDP_BATCH)
+
+class UdpBatchTest : public ::testing::Test {
+ protected:
+  using Udp = boost::asio::ip::udp;
+
+  UdpBatchTest()
+      : io_service_(),
+        sender_(io_service_, Udp::endpoint(Udp::v4(), 0)),
+        receiver_(io_service_,
+                  Udp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+  }
+
+  // Send the datagrams in batches then read them back
+  std::vector<std::string> Transfer(const std::vector<std::string>& datagrams) {
+    std::vector<boost::asio::const_buffer> buffers;
+    for (const auto& datagram : datagrams) {
+      buffers.push_back(boost::asio::buffer(datagram));
+    }
+
+    ssf::UdpSendBatch send_batch(4);
+    boost::system::error_code ec;
+    std::size_t sent = 0;
+    while (sent < buffers.size()) {
+      std::vector<boost::asio::const_buffer> pending(buffers.begin() + sent,
+                                                     buffers.end());
+      sent += send_batch.Send(sender_.native_handle(),
+                              receiver_.local_endpoint(), pending, ec);
+      EXPECT_FALSE(ec) << ec.message();
+      if (ec) {
+        break;
+      }
+    }
+
+    std::vector<std::string> received;
+    ssf::UdpReceiveBatch receive_batch(4);
+    while (received.size() < datagrams.size()) {
+      receiver_.receive(boost::asio::null_buffers(), 0, ec);
+      receive_batch.Receive(receiver_.native_handle(), ec);
+      if (ec == boost::asio::error::would_block) {
+        continue;
+      }
+      EXPECT_FALSE(ec) << ec.message();
+      if (ec) {
+        break;
+      }
+      for (std::size_t i = 0; i < receive_batch.size(); ++i) {
+        auto datagram = receive_batch.datagram(i);
+        received.emplace_back(
+            boost::asio::buffer_cast<const char*>(datagram),
+            boost::asio::buffer_size(datagram));
+        EXPECT_EQ(receive_batch.sender(i).port(),
+                  sender_.local_endpoint().port());
+      }
+      receive_batch.Clear();
+    }
+
+    return received;
+  }
+
+ protected:
+  boost::asio::io_service io_service_;
+  Udp::socket sender_;
+  Udp::socket receiver_;
+};
+
+TEST_F(UdpBatchTest, TransferDatagrams) {
+  std::vector<std::string> datagrams;
+  for (std::size_t i = 0; i < 10; ++i) {
+    datagrams.emplace_back(10 + i * 100, static_cast<char>('a' + i));
+  }
+
+  ASSERT_EQ(Transfer(datagrams), datagrams);
+}
+
+TEST_F(UdpBatchTest, TransferSegmentedDatagrams) {
+  ssf::UdpReceiveBatch::EnableReceiveOffload(receiver_.native_handle());
+
+  // Runs of datagrams of the same size are sent as single messages
+  std::vector<std::string> datagrams;
+  for (std::size_t i = 0; i < 9; ++i) {
+    datagrams.emplace_back(1000, static_cast<char>('a' + i));
+  }
+  datagrams.emplace_back(400, 'z');
+  datagrams.emplace_back(1000, 'y');
+
+  ASSERT_EQ(Transfer(datagrams), datagrams);
+}
+
+TEST_F(UdpBatchTest, CopyOutDatagrams) {
+  std::vector<std::string> datagrams = {"first", "", "third datagram"};
+  for (const auto& datagram : datagrams) {
+    sender_.send_to(boost::asio::buffer(datagram), receiver_.local_endpoint());
+  }
+
+  auto& receive_batch = ssf::UdpReceiveBatch::ForThread();
+  ssf::BufferPool::Buffer buffer;
+  std::vector<boost::asio::const_buffer> copied;
+  boost::system::error_code ec;
+  std::vector<std::string> received;
+  while (received.size() < datagrams.size()) {
+    receiver_.receive(boost::asio::null_buffers(), 0, ec);
+    receive_batch.Receive(receiver_.native_handle(), ec);
+    if (ec == boost::asio::error::would_block) {
+      continue;
+    }
+    ASSERT_FALSE(ec) << ec.message();
+
+    // The copies outlive the next Receive on the shared batch
+    receive_batch.CopyOut(&buffer, &copied);
+    ASSERT_EQ(copied.size(), receive_batch.size());
+    ASSERT_GE(buffer.size(), 5u);
+    ASSERT_LT(buffer.size(), ssf::UdpReceiveBatch::kSlotSize);
+    for (const auto& datagram : copied) {
+      received.emplace_back(boost::asio::buffer_cast<const char*>(datagram),
+                            boost::asio::buffer_size(datagram));
+    }
+    buffer.Reset();
+  }
+
+  ASSERT_EQ(received, datagrams);
+}
+
+TEST_F(UdpBatchTest, TransferSegmentedDatagramsV6) {
+  boost::system::error_code ec;
+  Udp::socket sender(io_service_);
+  Udp::socket receiver(io_service_);
+  sender.open(Udp::v6(), ec);
+  if (!ec) {
+    receiver.open(Udp::v6(), ec);
+  }
+  if (!ec) {
+    receiver.bind(Udp::endpoint(boost::asio::ip::address_v6::loopback(), 0),
+                  ec);
+  }
+  if (ec) {
+    GTEST_SKIP() << "IPv6 loopback not available";
+  }
+  ssf::UdpReceiveBatch::EnableReceiveOffload(receiver.native_handle());
+
+  // Segments of the largest IPv6 size are accepted by the kernel
+  std::vector<std::string> datagrams(8, std::string(1452, 'v'));
+  std::vector<boost::asio::const_buffer> buffers;
+  for (const auto& datagram : datagrams) {
+    buffers.push_back(boost::asio::buffer(datagram));
+  }
+
+  ssf::UdpSendBatch send_batch;
+  ASSERT_EQ(send_batch.Send(sender.native_handle(), receiver.local_endpoint(),
+                            buffers, ec),
+            datagrams.size());
+  ASSERT_FALSE(ec) << ec.message();
+
+  ssf::UdpReceiveBatch receive_batch;
+  std::size_t received = 0;
+  while (received < datagrams.size()) {
+    receiver.receive(boost::asio::null_buffers(), 0, ec);
+    receive_batch.Receive(receiver.native_handle(), ec);
+    if (ec == boost::asio::error::would_block) {
+      continue;
+    }
+    ASSERT_FALSE(ec) << ec.message();
+    for (std::size_t i = 0; i < receive_batch.size(); ++i) {
+      ASSERT_EQ(boost::asio::buffer_size(receive_batch.datagram(i)), 1452u);
+    }
+    received += receive_batch.size();
+    receive_batch.Clear();
+  }
+}
+
+TEST_F(UdpBatchTest, NoPendingDatagram) {
+  ssf::UdpReceiveBatch receive_batch;
+  boost::system::error_code ec;
+
+  ASSERT_EQ(receive_batch.Receive(receiver_.native_handle(), ec), 0u);
+  ASSERT_EQ(ec, boost::asio::error::would_block);
+}
+
+#endif  // defined(SSF_UDP_BATCH)
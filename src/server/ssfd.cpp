@@ -1,3 +1,4 @@
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 
@@ -6,6 +7,8 @@
 #include <boost/system/error_code.hpp>
 
 #include <ssf/log/log.h>
+#include <ssf/metrics/exporter.h>
+#include <ssf/metrics/metrics.h>
 
 #include "common/config/config.h"
 
@@ -68,15 +71,40 @@ void Run(int argc, char** argv, boost::system::error_code& exit_ec) {
     }
   }
 
+  if (ssf_config.logging().async()) {
+    SetAsyncLog(ssf_config.logging().queue_size(),
+                ssf_config.logging().overflow_policy());
+  }
+
   ssf_config.Log();
   if (cmd.show_status()) {
     ssf_config.LogStatus();
   }
 
+  // served metrics are recorded even when they are not exported
+  if (ssf_config.metrics().enabled() || ssf_config.metrics().serve()) {
+    ssf::metrics::Enable();
+  }
+
+  ssf::metrics::Exporter metrics_exporter;
+  if (ssf_config.metrics().enabled()) {
+    boost::system::error_code metrics_ec;
+    metrics_exporter.Start(ssf_config.metrics().file(),
+                           std::chrono::seconds(ssf_config.metrics().period()),
+                           metrics_ec);
+    if (metrics_ec) {
+      SSF_LOG("ssfd", warn, "cannot export metrics to <{}>",
+              ssf_config.metrics().file());
+    }
+  }
+
   ssf_config.services().SetGatewayPorts(cmd.gateway_ports());
 
   // initialize and run the server
-  Server server(ssf_config.services(), cmd.relay_only());
+  Server server(ssf_config.services(), cmd.relay_only(),
+                cmd.io_per_core() ? ssf::AsyncEngine::Mode::kPerCore
+                                  : ssf::AsyncEngine::Mode::kShared,
+                ssf_config.metrics().serve());
 
   // construct endpoint parameter stack
   auto endpoint_query = NetworkProtocol::GenerateServerQuery(
@@ -24,6 +24,8 @@
 #include "services/admin/admin_command.h"
 #include "services/admin/command_factory.h"
 #include "services/admin/requests/create_service_request.h"
+#include "services/admin/requests/stats_reply.h"
+#include "services/admin/requests/stats_request.h"
 #include "services/admin/requests/stop_service_request.h"
 
 #include "core/factories/service_factory.h"
@@ -44,6 +46,9 @@ class Admin : public BaseService<Demux> {
       std::function<void(BaseUserServicePtr, const boost::system::error_code&)>;
   using OnInitialization =
       std::function<void(const boost::system::error_code&)>;
+  // Receive the result of a command replied by the remote end
+  using ResultHandler = std::function<void(const boost::system::error_code&,
+                                           const std::string&)>;
 
  private:
   using LocalPortType = typename Demux::local_port_type;
@@ -58,6 +63,12 @@ class Admin : public BaseService<Demux> {
 
   using CommandHandler = std::function<void(const boost::system::error_code&)>;
   using IdToCommandHandlerMap = std::map<uint32_t, CommandHandler>;
+  // Result handler of a command, completed by the reply command expected
+  struct PendingResult {
+    uint32_t reply_id;
+    ResultHandler handler;
+  };
+  using IdToResultHandlerMap = std::map<uint32_t, PendingResult>;
 
  public:
   static AdminPtr Create(boost::asio::io_service& io_service,
@@ -110,6 +121,19 @@ class Admin : public BaseService<Demux> {
     AsyncSendCommand(*p_command, do_handler);
   }
 
+  /// Send a command whose reply carries a result (e.g. StatsRequest)
+  /**
+  * The handler receives the result of the reply command, or an error if the
+  * command could not be sent or the admin service stopped first.
+  */
+  template <typename Request>
+  void CommandWithResult(Request request, ResultHandler handler);
+
+  /// Ask the remote end for its metrics (JSON line, see StatsRequest)
+  void GetRemoteStats(const std::string& prefix, ResultHandler handler) {
+    CommandWithResult(admin::StatsRequest<Demux>(prefix), std::move(handler));
+  }
+
   void InsertHandler(uint32_t serial, CommandHandler command_handler) {
     std::unique_lock<std::recursive_mutex> lock1(command_handlers_mutex_);
     command_handlers_[serial] = command_handler;
@@ -162,6 +186,10 @@ class Admin : public BaseService<Demux> {
 
   void HandleStop();
 
+  void ExecuteAndRemoveResultHandler(uint32_t serial, uint32_t reply_id,
+                                     const boost::system::error_code& ec,
+                                     const std::string& result);
+
   void Initialize();
   void StartRemoteService(
       const admin::CreateServiceRequest<Demux>& create_request,
@@ -174,6 +202,8 @@ class Admin : public BaseService<Demux> {
       const boost::system::error_code& ec = boost::system::error_code(),
       size_t length = 0);
   void PostKeepAlive(const boost::system::error_code& ec, size_t length);
+  // Close the demux when the admin fiber fails while the service runs
+  void OnAdminFiberError(const boost::system::error_code& ec);
   void OnSendKeepAlive(const boost::system::error_code& ec);
   void ReceiveInstructionHeader();
   void ReceiveInstructionParameters();
@@ -256,6 +286,7 @@ class Admin : public BaseService<Demux> {
 
   std::recursive_mutex command_handlers_mutex_;
   IdToCommandHandlerMap command_handlers_;
+  IdToResultHandlerMap result_handlers_;
 
   OnUserService on_user_service_;
   OnInitialization on_initialization_;
@@ -264,6 +264,7 @@ void Admin<Demux>::ListenForCommand() {
 template <typename Demux>
 void Admin<Demux>::DoAdmin(const boost::system::error_code& ec, size_t length) {
   if (ec) {
+    OnAdminFiberError(ec);
     return;
   }
 
@@ -348,6 +349,13 @@ void Admin<Demux>::ProcessInstructionId() {
     boost::system::error_code ec;
     std::string serialized_result = (*p_executer)(serialized, &d, ec);
 
+    // Hand the result of a reply to its command (e.g, remote stats). The
+    // serial of a command received from the remote end may match a local
+    // pending command: only its reply completes it.
+    this->ExecuteAndRemoveResultHandler(command_serial_received_,
+                                        command_id_received_, ec,
+                                        serialized_result);
+
     // Get the right function to reply
     auto p_replier = cmd_factory_.GetReplier(command_id_received_);
 
@@ -390,6 +398,72 @@ void Admin<Demux>::StopRemoteService(
   this->Command(stop_request, handler);
 }
 
+template <typename Demux>
+template <typename Request>
+void Admin<Demux>::CommandWithResult(Request request, ResultHandler handler) {
+  auto self = this->shared_from_this();
+  {
+    std::unique_lock<std::recursive_mutex> lock(stopping_mutex_);
+    if (stopped_) {
+      this->get_io_service().post([handler]() {
+        handler({::error::operation_canceled, ::error::get_ssf_category()},
+                {});
+      });
+      return;
+    }
+  }
+
+  std::string parameters_buff_to_send = request.OnSending();
+
+  auto serial = GetAvailableSerial();
+  if (!serial) {
+    this->get_io_service().post([handler]() {
+      handler({::error::device_or_resource_busy, ::error::get_ssf_category()},
+              {});
+    });
+    return;
+  }
+
+  {
+    std::unique_lock<std::recursive_mutex> lock(command_handlers_mutex_);
+    result_handlers_[serial] = {Request::reply_id, std::move(handler)};
+  }
+
+  auto p_command = std::make_shared<AdminCommand>(
+      serial, request.command_id, (uint32_t)parameters_buff_to_send.size(),
+      parameters_buff_to_send);
+
+  auto on_command_sent = [this, self, serial, p_command](
+      const boost::system::error_code& ec, size_t length) {
+    if (ec) {
+      EraseHandler(serial);
+      ExecuteAndRemoveResultHandler(serial, Request::reply_id, ec, {});
+    }
+  };
+
+  AsyncSendCommand(*p_command, on_command_sent);
+}
+
+template <typename Demux>
+void Admin<Demux>::ExecuteAndRemoveResultHandler(
+    uint32_t serial, uint32_t reply_id, const boost::system::error_code& ec,
+    const std::string& result) {
+  ResultHandler result_handler;
+  {
+    std::unique_lock<std::recursive_mutex> lock(command_handlers_mutex_);
+    auto it = result_handlers_.find(serial);
+    if (it == result_handlers_.end() || it->second.reply_id != reply_id) {
+      return;
+    }
+    result_handler = std::move(it->second.handler);
+    result_handlers_.erase(it);
+  }
+
+  auto self = this->shared_from_this();
+  this->get_io_service().post(
+      [self, result_handler, ec, result]() { result_handler(ec, result); });
+}
+
 template <typename Demux>
 void Admin<Demux>::OnSendKeepAlive(const boost::system::error_code& ec) {
   if (ec) {
@@ -419,6 +493,7 @@ void Admin<Demux>::PostKeepAlive(const boost::system::error_code& ec,
                                  size_t length) {
   auto self = this->shared_from_this();
   if (ec) {
+    OnAdminFiberError(ec);
     return;
   }
 
@@ -430,6 +505,22 @@ void Admin<Demux>::PostKeepAlive(const boost::system::error_code& ec,
   reserved_keep_alive_timer_.async_wait(on_timeout);
 }
 
+template <typename Demux>
+void Admin<Demux>::OnAdminFiberError(const boost::system::error_code& ec) {
+  {
+    std::unique_lock<std::recursive_mutex> lock(stopping_mutex_);
+    if (stopped_) {
+      return;
+    }
+  }
+
+  // The admin fiber is reset when its link fails: without it, the session
+  // has no keep alive and no command channel
+  SSF_LOG("microservice", warn, "[admin] admin fiber lost: {} ({})",
+          ec.message(), ec.value());
+  this->get_demux().close();
+}
+
 template <typename Demux>
 void Admin<Demux>::HandleStop() {
   std::unique_lock<std::recursive_mutex> lock(stopping_mutex_);
@@ -446,6 +537,19 @@ void Admin<Demux>::HandleStop() {
   on_user_service_ = [](BaseUserServicePtr, const boost::system::error_code&) {
   };
   on_initialization_ = [](const boost::system::error_code&) {};
+
+  // The replies will not come
+  IdToResultHandlerMap result_handlers;
+  {
+    std::unique_lock<std::recursive_mutex> lock(command_handlers_mutex_);
+    result_handlers.swap(result_handlers_);
+  }
+  for (auto& result_handler : result_handlers) {
+    auto handler = std::move(result_handler.second.handler);
+    this->get_io_service().post([handler]() {
+      handler({::error::operation_canceled, ::error::get_ssf_category()}, {});
+    });
+  }
 }
 
 }  // admin
@@ -0,0 +1,108 @@
+#ifndef SSF_SERVICES_ADMIN_REQUESTS_STATS_REPLY_H_
+#define SSF_SERVICES_ADMIN_REQUESTS_STATS_REPLY_H_
+
+#include <cstdint>
+
+#include <sstream>
+#include <string>
+
+#include <boost/system/error_code.hpp>
+
+#include <msgpack.hpp>
+
+#include <ssf/log/log.h>
+
+#include "common/error/error.h"
+
+#include "services/admin/command_factory.h"
+
+namespace ssf {
+namespace services {
+namespace admin {
+
+/// Metrics of the remote end, in reply to a StatsRequest
+/**
+* On reception, the metrics JSON line is the result of the command: the
+* admin service hands it to the handler of the request (see
+* Admin::GetRemoteStats).
+*/
+template <typename Demux>
+class StatsReply {
+ public:
+  StatsReply() : error_code_value_(0), metrics_() {}
+
+  StatsReply(uint32_t error_code_value, const std::string& metrics)
+      : error_code_value_(error_code_value), metrics_(metrics) {}
+
+  enum { command_id = 5, reply_id = 5 };
+
+  static bool RegisterOnReceiveCommand(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterOnReceiveCommand(command_id,
+                                                 &StatsReply::OnReceive);
+  }
+
+  static bool RegisterOnReplyCommand(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterOnReplyCommand(command_id,
+                                               &StatsReply::OnReply);
+  }
+
+  static bool RegisterReplyCommandIndex(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterReplyCommandIndex(command_id, reply_id);
+  }
+
+  static std::string OnReceive(const std::string& serialized_reply,
+                               Demux* p_demux, boost::system::error_code& ec) {
+    StatsReply<Demux> reply;
+
+    try {
+      auto obj_handle =
+          msgpack::unpack(serialized_reply.data(), serialized_reply.size());
+      auto obj = obj_handle.get();
+      obj.convert(reply);
+    } catch (const std::exception&) {
+      SSF_LOG("microservice", warn,
+              "[admin] stats reply[on receive]: cannot extract reply");
+      ec.assign(::error::invalid_argument, ::error::get_ssf_category());
+      return {};
+    }
+
+    if (reply.error_code_value()) {
+      ec.assign(reply.error_code_value(), ::error::get_ssf_category());
+      return {};
+    }
+
+    return reply.metrics();
+  }
+
+  static std::string OnReply(const std::string& serialized_reply,
+                             Demux* p_demux,
+                             const boost::system::error_code& ec,
+                             const std::string& serialized_result) {
+    // Nothing to send back
+    return {};
+  }
+
+  std::string OnSending() const {
+    std::ostringstream ostrs;
+    msgpack::pack(ostrs, *this);
+    return ostrs.str();
+  }
+
+  uint32_t error_code_value() const { return error_code_value_; }
+
+  const std::string& metrics() const { return metrics_; }
+
+ public:
+  // add msgpack function definitions
+  MSGPACK_DEFINE(error_code_value_, metrics_)
+
+ private:
+  uint32_t error_code_value_;
+  std::string metrics_;
+};
+
+}  // admin
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_ADMIN_REQUESTS_STATS_REPLY_H_
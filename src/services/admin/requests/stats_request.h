@@ -0,0 +1,144 @@
+#ifndef SSF_SERVICES_ADMIN_REQUESTS_STATS_REQUEST_H_
+#define SSF_SERVICES_ADMIN_REQUESTS_STATS_REQUEST_H_
+
+#include <sstream>
+#include <string>
+
+#include <boost/system/error_code.hpp>
+
+#include <msgpack.hpp>
+
+#include <ssf/log/log.h>
+#include <ssf/metrics/metrics.h>
+
+#include "common/error/error.h"
+
+#include "services/admin/command_factory.h"
+#include "services/admin/requests/stats_reply.h"
+
+namespace ssf {
+namespace services {
+namespace admin {
+
+/// Ask the remote end for its current metrics
+/**
+* The remote end replies with a StatsReply holding the JSON line of its
+* metrics registry (see ssf::metrics::Registry::ToJson), restricted to the
+* metrics whose name starts with the requested prefix.
+*/
+template <typename Demux>
+class StatsRequest {
+ public:
+  StatsRequest() : prefix_() {}
+
+  explicit StatsRequest(const std::string& prefix) : prefix_(prefix) {}
+
+  enum { command_id = 4, reply_id = 5 };
+
+  static bool RegisterOnReceiveCommand(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterOnReceiveCommand(command_id,
+                                                 &StatsRequest::OnReceive);
+  }
+
+  static bool RegisterOnReplyCommand(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterOnReplyCommand(command_id,
+                                               &StatsRequest::OnReply);
+  }
+
+  static bool RegisterReplyCommandIndex(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterReplyCommandIndex(command_id, reply_id);
+  }
+
+  static std::string OnReceive(const std::string& serialized_request,
+                               Demux* p_demux, boost::system::error_code& ec) {
+    StatsRequest<Demux> request;
+
+    try {
+      auto obj_handle =
+          msgpack::unpack(serialized_request.data(), serialized_request.size());
+      auto obj = obj_handle.get();
+      obj.convert(request);
+    } catch (const std::exception&) {
+      SSF_LOG("microservice", warn,
+              "[admin] stats request[on receive]: cannot extract request");
+      ec.assign(::error::invalid_argument, ::error::get_ssf_category());
+      return {};
+    }
+
+    SSF_LOG("microservice", debug, "[admin] stats request: prefix <{}>",
+            request.prefix());
+
+    return ssf::metrics::GetRegistry().ToJson(request.prefix());
+  }
+
+  static std::string OnReply(const std::string& serialized_request,
+                             Demux* p_demux,
+                             const boost::system::error_code& ec,
+                             const std::string& serialized_result) {
+    if (ec) {
+      SSF_LOG("microservice", warn, "[admin] stats request[on reply] error");
+    }
+
+    // The reply is sent even on error: the requester waits for it
+    StatsReply<Demux> reply(ec.value(), serialized_result);
+
+    return reply.OnSending();
+  }
+
+  std::string OnSending() const {
+    std::ostringstream ostrs;
+    msgpack::pack(ostrs, *this);
+    return ostrs.str();
+  }
+
+  const std::string& prefix() const { return prefix_; }
+
+ public:
+  // add msgpack function definitions
+  MSGPACK_DEFINE(prefix_)
+
+ private:
+  std::string prefix_;
+};
+
+/// StatsRequest received by a server which does not serve its metrics
+/**
+* The request is answered with an operation_not_supported error (see the
+* metrics.serve configuration key).
+*/
+template <typename Demux>
+class RefusedStatsRequest {
+ public:
+  enum {
+    command_id = StatsRequest<Demux>::command_id,
+    reply_id = StatsRequest<Demux>::reply_id
+  };
+
+  static bool RegisterOnReceiveCommand(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterOnReceiveCommand(
+        command_id, &RefusedStatsRequest::OnReceive);
+  }
+
+  static bool RegisterOnReplyCommand(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterOnReplyCommand(command_id,
+                                               &StatsRequest<Demux>::OnReply);
+  }
+
+  static bool RegisterReplyCommandIndex(CommandFactory<Demux>* cmd_factory) {
+    return cmd_factory->RegisterReplyCommandIndex(command_id, reply_id);
+  }
+
+  static std::string OnReceive(const std::string& serialized_request,
+                               Demux* p_demux, boost::system::error_code& ec) {
+    SSF_LOG("microservice", debug,
+            "[admin] stats request refused (metrics not served)");
+    ec.assign(::error::operation_not_supported, ::error::get_ssf_category());
+    return {};
+  }
+};
+
+}  // admin
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_ADMIN_REQUESTS_STATS_REQUEST_H_
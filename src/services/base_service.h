@@ -10,6 +10,8 @@
 #include <boost/asio/io_service.hpp>
 #include <boost/system/error_code.hpp>
 
+#include <ssf/network/buffer_pool.h>
+
 #include "common/boost/fiber/stream_fiber.hpp"
 #include "common/boost/fiber/datagram_fiber.hpp"
 
@@ -47,6 +49,26 @@ class BaseService : public std::enable_shared_from_this<BaseService<Demux>> {
 
   uint32_t local_id() { return local_id_; }
 
+  /// Set the weight of the service fibers on the demultiplexer
+  void set_fiber_weight(uint8_t fiber_weight) { fiber_weight_ = fiber_weight; }
+
+  uint8_t fiber_weight() const { return fiber_weight_; }
+
+  /// Set the bounds of the working buffers of the service forwarding links
+  void set_buffer_limits(const BufferLimits& buffer_limits) {
+    buffer_limits_ = buffer_limits;
+  }
+
+  const BufferLimits& buffer_limits() const { return buffer_limits_; }
+
+  /// Apply the weight of the service to a fiber (or a fiber acceptor)
+  template <typename Fiber>
+  void apply_fiber_weight(Fiber& fiber) {
+    boost::system::error_code ec;
+    fiber.set_option(
+        boost::asio::fiber::detail::fiber_weight(fiber_weight_), ec);
+  }
+
  protected:
   /// Constructor
   /**
@@ -54,7 +76,11 @@ class BaseService : public std::enable_shared_from_this<BaseService<Demux>> {
   * @param demux the demultiplexer used to send and receive data
   */
   BaseService(boost::asio::io_service& io_service, Demux& demux)
-      : io_service_(io_service), demux_(demux) {}
+      : io_service_(io_service),
+        demux_(demux),
+        fiber_weight_(
+            boost::asio::fiber::detail::fiber_weight::kDefaultWeight),
+        buffer_limits_() {}
 
   /// Accessor for the io_service
   boost::asio::io_service& get_io_service() { return io_service_; }
@@ -70,6 +96,8 @@ class BaseService : public std::enable_shared_from_this<BaseService<Demux>> {
   boost::asio::io_service& io_service_;
   Demux& demux_;
   uint32_t local_id_;
+  uint8_t fiber_weight_;
+  BufferLimits buffer_limits_;
 };
 
 }  // ssf
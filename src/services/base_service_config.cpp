@@ -1,8 +1,14 @@
 #include "services/base_service_config.h"
 
+#include "common/boost/fiber/detail/fiber_weight.hpp"
+
 namespace ssf {
 
-BaseServiceConfig::BaseServiceConfig(bool enabled) : enabled_(enabled) {}
+BaseServiceConfig::BaseServiceConfig(bool enabled)
+    : enabled_(enabled),
+      fiber_weight_(
+          boost::asio::fiber::detail::fiber_weight::kDefaultWeight),
+      buffer_limits_() {}
 
 BaseServiceConfig::~BaseServiceConfig() {}
 
@@ -1,6 +1,10 @@
 #ifndef SSF_SERVICES_BASE_SERVICE_CONFIG_H_
 #define SSF_SERVICES_BASE_SERVICE_CONFIG_H_
 
+#include <cstdint>
+
+#include <ssf/network/buffer_pool.h>
+
 namespace ssf {
 
 class BaseServiceConfig {
@@ -11,11 +15,27 @@ class BaseServiceConfig {
 
   inline void set_enabled(bool enabled) { enabled_ = enabled; }
 
+  // Weight of the service fibers in the demux send scheduling
+  inline uint8_t fiber_weight() const { return fiber_weight_; }
+
+  inline void set_fiber_weight(uint8_t fiber_weight) {
+    fiber_weight_ = fiber_weight;
+  }
+
+  // Bounds of the working buffers of the service forwarding links
+  inline const BufferLimits& buffer_limits() const { return buffer_limits_; }
+
+  inline void set_buffer_limits(const BufferLimits& buffer_limits) {
+    buffer_limits_ = buffer_limits;
+  }
+
  protected:
   BaseServiceConfig(bool enabled);
 
  private:
   bool enabled_;
+  uint8_t fiber_weight_;
+  BufferLimits buffer_limits_;
 };
 
 }  // ssf
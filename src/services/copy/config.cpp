@@ -7,7 +7,7 @@ namespace copy {
 Config::Config() : BaseServiceConfig(false) {}
 
 Config::Config(const Config& copy_service)
-    : BaseServiceConfig(copy_service.enabled()) {}
+    : BaseServiceConfig(copy_service) {}
 
 }  // copy
 }  // services
@@ -10,10 +10,16 @@ namespace copy {
 
 CopyContext::CopyContext(boost::asio::io_service& io_service)
     : io_service_(io_service),
+      is_stream(false),
+      stream_acked(0),
       error_code(ErrorCode::kFailure),
       state_(nullptr),
       outbound_packet_(nullptr),
-      on_state_changed_([]() {}) {}
+      on_state_changed_([]() {}),
+      on_io_ready_([]() {}),
+      on_stream_file_copied_(
+          [](CopyContext*, const boost::system::error_code&) {}),
+      stream_index_(0) {}
 
 CopyContext::~CopyContext() {
   SSF_LOG("microservice", trace, "[copy][context] destroy");
@@ -33,6 +39,11 @@ void CopyContext::Init(const std::string& i_input_dir, const std::string& i_inpu
   filesize = i_filesize;
   output_dir = i_output_dir;
   output_filename = i_output_filename;
+  manifest.Clear();
+  is_stream = false;
+  stream_entries.clear();
+  stream_acked = 0;
+  stream_index_ = 0;
 }
 
 ssf::Path CopyContext::GetOutputFilepath() {
@@ -87,6 +98,15 @@ void CopyContext::ProcessInboundPacket(const Packet& packet,
   state_->ProcessInboundPacket(this, packet, ec);
 }
 
+bool CopyContext::AsyncWaitInboundReady(OnIoReady on_ready) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  if (!output || !output->full()) {
+    return false;
+  }
+  output->AsyncWaitReady(on_ready);
+  return true;
+}
+
 bool CopyContext::IsTerminal() {
   std::unique_lock<std::recursive_mutex> lock(mutex_);
   return state_->IsTerminal(this);
@@ -115,12 +135,51 @@ void CopyContext::SetState(ICopyStateUPtr state) {
   on_state_changed_();
 }
 
+void CopyContext::SelectStreamEntry(std::size_t index) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  if (index >= stream_entries.size()) {
+    return;
+  }
+
+  const auto& entry = stream_entries[index];
+  input_filename = entry.input_filepath;
+  output_filename = entry.output_filename;
+  filesize = entry.filesize;
+  stream_index_ = index;
+}
+
+void CopyContext::NotifyStreamFileCopied(const boost::system::error_code& ec) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  if (stream_acked >= stream_entries.size()) {
+    return;
+  }
+
+  // The file fields describe the acknowledged file during the notification
+  auto current_index = stream_index_;
+  SelectStreamEntry(stream_acked);
+  ++stream_acked;
+  on_stream_file_copied_(this, ec);
+  SelectStreamEntry(current_index);
+}
+
+void CopyContext::FailPendingStreamFiles(const boost::system::error_code& ec) {
+  boost::system::error_code failure_ec(ec);
+  if (!failure_ec) {
+    failure_ec.assign(ErrorCode::kInterrupted, get_copy_category());
+  }
+
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  while (stream_acked < stream_entries.size()) {
+    NotifyStreamFileCopied(failure_ec);
+  }
+}
+
 void CopyContext::Deinit() {
-  if (input.is_open()) {
-    input.close();
+  if (input) {
+    input->Close();
   }
-  if (output.is_open()) {
-    output.close();
+  if (output) {
+    output->Close();
   }
 
   boost::system::error_code exit_ec;
@@ -128,6 +187,7 @@ void CopyContext::Deinit() {
 
   on_outbound_packet_filled_.reset();
   on_state_changed_ = []() {};
+  on_io_ready_ = []() {};
 }
 
 }  // copy
@@ -1,19 +1,22 @@
 #ifndef SSF_SERVICES_COPY_COPY_CONTEXT_H_
 #define SSF_SERVICES_COPY_COPY_CONTEXT_H_
 
-#include <fstream>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <boost/asio/io_service.hpp>
 
-#include "common/crypto/sha1.h"
+#include "common/crypto/sha256.h"
 #include "common/filesystem/filesystem.h"
 
 #include "services/copy/error_code.h"
+#include "services/copy/file_reader.h"
+#include "services/copy/file_writer.h"
 #include "services/copy/i_copy_state.h"
 #include "services/copy/packet.h"
+#include "services/copy/packet/stream.h"
 
 namespace ssf {
 namespace services {
@@ -24,7 +27,10 @@ class CopyContext {
   using OnOutboundPacketFilled =
       std::function<void(const boost::system::error_code& ec)>;
   using OnStateChanged = std::function<void()>;
-  using Hash = ssf::crypto::Sha1;
+  using OnIoReady = std::function<void()>;
+  using OnStreamFileCopied = std::function<void(
+      CopyContext* context, const boost::system::error_code& ec)>;
+  using Hash = ssf::crypto::Sha256;
 
  private:
   using OnOutboundPacketFilledUPtr = std::unique_ptr<OnOutboundPacketFilled>;
@@ -46,6 +52,15 @@ class CopyContext {
     on_state_changed_ = on_state_changed;
   }
 
+  void set_on_io_ready(OnIoReady on_io_ready) { on_io_ready_ = on_io_ready; }
+
+  /// Handler resuming the session once a file operation is done
+  OnIoReady io_ready_handler() const { return on_io_ready_; }
+
+  void set_on_stream_file_copied(OnStreamFileCopied on_stream_file_copied) {
+    on_stream_file_copied_ = on_stream_file_copied;
+  }
+
   ssf::Path GetOutputFilepath();
 
   ssf::Path GetInputFilepath();
@@ -60,6 +75,12 @@ class CopyContext {
   void ProcessInboundPacket(const Packet& packet,
                             boost::system::error_code& ec);
 
+  /// Wait until a new inbound packet can be processed
+  /**
+  * @return false if it can be processed right away (on_ready is not called)
+  */
+  bool AsyncWaitInboundReady(OnIoReady on_ready);
+
   bool IsTerminal();
 
   bool IsClosed();
@@ -68,10 +89,20 @@ class CopyContext {
 
   void SetState(ICopyStateUPtr state);
 
+  /// Describe the file index of the stream with the file fields
+  /// (input_filename, output_filename, filesize)
+  void SelectStreamEntry(std::size_t index);
+
+  /// Notify that the next file of the stream is acknowledged by the receiver
+  void NotifyStreamFileCopied(const boost::system::error_code& ec);
+
+  /// Notify the files of the stream not acknowledged yet as failed
+  void FailPendingStreamFiles(const boost::system::error_code& ec);
+
  public:
   boost::asio::io_service& io_service_;
-  std::ifstream input;
-  std::ofstream output;
+  FileReaderPtr input;
+  FileWriterPtr output;
   std::string input_dir;
   std::string input_filename;
   Hash::Digest input_file_digest;
@@ -83,6 +114,13 @@ class CopyContext {
   std::string output_dir;
   std::string output_filename;
   Hash::Digest output_file_digest;
+  // digests of the chunks before start_offset (resumed copy)
+  FileManifest manifest;
+  // streamed copy: every file is sent on the same session
+  bool is_stream;
+  std::vector<StreamEntry> stream_entries;
+  // entries acknowledged by the receiver (in order)
+  std::size_t stream_acked;
   ssf::Filesystem fs;
   ErrorCode error_code;
 
@@ -92,6 +130,9 @@ class CopyContext {
   Packet* outbound_packet_;
   OnOutboundPacketFilledUPtr on_outbound_packet_filled_;
   OnStateChanged on_state_changed_;
+  OnIoReady on_io_ready_;
+  OnStreamFileCopied on_stream_file_copied_;
+  std::size_t stream_index_;
 };
 
 using CopyContextUPtr = std::unique_ptr<CopyContext>;
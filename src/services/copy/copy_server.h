@@ -74,7 +74,8 @@ class CopyServer : public BaseService<Demux> {
                       const Parameters& parameters) {
       return CopyServer::Create(io_service, fiber_demux, parameters);
     };
-    p_factory->RegisterServiceCreator(kFactoryId, creator);
+    p_factory->RegisterServiceCreator(kFactoryId, creator,
+                                      config.fiber_weight());
   }
 
   static ssf::services::admin::CreateServiceRequest<Demux> GetCreateRequest() {
@@ -154,6 +155,8 @@ class CopyServer : public BaseService<Demux> {
               "[copy][server] cannot accept control fiber");
       return;
     }
+    // the file fibers opened by the server inherit the control fiber weight
+    this->apply_fiber_weight(control_acceptor_);
     AcceptControlFiber();
   }
 
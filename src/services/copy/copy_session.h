@@ -41,6 +41,8 @@ class CopySession : public ssf::BaseSession {
     CopySessionPtr session(new CopySession(std::forward<Args>(args)...));
     auto on_state_changed = [session]() { session->OnStateChanged(); };
     session->context_->set_on_state_changed(on_state_changed);
+    auto on_io_ready = [session]() { session->OnIoReady(); };
+    session->context_->set_on_io_ready(on_io_ready);
 
     return session;
   }
@@ -117,7 +119,8 @@ class CopySession : public ssf::BaseSession {
       return;
     }
 
-    if (context_->filesize != 0 && context_->input.is_open()) {
+    if (context_->filesize != 0 && context_->input &&
+        context_->input->is_open()) {
       auto self = this->shared_from_this();
       on_file_status_(context_.get(), {});
     }
@@ -155,7 +158,8 @@ class CopySession : public ssf::BaseSession {
       return;
     }
 
-    if (context_->filesize != 0 && context_->output.is_open()) {
+    if (context_->filesize != 0 && context_->output &&
+        context_->output->is_open()) {
       auto self = this->shared_from_this();
       on_file_status_(context_.get(), {});
     }
@@ -164,7 +168,11 @@ class CopySession : public ssf::BaseSession {
       return;
     }
 
-    AsyncRead();
+    // Stop reading while the output file is behind
+    auto self = this->shared_from_this();
+    if (!context_->AsyncWaitInboundReady([this, self]() { AsyncRead(); })) {
+      AsyncRead();
+    }
   }
 
   void OnStateChanged() {
@@ -177,6 +185,15 @@ class CopySession : public ssf::BaseSession {
     context_->FillOutboundPacket(ec);
   }
 
+  void OnIoReady() {
+    if (context_->IsClosed()) {
+      return;
+    }
+
+    boost::system::error_code ec;
+    context_->FillOutboundPacket(ec);
+  }
+
   void StopSession() {
     {
       std::lock_guard<std::mutex> lock_stopped(stopped_mutex_);
@@ -82,6 +82,8 @@ std::string detail::copy_category::message(int value) const {
       return "file acceptor not bound";
     case kFileAcceptorNotListening:
       return "file acceptor not listening";
+    case kCopyProtocolVersionNotSupported:
+      return "copy protocol version not supported by the remote end";
     default:
       std::string generic_error("generic copy error ");
       generic_error += std::to_string(value);
@@ -58,6 +58,8 @@ enum ErrorCode {
 
   kFileAcceptorNotBound,
   kFileAcceptorNotListening,
+
+  kCopyProtocolVersionNotSupported,
 };
 
 namespace detail {
@@ -105,7 +105,8 @@ class FileAcceptor : public std::enable_shared_from_this<FileAcceptor<Demux>> {
  private:
   FileAcceptor(boost::asio::io_service& io_service)
       : fiber_acceptor_(io_service),
-        worker_(std::make_unique<boost::asio::io_service::work>(io_service)) {}
+        worker_(std::make_unique<boost::asio::io_service::work>(io_service)),
+        manager_("services.copy.receive") {}
 
   void ReceiveFile(FiberPtr p_fiber, const OnFileStatus& on_file_status,
                    const OnFileCopied& on_file_copied) {
@@ -115,11 +116,17 @@ class FileAcceptor : public std::enable_shared_from_this<FileAcceptor<Demux>> {
     CopyContextUPtr context =
         std::make_unique<CopyContext>(p_fiber->get_io_service());
     context->SetState(std::move(wait_request_state));
+    // files of a streamed copy are notified as they are acknowledged
+    context->set_on_stream_file_copied(on_file_copied);
 
     auto file_copied = [this, self, on_file_copied](
         BaseSessionPtr session, CopyContext* context,
         const boost::system::error_code& ec) {
-      on_file_copied(context, ec);
+      if (context->is_stream) {
+        context->FailPendingStreamFiles(ec);
+      } else {
+        on_file_copied(context, ec);
+      }
       boost::system::error_code stop_ec;
       manager_.stop(session, stop_ec);
     };
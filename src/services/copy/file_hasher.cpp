@@ -0,0 +1,95 @@
+#include "services/copy/file_hasher.h"
+
+#include <algorithm>
+
+#include "services/copy/file_io_pool.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+FileHasherPtr FileHasher::Start(boost::asio::io_service& io_service,
+                                const ssf::Path& path, uint64_t size,
+                                OnHashed on_hashed) {
+  auto chunk_count = FileManifest::ChunkCount(size);
+  auto range_count = static_cast<std::size_t>(std::min<uint64_t>(
+      chunk_count, FileIoPool::Get().thread_count()));
+
+  FileHasherPtr p_hasher(
+      new FileHasher(io_service, range_count, std::move(on_hashed)));
+  if (range_count == 0) {
+    io_service.post(std::move(p_hasher->on_hashed_));
+    p_hasher->on_hashed_ = nullptr;
+    return p_hasher;
+  }
+
+  uint64_t first = 0;
+  for (std::size_t range = 0; range < range_count; ++range) {
+    // Spread the remaining chunks over the remaining ranges
+    uint64_t last = first + (chunk_count - first) / (range_count - range);
+    FileIoPool::Get().Post([p_hasher, path, range, first, last]() {
+      p_hasher->HashRange(path, range, first, last);
+    });
+    first = last;
+  }
+  return p_hasher;
+}
+
+FileHasher::FileHasher(boost::asio::io_service& io_service,
+                       std::size_t range_count, OnHashed on_hashed)
+    : io_service_(io_service),
+      mutex_(),
+      ranges_(range_count),
+      pending_ranges_(range_count),
+      error_(),
+      manifest_(),
+      on_hashed_(std::move(on_hashed)) {}
+
+void FileHasher::Cancel() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_hashed_ = nullptr;
+}
+
+bool FileHasher::done() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return pending_ranges_ == 0;
+}
+
+boost::system::error_code FileHasher::error() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return error_;
+}
+
+FileManifest FileHasher::manifest() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return manifest_;
+}
+
+void FileHasher::HashRange(const ssf::Path& path, std::size_t range,
+                           uint64_t first, uint64_t last) {
+  boost::system::error_code ec;
+  auto digests = FileManifest::HashFileChunks(path, first, last, ec);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (ec && !error_) {
+    error_ = ec;
+  }
+  ranges_[range] = std::move(digests);
+  if (--pending_ranges_ > 0) {
+    return;
+  }
+
+  for (const auto& range_digests : ranges_) {
+    manifest_.Append(range_digests);
+  }
+  ranges_.clear();
+
+  if (on_hashed_) {
+    io_service_.post(std::move(on_hashed_));
+    on_hashed_ = nullptr;
+  }
+}
+
+}  // copy
+}  // services
+}  // ssf
@@ -0,0 +1,80 @@
+#ifndef SSF_SERVICES_COPY_FILE_HASHER_H_
+#define SSF_SERVICES_COPY_FILE_HASHER_H_
+
+#include <cstdint>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "common/crypto/hash_manifest.h"
+#include "common/crypto/sha256.h"
+#include "common/filesystem/path.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+/// Chunk digests of a copied file
+using FileManifest = ssf::crypto::HashManifest<ssf::crypto::Sha256>;
+
+class FileHasher;
+using FileHasherPtr = std::shared_ptr<FileHasher>;
+
+/// Hash the beginning of a file on the FileIoPool
+/**
+* The chunks are split in ranges hashed in parallel, one per pool thread.
+*/
+class FileHasher : public std::enable_shared_from_this<FileHasher> {
+ public:
+  using OnHashed = std::function<void()>;
+
+ public:
+  /// Hash the chunks covering the first size bytes of a file
+  /**
+  * on_hashed is called in the io_service once done() is true
+  */
+  static FileHasherPtr Start(boost::asio::io_service& io_service,
+                             const ssf::Path& path, uint64_t size,
+                             OnHashed on_hashed);
+
+  FileHasher(const FileHasher&) = delete;
+  FileHasher& operator=(const FileHasher&) = delete;
+
+  /// Forget the handler given to Start
+  void Cancel();
+
+  bool done() const;
+
+  boost::system::error_code error() const;
+
+  /// Digests of the hashed chunks (valid once done)
+  FileManifest manifest() const;
+
+ private:
+  FileHasher(boost::asio::io_service& io_service, std::size_t range_count,
+             OnHashed on_hashed);
+
+  void HashRange(const ssf::Path& path, std::size_t range, uint64_t first,
+                 uint64_t last);
+
+ private:
+  boost::asio::io_service& io_service_;
+
+  mutable std::mutex mutex_;
+  std::vector<FileManifest::Digests> ranges_;
+  std::size_t pending_ranges_;
+  boost::system::error_code error_;
+  FileManifest manifest_;
+  OnHashed on_hashed_;
+};
+
+}  // copy
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_COPY_FILE_HASHER_H_
@@ -0,0 +1,38 @@
+#include "services/copy/file_io_pool.h"
+
+#include <algorithm>
+
+#include <ssf/log/log.h>
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+FileIoPool& FileIoPool::Get() {
+  // Never destroyed: file operations may still be running at exit
+  static FileIoPool* p_pool = new FileIoPool();
+  return *p_pool;
+}
+
+FileIoPool::FileIoPool()
+    : io_service_(),
+      p_work_(new boost::asio::io_service::work(io_service_)),
+      threads_() {
+  std::size_t count = std::thread::hardware_concurrency();
+  count = std::min<std::size_t>(std::max<std::size_t>(count, kMinThreadCount),
+                                kMaxThreadCount);
+  for (std::size_t i = 0; i < count; ++i) {
+    threads_.emplace_back([this]() {
+      boost::system::error_code ec;
+      io_service_.run(ec);
+      if (ec) {
+        SSF_LOG("microservice", error, "[copy][file_io] run failed: {}",
+                ec.message());
+      }
+    });
+  }
+}
+
+}  // copy
+}  // services
+}  // ssf
@@ -0,0 +1,52 @@
+#ifndef SSF_SERVICES_COPY_FILE_IO_POOL_H_
+#define SSF_SERVICES_COPY_FILE_IO_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+/// Threads dedicated to the blocking file operations of the copy sessions
+/**
+* Disk reads and writes are run here so that they never block the threads of
+* the io_services shared by the fibers. Completions are posted back to the
+* io_service of the session.
+*/
+class FileIoPool {
+ public:
+  enum : std::size_t { kMinThreadCount = 2, kMaxThreadCount = 4 };
+
+ public:
+  /// The pool shared by all the copy sessions
+  static FileIoPool& Get();
+
+  FileIoPool(const FileIoPool&) = delete;
+  FileIoPool& operator=(const FileIoPool&) = delete;
+
+  std::size_t thread_count() const { return threads_.size(); }
+
+  template <class Handler>
+  void Post(Handler handler) {
+    io_service_.post(handler);
+  }
+
+ private:
+  FileIoPool();
+
+ private:
+  boost::asio::io_service io_service_;
+  std::unique_ptr<boost::asio::io_service::work> p_work_;
+  std::vector<std::thread> threads_;
+};
+
+}  // copy
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_COPY_FILE_IO_POOL_H_
@@ -0,0 +1,191 @@
+#include "services/copy/file_reader.h"
+
+#include <cstring>
+
+#include <algorithm>
+#include <iostream>
+
+#include <boost/asio/error.hpp>
+
+#include "services/copy/file_io_pool.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+FileReaderPtr FileReader::Open(boost::asio::io_service& io_service,
+                               const std::string& filepath, uint64_t offset,
+                               bool hash_chunks,
+                               boost::system::error_code& ec) {
+  FileReaderPtr p_reader(new FileReader(io_service, offset, hash_chunks));
+  p_reader->file_.open(filepath, std::ifstream::binary | std::ifstream::in);
+  if (!p_reader->file_.is_open() || !p_reader->file_.good()) {
+    ec.assign(boost::system::errc::no_such_file_or_directory,
+              boost::system::system_category());
+    return nullptr;
+  }
+  p_reader->file_.seekg(offset, std::ifstream::beg);
+  p_reader->p_input_ = &p_reader->file_;
+
+  std::unique_lock<std::mutex> lock(p_reader->mutex_);
+  p_reader->StartRead();
+  ec.assign(0, boost::system::system_category());
+  return p_reader;
+}
+
+FileReaderPtr FileReader::OpenStdin(boost::asio::io_service& io_service) {
+  FileReaderPtr p_reader(new FileReader(io_service, 0, false));
+  p_reader->p_input_ = &std::cin;
+
+  std::unique_lock<std::mutex> lock(p_reader->mutex_);
+  p_reader->StartRead();
+  return p_reader;
+}
+
+FileReader::FileReader(boost::asio::io_service& io_service, uint64_t offset,
+                       bool hash_chunks)
+    : io_service_(io_service),
+      file_(),
+      p_input_(nullptr),
+      offset_(offset),
+      hash_chunks_(hash_chunks),
+      mutex_(),
+      chunks_(),
+      reading_(false),
+      eof_(false),
+      closed_(false),
+      error_(),
+      on_ready_(),
+      digests_() {}
+
+FileReader::~FileReader() {
+  if (file_.is_open()) {
+    file_.close();
+  }
+}
+
+std::size_t FileReader::Read(char* p_data, std::size_t size,
+                             boost::system::error_code& ec) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::size_t copied = 0;
+  while (copied < size && !chunks_.empty()) {
+    auto& chunk = chunks_.front();
+    auto length = std::min(size - copied, chunk.size - chunk.consumed);
+    std::memcpy(p_data + copied, chunk.buffer.data() + chunk.consumed, length);
+    copied += length;
+    chunk.consumed += length;
+    if (chunk.consumed == chunk.size) {
+      chunks_.pop_front();
+    }
+  }
+
+  StartRead();
+
+  if (copied > 0) {
+    ec.assign(0, boost::system::system_category());
+  } else if (error_) {
+    ec = error_;
+  } else if (eof_) {
+    ec = boost::asio::error::eof;
+  } else {
+    ec = boost::asio::error::would_block;
+  }
+  return copied;
+}
+
+void FileReader::AsyncWaitReady(OnReady on_ready) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_ready_ = std::move(on_ready);
+  if (!chunks_.empty() || eof_ || error_) {
+    NotifyReady();
+  }
+}
+
+void FileReader::Close() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  closed_ = true;
+  chunks_.clear();
+  on_ready_ = nullptr;
+  // A running read closes the file when it is done
+  if (!reading_ && file_.is_open()) {
+    file_.close();
+  }
+}
+
+bool FileReader::is_open() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return !closed_;
+}
+
+FileManifest::Digests FileReader::chunk_digests() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return digests_;
+}
+
+void FileReader::StartRead() {
+  if (reading_ || eof_ || error_ || closed_ || chunks_.size() >= kDepth) {
+    return;
+  }
+  reading_ = true;
+
+  // Align the next reads on chunk boundaries of the file
+  std::size_t size =
+      kChunkSize - static_cast<std::size_t>(offset_ % kChunkSize);
+  auto self = this->shared_from_this();
+  FileIoPool::Get().Post([this, self, size]() { ReadChunk(size); });
+}
+
+void FileReader::ReadChunk(std::size_t size) {
+  Chunk chunk{BufferPool::Get().Acquire(size), 0, 0};
+  bool failed = false;
+  try {
+    p_input_->read(chunk.buffer.data(), size);
+    chunk.size = static_cast<std::size_t>(p_input_->gcount());
+    failed = p_input_->bad();
+  } catch (const std::exception&) {
+    failed = true;
+  }
+
+  FileManifest::Digest digest;
+  if (hash_chunks_ && !failed && chunk.size > 0) {
+    digest = FileManifest::HashChunk(chunk.buffer.data(), chunk.size);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  reading_ = false;
+  if (closed_) {
+    if (file_.is_open()) {
+      file_.close();
+    }
+    return;
+  }
+
+  offset_ += chunk.size;
+  if (chunk.size > 0) {
+    if (hash_chunks_ && !failed) {
+      digests_.push_back(digest);
+    }
+    chunks_.push_back(std::move(chunk));
+  }
+  if (failed) {
+    error_.assign(boost::system::errc::io_error,
+                  boost::system::system_category());
+  } else if (!p_input_->good()) {
+    eof_ = true;
+  }
+
+  NotifyReady();
+  StartRead();
+}
+
+void FileReader::NotifyReady() {
+  if (!on_ready_) {
+    return;
+  }
+  io_service_.post(std::move(on_ready_));
+  on_ready_ = nullptr;
+}
+
+}  // copy
+}  // services
+}  // ssf
@@ -0,0 +1,121 @@
+#ifndef SSF_SERVICES_COPY_FILE_READER_H_
+#define SSF_SERVICES_COPY_FILE_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <ssf/network/buffer_pool.h>
+
+#include "services/copy/file_hasher.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+class FileReader;
+using FileReaderPtr = std::shared_ptr<FileReader>;
+
+/// Read ahead of an input file on the FileIoPool
+/**
+* The input is read in large chunks, one at a time, while up to kDepth chunks
+* wait to be sent. File reads are aligned on chunk boundaries of the file.
+* Read only copies data already in memory: it never blocks on disk.
+*
+* The chunks may be hashed as soon as they are read (see FileManifest), the
+* offset should then be a multiple of the chunk size.
+*/
+class FileReader : public std::enable_shared_from_this<FileReader> {
+ public:
+  using OnReady = std::function<void()>;
+
+  enum : std::size_t { kChunkSize = BufferPool::kMaxClassSize, kDepth = 4 };
+
+  static_assert(static_cast<uint64_t>(kChunkSize) == FileManifest::kChunkSize,
+                "chunks read must be the chunks of the manifest");
+
+ public:
+  /// Open a file and start reading it from offset
+  static FileReaderPtr Open(boost::asio::io_service& io_service,
+                            const std::string& filepath, uint64_t offset,
+                            bool hash_chunks, boost::system::error_code& ec);
+
+  /// Start reading the standard input
+  static FileReaderPtr OpenStdin(boost::asio::io_service& io_service);
+
+  ~FileReader();
+
+  FileReader(const FileReader&) = delete;
+  FileReader& operator=(const FileReader&) = delete;
+
+  /// Copy read ahead data
+  /**
+  * @return the number of bytes copied in p_data. If none, ec is set to
+  *   would_block while a chunk is being read, to eof at the end of the input
+  *   or to the read error
+  */
+  std::size_t Read(char* p_data, std::size_t size,
+                   boost::system::error_code& ec);
+
+  /// Call on_ready in the io_service once Read has something new to return
+  void AsyncWaitReady(OnReady on_ready);
+
+  /// Stop reading ahead and close the input
+  void Close();
+
+  bool is_open() const;
+
+  /// Digests of the chunks read so far (if hashed)
+  FileManifest::Digests chunk_digests() const;
+
+ private:
+  struct Chunk {
+    BufferPool::Buffer buffer;
+    std::size_t size;
+    std::size_t consumed;
+  };
+
+ private:
+  FileReader(boost::asio::io_service& io_service, uint64_t offset,
+             bool hash_chunks);
+
+  // Must be called with mutex_ locked
+  void StartRead();
+
+  void ReadChunk(std::size_t size);
+
+  // Must be called with mutex_ locked
+  void NotifyReady();
+
+ private:
+  boost::asio::io_service& io_service_;
+  std::ifstream file_;
+  std::istream* p_input_;
+  uint64_t offset_;
+  bool hash_chunks_;
+
+  mutable std::mutex mutex_;
+  std::deque<Chunk> chunks_;
+  bool reading_;
+  bool eof_;
+  bool closed_;
+  boost::system::error_code error_;
+  OnReady on_ready_;
+  FileManifest::Digests digests_;
+};
+
+}  // copy
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_COPY_FILE_READER_H_
@@ -18,6 +18,7 @@
 #include "services/copy/packet/control.h"
 #include "services/copy/packet_helper.h"
 #include "services/copy/state/sender/send_init_request_state.h"
+#include "services/copy/state/sender/send_stream_state.h"
 
 #include "services/copy/file_acceptor.h"
 
@@ -44,6 +45,8 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
   using FiberPtr = std::shared_ptr<Fiber>;
   using Endpoint =
       typename boost::asio::fiber::stream_fiber<SocketType>::endpoint;
+  using FiberWeight =
+      typename boost::asio::fiber::stream_fiber<SocketType>::weight;
   using SessionManager = ItemManager<BaseSessionPtr>;
 
   using OnControlConnected = std::function<void(
@@ -123,14 +126,19 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
         worker_(std::make_unique<boost::asio::io_service::work>(
             demux.get_io_service())),
         control_fiber_(std::move(control_fiber)),
+        fiber_weight_(),
         copy_request_(req),
+        manager_("services.copy.send"),
         input_files_count_(0),
         copy_errors_count_(0),
         copy_ec_(ErrorCode::kSuccess),
         stopped_(false),
         on_file_status_(on_file_status),
         on_file_copied_(on_file_copied),
-        on_copy_finished_(on_copy_finished) {}
+        on_copy_finished_(on_copy_finished) {
+    boost::system::error_code ec;
+    control_fiber_.get_option(fiber_weight_, ec);
+  }
 
   void RunFileSessions() {
     boost::system::error_code ec;
@@ -146,9 +154,70 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
       return;
     }
 
+    if (copy_request_.is_stream) {
+      if (!copy_request_.is_resume) {
+        RunStreamSession();
+        return;
+      }
+      SSF_LOG("microservice", debug,
+              "[copy][file_sender] resume needs a session per file");
+    }
+
     RunFileSession();
   }
 
+  // Send every file on a single session
+  void RunStreamSession() {
+    std::list<Path> input_files;
+    {
+      std::lock_guard<std::recursive_mutex> lock(input_files_mutex_);
+      if (stopped_) {
+        return;
+      }
+      input_files.swap(pending_input_files_);
+      input_files_ = input_files;
+    }
+
+    SSF_LOG("microservice", debug,
+            "[copy][file_sender] start stream of {} files", input_files.size());
+
+    auto self = this->shared_from_this();
+
+    FiberPtr fiber = std::make_shared<Fiber>(io_service_);
+    boost::system::error_code weight_ec;
+    fiber->set_option(fiber_weight_, weight_ec);
+
+    auto on_stream_connected = [this, self, input_files,
+                                fiber](const boost::system::error_code& ec) {
+      boost::system::error_code session_ec;
+      auto context = GenerateStreamContext(input_files, session_ec);
+      context->set_on_stream_file_copied(
+          [this, self](CopyContext* context,
+                       const boost::system::error_code& ec) {
+            NotifyFileCopied(context, ec);
+          });
+
+      if (ec) {
+        boost::system::error_code copy_ec(ErrorCode::kNetworkError,
+                                          get_copy_category());
+        SSF_LOG("microservice", debug,
+                "[copy][file_sender] could not connect stream fiber {}",
+                ec.message());
+        context->FailPendingStreamFiles(copy_ec);
+        return;
+      }
+
+      StartSession(fiber, std::move(context), session_ec);
+    };
+
+    Endpoint ep(demux_, FileAcceptor<Demux>::kPort);
+
+    SSF_LOG("microservice", debug,
+            "[copy][file_sender] connect to file acceptor port {}",
+            FileAcceptor<Demux>::kPort);
+    fiber->async_connect(ep, on_stream_connected);
+  }
+
   void RunFileSession() {
     ssf::Path input_file;
     {
@@ -170,6 +239,8 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
     auto self = this->shared_from_this();
 
     FiberPtr fiber = std::make_shared<Fiber>(io_service_);
+    boost::system::error_code weight_ec;
+    fiber->set_option(fiber_weight_, weight_ec);
 
     auto on_file_connected = [this, self, input_file,
                               fiber](const boost::system::error_code& ec) {
@@ -226,6 +297,8 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
   void RunStdinSession() {
     auto self = this->shared_from_this();
     FiberPtr fiber = std::make_shared<Fiber>(io_service_);
+    boost::system::error_code weight_ec;
+    fiber->set_option(fiber_weight_, weight_ec);
 
     SSF_LOG("microservice", debug,
             "[copy][file_sender] connect to file acceptor port {}",
@@ -302,6 +375,49 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
     return context;
   }
 
+  CopyContextUPtr GenerateStreamContext(const std::list<Path>& input_files,
+                                        boost::system::error_code& ec) {
+    CopyContextUPtr context = std::make_unique<CopyContext>(io_service_);
+
+    Path input_dir(copy_request_.input_pattern);
+    if (!fs_.IsDirectory(input_dir, ec)) {
+      input_dir = input_dir.GetParent();
+    }
+
+    Path output_directory(copy_request_.output_pattern);
+    Path output_filename;
+    if (fs_.IsFile(copy_request_.input_pattern, ec)) {
+      // output_pattern should be a file path instead of a directory path
+      output_directory = Path(copy_request_.output_pattern).GetParent();
+      output_filename = Path(copy_request_.output_pattern).GetFilename();
+    }
+    ec.clear();
+
+    ICopyStateUPtr send_stream_state = SendStreamState::Create();
+    context->SetState(std::move(send_stream_state));
+
+    context->Init(input_dir.GetString(), "",
+                  copy_request_.check_file_integrity, false, 0, false, 0,
+                  output_directory.GetString(), "");
+    context->is_stream = true;
+    for (const auto& input_filepath : input_files) {
+      boost::system::error_code fs_ec;
+      auto filesize =
+          context->fs.GetFilesize(input_dir / input_filepath, fs_ec);
+      if (fs_ec) {
+        filesize = 0;
+      }
+      context->stream_entries.emplace_back(
+          input_filepath.GetString(),
+          output_filename.IsEmpty() ? input_filepath.GetString()
+                                    : output_filename.GetString(),
+          filesize);
+    }
+    context->SelectStreamEntry(0);
+
+    return context;
+  }
+
   CopyContextUPtr GenerateStdinContext(boost::system::error_code& ec) {
     Path output_path(copy_request_.output_pattern);
     Path output_directory = output_path.GetParent();
@@ -331,7 +447,12 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
     auto on_file_copied = [this, self](BaseSessionPtr session,
                                        CopyContext* context,
                                        const boost::system::error_code& ec) {
-      NotifyFileCopied(context, ec);
+      if (context->is_stream) {
+        // the acknowledged files are already notified
+        context->FailPendingStreamFiles(ec);
+      } else {
+        NotifyFileCopied(context, ec);
+      }
       boost::system::error_code stop_ec;
       manager_.stop(session, stop_ec);
     };
@@ -339,6 +460,10 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
     if (context->is_stdin_input) {
       SSF_LOG("microservice", debug, "[copy][file_sender] send stdin to {}",
               context->GetOutputFilepath().GetString());
+    } else if (context->is_stream) {
+      SSF_LOG("microservice", debug,
+              "[copy][file_sender] send {} files to {}",
+              context->stream_entries.size(), context->output_dir);
     } else {
       SSF_LOG("microservice", debug,
               "[copy][file_sender] send file {} to {}",
@@ -454,6 +579,7 @@ class FileSender : public std::enable_shared_from_this<FileSender<Demux>> {
   Demux& demux_;
   std::unique_ptr<boost::asio::io_service::work> worker_;
   Fiber control_fiber_;
+  FiberWeight fiber_weight_;
   CopyRequest copy_request_;
 
   SessionManager manager_;
@@ -0,0 +1,236 @@
+#include "services/copy/file_writer.h"
+
+#include <cstring>
+
+#include <algorithm>
+
+#include "services/copy/file_io_pool.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+FileWriterPtr FileWriter::Open(boost::asio::io_service& io_service,
+                               const std::string& filepath,
+                               std::ios_base::openmode mode,
+                               bool hash_chunks,
+                               boost::system::error_code& ec) {
+  FileWriterPtr p_writer(new FileWriter(io_service, hash_chunks));
+  p_writer->file_.open(filepath, mode);
+  if (!p_writer->file_.is_open()) {
+    ec.assign(boost::system::errc::permission_denied,
+              boost::system::system_category());
+    return nullptr;
+  }
+
+  ec.assign(0, boost::system::system_category());
+  return p_writer;
+}
+
+FileWriter::FileWriter(boost::asio::io_service& io_service, bool hash_chunks)
+    : io_service_(io_service),
+      file_(),
+      hash_chunks_(hash_chunks),
+      mutex_(),
+      current_{BufferPool::Buffer(), 0},
+      chunks_(),
+      writing_(false),
+      closing_(false),
+      closed_(false),
+      error_(),
+      on_ready_(),
+      on_closed_(),
+      started_(false),
+      digests_() {}
+
+FileWriter::~FileWriter() {
+  if (file_.is_open()) {
+    file_.close();
+  }
+}
+
+void FileWriter::Seek(uint64_t offset, boost::system::error_code& ec) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (started_ || closing_) {
+    ec.assign(boost::system::errc::operation_not_permitted,
+              boost::system::system_category());
+    return;
+  }
+
+  file_.seekp(offset, std::ofstream::beg);
+  if (!file_.good()) {
+    ec.assign(boost::system::errc::io_error, boost::system::system_category());
+    return;
+  }
+  ec.assign(0, boost::system::system_category());
+}
+
+void FileWriter::Write(const char* p_data, std::size_t size,
+                       boost::system::error_code& ec) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  started_ = true;
+  if (error_ || closing_) {
+    ec = error_ ? error_ : boost::system::error_code(
+                               boost::system::errc::bad_file_descriptor,
+                               boost::system::system_category());
+    return;
+  }
+
+  while (size > 0) {
+    if (!current_.buffer) {
+      current_.buffer = BufferPool::Get().Acquire(kChunkSize);
+      current_.size = 0;
+    }
+    auto length = std::min(size, kChunkSize - current_.size);
+    std::memcpy(current_.buffer.data() + current_.size, p_data, length);
+    current_.size += length;
+    p_data += length;
+    size -= length;
+
+    if (current_.size == kChunkSize) {
+      chunks_.push_back(std::move(current_));
+      current_.size = 0;
+    }
+  }
+
+  StartWrite();
+  ec.assign(0, boost::system::system_category());
+}
+
+bool FileWriter::full() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return chunks_.size() >= kDepth;
+}
+
+void FileWriter::AsyncWaitReady(OnReady on_ready) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_ready_ = std::move(on_ready);
+  if (chunks_.size() < kDepth || error_ || closing_) {
+    NotifyReady();
+  }
+}
+
+void FileWriter::AsyncClose(OnReady on_closed) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_ready_ = nullptr;
+  on_closed_ = std::move(on_closed);
+  if (closing_) {
+    if (closed_ && on_closed_) {
+      io_service_.post(std::move(on_closed_));
+      on_closed_ = nullptr;
+    }
+    return;
+  }
+
+  closing_ = true;
+  if (current_.size > 0) {
+    chunks_.push_back(std::move(current_));
+    current_.size = 0;
+  }
+  StartWrite();
+}
+
+bool FileWriter::is_open() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return !closing_;
+}
+
+bool FileWriter::closed() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return closed_;
+}
+
+boost::system::error_code FileWriter::error() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return error_;
+}
+
+FileManifest::Digests FileWriter::chunk_digests() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return digests_;
+}
+
+void FileWriter::StartWrite() {
+  if (writing_ || closed_) {
+    return;
+  }
+
+  auto self = this->shared_from_this();
+  if (chunks_.empty() || error_) {
+    if (!closing_) {
+      return;
+    }
+    // Everything is written: close the file
+    writing_ = true;
+    FileIoPool::Get().Post([this, self]() { WriteChunk(Chunk{}); });
+    return;
+  }
+
+  writing_ = true;
+  auto p_chunk = std::make_shared<Chunk>(std::move(chunks_.front()));
+  chunks_.pop_front();
+  NotifyReady();
+  FileIoPool::Get().Post(
+      [this, self, p_chunk]() { WriteChunk(std::move(*p_chunk)); });
+}
+
+void FileWriter::WriteChunk(Chunk chunk) {
+  bool failed = false;
+  bool close = !chunk.buffer;
+  FileManifest::Digest digest;
+  if (hash_chunks_ && !close) {
+    digest = FileManifest::HashChunk(chunk.buffer.data(), chunk.size);
+  }
+
+  try {
+    if (!close) {
+      file_.write(chunk.buffer.data(), chunk.size);
+      failed = !file_.good();
+    } else {
+      file_.close();
+      failed = file_.fail();
+    }
+  } catch (const std::exception&) {
+    failed = true;
+  }
+  chunk.buffer.Reset();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  writing_ = false;
+  if (hash_chunks_ && !close) {
+    digests_.push_back(digest);
+  }
+  if (failed && !error_) {
+    error_.assign(boost::system::errc::io_error,
+                  boost::system::system_category());
+  }
+
+  if (close) {
+    closed_ = true;
+    chunks_.clear();
+    if (on_closed_) {
+      io_service_.post(std::move(on_closed_));
+      on_closed_ = nullptr;
+    }
+    return;
+  }
+
+  if (error_) {
+    // Nothing more will be written
+    chunks_.clear();
+    NotifyReady();
+  }
+  StartWrite();
+}
+
+void FileWriter::NotifyReady() {
+  if (!on_ready_ || (chunks_.size() >= kDepth && !error_ && !closing_)) {
+    return;
+  }
+  io_service_.post(std::move(on_ready_));
+  on_ready_ = nullptr;
+}
+
+}  // copy
+}  // services
+}  // ssf
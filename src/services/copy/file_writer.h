@@ -0,0 +1,134 @@
+#ifndef SSF_SERVICES_COPY_FILE_WRITER_H_
+#define SSF_SERVICES_COPY_FILE_WRITER_H_
+
+#include <cstddef>
+
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <ssf/network/buffer_pool.h>
+
+#include "services/copy/file_hasher.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+class FileWriter;
+using FileWriterPtr = std::shared_ptr<FileWriter>;
+
+/// Write behind of an output file on the FileIoPool
+/**
+* Written data is gathered in large chunks which are written to disk one at a
+* time. Write only copies data in memory: it never blocks on disk. The writer
+* is full when kDepth chunks wait to be written, the caller should then wait
+* (AsyncWaitReady) before writing more.
+*
+* The chunks may be hashed before they are written (see FileManifest), the
+* writes should then start at a multiple of the chunk size.
+*/
+class FileWriter : public std::enable_shared_from_this<FileWriter> {
+ public:
+  using OnReady = std::function<void()>;
+
+  enum : std::size_t { kChunkSize = BufferPool::kMaxClassSize, kDepth = 4 };
+
+  static_assert(static_cast<uint64_t>(kChunkSize) == FileManifest::kChunkSize,
+                "chunks written must be the chunks of the manifest");
+
+ public:
+  /// Open a file (see std::ofstream::open for the mode)
+  static FileWriterPtr Open(boost::asio::io_service& io_service,
+                            const std::string& filepath,
+                            std::ios_base::openmode mode, bool hash_chunks,
+                            boost::system::error_code& ec);
+
+  ~FileWriter();
+
+  FileWriter(const FileWriter&) = delete;
+  FileWriter& operator=(const FileWriter&) = delete;
+
+  /// Set the position of the next write (before the first write only)
+  void Seek(uint64_t offset, boost::system::error_code& ec);
+
+  /// Copy data to write
+  /**
+  * @param ec set to the error of a previous write if any
+  */
+  void Write(const char* p_data, std::size_t size,
+             boost::system::error_code& ec);
+
+  /// True if the caller should wait before writing more
+  bool full() const;
+
+  /// Call on_ready in the io_service once the writer is not full or closed
+  void AsyncWaitReady(OnReady on_ready);
+
+  /// Write the remaining data then close the file
+  /**
+  * on_closed is called in the io_service once the file is closed, error()
+  * then tells if all the data was written
+  */
+  void AsyncClose(OnReady on_closed);
+
+  /// Write the remaining data then close the file in the background
+  void Close() { AsyncClose(nullptr); }
+
+  /// True until a close is requested
+  bool is_open() const;
+
+  /// True once the file is closed
+  bool closed() const;
+
+  boost::system::error_code error() const;
+
+  /// Digests of the chunks written so far (if hashed)
+  FileManifest::Digests chunk_digests() const;
+
+ private:
+  struct Chunk {
+    BufferPool::Buffer buffer;
+    std::size_t size;
+  };
+
+ private:
+  FileWriter(boost::asio::io_service& io_service, bool hash_chunks);
+
+  // Must be called with mutex_ locked
+  void StartWrite();
+
+  void WriteChunk(Chunk chunk);
+
+  // Must be called with mutex_ locked
+  void NotifyReady();
+
+ private:
+  boost::asio::io_service& io_service_;
+  std::ofstream file_;
+  bool hash_chunks_;
+
+  mutable std::mutex mutex_;
+  Chunk current_;
+  std::deque<Chunk> chunks_;
+  bool writing_;
+  bool closing_;
+  bool closed_;
+  boost::system::error_code error_;
+  OnReady on_ready_;
+  OnReady on_closed_;
+  bool started_;
+  FileManifest::Digests digests_;
+};
+
+}  // copy
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_COPY_FILE_WRITER_H_
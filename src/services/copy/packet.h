@@ -26,7 +26,14 @@ enum class PacketType : uint32_t {
   // control channel
   kCopyRequest,
   CopyRequestAck,
-  kCopyFinished
+  kCopyFinished,
+  // copy session (after the control channel types to keep their values)
+  kStartTransfer,
+  // streamed copy session
+  kStreamManifest,
+  kStreamFileHeader,
+  kStreamFileTrailer,
+  kStreamFileAck
 };
 
 class Packet {
@@ -22,7 +22,8 @@ struct CopyRequest {
         is_resume(false),
         is_recursive(false),
         check_file_integrity(false),
-        max_parallel_copies(1) {}
+        max_parallel_copies(1),
+        is_stream(false) {}
 
   CopyRequest(const CopyRequest& req)
       : is_from_stdin(req.is_from_stdin),
@@ -31,19 +32,21 @@ struct CopyRequest {
         check_file_integrity(req.check_file_integrity),
         max_parallel_copies(req.max_parallel_copies),
         input_pattern(req.input_pattern),
-        output_pattern(req.output_pattern) {}
+        output_pattern(req.output_pattern),
+        is_stream(req.is_stream) {}
 
   CopyRequest(bool i_is_from_stdin, bool i_is_resume, bool i_is_recursive,
               bool i_check_file_integrity, uint32_t i_max_parallel_copies,
               const std::string& i_input_pattern,
-              const std::string& i_output_pattern)
+              const std::string& i_output_pattern, bool i_is_stream = false)
       : is_from_stdin(i_is_from_stdin),
         is_resume(i_is_resume),
         is_recursive(i_is_recursive),
         check_file_integrity(i_check_file_integrity),
         max_parallel_copies(i_max_parallel_copies),
         input_pattern(i_input_pattern),
-        output_pattern(i_output_pattern) {}
+        output_pattern(i_output_pattern),
+        is_stream(i_is_stream) {}
 
   CopyRequest& operator=(const CopyRequest& other) {
     is_from_stdin = other.is_from_stdin;
@@ -53,6 +56,7 @@ struct CopyRequest {
     max_parallel_copies = other.max_parallel_copies;
     input_pattern = other.input_pattern;
     output_pattern = other.output_pattern;
+    is_stream = other.is_stream;
 
     return *this;
   }
@@ -64,9 +68,11 @@ struct CopyRequest {
   uint32_t max_parallel_copies;
   std::string input_pattern;
   std::string output_pattern;
+  // send every file on a single copy session
+  bool is_stream;
 
   MSGPACK_DEFINE(is_from_stdin, is_resume, is_recursive, check_file_integrity,
-                 max_parallel_copies, input_pattern, output_pattern)
+                 max_parallel_copies, input_pattern, output_pattern, is_stream)
 };
 
 struct CopyRequestAck {
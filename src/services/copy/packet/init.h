@@ -4,26 +4,32 @@
 #include <cstdint>
 
 #include <string>
+#include <vector>
 
 #include <msgpack.hpp>
 
-#include "common/crypto/sha1.h"
+#include "common/crypto/sha256.h"
 #include "services/copy/packet.h"
 
 namespace ssf {
 namespace services {
 namespace copy {
 
+// Version of the copy session packets, first field of InitRequest and
+// InitReply since version 2 (resume by chunk digests, StartTransfer)
+enum : uint32_t { kCopyProtocolVersion = 2 };
+
 struct InitRequest {
   static const PacketType kType = PacketType::kInitRequest;
 
-  InitRequest() {}
+  InitRequest() : protocol_version(0) {}
 
   InitRequest(const std::string& i_input_filepath, bool i_check_file_integrity,
               bool i_stdin_input, bool i_resume, uint64_t i_filesize,
               const std::string& i_output_dir,
               const std::string& i_output_filename)
-      : input_filepath(i_input_filepath),
+      : protocol_version(kCopyProtocolVersion),
+        input_filepath(i_input_filepath),
         check_file_integrity(i_check_file_integrity),
         stdin_input(i_stdin_input),
         resume(i_resume),
@@ -31,6 +37,7 @@ struct InitRequest {
         output_dir(i_output_dir),
         output_filename(i_output_filename) {}
 
+  uint32_t protocol_version;
   std::string input_filepath;
   bool check_file_integrity;
   bool stdin_input;
@@ -39,31 +46,59 @@ struct InitRequest {
   std::string output_dir;
   std::string output_filename;
 
-  MSGPACK_DEFINE(input_filepath, check_file_integrity, stdin_input, resume,
-                 filesize, output_dir, output_filename)
+  MSGPACK_DEFINE(protocol_version, input_filepath, check_file_integrity,
+                 stdin_input, resume, filesize, output_dir, output_filename)
 };
 
 struct InitReply {
   static const PacketType kType = PacketType::kInitReply;
-  using Hash = ssf::crypto::Sha1;
+  using Digest = ssf::crypto::Sha256::Digest;
   enum Status { kInitializationFailed = 0, kInitializationSucceeded };
 
-  InitReply() : req(), status(kInitializationFailed) {}
+  // Digests fitting in a packet
+  enum : uint32_t { kMaxChunkDigests = 512 };
+
+  InitReply()
+      : protocol_version(0),
+        req(),
+        start_offset(0),
+        chunk_size(0),
+        status(kInitializationFailed) {}
 
   InitReply(const InitRequest& i_req, uint64_t i_start_offset,
-            const ssf::crypto::Sha1::Digest& i_current_filehash,
+            uint64_t i_chunk_size, const std::vector<Digest>& i_chunk_digests,
             Status i_status)
-      : req(i_req),
+      : protocol_version(kCopyProtocolVersion),
+        req(i_req),
         start_offset(i_start_offset),
-        current_filehash(i_current_filehash),
+        chunk_size(i_chunk_size),
+        chunk_digests(i_chunk_digests),
         status(i_status) {}
 
+  uint32_t protocol_version;
   InitRequest req;
+  // size of the output file available to resume the copy
   uint64_t start_offset;
-  Hash::Digest current_filehash;
+  // digests of the chunks of chunk_size bytes before start_offset
+  uint64_t chunk_size;
+  std::vector<Digest> chunk_digests;
   Status status;
 
-  MSGPACK_DEFINE(req, start_offset, current_filehash, status)
+  MSGPACK_DEFINE(protocol_version, req, start_offset, chunk_size,
+                 chunk_digests, status)
+};
+
+struct StartTransfer {
+  static const PacketType kType = PacketType::kStartTransfer;
+
+  StartTransfer() : start_offset(0) {}
+
+  StartTransfer(uint64_t i_start_offset) : start_offset(i_start_offset) {}
+
+  // offset of the first data sent
+  uint64_t start_offset;
+
+  MSGPACK_DEFINE(start_offset)
 };
 
 }  // copy
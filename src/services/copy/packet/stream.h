@@ -0,0 +1,114 @@
+#ifndef SSF_SERVICES_COPY_PACKET_STREAM_H_
+#define SSF_SERVICES_COPY_PACKET_STREAM_H_
+
+#include <cstdint>
+
+#include <string>
+
+#include <msgpack.hpp>
+
+#include "common/crypto/sha256.h"
+#include "services/copy/packet.h"
+#include "services/copy/packet/error_code.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+// A streamed copy sends every file on a single session:
+//   StreamManifest, then for each file
+//   StreamFileHeader, Data..., StreamFileTrailer
+// The receiver acknowledges each file (StreamFileAck) once it is written
+// without stopping the sender.
+
+struct StreamManifest {
+  static const PacketType kType = PacketType::kStreamManifest;
+
+  StreamManifest()
+      : check_file_integrity(false), files_count(0), total_size(0) {}
+
+  StreamManifest(bool i_check_file_integrity, const std::string& i_output_dir,
+                 uint64_t i_files_count, uint64_t i_total_size)
+      : check_file_integrity(i_check_file_integrity),
+        output_dir(i_output_dir),
+        files_count(i_files_count),
+        total_size(i_total_size) {}
+
+  bool check_file_integrity;
+  std::string output_dir;
+  uint64_t files_count;
+  uint64_t total_size;
+
+  MSGPACK_DEFINE(check_file_integrity, output_dir, files_count, total_size)
+};
+
+struct StreamEntry {
+  StreamEntry() : filesize(0) {}
+
+  StreamEntry(const std::string& i_input_filepath,
+              const std::string& i_output_filename, uint64_t i_filesize)
+      : input_filepath(i_input_filepath),
+        output_filename(i_output_filename),
+        filesize(i_filesize) {}
+
+  std::string input_filepath;
+  // output file path relative to the output directory of the manifest
+  std::string output_filename;
+  uint64_t filesize;
+
+  MSGPACK_DEFINE(input_filepath, output_filename, filesize)
+};
+
+struct StreamFileHeader {
+  static const PacketType kType = PacketType::kStreamFileHeader;
+
+  StreamFileHeader() : index(0), entry() {}
+
+  StreamFileHeader(uint64_t i_index, const StreamEntry& i_entry)
+      : index(i_index), entry(i_entry) {}
+
+  uint64_t index;
+  StreamEntry entry;
+
+  MSGPACK_DEFINE(index, entry)
+};
+
+struct StreamFileTrailer {
+  static const PacketType kType = PacketType::kStreamFileTrailer;
+  using Digest = ssf::crypto::Sha256::Digest;
+
+  StreamFileTrailer()
+      : index(0), error_code(ErrorCode::kUnknown), file_digest({{0}}) {}
+
+  StreamFileTrailer(uint64_t i_index, ErrorCode i_error_code,
+                    const Digest& i_file_digest)
+      : index(i_index), error_code(i_error_code), file_digest(i_file_digest) {}
+
+  uint64_t index;
+  // status of the file on the sender side
+  ErrorCode error_code;
+  // root digest of the chunks of the file (integrity check only)
+  Digest file_digest;
+
+  MSGPACK_DEFINE(index, error_code, file_digest)
+};
+
+struct StreamFileAck {
+  static const PacketType kType = PacketType::kStreamFileAck;
+
+  StreamFileAck() : index(0), error_code(ErrorCode::kUnknown) {}
+
+  StreamFileAck(uint64_t i_index, ErrorCode i_error_code)
+      : index(i_index), error_code(i_error_code) {}
+
+  uint64_t index;
+  ErrorCode error_code;
+
+  MSGPACK_DEFINE(index, error_code)
+};
+
+}  // copy
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_COPY_PACKET_STREAM_H_
@@ -118,6 +118,36 @@ void PacketToPayload(const Packet& packet, Payload& payload,
   }
 }
 
+/// Get the protocol version of an InitRequest or InitReply packet
+/**
+* The version is the first field of the packets since version 2. The
+* packets of version 1 start with a string (InitRequest) or an array
+* (InitReply).
+*
+* @return the version, 0 if the packet is not a msgpack array
+*/
+inline uint32_t GetProtocolVersion(const Packet& packet) {
+  try {
+    auto obj_handle =
+        msgpack::unpack(packet.buffer().data(), packet.payload_size());
+    auto obj = obj_handle.get();
+    if (obj.type != msgpack::type::ARRAY) {
+      return 0;
+    }
+    if (obj.via.array.size == 0 ||
+        obj.via.array.ptr[0].type != msgpack::type::POSITIVE_INTEGER) {
+      return 1;
+    }
+    return obj.via.array.ptr[0].as<uint32_t>();
+  } catch (const std::exception& e) {
+    (void)(e);
+    SSF_LOG("microservice", debug,
+            "[copy][packet_helper] could not read protocol version {}",
+            e.what());
+    return 0;
+  }
+}
+
 }  // copy
 }  // services
 }  // ssf
@@ -8,6 +8,8 @@
 #include "common/error/error.h"
 
 #include "services/copy/i_copy_state.h"
+#include "services/copy/packet/init.h"
+#include "services/copy/packet_helper.h"
 #include "services/copy/state/on_abort.h"
 #include "services/copy/state/receiver/abort_receiver_state.h"
 #include "services/copy/state/receiver/send_eof_state.h"
@@ -24,7 +26,7 @@ class ReceiveFileState : ICopyState {
   }
 
  private:
-  ReceiveFileState() : ICopyState() {}
+  ReceiveFileState() : ICopyState(), started_(false), closing_(false) {}
 
  public:
   // ICopyState
@@ -34,32 +36,46 @@ class ReceiveFileState : ICopyState {
 
   bool FillOutboundPacket(CopyContext* context, Packet* packet,
                           boost::system::error_code& ec) {
+    if (!closing_ || !context->output->closed()) {
+      return false;
+    }
+
+    if (context->output->error()) {
+      SSF_LOG("microservice", debug, "[copy][receive_file] write failed");
+      context->SetState(
+          AbortReceiverState::Create(ErrorCode::kOutputFileWriteError));
+      return false;
+    }
+
+    context->SetState(SendEofState::Create());
     return false;
   }
 
   void ProcessInboundPacket(CopyContext* context, const Packet& packet,
                             boost::system::error_code& ec) {
     switch (packet.type()) {
+      case PacketType::kStartTransfer: {
+        return OnStartTransfer(context, packet);
+      }
       case PacketType::kEof: {
         SSF_LOG("microservice", debug, "[copy][receive_file] eof");
-        context->output.close();
-
-        context->SetState(SendEofState::Create());
+        // Send eof once the output file is written and closed
+        closing_ = true;
+        context->output->AsyncClose(context->io_ready_handler());
         break;
       }
       case PacketType::kData: {
-        try {
-          // write data into output file
-          context->output.write(packet.buffer().data(), packet.payload_size());
-        } catch (const std::exception&) {
+        if (!started_) {
           SSF_LOG("microservice", debug,
-                  "[copy][receive_file] error while "
-                  "writing to output file");
-          context->SetState(
-              AbortReceiverState::Create(ErrorCode::kOutputFileWriteError));
+                  "[copy][receive_file] data before transfer start");
+          context->SetState(AbortReceiverState::Create(
+              ErrorCode::kInboundPacketNotSupported));
           return;
         }
-        if (!context->output.good()) {
+        boost::system::error_code write_ec;
+        context->output->Write(packet.buffer().data(), packet.payload_size(),
+                               write_ec);
+        if (write_ec) {
           SSF_LOG("microservice", debug, "[copy][receive_file] write failed");
           context->SetState(
               AbortReceiverState::Create(ErrorCode::kOutputFileWriteError));
@@ -81,6 +97,56 @@ class ReceiveFileState : ICopyState {
   }
 
   bool IsTerminal(CopyContext* context) { return false; }
+
+ private:
+  // Restart the output file at the offset chosen by the sender
+  void OnStartTransfer(CopyContext* context, const Packet& packet) {
+    StartTransfer start;
+    boost::system::error_code convert_ec;
+    PacketToPayload(packet, start, convert_ec);
+    if (convert_ec || started_ ||
+        start.start_offset > context->start_offset ||
+        start.start_offset % FileManifest::kChunkSize != 0) {
+      SSF_LOG("microservice", debug,
+              "[copy][receive_file] invalid transfer start");
+      context->SetState(AbortReceiverState::Create(
+          ErrorCode::kResumeFileTransferNotPermitted));
+      return;
+    }
+
+    if (start.start_offset < context->start_offset) {
+      SSF_LOG("microservice", debug,
+              "[copy][receive_file] output file differs from byte index {}",
+              start.start_offset);
+    }
+
+    boost::system::error_code resize_ec;
+    if (context->resume) {
+      context->fs.ResizeFile(context->GetOutputFilepath(), start.start_offset,
+                             resize_ec);
+    }
+    if (!resize_ec) {
+      context->output->Seek(start.start_offset, resize_ec);
+    }
+    if (resize_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][receive_file] cannot restart output file at byte "
+              "index {}",
+              start.start_offset);
+      context->SetState(
+          AbortReceiverState::Create(ErrorCode::kOutputFileWriteError));
+      return;
+    }
+
+    context->start_offset = start.start_offset;
+    context->manifest.Truncate(static_cast<std::size_t>(
+        start.start_offset / FileManifest::kChunkSize));
+    started_ = true;
+  }
+
+ private:
+  bool started_;
+  bool closing_;
 };
 
 }  // copy
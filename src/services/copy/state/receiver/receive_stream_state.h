@@ -0,0 +1,243 @@
+#ifndef SSF_SERVICES_COPY_STATE_RECEIVER_RECEIVE_STREAM_STATE_H_
+#define SSF_SERVICES_COPY_STATE_RECEIVER_RECEIVE_STREAM_STATE_H_
+
+#include <cstdint>
+
+#include <deque>
+
+#include <msgpack.hpp>
+
+#include <ssf/log/log.h>
+
+#include "common/error/error.h"
+#include "common/filesystem/path.h"
+
+#include "services/copy/file_hasher.h"
+#include "services/copy/i_copy_state.h"
+#include "services/copy/packet/stream.h"
+#include "services/copy/packet_helper.h"
+#include "services/copy/state/on_abort.h"
+#include "services/copy/state/receiver/abort_receiver_state.h"
+#include "services/copy/state/receiver/wait_close_state.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+/// Receive the files of a stream
+/**
+* The output files are created as their headers arrive. A file is
+* acknowledged once it is written and closed, while the next files are
+* received.
+*/
+class ReceiveStreamState : ICopyState {
+ public:
+  template <typename... Args>
+  static ICopyStateUPtr Create(Args&&... args) {
+    return ICopyStateUPtr(new ReceiveStreamState(std::forward<Args>(args)...));
+  }
+
+ private:
+  struct Record {
+    FileWriterPtr output;
+    StreamFileTrailer::Digest file_digest;
+    ErrorCode error_code;
+    bool ended;
+  };
+
+ private:
+  ReceiveStreamState(uint64_t files_count)
+      : ICopyState(), files_count_(files_count), records_() {}
+
+ public:
+  // ICopyState
+  void Enter(CopyContext* context, boost::system::error_code& ec) {
+    SSF_LOG("microservice", trace, "[copy][receive_stream] enter");
+  }
+
+  void Exit(CopyContext* context, boost::system::error_code& ec) {
+    for (auto& record : records_) {
+      if (record.output) {
+        record.output->Close();
+      }
+    }
+  }
+
+  bool FillOutboundPacket(CopyContext* context, Packet* packet,
+                          boost::system::error_code& ec) {
+    if (records_.empty() || !records_.front().ended ||
+        (records_.front().output && !records_.front().output->closed())) {
+      return false;
+    }
+
+    auto record = std::move(records_.front());
+    records_.pop_front();
+
+    auto error_code = record.error_code;
+    if (error_code == ErrorCode::kSuccess && record.output->error()) {
+      error_code = ErrorCode::kOutputFileWriteError;
+    }
+    if (error_code == ErrorCode::kSuccess && context->check_file_integrity &&
+        FileManifest(record.output->chunk_digests()).Root() !=
+            record.file_digest) {
+      error_code = ErrorCode::kOutputFileCorrupted;
+    }
+
+    StreamFileAck ack(context->stream_acked, error_code);
+    boost::system::error_code convert_ec;
+    PayloadToPacket(ack, packet, convert_ec);
+    if (convert_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][receive_stream] cannot convert file ack to packet");
+      context->SetState(
+          AbortReceiverState::Create(ErrorCode::kOutboundPacketNotGenerated));
+      return false;
+    }
+
+    context->NotifyStreamFileCopied({error_code, get_copy_category()});
+
+    if (context->stream_acked == files_count_) {
+      context->error_code = ErrorCode::kSuccess;
+      context->SetState(WaitCloseState::Create());
+    }
+
+    return true;
+  }
+
+  void ProcessInboundPacket(CopyContext* context, const Packet& packet,
+                            boost::system::error_code& ec) {
+    switch (packet.type()) {
+      case PacketType::kStreamFileHeader: {
+        return OnFileHeader(context, packet);
+      }
+      case PacketType::kData: {
+        if (records_.empty() || records_.back().ended) {
+          SSF_LOG("microservice", debug,
+                  "[copy][receive_stream] data out of a file");
+          context->SetState(AbortReceiverState::Create(
+              ErrorCode::kInboundPacketNotSupported));
+          return;
+        }
+        auto& record = records_.back();
+        if (record.error_code != ErrorCode::kSuccess) {
+          // the file is skipped
+          return;
+        }
+        boost::system::error_code write_ec;
+        record.output->Write(packet.buffer().data(), packet.payload_size(),
+                             write_ec);
+        if (write_ec) {
+          SSF_LOG("microservice", debug,
+                  "[copy][receive_stream] write failed {}",
+                  context->GetOutputFilepath().GetString());
+          record.error_code = ErrorCode::kOutputFileWriteError;
+        }
+        return;
+      }
+      case PacketType::kStreamFileTrailer: {
+        return OnFileTrailer(context, packet);
+      }
+      case PacketType::kAbort: {
+        return OnReceiverAbortPacket(context, packet, ec);
+      }
+      default: {
+        SSF_LOG("microservice", debug,
+                "[copy][receive_stream] cannot process inbound packet");
+        context->SetState(
+            AbortReceiverState::Create(ErrorCode::kInboundPacketNotSupported));
+        return;
+      }
+    };
+  }
+
+  bool IsTerminal(CopyContext* context) { return false; }
+
+ private:
+  void OnFileHeader(CopyContext* context, const Packet& packet) {
+    StreamFileHeader header;
+    boost::system::error_code convert_ec;
+    PacketToPayload(packet, header, convert_ec);
+    if (convert_ec || header.index != context->stream_entries.size() ||
+        header.index >= files_count_ ||
+        (!records_.empty() && !records_.back().ended)) {
+      SSF_LOG("microservice", debug,
+              "[copy][receive_stream] invalid file header");
+      context->SetState(
+          AbortReceiverState::Create(ErrorCode::kInboundPacketNotSupported));
+      return;
+    }
+
+    boost::system::error_code fs_ec;
+    ssf::Path output_path(context->output_dir);
+    output_path /= header.entry.output_filename;
+    if (context->fs.IsDirectory(output_path, fs_ec)) {
+      // copy the input file in the output directory
+      output_path /= Path(header.entry.input_filepath).GetFilename();
+      header.entry.output_filename =
+          (Path(header.entry.output_filename) /
+           Path(header.entry.input_filepath).GetFilename())
+              .GetString();
+    }
+    context->stream_entries.push_back(header.entry);
+    context->SelectStreamEntry(static_cast<std::size_t>(header.index));
+
+    Record record{nullptr, {{0}}, ErrorCode::kSuccess, false};
+    fs_ec.clear();
+    context->fs.MakeDirectories(output_path.GetParent(), fs_ec);
+    boost::system::error_code open_ec;
+    record.output = FileWriter::Open(
+        context->io_service_, output_path.GetString(),
+        std::ofstream::out | std::ofstream::binary | std::ofstream::trunc,
+        context->check_file_integrity, open_ec);
+    if (open_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][receive_stream] cannot open output file {}",
+              output_path.GetString());
+      record.error_code = ErrorCode::kOutputFileNotAvailable;
+    } else {
+      // the session stops reading while the file is behind
+      context->output = record.output;
+    }
+    records_.push_back(std::move(record));
+  }
+
+  void OnFileTrailer(CopyContext* context, const Packet& packet) {
+    StreamFileTrailer trailer;
+    boost::system::error_code convert_ec;
+    PacketToPayload(packet, trailer, convert_ec);
+    if (convert_ec || records_.empty() || records_.back().ended ||
+        trailer.index != context->stream_entries.size() - 1) {
+      SSF_LOG("microservice", debug,
+              "[copy][receive_stream] invalid file trailer");
+      context->SetState(
+          AbortReceiverState::Create(ErrorCode::kInboundPacketNotSupported));
+      return;
+    }
+
+    auto& record = records_.back();
+    record.ended = true;
+    record.file_digest = trailer.file_digest;
+    if (record.error_code == ErrorCode::kSuccess) {
+      // error on the sender side
+      record.error_code = trailer.error_code;
+    }
+
+    if (record.output) {
+      // Acknowledge the file once it is written and closed
+      record.output->AsyncClose(context->io_ready_handler());
+    } else {
+      context->io_service_.post(context->io_ready_handler());
+    }
+  }
+
+ private:
+  uint64_t files_count_;
+  // files received but not acknowledged yet
+  std::deque<Record> records_;
+};
+
+}  // copy
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_COPY_STATE_RECEIVER_RECEIVE_STREAM_STATE_H_
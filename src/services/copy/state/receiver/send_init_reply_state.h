@@ -6,9 +6,9 @@
 
 #include <ssf/log/log.h>
 
-#include "common/crypto/hash.h"
 #include "common/error/error.h"
 
+#include "services/copy/file_hasher.h"
 #include "services/copy/i_copy_state.h"
 #include "services/copy/state/on_abort.h"
 #include "services/copy/state/receiver/abort_receiver_state.h"
@@ -26,7 +26,7 @@ class SendInitReplyState : ICopyState {
   }
 
  private:
-  SendInitReplyState() : ICopyState() {}
+  SendInitReplyState() : ICopyState(), hash_started_(false), p_hasher_() {}
 
  public:
   // ICopyState
@@ -34,37 +34,57 @@ class SendInitReplyState : ICopyState {
     SSF_LOG("microservice", trace, "[copy][send_init_reply] enter");
   }
 
+  void Exit(CopyContext* context, boost::system::error_code& ec) override {
+    if (p_hasher_) {
+      p_hasher_->Cancel();
+    }
+  }
+
   bool FillOutboundPacket(CopyContext* context, Packet* packet,
                           boost::system::error_code& ec) override {
+    if (context->resume && !hash_started_) {
+      hash_started_ = true;
+      StartHashOutputFile(context);
+    }
+    if (p_hasher_ && !p_hasher_->done()) {
+      // filled again once the output file is hashed
+      return false;
+    }
+
     InitRequest req(context->GetInputFilepath().GetString(),
                     context->check_file_integrity,
                     context->is_stdin_input, context->resume, context->filesize,
                     context->output_dir, context->output_filename);
 
-    auto& output_fh = context->output;
-    InitReply::Hash::Digest file_digest = {{0}};
-    if (context->resume) {
-      output_fh.seekp(0, std::ofstream::end);
+    uint64_t chunk_size = FileManifest::kChunkSize;
+    FileManifest::Digests chunk_digests;
+    context->start_offset = 0;
+    context->manifest.Clear();
+    if (p_hasher_ && !p_hasher_->error()) {
+      context->manifest = p_hasher_->manifest();
+      context->start_offset =
+          context->manifest.size() * FileManifest::kChunkSize;
+
+      // send one digest per group of chunks to fit in the packet
+      auto group_size =
+          (context->manifest.size() + InitReply::kMaxChunkDigests - 1) /
+          InitReply::kMaxChunkDigests;
+      if (group_size > 0) {
+        chunk_size *= group_size;
+        chunk_digests = context->manifest.GroupDigests(group_size);
+      }
       SSF_LOG("microservice", debug,
               "[copy][send_init_reply] resume file "
               "transfer at byte index {}",
-              output_fh.tellp());
-
-      boost::system::error_code hash_ec;
-      file_digest = ssf::crypto::HashFile<InitReply::Hash>(
-          context->GetOutputFilepath(), hash_ec);
-      if (!hash_ec) {
-        context->start_offset = output_fh.tellp();
-      } else {
-        SSF_LOG("microservice", debug,
-                "[copy][send_init_reply] could not "
-                "generate digest for "
-                "output_file. Do not resume file copy");
-        context->start_offset = 0;
-      }
+              context->start_offset);
+    } else if (p_hasher_) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_init_reply] could not "
+              "generate digest for "
+              "output_file. Do not resume file copy");
     }
 
-    InitReply rep(req, context->start_offset, file_digest,
+    InitReply rep(req, context->start_offset, chunk_size, chunk_digests,
                   InitReply::Status::kInitializationSucceeded);
 
     boost::system::error_code convert_ec;
@@ -94,6 +114,28 @@ class SendInitReplyState : ICopyState {
   }
 
   bool IsTerminal(CopyContext* context) override { return false; }
+
+ private:
+  // Hash the full chunks of the output file on the file I/O pool
+  void StartHashOutputFile(CopyContext* context) {
+    boost::system::error_code fs_ec;
+    auto filesize =
+        context->fs.GetFilesize(context->GetOutputFilepath(), fs_ec);
+    if (fs_ec) {
+      return;
+    }
+    filesize -= filesize % FileManifest::kChunkSize;
+    if (filesize == 0) {
+      return;
+    }
+    p_hasher_ = FileHasher::Start(context->io_service_,
+                                  context->GetOutputFilepath(), filesize,
+                                  context->io_ready_handler());
+  }
+
+ private:
+  bool hash_started_;
+  FileHasherPtr p_hasher_;
 };
 
 }  // copy
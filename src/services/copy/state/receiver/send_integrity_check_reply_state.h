@@ -9,7 +9,7 @@
 
 #include "common/error/error.h"
 
-#include "common/crypto/hash.h"
+#include "services/copy/file_hasher.h"
 #include "services/copy/i_copy_state.h"
 #include "services/copy/packet/check.h"
 #include "services/copy/packet_helper.h"
@@ -40,9 +40,11 @@ class SendIntegrityCheckReplyState : ICopyState {
 
   bool FillOutboundPacket(CopyContext* context, Packet* packet,
                           boost::system::error_code& ec) {
-    boost::system::error_code hash_ec;
-    context->output_file_digest = ssf::crypto::HashFile<CopyContext::Hash>(
-        context->GetOutputFilepath().GetString(), hash_ec);
+    // the chunks were hashed while they were written
+    boost::system::error_code hash_ec = context->output->error();
+    FileManifest manifest(context->manifest);
+    manifest.Append(context->output->chunk_digests());
+    context->output_file_digest = manifest.Root();
 
     CheckIntegrityRequest<CopyContext::Hash> req(context->input_file_digest);
 
@@ -10,10 +10,13 @@
 
 #include "services/copy/i_copy_state.h"
 #include "services/copy/packet/init.h"
+#include "services/copy/packet/stream.h"
 #include "services/copy/packet_helper.h"
 #include "services/copy/state/on_abort.h"
 #include "services/copy/state/receiver/abort_receiver_state.h"
+#include "services/copy/state/receiver/receive_stream_state.h"
 #include "services/copy/state/receiver/send_init_reply_state.h"
+#include "services/copy/state/receiver/wait_close_state.h"
 
 namespace ssf {
 namespace services {
@@ -47,6 +50,10 @@ class WaitInitRequestState : ICopyState {
       return OnReceiverAbortPacket(context, packet, ec);
     }
 
+    if (packet.type() == PacketType::kStreamManifest) {
+      return OnStreamManifest(context, packet);
+    }
+
     if (packet.type() != PacketType::kInitRequest) {
       SSF_LOG("microservice", debug,
               "[copy][wait_init_request] cannot "
@@ -57,6 +64,18 @@ class WaitInitRequestState : ICopyState {
       return;
     }
 
+    // a sender of another protocol version would misread the reply
+    auto protocol_version = GetProtocolVersion(packet);
+    if (protocol_version != kCopyProtocolVersion) {
+      SSF_LOG("microservice", warn,
+              "[copy][wait_init_request] copy protocol version {} not "
+              "supported (expected {})",
+              protocol_version, static_cast<uint32_t>(kCopyProtocolVersion));
+      context->SetState(AbortReceiverState::Create(
+          ErrorCode::kCopyProtocolVersionNotSupported));
+      return;
+    }
+
     // create InitRequest struct from payload
     boost::system::error_code convert_ec;
     InitRequest init_req;
@@ -115,8 +134,6 @@ class WaitInitRequestState : ICopyState {
           AbortReceiverState::Create(ErrorCode::kOutputFileDirectoryNotFound));
     }
 
-    auto& output_fh = context->output;
-
     std::ios_base::openmode open_flags =
         std::ofstream::out | std::ofstream::binary;
     if (context->fs.IsFile(context->GetOutputFilepath(), fs_ec)) {
@@ -125,12 +142,13 @@ class WaitInitRequestState : ICopyState {
     if (!context->resume) {
       // trunc file
       open_flags |= std::ofstream::trunc;
-    } else {
-      // seek to the end of stream
-      open_flags |= std::ofstream::ate;
     }
-    output_fh.open(context->GetOutputFilepath().GetString(), open_flags);
-    if (!output_fh.is_open()) {
+    boost::system::error_code open_ec;
+    context->output =
+        FileWriter::Open(context->io_service_,
+                         context->GetOutputFilepath().GetString(), open_flags,
+                         context->check_file_integrity, open_ec);
+    if (open_ec) {
       SSF_LOG("microservice", debug,
               "[copy][wait_init_request] cannot open output file {}",
               context->GetOutputFilepath().GetString());
@@ -143,6 +161,47 @@ class WaitInitRequestState : ICopyState {
   }
 
   bool IsTerminal(CopyContext* context) { return false; }
+
+ private:
+  // Receive every file on this session
+  void OnStreamManifest(CopyContext* context, const Packet& packet) {
+    boost::system::error_code convert_ec;
+    StreamManifest manifest;
+    PacketToPayload(packet, manifest, convert_ec);
+    if (convert_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][wait_init_request] cannot "
+              "convert packet to stream manifest");
+      context->SetState(
+          AbortReceiverState::Create(ErrorCode::kInitRequestPacketCorrupted));
+      return;
+    }
+
+    boost::system::error_code fs_ec;
+    if (!context->fs.IsDirectory(manifest.output_dir, fs_ec)) {
+      SSF_LOG("microservice", debug,
+              "[copy][wait_init_request] output directory {} not found",
+              manifest.output_dir);
+      context->SetState(
+          AbortReceiverState::Create(ErrorCode::kOutputDirectoryNotFound));
+      return;
+    }
+
+    SSF_LOG("microservice", debug,
+            "[copy][wait_init_request] receive stream of {} files ({}b)",
+            manifest.files_count, manifest.total_size);
+    context->Init("", "", manifest.check_file_integrity, false, 0, false, 0,
+                  manifest.output_dir, "");
+    context->is_stream = true;
+
+    if (manifest.files_count == 0) {
+      context->error_code = ErrorCode::kSuccess;
+      context->SetState(WaitCloseState::Create());
+      return;
+    }
+
+    context->SetState(ReceiveStreamState::Create(manifest.files_count));
+  }
 };
 
 }  // copy
@@ -1,7 +1,7 @@
 #ifndef SSF_SERVICES_COPY_STATE_SENDER_SEND_FILE_STATE_H_
 #define SSF_SERVICES_COPY_STATE_SENDER_SEND_FILE_STATE_H_
 
-#include <iostream>
+#include <boost/asio/error.hpp>
 
 #include <msgpack.hpp>
 
@@ -11,6 +11,7 @@
 
 #include "services/copy/i_copy_state.h"
 #include "services/copy/packet/init.h"
+#include "services/copy/packet_helper.h"
 #include "services/copy/state/on_abort.h"
 #include "services/copy/state/sender/abort_sender_state.h"
 #include "services/copy/state/sender/wait_eof_state.h"
@@ -27,7 +28,7 @@ class SendFileState : ICopyState {
   }
 
  private:
-  SendFileState() : ICopyState() {}
+  SendFileState() : ICopyState(), started_(false) {}
 
  public:
   // ICopyState
@@ -37,21 +38,22 @@ class SendFileState : ICopyState {
 
   bool FillOutboundPacket(CopyContext* context, Packet* packet,
                           boost::system::error_code& ec) {
-    auto& input = context->is_stdin_input ? std::cin : context->input;
-
-    if (input.good()) {
-      try {
-        input.read(packet->buffer().data(), packet->buffer().size());
-      } catch (const std::exception&) {
-        SSF_LOG("microservice", debug, "[copy][send_file] error while reading input file");
-        context->SetState(
-            AbortSenderState::Create(ErrorCode::kInputFileReadError));
-        return false;
-      }
+    if (!started_) {
+      return FillStartTransferPacket(context, packet);
+    }
+
+    boost::system::error_code read_ec;
+    auto length = context->input->Read(packet->buffer().data(),
+                                       packet->buffer().size(), read_ec);
+    if (!read_ec) {
       packet->set_type(PacketType::kData);
-      packet->set_payload_size(static_cast<uint32_t>(input.gcount()));
+      packet->set_payload_size(static_cast<uint32_t>(length));
       return true;
-    } else if (input.eof()) {
+    } else if (read_ec == boost::asio::error::would_block) {
+      // The packet is filled again once the next chunk is read
+      context->input->AsyncWaitReady(context->io_ready_handler());
+      return false;
+    } else if (read_ec == boost::asio::error::eof) {
       packet->set_type(PacketType::kEof);
       packet->set_payload_size(0);
       context->SetState(WaitEofState::Create());
@@ -77,6 +79,27 @@ class SendFileState : ICopyState {
   }
 
   bool IsTerminal(CopyContext* context) { return false; }
+
+ private:
+  // Tell the receiver where the data starts
+  bool FillStartTransferPacket(CopyContext* context, Packet* packet) {
+    StartTransfer start(context->start_offset);
+    boost::system::error_code convert_ec;
+    PayloadToPacket(start, packet, convert_ec);
+    if (convert_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_file] cannot convert transfer start to packet");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kInitRequestPacketNotGenerated));
+      return false;
+    }
+
+    started_ = true;
+    return true;
+  }
+
+ private:
+  bool started_;
 };
 
 }  // copy
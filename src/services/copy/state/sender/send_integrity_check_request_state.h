@@ -7,9 +7,9 @@
 
 #include <ssf/log/log.h>
 
-#include "common/crypto/hash.h"
 #include "common/error/error.h"
 
+#include "services/copy/file_hasher.h"
 #include "services/copy/i_copy_state.h"
 #include "services/copy/packet/check.h"
 #include "services/copy/state/on_abort.h"
@@ -39,18 +39,10 @@ class SendIntegrityCheckRequestState : ICopyState {
 
   bool FillOutboundPacket(CopyContext* context, Packet* packet,
                           boost::system::error_code& ec) {
-    boost::system::error_code hash_ec;
-
-    auto digest = ssf::crypto::HashFile<CopyContext::Hash>(
-        context->GetInputFilepath(), hash_ec);
-    if (hash_ec) {
-      SSF_LOG("microservice", debug,
-              "[copy][send_integrity_check_request] "
-              "cannot generate input file digest");
-      context->SetState(
-          AbortSenderState::Create(ErrorCode::kInputFileDigestNotAvailable));
-      return false;
-    }
+    // the chunks were hashed while they were read
+    FileManifest manifest(context->manifest);
+    manifest.Append(context->input->chunk_digests());
+    auto digest = manifest.Root();
 
     CheckIntegrityRequest<CopyContext::Hash> req(digest);
     boost::system::error_code convert_ec;
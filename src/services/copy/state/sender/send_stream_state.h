@@ -0,0 +1,231 @@
+#ifndef SSF_SERVICES_COPY_STATE_SENDER_SEND_STREAM_STATE_H_
+#define SSF_SERVICES_COPY_STATE_SENDER_SEND_STREAM_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/asio/error.hpp>
+
+#include <msgpack.hpp>
+
+#include <ssf/log/log.h>
+
+#include "common/error/error.h"
+
+#include "services/copy/file_hasher.h"
+#include "services/copy/i_copy_state.h"
+#include "services/copy/packet/stream.h"
+#include "services/copy/packet_helper.h"
+#include "services/copy/state/on_abort.h"
+#include "services/copy/state/sender/abort_sender_state.h"
+#include "services/copy/state/sender/close_state.h"
+
+namespace ssf {
+namespace services {
+namespace copy {
+
+/// Send the files of the stream one after the other
+/**
+* The manifest of the stream is sent first. Then each file is sent as a
+* header, its data and a trailer without waiting for the receiver. The
+* receiver acknowledges the files in order; at most
+* kMaxPendingFiles files are sent ahead of the acknowledgements so that the
+* receiver does not buffer too many files being written.
+*/
+class SendStreamState : ICopyState {
+ public:
+  enum : std::size_t { kMaxPendingFiles = 8 };
+
+ public:
+  template <typename... Args>
+  static ICopyStateUPtr Create(Args&&... args) {
+    return ICopyStateUPtr(new SendStreamState(std::forward<Args>(args)...));
+  }
+
+ private:
+  SendStreamState()
+      : ICopyState(),
+        manifest_sent_(false),
+        index_(0),
+        header_sent_(false),
+        file_error_code_(ErrorCode::kSuccess) {}
+
+ public:
+  // ICopyState
+  void Enter(CopyContext* context, boost::system::error_code& ec) {
+    SSF_LOG("microservice", trace, "[copy][send_stream] enter");
+  }
+
+  bool FillOutboundPacket(CopyContext* context, Packet* packet,
+                          boost::system::error_code& ec) {
+    if (!manifest_sent_) {
+      return FillManifestPacket(context, packet);
+    }
+
+    if (!header_sent_) {
+      if (index_ == context->stream_entries.size() ||
+          index_ - context->stream_acked >= kMaxPendingFiles) {
+        // The packet is filled again once a file is acknowledged
+        return false;
+      }
+      return FillFileHeaderPacket(context, packet);
+    }
+
+    if (file_error_code_ == ErrorCode::kSuccess) {
+      boost::system::error_code read_ec;
+      auto length = context->input->Read(packet->buffer().data(),
+                                         packet->buffer().size(), read_ec);
+      if (!read_ec) {
+        packet->set_type(PacketType::kData);
+        packet->set_payload_size(static_cast<uint32_t>(length));
+        return true;
+      } else if (read_ec == boost::asio::error::would_block) {
+        // The packet is filled again once the next chunk is read
+        context->input->AsyncWaitReady(context->io_ready_handler());
+        return false;
+      } else if (read_ec != boost::asio::error::eof) {
+        SSF_LOG("microservice", debug,
+                "[copy][send_stream] cannot read input file {}",
+                context->GetInputFilepath().GetString());
+        file_error_code_ = ErrorCode::kInputFileReadError;
+      }
+    }
+
+    return FillFileTrailerPacket(context, packet);
+  }
+
+  void ProcessInboundPacket(CopyContext* context, const Packet& packet,
+                            boost::system::error_code& ec) {
+    if (packet.type() == PacketType::kAbort) {
+      return OnSenderAbortPacket(context, packet, ec);
+    }
+
+    if (packet.type() != PacketType::kStreamFileAck) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_stream] cannot process inbound packet");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kInboundPacketNotSupported));
+      return;
+    }
+
+    StreamFileAck ack;
+    boost::system::error_code convert_ec;
+    PacketToPayload(packet, ack, convert_ec);
+    // Files are acknowledged in order once their trailer is received
+    if (convert_ec || ack.index != context->stream_acked ||
+        ack.index >= index_) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_stream] invalid file acknowledgement");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kInboundPacketNotSupported));
+      return;
+    }
+
+    context->NotifyStreamFileCopied({ack.error_code, get_copy_category()});
+
+    if (context->stream_acked == context->stream_entries.size()) {
+      context->error_code = ErrorCode::kSuccess;
+      context->SetState(CloseState::Create());
+      return;
+    }
+
+    // The next file may be waiting for this acknowledgement
+    context->io_service_.post(context->io_ready_handler());
+  }
+
+  bool IsTerminal(CopyContext* context) { return false; }
+
+ private:
+  bool FillManifestPacket(CopyContext* context, Packet* packet) {
+    uint64_t total_size = 0;
+    for (const auto& entry : context->stream_entries) {
+      total_size += entry.filesize;
+    }
+
+    StreamManifest manifest(context->check_file_integrity, context->output_dir,
+                            context->stream_entries.size(), total_size);
+    boost::system::error_code convert_ec;
+    PayloadToPacket(manifest, packet, convert_ec);
+    if (convert_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_stream] cannot convert manifest to packet");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kInitRequestPacketNotGenerated));
+      return false;
+    }
+
+    manifest_sent_ = true;
+    return true;
+  }
+
+  bool FillFileHeaderPacket(CopyContext* context, Packet* packet) {
+    context->SelectStreamEntry(index_);
+
+    file_error_code_ = ErrorCode::kSuccess;
+    boost::system::error_code open_ec;
+    context->input = FileReader::Open(
+        context->io_service_, context->GetInputFilepath().GetString(), 0,
+        context->check_file_integrity, open_ec);
+    if (open_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_stream] cannot open input file {}",
+              context->GetInputFilepath().GetString());
+      file_error_code_ = ErrorCode::kInputFileNotAvailable;
+    }
+
+    StreamFileHeader header(index_, context->stream_entries[index_]);
+    boost::system::error_code convert_ec;
+    PayloadToPacket(header, packet, convert_ec);
+    if (convert_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_stream] cannot convert file header to packet");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kOutboundPacketNotGenerated));
+      return false;
+    }
+
+    header_sent_ = true;
+    return true;
+  }
+
+  bool FillFileTrailerPacket(CopyContext* context, Packet* packet) {
+    StreamFileTrailer::Digest digest = {{0}};
+    if (context->input) {
+      if (context->check_file_integrity &&
+          file_error_code_ == ErrorCode::kSuccess) {
+        // the chunks were hashed while they were read
+        digest = FileManifest(context->input->chunk_digests()).Root();
+      }
+      context->input->Close();
+      context->input.reset();
+    }
+
+    StreamFileTrailer trailer(index_, file_error_code_, digest);
+    boost::system::error_code convert_ec;
+    PayloadToPacket(trailer, packet, convert_ec);
+    if (convert_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][send_stream] cannot convert file trailer to packet");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kOutboundPacketNotGenerated));
+      return false;
+    }
+
+    ++index_;
+    header_sent_ = false;
+    return true;
+  }
+
+ private:
+  bool manifest_sent_;
+  // file being sent
+  std::size_t index_;
+  bool header_sent_;
+  ErrorCode file_error_code_;
+};
+
+}  // copy
+}  // services
+}  // ssf
+
+#endif  // SSF_SERVICES_COPY_STATE_SENDER_SEND_STREAM_STATE_H_
@@ -43,8 +43,8 @@ class WaitEofState : ICopyState {
 
   void ProcessInboundPacket(CopyContext* context, const Packet& packet,
                             boost::system::error_code& ec) {
-    if (context->input.good() && context->input.is_open()) {
-      context->input.close();
+    if (context->input) {
+      context->input->Close();
     }
 
     if (packet.type() == PacketType::kAbort) {
@@ -1,16 +1,19 @@
 #ifndef SSF_SERVICES_COPY_STATE_SENDER_WAIT_INIT_REPLY_STATE_H_
 #define SSF_SERVICES_COPY_STATE_SENDER_WAIT_INIT_REPLY_STATE_H_
 
-#include <iostream>
+#include <algorithm>
+#include <vector>
+
 #include <msgpack.hpp>
 
 #include <ssf/log/log.h>
 
-#include "common/crypto/hash.h"
 #include "common/error/error.h"
 
+#include "services/copy/file_hasher.h"
 #include "services/copy/i_copy_state.h"
-#include "services/copy/packet/check.h"
+#include "services/copy/packet/init.h"
+#include "services/copy/packet_helper.h"
 #include "services/copy/state/on_abort.h"
 #include "services/copy/state/sender/abort_sender_state.h"
 #include "services/copy/state/sender/send_file_state.h"
@@ -27,7 +30,12 @@ class WaitInitReplyState : ICopyState {
   }
 
  private:
-  WaitInitReplyState() : ICopyState() {}
+  WaitInitReplyState()
+      : ICopyState(),
+        resume_offset_(0),
+        group_size_(0),
+        remote_digests_(),
+        p_hasher_() {}
 
  public:
   // ICopyState
@@ -35,8 +43,51 @@ class WaitInitReplyState : ICopyState {
     SSF_LOG("microservice", trace, "[copy][wait_init_reply] enter");
   }
 
+  void Exit(CopyContext* context, boost::system::error_code& ec) override {
+    if (p_hasher_) {
+      p_hasher_->Cancel();
+    }
+  }
+
   bool FillOutboundPacket(CopyContext* context, Packet* packet,
                           boost::system::error_code& ec) override {
+    if (!p_hasher_ || !p_hasher_->done()) {
+      return false;
+    }
+
+    if (p_hasher_->error()) {
+      SSF_LOG("microservice", debug,
+              "[copy][wait_init_reply] cannot "
+              "generate input file hash");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kInputFileDigestNotAvailable));
+      return false;
+    }
+
+    // resume from the first chunk group which differs
+    auto manifest = p_hasher_->manifest();
+    auto local_digests = manifest.GroupDigests(group_size_);
+    std::size_t same_groups = 0;
+    while (same_groups < local_digests.size() &&
+           same_groups < remote_digests_.size() &&
+           local_digests[same_groups] == remote_digests_[same_groups]) {
+      ++same_groups;
+    }
+
+    context->start_offset =
+        std::min<uint64_t>(same_groups * group_size_ * FileManifest::kChunkSize,
+                           resume_offset_);
+    manifest.Truncate(static_cast<std::size_t>(context->start_offset /
+                                               FileManifest::kChunkSize));
+    context->manifest = manifest;
+    if (context->start_offset < resume_offset_) {
+      SSF_LOG("microservice", debug,
+              "[copy][wait_init_reply] input file and output "
+              "file differ from byte index {}",
+              context->start_offset);
+    }
+
+    StartTransfer(context);
     return false;
   }
 
@@ -54,6 +105,17 @@ class WaitInitReplyState : ICopyState {
       return;
     }
 
+    auto protocol_version = GetProtocolVersion(packet);
+    if (protocol_version != kCopyProtocolVersion) {
+      SSF_LOG("microservice", warn,
+              "[copy][wait_init_reply] copy protocol version {} not "
+              "supported (expected {})",
+              protocol_version, static_cast<uint32_t>(kCopyProtocolVersion));
+      context->SetState(AbortSenderState::Create(
+          ErrorCode::kCopyProtocolVersionNotSupported));
+      return;
+    }
+
     // create InitReply struct from payload
     InitReply init_rep;
 
@@ -81,35 +143,62 @@ class WaitInitReplyState : ICopyState {
     context->start_offset = 0;
     context->output_dir = init_rep.req.output_dir;
     context->output_filename = init_rep.req.output_filename;
-    if (init_rep.req.resume && init_rep.start_offset > 0) {
-      boost::system::error_code hash_ec;
-      auto digest = ssf::crypto::HashFile<CopyContext::Hash>(
-          context->GetInputFilepath(), init_rep.start_offset, hash_ec);
-      if (hash_ec) {
-        SSF_LOG("microservice", debug,
-                "[copy][wait_init_reply] cannot "
-                "generate input file hash");
-        context->SetState(
-            AbortSenderState::Create(ErrorCode::kInputFileDigestNotAvailable));
-        return;
-      }
+    if (init_rep.req.resume && init_rep.start_offset > 0 &&
+        !context->is_stdin_input) {
+      StartResume(context, init_rep);
+      return;
+    }
 
-      if (!std::equal(digest.begin(), digest.end(),
-                      init_rep.current_filehash.begin())) {
-        SSF_LOG("microservice", debug,
-                "[copy][wait_init_reply] input file and output "
-                "file are different");
-        context->SetState(AbortSenderState::Create(
-            ErrorCode::kResumeFileTransferNotPermitted));
-        return;
-      }
-      context->start_offset = init_rep.start_offset;
+    StartTransfer(context);
+  }
+
+  bool IsTerminal(CopyContext* context) override { return false; }
+
+ private:
+  // Hash the input file chunks which the output file already has on the
+  // file I/O pool before sending the rest
+  void StartResume(CopyContext* context, const InitReply& init_rep) {
+    if (init_rep.chunk_size == 0 ||
+        init_rep.chunk_size % FileManifest::kChunkSize != 0 ||
+        init_rep.start_offset % FileManifest::kChunkSize != 0) {
+      SSF_LOG("microservice", debug,
+              "[copy][wait_init_reply] invalid resume chunks");
+      context->SetState(AbortSenderState::Create(
+          ErrorCode::kResumeFileTransferNotPermitted));
+      return;
     }
 
+    boost::system::error_code fs_ec;
+    auto filesize =
+        context->fs.GetFilesize(context->GetInputFilepath(), fs_ec);
+    if (fs_ec) {
+      SSF_LOG("microservice", debug,
+              "[copy][wait_init_reply] cannot get input file size");
+      context->SetState(
+          AbortSenderState::Create(ErrorCode::kInputFileNotAvailable));
+      return;
+    }
+
+    resume_offset_ = init_rep.start_offset;
+    group_size_ = static_cast<std::size_t>(init_rep.chunk_size /
+                                           FileManifest::kChunkSize);
+    remote_digests_ = init_rep.chunk_digests;
+    p_hasher_ = FileHasher::Start(context->io_service_,
+                                  context->GetInputFilepath(),
+                                  std::min(filesize, resume_offset_),
+                                  context->io_ready_handler());
+  }
+
+  void StartTransfer(CopyContext* context) {
+    bool hash_chunks =
+        context->check_file_integrity && !context->is_stdin_input;
     if (!context->is_stdin_input) {
-      context->input.open(context->GetInputFilepath().GetString(),
-                          std::ifstream::binary | std::ifstream::in);
-      if (!context->input.is_open() || !context->input.good()) {
+      boost::system::error_code open_ec;
+      context->input =
+          FileReader::Open(context->io_service_,
+                           context->GetInputFilepath().GetString(),
+                           context->start_offset, hash_chunks, open_ec);
+      if (open_ec) {
         SSF_LOG("microservice", debug,
                 "[copy][wait_init_reply] cannot open input file {}",
                 context->GetInputFilepath().GetString());
@@ -117,13 +206,18 @@ class WaitInitReplyState : ICopyState {
             AbortSenderState::Create(ErrorCode::kInputFileNotAvailable));
         return;
       }
-      context->input.seekg(context->start_offset, std::ifstream::beg);
+    } else {
+      context->input = FileReader::OpenStdin(context->io_service_);
     }
 
     context->SetState(SendFileState::Create());
   }
 
-  bool IsTerminal(CopyContext* context) override { return false; }
+ private:
+  uint64_t resume_offset_;
+  std::size_t group_size_;
+  std::vector<InitReply::Digest> remote_digests_;
+  FileHasherPtr p_hasher_;
 };
 
 }  // copy
@@ -1,22 +1,43 @@
 #ifndef SSF_SERVICES_DATAGRAM_DATAGRAM_LINK_H_
 #define SSF_SERVICES_DATAGRAM_DATAGRAM_LINK_H_
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <type_traits>
+#include <vector>
 
 #include <boost/noncopyable.hpp>  // NOLINT
 
 #include <boost/asio/buffer.hpp>  // NOLINT
 #include <boost/asio/coroutine.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
 #include <boost/system/error_code.hpp>  // NOLINT
 
-#include <boost/asio/steady_timer.hpp>
+#include <ssf/network/udp_batch.h>
 
 #include "services/datagram/datagram_link_operator.h"
+#include "services/datagram/datagram_ring.h"
+#include "services/datagram/flow_limits.h"
 
 namespace ssf {
+namespace detail {
+
+/// Sockets read and written by batches of datagrams (see UdpReceiveBatch)
+template <class Socket>
+struct IsBatchSocket : std::false_type {};
+
+#if defined(SSF_UDP_BATCH)
+template <>
+struct IsBatchSocket<boost::asio::ip::udp::socket> : std::true_type {};
+#endif
+
+}  // detail
+
 //-----------------------------------------------------------------------------
 
 /// Asynchronous Full Duplex Datagram Forwarder
@@ -26,12 +47,6 @@ struct DatagramLink : public std::enable_shared_from_this<
                           DatagramLink<RemoteEndpointRight, RightEndSocket,
                                        RemoteEndpointLeft, LeftEndSocket>> {
  private:
-  template <class T>
-  struct make_queue {
-    typedef std::queue<T> type;
-    typedef T value_type;
-  };
-
   using DatagramLinkPtr = std::shared_ptr<DatagramLink>;
 
   /// Types for the DatagramLink manager
@@ -40,31 +55,48 @@ struct DatagramLink : public std::enable_shared_from_this<
                            RemoteEndpointLeft, LeftEndSocket>;
   using DatagramLinkOperatorSpecPtr = std::shared_ptr<DatagramLinkOperatorSpec>;
 
-  using Datagram = std::vector<uint8_t>;
-  using DatagramQueue = typename make_queue<Datagram>::type;
+  using LeftBatch = detail::IsBatchSocket<LeftEndSocket>;
+
+ public:
+  using Clock = std::chrono::steady_clock;
 
  public:
   static DatagramLinkPtr Create(RightEndSocket& right, LeftEndSocket left,
                                 RemoteEndpointRight remote_endpoint_right,
                                 RemoteEndpointLeft remote_endpoint_left,
                                 boost::asio::io_service& io_service,
-                                DatagramLinkOperatorSpecPtr oper) {
+                                DatagramLinkOperatorSpecPtr oper,
+                                const FlowLimits& limits) {
     return DatagramLinkPtr(
         new DatagramLink(right, std::move(left), remote_endpoint_right,
-                         remote_endpoint_left, io_service, oper));
+                         remote_endpoint_left, io_service, oper, limits));
   }
 
   /// Feed data to be sent to the "left endpoint"
   void Feed(boost::asio::const_buffer buffer, size_t length) {
     std::unique_lock<std::recursive_mutex> lock(datagram_queue_mutex_);
 
-    // Copy the data into the Datagram queue
-    Datagram dgr(length);
-    boost::asio::buffer_copy(boost::asio::buffer(dgr), buffer);
-    dgr_queue_.push(dgr);
+    // Copy the data into a pooled slot of the Datagram queue
+    dgr_queue_.Push(boost::asio::buffer(buffer, length));
+    Touch();
+
+    // Resume the sending loop if it waits for data
+    if (!sending_) {
+      sending_ = true;
+      io_service_.post(std::bind(&DatagramLink::ExternalFeed,
+                                 this->shared_from_this(),
+                                 boost::system::error_code(), 0));
+    }
+  }
+
+  /// Endpoint of the flow on the right end socket
+  const RemoteEndpointRight& right_endpoint() const {
+    return remote_endpoint_right_;
+  }
 
-    // Notify that new data is available
-    timer_.cancel();
+  /// Date of the last datagram forwarded in either direction
+  Clock::time_point last_activity() const {
+    return Clock::time_point(Clock::duration(last_activity_.load()));
   }
 
 #include <boost/asio/yield.hpp>  // NOLINT
@@ -83,22 +115,16 @@ struct DatagramLink : public std::enable_shared_from_this<
 
     reenter(coro_external_) {
       for (;;) {
-        // if no error occured but no data is available, we wait
-        if (!ec && dgr_queue_.empty()) {
-          timer_.expires_from_now(std::chrono::seconds(30));
-          yield timer_.async_wait(std::bind(&DatagramLink::ExternalFeed,
-                                            this->shared_from_this(),
-                                            std::placeholders::_1, 0));
-        }
-
-        // if no other error than a canceled timer has occured and that some
-        // data is available, we send it, else we stop
-        if (ec && ec.value() != boost::asio::error::operation_aborted) {
+        if (ec) {
           Shutdown();
           return;
         }
 
+        // if no data is available, we wait for Feed to resume the loop
         if (dgr_queue_.empty()) {
+          dgr_queue_.Trim();
+          sending_ = false;
+          yield;
           continue;
         }
 
@@ -107,11 +133,10 @@ struct DatagramLink : public std::enable_shared_from_this<
           return;
         }
 
-        yield l_.async_send_to(
-            boost::asio::buffer(dgr_queue_.front()), remote_endpoint_left_,
+        yield AsyncSendToLeft(
             std::bind(&DatagramLink::ExternalFeed, this->shared_from_this(),
-                      std::placeholders::_1, std::placeholders::_2));
-        dgr_queue_.pop();
+                      std::placeholders::_1, std::placeholders::_2),
+            LeftBatch());
         if (!auto_feeding_) {
           auto_feeding_ = true;
           AutoFeed();
@@ -140,22 +165,21 @@ struct DatagramLink : public std::enable_shared_from_this<
 
     reenter(coro_auto_) {
       for (;;) {
-        yield l_.async_receive_from(
-            boost::asio::buffer(array_buffer_), remote_endpoint_left_,
+        yield AsyncReceiveFromLeft(
             std::bind(&DatagramLink::AutoFeed, this->shared_from_this(),
-                      std::placeholders::_1, std::placeholders::_2));
-        bytes_to_transfer_ = n;
-        transferred_bytes_ = 0;
-        while (transferred_bytes_ < bytes_to_transfer_) {
+                      std::placeholders::_1, std::placeholders::_2),
+            LeftBatch());
+        Touch();
+
+        // Each datagram is forwarded as is: datagram boundaries are kept
+        for (received_index_ = 0; received_index_ < received_.size();
+             ++received_index_) {
           yield r_.async_send_to(
-              boost::asio::buffer(array_buffer_,
-                                  bytes_to_transfer_ - transferred_bytes_),
-              remote_endpoint_right_,
+              received_[received_index_], remote_endpoint_right_,
               std::bind(&DatagramLink::AutoFeed, this->shared_from_this(),
                         std::placeholders::_1, std::placeholders::_2));
-
-          transferred_bytes_ += n;
         }
+        ReleaseReceived(LeftBatch());
       }
     }
   }
@@ -174,8 +198,6 @@ struct DatagramLink : public std::enable_shared_from_this<
     l_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
     ec.clear();
     l_.close(ec);
-    ec.clear();
-    timer_.cancel(ec);
   }
 
  private:
@@ -183,19 +205,158 @@ struct DatagramLink : public std::enable_shared_from_this<
                RemoteEndpointRight remote_endpoint_right,
                RemoteEndpointLeft remote_endpoint_left,
                boost::asio::io_service& io_service,
-               DatagramLinkOperatorSpecPtr oper)
+               DatagramLinkOperatorSpecPtr oper, const FlowLimits& limits)
       : coro_auto_(),
         coro_external_(),
         r_(right),
         l_(std::move(left)),
-        bytes_to_transfer_(0),
-        transferred_bytes_(0),
-        timer_(io_service),
+        dgr_queue_(limits.queue_size, limits.overflow_policy),
+        sending_datagram_(),
+        received_(),
+        received_index_(0),
+        pending_(),
+#if defined(SSF_UDP_BATCH)
+        receive_offload_(false),
+        received_buffer_(),
+        p_send_batch_(),
+#endif
+        io_service_(io_service),
         remote_endpoint_right_(remote_endpoint_right),
         remote_endpoint_left_(remote_endpoint_left),
         stopping_(false),
         p_operator_(oper),
-        auto_feeding_(false) {}
+        auto_feeding_(false),
+        sending_(true),
+        last_activity_(Clock::now().time_since_epoch().count()) {}
+
+  void Touch() {
+    last_activity_.store(Clock::now().time_since_epoch().count());
+  }
+
+  /// Pop the datagram at the front of the queue and send it
+  template <class Handler>
+  void AsyncSendToLeft(Handler handler, std::false_type) {
+    // The datagram leaves the queue: a full queue cannot overwrite it
+    sending_datagram_ = dgr_queue_.TakeFront();
+
+    auto self = this->shared_from_this();
+    l_.async_send_to(
+        sending_datagram_.data(), remote_endpoint_left_,
+        [this, self, handler](const boost::system::error_code& ec,
+                              std::size_t n) mutable {
+          {
+            std::unique_lock<std::recursive_mutex> lock(datagram_queue_mutex_);
+            sending_datagram_ = DatagramRing::Datagram();
+          }
+          handler(ec, n);
+        });
+  }
+
+#if defined(SSF_UDP_BATCH)
+  /// Send as many queued datagrams as possible with one system call and pop
+  /// them
+  template <class Handler>
+  void AsyncSendToLeft(Handler handler, std::true_type) {
+    auto self = this->shared_from_this();
+    l_.async_send(
+        boost::asio::null_buffers(),
+        [this, self, handler](const boost::system::error_code& ec,
+                              std::size_t) mutable {
+          if (ec) {
+            handler(ec, 0);
+            return;
+          }
+
+          std::unique_lock<std::recursive_mutex> lock(datagram_queue_mutex_);
+          if (!p_send_batch_) {
+            p_send_batch_.reset(new UdpSendBatch());
+          }
+
+          pending_.clear();
+          auto count = std::min(dgr_queue_.size(), p_send_batch_->capacity());
+          for (std::size_t i = 0; i < count; ++i) {
+            pending_.push_back(dgr_queue_[i]);
+          }
+
+          boost::system::error_code send_ec;
+          auto sent = p_send_batch_->Send(l_.native_handle(),
+                                          remote_endpoint_left_, pending_,
+                                          send_ec);
+          pending_.clear();
+          if (send_ec == boost::asio::error::would_block) {
+            AsyncSendToLeft(handler, std::true_type());
+            return;
+          }
+
+          dgr_queue_.Pop(sent);
+          handler(send_ec, sent);
+        });
+  }
+#endif  // defined(SSF_UDP_BATCH)
+
+  /// Receive one datagram from the left end socket
+  template <class Handler>
+  void AsyncReceiveFromLeft(Handler handler, std::false_type) {
+    auto self = this->shared_from_this();
+    l_.async_receive_from(
+        boost::asio::buffer(array_buffer_), remote_endpoint_left_,
+        [this, self, handler](const boost::system::error_code& ec,
+                              std::size_t n) mutable {
+          received_.assign(1, boost::asio::buffer(array_buffer_, n));
+          handler(ec, n);
+        });
+  }
+
+#if defined(SSF_UDP_BATCH)
+  /// Receive every pending datagram from the left end socket with one system
+  /// call
+  /**
+  * The datagrams are read in the batch of the thread then copied out: the
+  * link only holds the bytes received while it forwards them.
+  */
+  template <class Handler>
+  void AsyncReceiveFromLeft(Handler handler, std::true_type) {
+    if (!receive_offload_) {
+      receive_offload_ = true;
+      UdpReceiveBatch::EnableReceiveOffload(l_.native_handle());
+    }
+
+    auto self = this->shared_from_this();
+    l_.async_receive(
+        boost::asio::null_buffers(),
+        [this, self, handler](const boost::system::error_code& ec,
+                              std::size_t) mutable {
+          if (ec) {
+            handler(ec, 0);
+            return;
+          }
+
+          auto& receive_batch = UdpReceiveBatch::ForThread();
+          boost::system::error_code receive_ec;
+          auto count = receive_batch.Receive(l_.native_handle(), receive_ec);
+          if (receive_ec == boost::asio::error::would_block) {
+            AsyncReceiveFromLeft(handler, std::true_type());
+            return;
+          }
+
+          receive_batch.CopyOut(&received_buffer_, &received_);
+          if (count > 0) {
+            std::unique_lock<std::recursive_mutex> lock(datagram_queue_mutex_);
+            remote_endpoint_left_ = receive_batch.sender(count - 1);
+          }
+          handler(receive_ec, count);
+        });
+  }
+#endif  // defined(SSF_UDP_BATCH)
+
+  void ReleaseReceived(std::false_type) { received_.clear(); }
+
+#if defined(SSF_UDP_BATCH)
+  void ReleaseReceived(std::true_type) {
+    received_.clear();
+    received_buffer_.Reset();
+  }
+#endif  // defined(SSF_UDP_BATCH)
 
   void Shutdown() {
     {
@@ -219,11 +380,18 @@ struct DatagramLink : public std::enable_shared_from_this<
   boost::asio::coroutine coro_external_;
   RightEndSocket& r_;
   LeftEndSocket l_;
-  DatagramQueue dgr_queue_;
+  DatagramRing dgr_queue_;
+  DatagramRing::Datagram sending_datagram_;
   std::array<uint8_t, 50 * 1024> array_buffer_;
-  size_t bytes_to_transfer_;
-  size_t transferred_bytes_;
-  boost::asio::steady_timer timer_;
+  std::vector<boost::asio::const_buffer> received_;
+  std::size_t received_index_;
+  std::vector<boost::asio::const_buffer> pending_;
+#if defined(SSF_UDP_BATCH)
+  bool receive_offload_;
+  BufferPool::Buffer received_buffer_;
+  std::unique_ptr<UdpSendBatch> p_send_batch_;
+#endif
+  boost::asio::io_service& io_service_;
   RemoteEndpointRight remote_endpoint_right_;
   RemoteEndpointLeft remote_endpoint_left_;
   std::recursive_mutex datagram_queue_mutex_;
@@ -232,6 +400,8 @@ struct DatagramLink : public std::enable_shared_from_this<
   bool stopping_;
   DatagramLinkOperatorSpecPtr p_operator_;
   bool auto_feeding_;
+  bool sending_;
+  std::atomic<Clock::rep> last_activity_;
 };
 
 }  // ssf
@@ -1,12 +1,16 @@
 #ifndef SSF_SERVICES_DATAGRAM_DATAGRAM_LINK_OPERATOR_H_
 #define SSF_SERVICES_DATAGRAM_DATAGRAM_LINK_OPERATOR_H_
 
-#include <map>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <set>
 
+#include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/udp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "services/datagram/flow_limits.h"
+#include "services/datagram/flow_table.h"
 
 namespace ssf {
 
@@ -15,6 +19,10 @@ template <class RemoteEndpointRight, class RightEndSocket,
 struct DatagramLink;
 
 /// Class to manager DatagramLinks
+/**
+* The links are indexed by the endpoint of their flow on the right end socket
+* (see FlowTable). A single timer per operator removes the idle links.
+*/
 template <typename RemoteEndpointRight, typename RightEndSocket,
           typename RemoteEndpointLeft, typename LeftEndSocket>
 class DatagramLinkOperator
@@ -26,12 +34,14 @@ class DatagramLinkOperator
   using DatagramLinkSpec = DatagramLink<RemoteEndpointRight, RightEndSocket,
                                         RemoteEndpointLeft, LeftEndSocket>;
   using DatagramLinkPtr = std::shared_ptr<DatagramLinkSpec>;
+  using Table = FlowTable<RemoteEndpointRight, DatagramLinkSpec>;
 
  public:
   static std::shared_ptr<DatagramLinkOperator> Create(
-      RightEndSocket& right_end_socket) {
+      RightEndSocket& right_end_socket, boost::asio::io_service& io_service,
+      const FlowLimits& limits = FlowLimits()) {
     return std::shared_ptr<DatagramLinkOperator>(
-        new DatagramLinkOperator(right_end_socket));
+        new DatagramLinkOperator(right_end_socket, io_service, limits));
   }
 
   ~DatagramLinkOperator() {}
@@ -39,63 +49,116 @@ class DatagramLinkOperator
   /// Function called when data is received from the right end socket
   bool Feed(RemoteEndpointRight received_from, boost::asio::const_buffer buffer,
             size_t length) {
-    std::unique_lock<std::recursive_mutex> lock(links_mutex_);
-
     // If the endpoint is registered, transfer the data to its DataLink
-    if (links_.count(received_from)) {
-      links_[received_from]->Feed(buffer, length);
-      return true;
-    } else {
+    auto link = flows_.Find(received_from);
+    if (!link) {
       return false;
     }
+
+    link->Feed(buffer, length);
+    return true;
   }
 
   /// Function to add a new DataLink
-  void AddLink(LeftEndSocket left, RemoteEndpointRight right_endpoint,
+  /**
+  * @return false if the link could not be added (flow limit reached)
+  */
+  bool AddLink(LeftEndSocket left, RemoteEndpointRight right_endpoint,
                RemoteEndpointLeft left_endpoint,
                boost::asio::io_service& io_service) {
-    std::unique_lock<std::recursive_mutex> lock(links_mutex_);
+    auto link = DatagramLinkSpec::Create(
+        right_end_socket_, std::move(left), right_endpoint, left_endpoint,
+        io_service, this->shared_from_this(), limits_);
+    if (!flows_.Insert(right_endpoint, link)) {
+      link->Stop();
+      return false;
+    }
 
-    auto link = DatagramLinkSpec::Create(right_end_socket_, std::move(left),
-                                         right_endpoint, left_endpoint,
-                                         io_service, this->shared_from_this());
-    links_[right_endpoint] = link;
-    endpoints_[link] = right_endpoint;
     link->ExternalFeed();
+    StartExpiry();
+    return true;
   }
 
   /// Function to stop a DataLink
   void Stop(DatagramLinkPtr link) {
-    std::unique_lock<std::recursive_mutex> lock(links_mutex_);
-    if (endpoints_.count(link)) {
-      links_.erase(endpoints_[link]);
-      endpoints_.erase(link);
+    if (flows_.Erase(link->right_endpoint(), link)) {
       link->Stop();
     }
   }
 
   /// Function to stop all DataLinks
   void StopAll() {
-    std::unique_lock<std::recursive_mutex> lock(links_mutex_);
-    while (!links_.empty()) {
-      auto link_it = links_.begin();
-      auto link = link_it->second;
-      links_.erase(link_it->first);
-      endpoints_.erase(link);
+    {
+      std::unique_lock<std::mutex> lock(expiry_mutex_);
+      stopped_ = true;
+      boost::system::error_code ec;
+      expiry_timer_.cancel(ec);
+    }
+
+    for (auto& link : flows_.Clear()) {
+      link->Stop();
+    }
+  }
+
+  /// Number of active DataLinks
+  std::size_t size() const { return flows_.size(); }
+
+ private:
+  DatagramLinkOperator(RightEndSocket& right_end_socket,
+                       boost::asio::io_service& io_service,
+                       const FlowLimits& limits)
+      : right_end_socket_(right_end_socket),
+        limits_(limits),
+        flows_(limits),
+        expiry_mutex_(),
+        expiry_timer_(io_service),
+        expiring_(false),
+        stopped_(false) {}
+
+  void StartExpiry() {
+    std::unique_lock<std::mutex> lock(expiry_mutex_);
+    if (expiring_ || stopped_) {
+      return;
+    }
+    expiring_ = true;
+    AsyncWaitExpiry();
+  }
+
+  // Must be called with expiry_mutex_ locked
+  void AsyncWaitExpiry() {
+    expiry_timer_.expires_from_now(Table::tick_duration());
+    expiry_timer_.async_wait(std::bind(&DatagramLinkOperator::OnExpiryTick,
+                                       this->shared_from_this(),
+                                       std::placeholders::_1));
+  }
+
+  void OnExpiryTick(const boost::system::error_code& ec) {
+    if (ec) {
+      return;
+    }
+
+    for (auto& link : flows_.Expire(Table::Clock::now())) {
       link->Stop();
     }
+
+    std::unique_lock<std::mutex> lock(expiry_mutex_);
+    if (stopped_) {
+      return;
+    }
+    AsyncWaitExpiry();
   }
 
  private:
-  DatagramLinkOperator(RightEndSocket& right_end_socket)
-      : right_end_socket_(right_end_socket) {}
-  
-  std::recursive_mutex links_mutex_;
-  std::map<DatagramLinkPtr, RemoteEndpointRight> endpoints_;
-  std::map<RemoteEndpointRight, DatagramLinkPtr> links_;
   RightEndSocket& right_end_socket_;
+  FlowLimits limits_;
+  Table flows_;
+
+  std::mutex expiry_mutex_;
+  boost::asio::steady_timer expiry_timer_;
+  bool expiring_;
+  bool stopped_;
 };
 
 }  // ssf
 
-#endif  // SSF_SERVICES_DATAGRAM_DATAGRAM_LINK_OPERATOR_H_
\ No newline at end of file
+#endif  // SSF_SERVICES_DATAGRAM_DATAGRAM_LINK_OPERATOR_H_
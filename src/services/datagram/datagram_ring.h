@@ -0,0 +1,141 @@
+#ifndef SSF_SERVICES_DATAGRAM_DATAGRAM_RING_H_
+#define SSF_SERVICES_DATAGRAM_DATAGRAM_RING_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include <ssf/network/buffer_pool.h>
+
+#include "services/datagram/flow_limits.h"
+
+namespace ssf {
+
+/// Bounded FIFO of datagrams stored in pooled buffers
+/**
+* The ring has a fixed number of slots. A slot keeps its buffer when its
+* datagram is popped so that the next datagram of the same size class is
+* stored without going through the pool. Trim gives the buffers of the free
+* slots back to the pool.
+*
+* Not thread safe.
+*/
+class DatagramRing {
+ public:
+  /// Datagram taken out of the ring
+  struct Datagram {
+    Datagram() : buffer(), size(0) {}
+    Datagram(Datagram&& other)
+        : buffer(std::move(other.buffer)), size(other.size) {}
+    Datagram& operator=(Datagram&& other) {
+      buffer = std::move(other.buffer);
+      size = other.size;
+      return *this;
+    }
+
+    boost::asio::const_buffers_1 data() const {
+      return boost::asio::buffer(static_cast<const char*>(buffer.data()),
+                                 size);
+    }
+
+    BufferPool::Buffer buffer;
+    std::size_t size;
+  };
+
+ public:
+  DatagramRing(std::size_t capacity, QueueOverflowPolicy policy)
+      : slots_(std::max<std::size_t>(capacity, 1)),
+        policy_(policy),
+        head_(0),
+        size_(0),
+        dropped_(0) {}
+
+  DatagramRing(const DatagramRing&) = delete;
+  DatagramRing& operator=(const DatagramRing&) = delete;
+
+  bool empty() const { return size_ == 0; }
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return slots_.size(); }
+
+  /// Number of datagrams dropped because the ring was full
+  std::size_t dropped() const { return dropped_; }
+
+  /// Copy a datagram at the back of the ring
+  /**
+  * @return false if a datagram was dropped (the given one or the oldest one
+  *   depending on the overflow policy)
+  */
+  bool Push(boost::asio::const_buffer datagram) {
+    bool dropped = false;
+    if (size_ == slots_.size()) {
+      ++dropped_;
+      dropped = true;
+      if (policy_ == QueueOverflowPolicy::kDropNewest) {
+        return false;
+      }
+      Pop(1);
+    }
+
+    auto& slot = slots_[Index(size_)];
+    auto length = boost::asio::buffer_size(datagram);
+    if (slot.buffer.size() < length) {
+      slot.buffer.Reset();
+      slot.buffer = BufferPool::Get().Acquire(length);
+    }
+    boost::asio::buffer_copy(
+        boost::asio::buffer(slot.buffer.data(), slot.buffer.size()),
+        datagram);
+    slot.size = length;
+    ++size_;
+
+    return !dropped;
+  }
+
+  /// Datagram at position i from the front
+  boost::asio::const_buffers_1 operator[](std::size_t i) const {
+    return slots_[Index(i)].data();
+  }
+
+  /// Remove the datagram at the front and give its buffer to the caller
+  Datagram TakeFront() {
+    Datagram datagram(std::move(slots_[head_]));
+    Pop(1);
+    return datagram;
+  }
+
+  /// Remove count datagrams from the front
+  void Pop(std::size_t count) {
+    count = std::min(count, size_);
+    for (std::size_t i = 0; i < count; ++i) {
+      slots_[head_].size = 0;
+      head_ = (head_ + 1) % slots_.size();
+    }
+    size_ -= count;
+  }
+
+  /// Give the buffers of the free slots back to the pool
+  void Trim() {
+    for (std::size_t i = size_; i < slots_.size(); ++i) {
+      slots_[Index(i)].buffer.Reset();
+    }
+  }
+
+ private:
+  std::size_t Index(std::size_t i) const {
+    return (head_ + i) % slots_.size();
+  }
+
+ private:
+  std::vector<Datagram> slots_;
+  QueueOverflowPolicy policy_;
+  std::size_t head_;
+  std::size_t size_;
+  std::size_t dropped_;
+};
+
+}  // ssf
+
+#endif  // SSF_SERVICES_DATAGRAM_DATAGRAM_RING_H_
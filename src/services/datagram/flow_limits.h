@@ -0,0 +1,35 @@
+#ifndef SSF_SERVICES_DATAGRAM_FLOW_LIMITS_H_
+#define SSF_SERVICES_DATAGRAM_FLOW_LIMITS_H_
+
+#include <chrono>
+#include <cstddef>
+
+namespace ssf {
+
+/// Datagram dropped when a datagram arrives in a full flow queue
+enum class QueueOverflowPolicy { kDropNewest, kDropOldest };
+
+/// Bounds of the UDP flows of a datagram forwarding service
+struct FlowLimits {
+  /// Default bounds: 4096 flows, forgotten after 60 seconds without traffic,
+  /// up to 64 datagrams waiting to be sent per flow
+  FlowLimits()
+      : max_flows(4096),
+        idle_timeout(60),
+        queue_size(64),
+        overflow_policy(QueueOverflowPolicy::kDropNewest) {}
+  FlowLimits(std::size_t max, std::chrono::seconds timeout)
+      : max_flows(max),
+        idle_timeout(timeout),
+        queue_size(64),
+        overflow_policy(QueueOverflowPolicy::kDropNewest) {}
+
+  std::size_t max_flows;
+  std::chrono::seconds idle_timeout;
+  std::size_t queue_size;
+  QueueOverflowPolicy overflow_policy;
+};
+
+}  // ssf
+
+#endif  // SSF_SERVICES_DATAGRAM_FLOW_LIMITS_H_
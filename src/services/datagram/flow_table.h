@@ -0,0 +1,274 @@
+#ifndef SSF_SERVICES_DATAGRAM_FLOW_TABLE_H_
+#define SSF_SERVICES_DATAGRAM_FLOW_TABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/ip/udp.hpp>
+
+#include "services/datagram/flow_limits.h"
+
+namespace ssf {
+
+/// Hash of a flow endpoint (endpoints identified by their port)
+template <class Endpoint>
+struct EndpointHash {
+  std::size_t operator()(const Endpoint& endpoint) const {
+    return std::hash<std::size_t>()(endpoint.port());
+  }
+};
+
+/// Hash of a UDP endpoint
+template <>
+struct EndpointHash<boost::asio::ip::udp::endpoint> {
+  std::size_t operator()(const boost::asio::ip::udp::endpoint& endpoint) const {
+    std::size_t seed = endpoint.port();
+    auto address = endpoint.address();
+    if (address.is_v4()) {
+      Combine(seed, address.to_v4().to_ulong());
+    } else {
+      for (auto byte : address.to_v6().to_bytes()) {
+        Combine(seed, byte);
+      }
+    }
+    return seed;
+  }
+
+ private:
+  static void Combine(std::size_t& seed, std::size_t value) {
+    seed ^= std::hash<std::size_t>()(value) + 0x9e3779b9 + (seed << 6) +
+            (seed >> 2);
+  }
+};
+
+/// Equality of flow endpoints consistent with their ordering
+template <class Endpoint>
+struct EndpointEqual {
+  bool operator()(const Endpoint& lhs, const Endpoint& rhs) const {
+    return !(lhs < rhs) && !(rhs < lhs);
+  }
+};
+
+/// Table of the links of a datagram service indexed by flow endpoint
+/**
+* The table is split in shards locked independently so that lookups from
+* several threads rarely contend. Idle links are found with a timing wheel
+* driven by Expire: a link is checked once per idle timeout instead of having
+* its own timer, and lookups only refresh the activity date kept by the link.
+*
+* @tparam Endpoint flow endpoint type
+* @tparam Link link type providing
+*   std::chrono::steady_clock::time_point last_activity() const
+*/
+template <class Endpoint, class Link>
+class FlowTable {
+ public:
+  using LinkPtr = std::shared_ptr<Link>;
+  using Clock = std::chrono::steady_clock;
+
+  enum : std::size_t { kShardCount = 16 };
+
+ public:
+  explicit FlowTable(const FlowLimits& limits)
+      : max_flows_(limits.max_flows),
+        timeout_ticks_(std::max<std::size_t>(
+            1, static_cast<std::size_t>(
+                   std::chrono::duration_cast<TickDuration>(
+                       limits.idle_timeout)
+                       .count()))),
+        size_(0),
+        shards_(),
+        wheel_mutex_(),
+        start_(Clock::now()),
+        current_tick_(0),
+        wheel_(timeout_ticks_ + 1) {}
+
+  FlowTable(const FlowTable&) = delete;
+  FlowTable& operator=(const FlowTable&) = delete;
+
+  /// Interval at which Expire should be called
+  static Clock::duration tick_duration() { return TickDuration(1); }
+
+  /// Number of links in the table
+  std::size_t size() const { return size_.load(); }
+
+  /// Get the link of a flow (nullptr if unknown)
+  LinkPtr Find(const Endpoint& endpoint) {
+    auto& shard = GetShard(endpoint);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto link_it = shard.links.find(endpoint);
+    if (link_it == shard.links.end()) {
+      return nullptr;
+    }
+    return link_it->second;
+  }
+
+  /// Add the link of a new flow
+  /**
+  * @return false if the flow is already known or if the table is full
+  */
+  bool Insert(const Endpoint& endpoint, LinkPtr p_link) {
+    if (size_.fetch_add(1) >= max_flows_) {
+      --size_;
+      return false;
+    }
+
+    {
+      auto& shard = GetShard(endpoint);
+      std::unique_lock<std::mutex> lock(shard.mutex);
+      if (!shard.links.emplace(endpoint, p_link).second) {
+        --size_;
+        return false;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(wheel_mutex_);
+    Schedule(WheelEntry{endpoint, p_link}, current_tick_ + timeout_ticks_);
+    return true;
+  }
+
+  /// Remove the link of a flow if it is still the given one
+  /**
+  * @return true if the link was removed
+  */
+  bool Erase(const Endpoint& endpoint, const LinkPtr& p_link) {
+    auto& shard = GetShard(endpoint);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto link_it = shard.links.find(endpoint);
+    if (link_it == shard.links.end() || link_it->second != p_link) {
+      return false;
+    }
+    shard.links.erase(link_it);
+    --size_;
+    return true;
+  }
+
+  /// Remove every link
+  std::vector<LinkPtr> Clear() {
+    std::vector<LinkPtr> links;
+    for (auto& shard : shards_) {
+      std::unique_lock<std::mutex> lock(shard.mutex);
+      for (auto& link_pair : shard.links) {
+        links.push_back(link_pair.second);
+      }
+      size_ -= shard.links.size();
+      shard.links.clear();
+    }
+
+    std::unique_lock<std::mutex> lock(wheel_mutex_);
+    for (auto& slot : wheel_) {
+      slot.clear();
+    }
+    return links;
+  }
+
+  /// Advance the wheel up to now
+  /**
+  * @return the links removed because they were idle for longer than the
+  *   timeout
+  */
+  std::vector<LinkPtr> Expire(Clock::time_point now) {
+    std::vector<LinkPtr> expired;
+    std::unique_lock<std::mutex> lock(wheel_mutex_);
+
+    auto now_tick = ToTick(now);
+    auto steps = std::min<std::size_t>(now_tick - current_tick_, wheel_.size());
+    current_tick_ = now_tick - steps;
+
+    std::vector<WheelEntry> entries;
+    for (std::size_t step = 0; step < steps; ++step) {
+      ++current_tick_;
+      entries.clear();
+      entries.swap(wheel_[current_tick_ % wheel_.size()]);
+
+      for (auto& entry : entries) {
+        auto p_link = entry.p_link.lock();
+        if (!p_link) {
+          continue;
+        }
+
+        auto& shard = GetShard(entry.endpoint);
+        std::unique_lock<std::mutex> shard_lock(shard.mutex);
+        auto link_it = shard.links.find(entry.endpoint);
+        if (link_it == shard.links.end() || link_it->second != p_link) {
+          // Erased (and maybe replaced) since it was scheduled
+          continue;
+        }
+
+        auto due_tick = ToTick(p_link->last_activity()) + timeout_ticks_;
+        if (due_tick <= current_tick_) {
+          shard.links.erase(link_it);
+          --size_;
+          expired.push_back(std::move(p_link));
+          continue;
+        }
+
+        shard_lock.unlock();
+        Schedule(std::move(entry), due_tick);
+      }
+    }
+
+    // Catch up after a long pause: the wheel was fully processed
+    current_tick_ = now_tick;
+
+    return expired;
+  }
+
+ private:
+  using TickDuration = std::chrono::seconds;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<Endpoint, LinkPtr, EndpointHash<Endpoint>,
+                       EndpointEqual<Endpoint>>
+        links;
+  };
+
+  struct WheelEntry {
+    Endpoint endpoint;
+    std::weak_ptr<Link> p_link;
+  };
+
+ private:
+  Shard& GetShard(const Endpoint& endpoint) {
+    return shards_[EndpointHash<Endpoint>()(endpoint) % kShardCount];
+  }
+
+  std::size_t ToTick(Clock::time_point time_point) const {
+    if (time_point <= start_) {
+      return 0;
+    }
+    return static_cast<std::size_t>(
+        std::chrono::duration_cast<TickDuration>(time_point - start_).count());
+  }
+
+  // Must be called with wheel_mutex_ locked
+  void Schedule(WheelEntry entry, std::size_t tick) {
+    tick = std::max(tick, current_tick_ + 1);
+    tick = std::min(tick, current_tick_ + wheel_.size() - 1);
+    wheel_[tick % wheel_.size()].push_back(std::move(entry));
+  }
+
+ private:
+  std::size_t max_flows_;
+  std::size_t timeout_ticks_;
+  std::atomic<std::size_t> size_;
+  std::array<Shard, kShardCount> shards_;
+
+  std::mutex wheel_mutex_;
+  Clock::time_point start_;
+  std::size_t current_tick_;
+  std::vector<std::vector<WheelEntry>> wheel_;
+};
+
+}  // ssf
+
+#endif  // SSF_SERVICES_DATAGRAM_FLOW_TABLE_H_
@@ -4,11 +4,13 @@ namespace ssf {
 namespace services {
 namespace datagrams_to_fibers {
 
-Config::Config() : BaseServiceConfig(true), gateway_ports_(false) {}
+Config::Config()
+    : BaseServiceConfig(true), gateway_ports_(false), flow_limits_() {}
 
 Config::Config(const Config& datagram_listener)
-    : BaseServiceConfig(datagram_listener.enabled()),
-      gateway_ports_(datagram_listener.gateway_ports_) {}
+    : BaseServiceConfig(datagram_listener),
+      gateway_ports_(datagram_listener.gateway_ports_),
+      flow_limits_(datagram_listener.flow_limits_) {}
 
 }  // datagrams_to_fibers
 }  // services
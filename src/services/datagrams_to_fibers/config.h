@@ -2,6 +2,7 @@
 #define SSF_SERVICES_DATAGRAMS_TO_FIBERS_CONFIG_H_
 
 #include "services/base_service_config.h"
+#include "services/datagram/flow_limits.h"
 
 namespace ssf {
 namespace services {
@@ -17,8 +18,15 @@ class Config : public BaseServiceConfig {
     gateway_ports_ = gateway_ports;
   }
 
+  // Bounds of the UDP flows forwarded by the service
+  inline const FlowLimits& flow_limits() const { return flow_limits_; }
+  inline void set_flow_limits(const FlowLimits& flow_limits) {
+    flow_limits_ = flow_limits;
+  }
+
  private:
   bool gateway_ports_;
+  FlowLimits flow_limits_;
 };
 
 }  // datagrams_to_fibers
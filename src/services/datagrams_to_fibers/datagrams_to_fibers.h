@@ -7,6 +7,8 @@
 
 #include <boost/asio.hpp>
 
+#include <ssf/network/udp_batch.h>
+
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 #include "common/boost/fiber/datagram_fiber.hpp"
 #include "common/utils/to_underlying.h"
@@ -67,6 +69,7 @@ class DatagramsToFibers : public BaseService<Demux> {
   // @param parameters microservice configuration parameters
   // @param gateway_ports true to interpret local_addr parameters. Default
   //   behavior will set local_addr to 127.0.0.1
+  // @param flow_limits bounds of the forwarded UDP flows
   // @returns Microservice or nullptr if an error occured
   //
   // parameters format:
@@ -78,7 +81,8 @@ class DatagramsToFibers : public BaseService<Demux> {
   static DatagramsToFibersPtr Create(boost::asio::io_service& io_service,
                                      Demux& fiber_demux,
                                      const Parameters& parameters,
-                                     bool gateway_ports) {
+                                     bool gateway_ports,
+                                     const FlowLimits& flow_limits) {
     if (!parameters.count("local_addr") || !parameters.count("local_port") ||
         !parameters.count("remote_port")) {
       return DatagramsToFibersPtr(nullptr);
@@ -120,7 +124,7 @@ class DatagramsToFibers : public BaseService<Demux> {
 
     return std::shared_ptr<DatagramsToFibers>(new DatagramsToFibers(
         io_service, fiber_demux, local_addr,
-        static_cast<LocalPortType>(local_port), remote_port));
+        static_cast<LocalPortType>(local_port), remote_port, flow_limits));
   }
 
   static void RegisterToServiceFactory(
@@ -131,13 +135,15 @@ class DatagramsToFibers : public BaseService<Demux> {
     }
 
     bool gateway_ports = config.gateway_ports();
-    auto creator = [gateway_ports](boost::asio::io_service& io_service,
-                                   Demux& fiber_demux,
-                                   const Parameters& parameters) {
+    FlowLimits flow_limits = config.flow_limits();
+    auto creator = [gateway_ports, flow_limits](
+        boost::asio::io_service& io_service, Demux& fiber_demux,
+        const Parameters& parameters) {
       return DatagramsToFibers::Create(io_service, fiber_demux, parameters,
-                                       gateway_ports);
+                                       gateway_ports, flow_limits);
     };
-    p_factory->RegisterServiceCreator(kFactoryId, creator);
+    p_factory->RegisterServiceCreator(kFactoryId, creator,
+                                      config.fiber_weight());
   }
 
   static ssf::services::admin::CreateServiceRequest<Demux> GetCreateRequest(
@@ -159,12 +165,18 @@ class DatagramsToFibers : public BaseService<Demux> {
  private:
   DatagramsToFibers(boost::asio::io_service& io_service, Demux& fiber_demux,
                     const std::string& local_addr, LocalPortType local_port,
-                    RemotePortType remote_port);
+                    RemotePortType remote_port, const FlowLimits& flow_limits);
 
   void AsyncReceiveDatagram();
   void OnSocketDatagramReceive(BaseServicePtr self,
                                const boost::system::error_code& ec,
                                size_t length);
+#if defined(SSF_UDP_BATCH)
+  void OnSocketReadable(BaseServicePtr self,
+                        const boost::system::error_code& ec);
+#endif
+  void ForwardDatagram(const Udp::endpoint& from,
+                       boost::asio::const_buffer datagram);
 
  private:
   std::string local_addr_;
@@ -176,6 +188,9 @@ class DatagramsToFibers : public BaseService<Demux> {
   FiberEndpoint to_endpoint_;
 
   WorkingBufferType working_buffer_;
+#if defined(SSF_UDP_BATCH)
+  UdpReceiveBatch receive_batch_;
+#endif
 
   UdpOperatorPtr p_udp_operator_;
 };
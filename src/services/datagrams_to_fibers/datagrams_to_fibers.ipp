@@ -14,7 +14,8 @@ DatagramsToFibers<Demux>::DatagramsToFibers(boost::asio::io_service& io_service,
                                             Demux& fiber_demux,
                                             const std::string& local_addr,
                                             LocalPortType local_port,
-                                            RemotePortType remote_port)
+                                            RemotePortType remote_port,
+                                            const FlowLimits& flow_limits)
     : ssf::BaseService<Demux>::BaseService(io_service, fiber_demux),
       local_addr_(local_addr),
       local_port_(local_port),
@@ -22,7 +23,7 @@ DatagramsToFibers<Demux>::DatagramsToFibers(boost::asio::io_service& io_service,
       socket_(io_service),
       from_endpoint_(),
       to_endpoint_(fiber_demux, remote_port),
-      p_udp_operator_(UdpOperator::Create(socket_)) {}
+      p_udp_operator_(UdpOperator::Create(socket_, io_service, flow_limits)) {}
 
 template <typename Demux>
 void DatagramsToFibers<Demux>::start(boost::system::error_code& ec) {
@@ -66,6 +67,13 @@ void DatagramsToFibers<Demux>::start(boost::system::error_code& ec) {
     return;
   }
 
+#if defined(SSF_UDP_BATCH)
+  if (!UdpReceiveBatch::EnableReceiveOffload(socket_.native_handle())) {
+    SSF_LOG("microservice", debug,
+            "[datagram_listener]: UDP receive offload not available");
+  }
+#endif
+
   SSF_LOG("microservice", info,
           "[datagram_listener]: forward UDP datagrams from <{}:{}> to fiber "
           "port {}",
@@ -96,11 +104,19 @@ template <typename Demux>
 void DatagramsToFibers<Demux>::AsyncReceiveDatagram() {
   SSF_LOG("microservice", trace, "[datagram_listener]: receiving new datagram");
 
+#if defined(SSF_UDP_BATCH)
+  // Wait for the socket to be readable then read every pending datagram
+  socket_.async_receive(
+      boost::asio::null_buffers(),
+      std::bind(&DatagramsToFibers::OnSocketReadable, this,
+                this->shared_from_this(), std::placeholders::_1));
+#else
   socket_.async_receive_from(
       boost::asio::buffer(working_buffer_), from_endpoint_,
       std::bind(&DatagramsToFibers::OnSocketDatagramReceive, this,
                 this->shared_from_this(), std::placeholders::_1,
                 std::placeholders::_2));
+#endif
 }
 
 template <typename Demux>
@@ -113,19 +129,67 @@ void DatagramsToFibers<Demux>::OnSocketDatagramReceive(
     return;
   }
 
-  auto already_in = p_udp_operator_->Feed(
-      from_endpoint_, boost::asio::buffer(working_buffer_), length);
+  ForwardDatagram(from_endpoint_,
+                  boost::asio::buffer(working_buffer_, length));
+
+  this->AsyncReceiveDatagram();
+}
+
+#if defined(SSF_UDP_BATCH)
+template <typename Demux>
+void DatagramsToFibers<Demux>::OnSocketReadable(
+    BaseServicePtr self, const boost::system::error_code& ec) {
+  boost::system::error_code receive_ec(ec);
+  std::size_t count = 0;
+  if (!receive_ec) {
+    count = receive_batch_.Receive(socket_.native_handle(), receive_ec);
+  }
+
+  if (receive_ec == boost::asio::error::would_block) {
+    this->AsyncReceiveDatagram();
+    return;
+  }
+
+  if (receive_ec) {
+    SSF_LOG("microservice", debug,
+            "[datagram_listener]: error receiving datagram: {} ({})",
+            receive_ec.message(), receive_ec.value());
+    receive_batch_.Clear();
+    return;
+  }
+
+  SSF_LOG("microservice", trace, "[datagram_listener]: {} datagrams received",
+          count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    ForwardDatagram(receive_batch_.sender(i), receive_batch_.datagram(i));
+  }
+  receive_batch_.Clear();
+
+  this->AsyncReceiveDatagram();
+}
+#endif
+
+template <typename Demux>
+void DatagramsToFibers<Demux>::ForwardDatagram(
+    const Udp::endpoint& from, boost::asio::const_buffer datagram) {
+  auto length = boost::asio::buffer_size(datagram);
+  auto already_in = p_udp_operator_->Feed(from, datagram, length);
 
   if (!already_in) {
     FiberDatagram left(this->get_demux().get_io_service(),
                        FiberEndpoint(this->get_demux(), 0));
-    p_udp_operator_->AddLink(std::move(left), from_endpoint_, to_endpoint_,
-                             this->get_io_service());
-    p_udp_operator_->Feed(from_endpoint_, boost::asio::buffer(working_buffer_),
-                          length);
+    this->apply_fiber_weight(left);
+    if (!p_udp_operator_->AddLink(std::move(left), from, to_endpoint_,
+                                  this->get_io_service())) {
+      SSF_LOG("microservice", debug,
+              "[datagram_listener]: flow limit reached, drop datagram from "
+              "<{}:{}>",
+              from.address().to_string(), from.port());
+      return;
+    }
+    p_udp_operator_->Feed(from, datagram, length);
   }
-
-  this->AsyncReceiveDatagram();
 }
 
 }  // datagrams_to_fibers
@@ -4,10 +4,11 @@ namespace ssf {
 namespace services {
 namespace fibers_to_datagrams {
 
-Config::Config() : BaseServiceConfig(true) {}
+Config::Config() : BaseServiceConfig(true), flow_limits_() {}
 
 Config::Config(const Config& datagram_forwarder)
-    : BaseServiceConfig(datagram_forwarder.enabled()) {}
+    : BaseServiceConfig(datagram_forwarder),
+      flow_limits_(datagram_forwarder.flow_limits_) {}
 
 }  // fibers_to_datagrams
 }  // services
@@ -2,6 +2,7 @@
 #define SSF_SERVICES_FIBERS_TO_DATAGRAMS_CONFIG_H_
 
 #include "services/base_service_config.h"
+#include "services/datagram/flow_limits.h"
 
 namespace ssf {
 namespace services {
@@ -11,6 +12,15 @@ class Config : public BaseServiceConfig {
  public:
   Config();
   Config(const Config& datagram_forwarder);
+
+  // Bounds of the UDP flows forwarded by the service
+  inline const FlowLimits& flow_limits() const { return flow_limits_; }
+  inline void set_flow_limits(const FlowLimits& flow_limits) {
+    flow_limits_ = flow_limits;
+  }
+
+ private:
+  FlowLimits flow_limits_;
 };
 
 }  // fibers_to_datagrams
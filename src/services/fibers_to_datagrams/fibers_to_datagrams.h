@@ -60,7 +60,8 @@ class FibersToDatagrams : public BaseService<Demux> {
  public:
   static FibersToDatagramsPtr Create(boost::asio::io_service& io_service,
                                      Demux& fiber_demux,
-                                     const Parameters& parameters) {
+                                     const Parameters& parameters,
+                                     const FlowLimits& flow_limits) {
     if (!parameters.count("local_port") || !parameters.count("remote_ip") ||
         !parameters.count("remote_port")) {
       return FibersToDatagramsPtr(nullptr);
@@ -85,7 +86,7 @@ class FibersToDatagrams : public BaseService<Demux> {
 
     return FibersToDatagramsPtr(new FibersToDatagrams(
         io_service, fiber_demux, local_port, parameters.at("remote_ip"),
-        static_cast<RemotePortType>(remote_port)));
+        static_cast<RemotePortType>(remote_port), flow_limits));
   }
 
   static void RegisterToServiceFactory(
@@ -95,11 +96,15 @@ class FibersToDatagrams : public BaseService<Demux> {
       return;
     }
 
-    auto creator = [](boost::asio::io_service& io_service, Demux& fiber_demux,
-                      const Parameters& parameters) {
-      return FibersToDatagrams::Create(io_service, fiber_demux, parameters);
+    FlowLimits flow_limits = config.flow_limits();
+    auto creator = [flow_limits](boost::asio::io_service& io_service,
+                                 Demux& fiber_demux,
+                                 const Parameters& parameters) {
+      return FibersToDatagrams::Create(io_service, fiber_demux, parameters,
+                                       flow_limits);
     };
-    p_factory->RegisterServiceCreator(kFactoryId, creator);
+    p_factory->RegisterServiceCreator(kFactoryId, creator,
+                                      config.fiber_weight());
   }
 
   static ssf::services::admin::CreateServiceRequest<Demux> GetCreateRequest(
@@ -121,7 +126,7 @@ class FibersToDatagrams : public BaseService<Demux> {
  private:
   FibersToDatagrams(boost::asio::io_service& io_service, Demux& fiber_demux,
                     LocalPortType local, const std::string& ip,
-                    RemotePortType remote_port);
+                    RemotePortType remote_port, const FlowLimits& flow_limits);
 
   void AsyncReceiveDatagram();
   void OnFiberDatagramReceive(BaseServicePtr self,
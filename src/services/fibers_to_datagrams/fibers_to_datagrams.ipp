@@ -13,14 +13,15 @@ FibersToDatagrams<Demux>::FibersToDatagrams(boost::asio::io_service& io_service,
                                             Demux& fiber_demux,
                                             LocalPortType local_port,
                                             const std::string& ip,
-                                            RemotePortType remote_port)
+                                            RemotePortType remote_port,
+                                            const FlowLimits& flow_limits)
     : ssf::BaseService<Demux>::BaseService(io_service, fiber_demux),
       remote_port_(remote_port),
       ip_(ip),
       local_port_(local_port),
       fiber_(io_service),
       from_endpoint_(fiber_demux, 0),
-      p_udp_operator_(UdpOperator::Create(fiber_)) {}
+      p_udp_operator_(UdpOperator::Create(fiber_, io_service, flow_limits)) {}
 
 template <typename Demux>
 void FibersToDatagrams<Demux>::start(boost::system::error_code& ec) {
@@ -31,6 +32,7 @@ void FibersToDatagrams<Demux>::start(boost::system::error_code& ec) {
             local_port_);
     return;
   }
+  this->apply_fiber_weight(fiber_);
 
   // Resolve the given address
   Udp::resolver resolver(this->get_io_service());
@@ -91,8 +93,15 @@ void FibersToDatagrams<Demux>::OnFiberDatagramReceive(
 
   if (!already_in) {
     Udp::socket left(this->get_io_service(), Udp::endpoint(Udp::v4(), 0));
-    p_udp_operator_->AddLink(std::move(left), from_endpoint_, to_endpoint_,
-                             this->get_io_service());
+    if (!p_udp_operator_->AddLink(std::move(left), from_endpoint_,
+                                  to_endpoint_, this->get_io_service())) {
+      SSF_LOG("microservice", debug,
+              "[datagram_forwarder]: flow limit reached, drop datagram from "
+              "fiber port {}",
+              from_endpoint_.port());
+      this->AsyncReceiveDatagram();
+      return;
+    }
     p_udp_operator_->Feed(from_endpoint_, boost::asio::buffer(working_buffer_),
                           length);
   }
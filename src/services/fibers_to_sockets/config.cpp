@@ -7,7 +7,7 @@ namespace fibers_to_sockets {
 Config::Config() : BaseServiceConfig(true) {}
 
 Config::Config(const Config& stream_forwarder)
-    : BaseServiceConfig(stream_forwarder.enabled()) {}
+    : BaseServiceConfig(stream_forwarder) {}
 
 }  // fibers_to_sockets
 }  // services
@@ -95,7 +95,9 @@ class FibersToSockets : public BaseService<Demux> {
                       const Parameters& parameters) {
       return FibersToSockets::Create(io_service, fiber_demux, parameters);
     };
-    p_factory->RegisterServiceCreator(kFactoryId, creator);
+    p_factory->RegisterServiceCreator(kFactoryId, creator,
+                                      config.fiber_weight(),
+                                      config.buffer_limits());
   }
 
   static ssf::services::admin::CreateServiceRequest<Demux> GetCreateRequest(
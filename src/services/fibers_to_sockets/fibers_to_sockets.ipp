@@ -21,7 +21,8 @@ FibersToSockets<Demux>::FibersToSockets(boost::asio::io_service& io_service,
       remote_port_(remote_port),
       ip_(ip),
       local_port_(local_port),
-      fiber_acceptor_(io_service) {}
+      fiber_acceptor_(io_service),
+      manager_("services.stream_forwarder") {}
 
 template <typename Demux>
 void FibersToSockets<Demux>::start(boost::system::error_code& ec) {
@@ -42,6 +43,7 @@ void FibersToSockets<Demux>::start(boost::system::error_code& ec) {
             local_port_);
     return;
   }
+  this->apply_fiber_weight(fiber_acceptor_);
 
   // Resolve the given address
   Tcp::resolver resolver(this->get_io_service());
@@ -133,7 +135,8 @@ void FibersToSockets<Demux>::TcpSocketConnectHandler(
   }
 
   auto session = Session<Demux, Fiber, Tcp::socket>::create(
-      this->SelfFromThis(), std::move(*fiber_connection), std::move(*socket));
+      this->SelfFromThis(), std::move(*fiber_connection), std::move(*socket),
+      this->buffer_limits());
   boost::system::error_code start_ec;
   manager_.start(session, start_ec);
   if (start_ec) {
@@ -1,7 +1,6 @@
 #ifndef SSF_SERVICES_FIBERS_TO_SOCKETS_SESSION_H_
 #define SSF_SERVICES_FIBERS_TO_SOCKETS_SESSION_H_
 
-#include <array>
 #include <memory>
 
 #include <boost/system/error_code.hpp>
@@ -11,6 +10,7 @@
 #include <ssf/log/log.h>
 
 #include "ssf/network/base_session.h"  // NOLINT
+#include "ssf/network/buffer_pool.h"
 #include "ssf/network/socket_link.h"
 
 namespace ssf {
@@ -20,10 +20,6 @@ namespace fibers_to_sockets {
 /// Create a Full Duplex Forwarding Link
 template <typename Demux, typename InwardStream, typename ForwardStream>
 class Session : public ssf::BaseSession {
- private:
-  /// Buffer type for the transiting data
-  using StreamBuf = std::array<char, 50 * 1024>;
-
  public:
   using Server = FibersToSockets<Demux>;
   using FibersToSocketsWPtr = std::weak_ptr<Server>;
@@ -78,10 +74,11 @@ class Session : public ssf::BaseSession {
  private:
   /// The constructor is made private to ensure users only use create()
   Session(FibersToSocketsWPtr server, InwardStream inbound,
-          ForwardStream outbound)
+          ForwardStream outbound, const BufferLimits& buffer_limits)
       : server_(server),
         inbound_(std::move(inbound)),
-        outbound_(std::move(outbound)) {}
+        outbound_(std::move(outbound)),
+        buffer_limits_(buffer_limits) {}
 
   /// Start forwarding
   void DoForward() {
@@ -91,10 +88,10 @@ class Session : public ssf::BaseSession {
 
     // Make two Half Duplex links to have a Full Duplex Link
     AsyncEstablishHDLink(ReadFrom(inbound_), WriteTo(outbound_),
-                         boost::asio::buffer(inwardBuffer_), stop_handler);
+                         buffer_limits_, stop_handler);
 
     AsyncEstablishHDLink(ReadFrom(outbound_), WriteTo(inbound_),
-                         boost::asio::buffer(forwardBuffer_), stop_handler);
+                         buffer_limits_, stop_handler);
   }
 
   /// Stop forwarding
@@ -112,9 +109,8 @@ class Session : public ssf::BaseSession {
   InwardStream inbound_;
   ForwardStream outbound_;
 
-  // One buffer for each Half Duplex Link
-  StreamBuf inwardBuffer_;
-  StreamBuf forwardBuffer_;
+  // Bounds of the pooled buffer of each Half Duplex Link
+  BufferLimits buffer_limits_;
 };
 
 }  // fibers_to_sockets
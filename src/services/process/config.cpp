@@ -7,7 +7,7 @@ namespace process {
 Config::Config() : BaseServiceConfig(false), path_(""), args_("") {}
 
 Config::Config(const Config& process_service)
-    : BaseServiceConfig(process_service.enabled()),
+    : BaseServiceConfig(process_service),
       path_(process_service.path_),
       args_(process_service.args_) {}
 
@@ -99,7 +99,8 @@ class Server : public BaseService<Demux> {
       return Server::Create(io_service, fiber_demux, parameters, bin_path,
                             bin_args);
     };
-    p_factory->RegisterServiceCreator(kFactoryId, creator);
+    p_factory->RegisterServiceCreator(kFactoryId, creator,
+                                      config.fiber_weight());
   }
 
   // Function used to create service request
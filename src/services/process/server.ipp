@@ -19,7 +19,7 @@ Server<Demux>::Server(boost::asio::io_service& io_service, Demux& fiber_demux,
                       const std::string& binary_args)
     : ssf::BaseService<Demux>::BaseService(io_service, fiber_demux),
       fiber_acceptor_(io_service),
-      session_manager_(),
+      session_manager_("services.shell"),
       local_port_(port),
       binary_path_(binary_path),
       binary_args_(binary_args) {}
@@ -40,6 +40,7 @@ void Server<Demux>::start(boost::system::error_code& ec) {
     SSF_LOG("microservice", error, "[shell]: fiber acceptor could not listen");
     return;
   }
+  this->apply_fiber_weight(fiber_acceptor_);
 
   if (!CheckBinaryPath()) {
     SSF_LOG("microservice", error, "[shell]: binary not found");
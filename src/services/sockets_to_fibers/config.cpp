@@ -7,7 +7,7 @@ namespace sockets_to_fibers {
 Config::Config() : BaseServiceConfig(true), gateway_ports_(false) {}
 
 Config::Config(const Config& stream_listener)
-    : BaseServiceConfig(stream_listener.enabled()),
+    : BaseServiceConfig(stream_listener),
       gateway_ports_(stream_listener.gateway_ports_) {}
 
 }  // sockets_to_fibers
@@ -132,7 +132,9 @@ class SocketsToFibers : public BaseService<Demux> {
       return SocketsToFibers::Create(io_service, fiber_demux, parameters,
                                      gateway_ports);
     };
-    p_factory->RegisterServiceCreator(kFactoryId, creator);
+    p_factory->RegisterServiceCreator(kFactoryId, creator,
+                                      config.fiber_weight(),
+                                      config.buffer_limits());
   }
 
   static ssf::services::admin::CreateServiceRequest<Demux> GetCreateRequest(
@@ -18,7 +18,8 @@ SocketsToFibers<Demux>::SocketsToFibers(boost::asio::io_service& io_service,
       local_addr_(local_addr),
       local_port_(local_port),
       remote_port_(remote_port),
-      socket_acceptor_(io_service) {}
+      socket_acceptor_(io_service),
+      manager_("services.stream_listener") {}
 
 template <typename Demux>
 void SocketsToFibers<Demux>::start(boost::system::error_code& ec) {
@@ -134,6 +135,7 @@ void SocketsToFibers<Demux>::SocketAcceptHandler(
   }
 
   FiberPtr fiber_connection = std::make_shared<Fiber>(this->get_io_service());
+  this->apply_fiber_weight(*fiber_connection);
   FiberEndpoint ep(this->get_demux(), remote_port_);
 
   auto self = this->shared_from_this();
@@ -160,7 +162,7 @@ void SocketsToFibers<Demux>::FiberConnectHandler(
 
   auto session = Session<Demux, Tcp::socket, Fiber>::create(
       this->SelfFromThis(), std::move(*socket_connection),
-      std::move(*fiber_connection));
+      std::move(*fiber_connection), this->buffer_limits());
   boost::system::error_code start_ec;
   manager_.start(session, start_ec);
   if (start_ec) {
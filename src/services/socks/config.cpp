@@ -7,7 +7,7 @@ namespace socks {
 Config::Config() : BaseServiceConfig(true) {}
 
 Config::Config(const Config& process_service)
-    : BaseServiceConfig(process_service.enabled()) {}
+    : BaseServiceConfig(process_service) {}
 
 }  // socks
 }  // services
@@ -82,7 +82,9 @@ class SocksServer : public BaseService<Demux> {
                       const Parameters& parameters) {
       return SocksServer::Create(io_service, fiber_demux, parameters);
     };
-    p_factory->RegisterServiceCreator(kFactoryId, creator);
+    p_factory->RegisterServiceCreator(kFactoryId, creator,
+                                      config.fiber_weight(),
+                                      config.buffer_limits());
   }
 
   // Generate create service request
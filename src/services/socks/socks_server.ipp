@@ -20,7 +20,7 @@ SocksServer<Demux>::SocksServer(boost::asio::io_service& io_service,
                                 Demux& fiber_demux, const LocalPortType& port)
     : ssf::BaseService<Demux>::BaseService(io_service, fiber_demux),
       fiber_acceptor_(io_service),
-      session_manager_(),
+      session_manager_("services.socks"),
       local_port_(port) {
   // The init_ec will be returned when start() is called
   // fiber_acceptor_.open();
@@ -38,6 +38,7 @@ void SocksServer<Demux>::start(boost::system::error_code& ec) {
     return;
   }
 
+  this->apply_fiber_weight(fiber_acceptor_);
   this->AsyncAcceptFiber();
 }
 
@@ -105,7 +106,8 @@ void SocksServer<Demux>::FiberAcceptHandler(
             SSF_LOG("microservice", trace, "[socks]: version accepted: v4");
             ssf::BaseSessionPtr new_socks_session =
                 std::make_shared<v4::Session<Demux> >(
-                    this->SelfFromThis(), std::move(*fiber_connection));
+                    this->SelfFromThis(), std::move(*fiber_connection),
+                    this->buffer_limits());
             boost::system::error_code e;
             session_manager_.start(new_socks_session, e);
             break;
@@ -114,7 +116,8 @@ void SocksServer<Demux>::FiberAcceptHandler(
             SSF_LOG("microservice", trace, "[socks]: version accepted: v5");
             ssf::BaseSessionPtr new_socks_session =
                 std::make_shared<v5::Session<Demux> >(
-                    this->SelfFromThis(), std::move(*fiber_connection));
+                    this->SelfFromThis(), std::move(*fiber_connection),
+                    this->buffer_limits());
             boost::system::error_code e;
             session_manager_.start(new_socks_session, e);
             break;
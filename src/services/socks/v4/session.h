@@ -29,7 +29,6 @@ namespace v4 {
 template <typename Demux>
 class Session : public ssf::BaseSession {
  private:
-  using StreamBuf = std::array<char, 50 * 1024>;
   using Tcp = boost::asio::ip::tcp;
   using Fiber = typename boost::asio::fiber::stream_fiber<
       typename Demux::socket_type>::socket;
@@ -41,7 +40,8 @@ class Session : public ssf::BaseSession {
   using SocksServerWPtr = std::weak_ptr<Server>;
 
  public:
-  Session(SocksServerWPtr p_socks_server, Fiber client);
+  Session(SocksServerWPtr p_socks_server, Fiber client,
+          const BufferLimits& buffer_limits);
 
  public:
   virtual void start(boost::system::error_code&);
@@ -79,8 +79,8 @@ class Session : public ssf::BaseSession {
 
   Request request_;
 
-  std::shared_ptr<StreamBuf> upstream_;
-  std::shared_ptr<StreamBuf> downstream_;
+  // Bounds of the pooled buffer of each half duplex link
+  BufferLimits buffer_limits_;
 };
 
 template <class VerifyHandler, class StreamSocket>
@@ -13,13 +13,15 @@ namespace socks {
 namespace v5 {
 
 template <typename Demux>
-Session<Demux>::Session(SocksServerWPtr socks_server, Fiber client)
+Session<Demux>::Session(SocksServerWPtr socks_server, Fiber client,
+                        const BufferLimits& buffer_limits)
     : ssf::BaseSession(),
       io_service_(client.get_io_service()),
       socks_server_(socks_server),
       client_(std::move(client)),
       server_(io_service_),
-      server_resolver_(io_service_) {}
+      server_resolver_(io_service_),
+      buffer_limits_(buffer_limits) {}
 
 template <typename Demux>
 void Session<Demux>::HandleStop() {
@@ -263,15 +265,12 @@ template <typename Demux>
 void Session<Demux>::EstablishLink() {
   auto self = SelfFromThis();
 
-  upstream_.reset(new StreamBuf());
-  downstream_.reset(new StreamBuf());
-
   AsyncEstablishHDLink(ssf::ReadFrom(client_), ssf::WriteTo(server_),
-                       boost::asio::buffer(*upstream_),
+                       buffer_limits_,
                        std::bind(&Session<Demux>::HandleStop, self));
 
   AsyncEstablishHDLink(ssf::ReadFrom(server_), ssf::WriteTo(client_),
-                       boost::asio::buffer(*downstream_),
+                       buffer_limits_,
                        std::bind(&Session<Demux>::HandleStop, self));
 }
 }  // v5
@@ -19,13 +19,14 @@ TEST(StandardCommandLineTests, ServerTest) {
 
   ASSERT_FALSE(cmd.show_status());
   ASSERT_FALSE(cmd.relay_only());
+  ASSERT_FALSE(cmd.io_per_core());
   ASSERT_FALSE(cmd.gateway_ports());
 
   boost::system::error_code ec;
 
   std::vector<const char*> argv = {
       "test_exec", "-p", "8012", "-c", "config_file.json", "-v", "critical",
-      "-S",        "-R", "-g",   "-l", "127.0.0.1"};
+      "-S",        "-R", "-g",   "-l", "127.0.0.1",        "--io-per-core"};
 
   cmd.Parse(static_cast<int>(argv.size()), const_cast<char**>(argv.data()), ec);
 
@@ -40,6 +41,7 @@ TEST(StandardCommandLineTests, ServerTest) {
 
   ASSERT_TRUE(cmd.show_status());
   ASSERT_TRUE(cmd.relay_only());
+  ASSERT_TRUE(cmd.io_per_core());
   ASSERT_TRUE(cmd.gateway_ports());
 }
 
@@ -59,6 +59,25 @@ TEST_F(LoadConfigTest, DefaultValueTest) {
   ASSERT_FALSE(config_.tls().dh().IsBuffer());
   ASSERT_EQ(config_.tls().dh().value(), "./certs/dh4096.pem");
   ASSERT_EQ(config_.tls().cipher_alg(), "DHE-RSA-AES256-GCM-SHA384");
+  ASSERT_FALSE(config_.tls().session_resumption());
+  ASSERT_EQ(config_.tls().session_lifetime(), 3600u);
+  ASSERT_FALSE(config_.tls().direct_read());
+  ASSERT_EQ(config_.tls().direct_read_threshold(), 4u * 1024);
+  ASSERT_EQ(config_.tls().receive_buffer_size(), 50u * 1024);
+  ASSERT_EQ(config_.tls().receive_queue_low_bound(), 1024u * 1024);
+  ASSERT_EQ(config_.tls().receive_queue_high_bound(), 16u * 1024 * 1024);
+  ASSERT_FALSE(config_.tls().kernel_tls());
+
+  ASSERT_FALSE(config_.logging().async());
+  ASSERT_EQ(config_.logging().queue_size(), 8192u);
+  ASSERT_EQ(config_.logging().overflow_policy(),
+            ssf::log::OverflowPolicy::kDrop);
+
+  ASSERT_FALSE(config_.metrics().enabled());
+  ASSERT_EQ(config_.metrics().file(), "");
+  ASSERT_EQ(config_.metrics().period(), 10u);
+  ASSERT_FALSE(config_.metrics().remote());
+  ASSERT_FALSE(config_.metrics().serve());
 
   ASSERT_EQ(config_.http_proxy().host(), "");
   ASSERT_EQ(config_.http_proxy().port(), "");
@@ -143,6 +162,14 @@ TEST_F(LoadConfigTest, LoadTlsCompleteFileTest) {
   ASSERT_FALSE(config_.tls().dh().IsBuffer());
   ASSERT_EQ(config_.tls().dh().value(), "test_dh_path");
   ASSERT_EQ(config_.tls().cipher_alg(), "test_cipher_alg");
+  ASSERT_TRUE(config_.tls().session_resumption());
+  ASSERT_EQ(config_.tls().session_lifetime(), 600u);
+  ASSERT_TRUE(config_.tls().direct_read());
+  ASSERT_EQ(config_.tls().direct_read_threshold(), 16384u);
+  ASSERT_EQ(config_.tls().receive_buffer_size(), 65536u);
+  ASSERT_EQ(config_.tls().receive_queue_low_bound(), 524288u);
+  ASSERT_EQ(config_.tls().receive_queue_high_bound(), 4194304u);
+  ASSERT_TRUE(config_.tls().kernel_tls());
 
   ASSERT_EQ(config_.http_proxy().host(), "");
   ASSERT_EQ(config_.http_proxy().port(), "");
@@ -198,6 +225,20 @@ TEST_F(LoadConfigTest, LoadServicesFileTest) {
   ASSERT_FALSE(config_.services().datagram_forwarder().enabled());
   ASSERT_FALSE(config_.services().datagram_listener().enabled());
   ASSERT_TRUE(config_.services().datagram_listener().gateway_ports());
+  ASSERT_EQ(config_.services().datagram_listener().flow_limits().max_flows,
+            256u);
+  ASSERT_EQ(
+      config_.services().datagram_listener().flow_limits().idle_timeout.count(),
+      15);
+  ASSERT_EQ(config_.services().datagram_forwarder().flow_limits().max_flows,
+            4096u);
+  ASSERT_EQ(config_.services().datagram_forwarder().flow_limits().queue_size,
+            32u);
+  ASSERT_EQ(
+      config_.services().datagram_forwarder().flow_limits().overflow_policy,
+      ssf::QueueOverflowPolicy::kDropOldest);
+  ASSERT_EQ(config_.services().datagram_listener().flow_limits().queue_size,
+            64u);
   ASSERT_TRUE(config_.services().copy().enabled());
   ASSERT_FALSE(config_.services().socks().enabled());
   ASSERT_FALSE(config_.services().stream_forwarder().enabled());
@@ -207,6 +248,14 @@ TEST_F(LoadConfigTest, LoadServicesFileTest) {
 
   ASSERT_EQ(config_.services().process().path(), "/bin/custom_path");
   ASSERT_EQ(config_.services().process().args(), "-custom args");
+  ASSERT_EQ(config_.services().process().fiber_weight(), 4);
+  ASSERT_EQ(config_.services().copy().fiber_weight(), 1);
+  ASSERT_EQ(config_.services().stream_forwarder().buffer_limits().min_size,
+            8192u);
+  ASSERT_EQ(config_.services().stream_forwarder().buffer_limits().max_size,
+            262144u);
+  ASSERT_EQ(config_.services().socks().buffer_limits().min_size, 4096u);
+  ASSERT_EQ(config_.services().socks().buffer_limits().max_size, 65536u);
 }
 
 TEST_F(LoadConfigTest, LoadCircuitFileTest) {
@@ -227,6 +276,31 @@ TEST_F(LoadConfigTest, LoadCircuitFileTest) {
   ASSERT_EQ(node_it->port(), "8013");
 }
 
+TEST_F(LoadConfigTest, LoadLoggingFileTest) {
+  boost::system::error_code ec;
+
+  config_.UpdateFromFile("./config_files/logging.json", ec);
+
+  ASSERT_EQ(ec.value(), 0) << "Success if complete file format";
+  ASSERT_TRUE(config_.logging().async());
+  ASSERT_EQ(config_.logging().queue_size(), 1024u);
+  ASSERT_EQ(config_.logging().overflow_policy(),
+            ssf::log::OverflowPolicy::kBlock);
+}
+
+TEST_F(LoadConfigTest, LoadMetricsFileTest) {
+  boost::system::error_code ec;
+
+  config_.UpdateFromFile("./config_files/metrics.json", ec);
+
+  ASSERT_EQ(ec.value(), 0) << "Success if complete file format";
+  ASSERT_TRUE(config_.metrics().enabled());
+  ASSERT_EQ(config_.metrics().file(), "ssf_metrics.jsonl");
+  ASSERT_EQ(config_.metrics().period(), 2u);
+  ASSERT_TRUE(config_.metrics().remote());
+  ASSERT_TRUE(config_.metrics().serve());
+}
+
 TEST_F(LoadConfigTest, LoadArgumentsFileTest) {
   boost::system::error_code ec;
 
@@ -0,0 +1,96 @@
+#include <future>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "core/async_engine.h"
+
+namespace {
+
+// Run a handler on the io_service and wait for it
+template <class Handler>
+void RunOn(boost::asio::io_service& io_service, Handler handler) {
+  std::promise<void> done;
+  io_service.post([&handler, &done]() {
+    handler();
+    done.set_value();
+  });
+  done.get_future().wait();
+}
+
+}  // namespace
+
+TEST(AsyncEngineTests, PerCoreWorkersFollowTheAllowedCores) {
+  auto cores = ssf::AsyncEngine::AllowedCores();
+  ASSERT_FALSE(cores.empty());
+#if defined(__linux__)
+  cpu_set_t process_set;
+  CPU_ZERO(&process_set);
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(process_set), &process_set));
+  ASSERT_EQ(static_cast<std::size_t>(CPU_COUNT(&process_set)), cores.size());
+#endif
+
+  ssf::AsyncEngine engine(ssf::AsyncEngine::Mode::kPerCore);
+  // One worker io_service per allowed core next to the main io_service
+  ASSERT_EQ(cores.size() + 1, engine.io_service_count());
+  engine.Start();
+
+  std::thread::id main_thread;
+  RunOn(engine.get_io_service(),
+        [&main_thread]() { main_thread = std::this_thread::get_id(); });
+
+  std::set<std::thread::id> worker_threads;
+  std::set<int> worker_cores;
+  for (std::size_t i = 0; i < cores.size(); ++i) {
+    auto& io_service = engine.GetNextIoService();
+    ASSERT_NE(&engine.get_io_service(), &io_service);
+
+    // Everything posted on a worker io_service runs on the same thread
+    std::thread::id first_thread;
+    RunOn(io_service,
+          [&first_thread]() { first_thread = std::this_thread::get_id(); });
+    std::thread::id second_thread;
+    RunOn(io_service,
+          [&second_thread]() { second_thread = std::this_thread::get_id(); });
+    ASSERT_EQ(first_thread, second_thread);
+    ASSERT_NE(main_thread, first_thread);
+    worker_threads.insert(first_thread);
+
+#if defined(__linux__)
+    // The worker is pinned to a single core of the process affinity
+    cpu_set_t thread_set;
+    CPU_ZERO(&thread_set);
+    RunOn(io_service, [&thread_set]() {
+      pthread_getaffinity_np(pthread_self(), sizeof(thread_set), &thread_set);
+    });
+    ASSERT_EQ(1, CPU_COUNT(&thread_set));
+    for (auto core : cores) {
+      if (CPU_ISSET(core, &thread_set)) {
+        worker_cores.insert(static_cast<int>(core));
+      }
+    }
+#endif
+  }
+
+  // Round robin over distinct workers, one per core
+  ASSERT_EQ(cores.size(), worker_threads.size());
+#if defined(__linux__)
+  ASSERT_EQ(cores.size(), worker_cores.size());
+#endif
+
+  engine.Stop();
+}
+
+TEST(AsyncEngineTests, SharedModeHasOneIoService) {
+  ssf::AsyncEngine engine(ssf::AsyncEngine::Mode::kShared);
+  ASSERT_EQ(1u, engine.io_service_count());
+  ASSERT_EQ(&engine.get_io_service(), &engine.GetNextIoService());
+}
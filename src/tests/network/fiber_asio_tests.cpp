@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <iterator>
 #include <future>
 #include <list>
 #include <memory>
@@ -17,7 +21,9 @@
 #include "common/boost/fiber/basic_endpoint.hpp"
 #include "common/boost/fiber/basic_fiber_demux.hpp"
 #include "common/boost/fiber/datagram_fiber.hpp"
+#include "common/boost/fiber/detail/fiber_header.hpp"
 #include "common/boost/fiber/stream_fiber.hpp"
+#include "common/error/error.h"
 
 #include "tests/tls_config_helper.h"
 
@@ -44,7 +50,9 @@ class FiberTest : public ::testing::Test {
         query_server_(boost::asio::ip::tcp::v4(), "127.0.0.1", "9011"),
         endpoint_server_(*resolver_server_.resolve(query_server_)),
         demux_server_(io_service_server_),
-        server_ready_() {}
+        server_ready_(),
+        server_mtu_(fiber_demux::kDefaultMTU),
+        client_mtu_(fiber_demux::kDefaultMTU) {}
 
   ~FiberTest() {}
 
@@ -98,7 +106,8 @@ class FiberTest : public ::testing::Test {
     auto accepted_lambda = [this,
                             accept_h](const boost::system::error_code& ec) {
       if (!ec) {
-        this->demux_server_.fiberize(std::move(this->socket_server_));
+        this->demux_server_.fiberize(
+            std::move(this->socket_server_), []() {}, this->server_mtu_);
       }
 
       this->server_ready_.set_value(!ec);
@@ -130,7 +139,8 @@ class FiberTest : public ::testing::Test {
     auto connected_lambda = [this, connect_h](
         const boost::system::error_code& ec, tcp_endpoint_it ep_it) {
       if (!ec) {
-        this->demux_client_.fiberize(std::move(this->socket_client_));
+        this->demux_client_.fiberize(
+            std::move(this->socket_client_), []() {}, this->client_mtu_);
       }
 
       this->client_ready_.set_value(!ec);
@@ -190,6 +200,99 @@ class FiberTest : public ::testing::Test {
   boost::asio::ip::tcp::endpoint endpoint_server_;
   fiber_demux demux_server_;
   std::promise<bool> server_ready_;
+
+  // maximum frame payload sizes of the demuxes (negotiated by the transport
+  // handshake in SSF)
+  size_t server_mtu_;
+  size_t client_mtu_;
+};
+
+class JumboFiberTest : public FiberTest {
+ protected:
+  enum { kJumboMTU = 256 * 1024 };
+
+  JumboFiberTest() {
+    server_mtu_ = kJumboMTU;
+    client_mtu_ = kJumboMTU;
+  }
+};
+
+// The client demux sends frames larger than the server demux accepts
+class MismatchedMTUFiberTest : public FiberTest {
+ protected:
+  enum { kClientMTU = 256 * 1024 };
+
+  MismatchedMTUFiberTest() { client_mtu_ = kClientMTU; }
+};
+
+// Stream fibers connected through the demuxes with credit-based flow control
+class FlowControlFiberTest : public FiberTest {
+ protected:
+  typedef boost::asio::fiber::detail::basic_fiber_impl<socket> fiber_impl;
+
+  enum { kWindow = fiber_impl::kDefaultReceiveWindow };
+
+  // Connect a client fiber to a fiber accepted on the server demux
+  bool ConnectFibers(fiber_acceptor& fib_acceptor, fiber& fib_server,
+                     fiber& fib_client) {
+    std::promise<boost::system::error_code> accepted;
+    std::promise<boost::system::error_code> connected;
+
+    boost::system::error_code acceptor_ec;
+    fiber_endpoint server_endpoint(stream_fiber::v1(), demux_server_, 1);
+    fib_acceptor.open(server_endpoint.protocol(), acceptor_ec);
+    fib_acceptor.bind(server_endpoint, acceptor_ec);
+    fib_acceptor.listen(boost::asio::socket_base::max_connections,
+                        acceptor_ec);
+    fib_acceptor.async_accept(
+        fib_server, [&accepted](const boost::system::error_code& ec) {
+          accepted.set_value(ec);
+        });
+
+    fiber_endpoint client_endpoint(stream_fiber::v1(), demux_client_, 1);
+    fib_client.async_connect(
+        client_endpoint, [&connected](const boost::system::error_code& ec) {
+          connected.set_value(ec);
+        });
+
+    auto accept_ec = accepted.get_future().get();
+    auto connect_ec = connected.get_future().get();
+    return !accept_ec && !connect_ec;
+  }
+
+  // Wait until a send of the fiber is parked for lack of credits
+  bool WaitParkedSend(fiber& fib) {
+    auto p_impl = fib.native_handle();
+    for (int i = 0; i < 500; ++i) {
+      {
+        std::unique_lock<std::recursive_mutex> lock(p_impl->credit_mutex);
+        if (!p_impl->pending_sends.empty()) {
+          return true;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  // Read exactly size bytes from the fiber
+  boost::system::error_code Read(fiber& fib, uint8_t* data, size_t size) {
+    std::promise<boost::system::error_code> read;
+    boost::asio::async_read(
+        fib, boost::asio::buffer(data, size),
+        [&read](const boost::system::error_code& ec, size_t) {
+          read.set_value(ec);
+        });
+    return read.get_future().get();
+  }
+
+  static std::vector<uint8_t> MakeData(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = static_cast<uint8_t>(i % 251);
+    }
+    return data;
+  }
 };
 
 //-----------------------------------------------------------------------------
@@ -254,6 +357,54 @@ TEST_F(FiberTest, ConnectDisconnectFiberFromServer) {
   fib_acceptor.close(close_fib_acceptor_ec);
 }
 
+//----------------------------------------------------------------------------
+TEST_F(FiberTest, AcceptedFiberInheritsWeight) {
+  Wait();
+
+  std::promise<bool> accepted;
+  std::promise<bool> connected;
+
+  fiber_acceptor fib_acceptor(io_service_server_);
+  fiber fib_server(io_service_server_);
+  fiber fib_client(io_service_client_);
+
+  fiber_endpoint fib_server_endpoint(
+      boost::asio::fiber::stream_fiber<socket>::v1(), demux_server_, 1);
+  fib_acceptor.open(fib_server_endpoint.protocol());
+  boost::system::error_code acceptor_ec;
+  fib_acceptor.bind(fib_server_endpoint, acceptor_ec);
+  fib_acceptor.listen();
+  fib_acceptor.set_option(stream_fiber::weight(8));
+  fib_acceptor.async_accept(
+      fib_server, [&accepted](const boost::system::error_code& ec) {
+        accepted.set_value(!ec);
+      });
+
+  fib_client.set_option(stream_fiber::weight(3));
+  fiber_endpoint fib_client_endpoint(
+      boost::asio::fiber::stream_fiber<socket>::v1(), demux_client_, 1);
+  fib_client.async_connect(
+      fib_client_endpoint, [&connected](const boost::system::error_code& ec) {
+        connected.set_value(!ec);
+      });
+
+  ASSERT_TRUE(accepted.get_future().get());
+  ASSERT_TRUE(connected.get_future().get());
+
+  stream_fiber::weight server_weight;
+  fib_server.get_option(server_weight);
+  ASSERT_EQ(server_weight.value(), 8);
+
+  stream_fiber::weight client_weight;
+  fib_client.get_option(client_weight);
+  ASSERT_EQ(client_weight.value(), 3);
+
+  boost::system::error_code close_ec;
+  fib_client.close(close_ec);
+  fib_server.close(close_ec);
+  fib_acceptor.close(close_ec);
+}
+
 //----------------------------------------------------------------------------
 TEST_F(FiberTest, ConnectDisconnectFiberFromClient) {
   Wait();
@@ -737,6 +888,329 @@ TEST_F(FiberTest, ExchangePacketsFiveClients) {
   ASSERT_EQ(finished, true) << "Test did not finish completely";
 }
 
+//----------------------------------------------------------------------------
+TEST_F(FiberTest, ExchangePacketsTwoLinks) {
+  Wait();
+
+  typedef std::array<uint8_t, 5> buffer_type;
+
+  struct TestConnection {
+    TestConnection(boost::asio::io_service& io_service_server,
+                   boost::asio::io_service& io_service_client)
+        : fib_server(io_service_server), fib_client(io_service_client) {}
+
+    fiber fib_server;
+    fiber fib_client;
+    buffer_type buffer_server;
+    buffer_type buffer_client;
+    buffer_type buffer_echo;
+    std::promise<bool> server_done;
+    std::promise<bool> client_done;
+  };
+
+  // Second link between the demultiplexers
+  socket link_server(io_service_server_);
+  socket link_client(io_service_client_);
+  std::promise<bool> link_accepted;
+  acceptor_server_.async_accept(
+      link_server, [&link_accepted](const boost::system::error_code& ec) {
+        link_accepted.set_value(!ec);
+      });
+  boost::system::error_code link_ec;
+  boost::asio::connect(link_client, iterator_client_, link_ec);
+  ASSERT_EQ(link_ec.value(), 0);
+  ASSERT_TRUE(link_accepted.get_future().get());
+
+  demux_server_.add_link(std::move(link_server), link_ec);
+  ASSERT_EQ(link_ec.value(), 0);
+  demux_client_.add_link(std::move(link_client), link_ec);
+  ASSERT_EQ(link_ec.value(), 0);
+  ASSERT_EQ(2, demux_server_.link_count());
+  ASSERT_EQ(2, demux_client_.link_count());
+
+  uint32_t connection_number = 8;
+  fiber_acceptor fib_acceptor(io_service_server_);
+  std::list<TestConnection> test_connections;
+
+  // The server echoes one packet on each fiber
+  auto async_accept_h = [](TestConnection& connection,
+                           const boost::system::error_code& ec) {
+    if (ec) {
+      connection.server_done.set_value(false);
+      return;
+    }
+    boost::asio::async_read(
+        connection.fib_server, boost::asio::buffer(connection.buffer_server),
+        [&connection](const boost::system::error_code& ec, std::size_t) {
+          if (ec) {
+            connection.server_done.set_value(false);
+            return;
+          }
+          boost::asio::async_write(
+              connection.fib_server,
+              boost::asio::buffer(connection.buffer_server),
+              [&connection](const boost::system::error_code& ec, std::size_t) {
+                connection.server_done.set_value(!ec);
+              });
+        });
+  };
+
+  auto async_connect_h = [](TestConnection& connection,
+                            const boost::system::error_code& ec) {
+    if (ec) {
+      connection.client_done.set_value(false);
+      return;
+    }
+    boost::asio::async_write(
+        connection.fib_client, boost::asio::buffer(connection.buffer_client),
+        [&connection](const boost::system::error_code& ec, std::size_t) {
+          if (ec) {
+            connection.client_done.set_value(false);
+            return;
+          }
+          boost::asio::async_read(
+              connection.fib_client,
+              boost::asio::buffer(connection.buffer_echo),
+              [&connection](const boost::system::error_code& ec, std::size_t) {
+                connection.client_done.set_value(
+                    !ec && connection.buffer_echo == connection.buffer_client);
+              });
+        });
+  };
+
+  boost::system::error_code acceptor_ec;
+  fiber_endpoint server_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_server_, 1);
+  fib_acceptor.open(server_endpoint.protocol(), acceptor_ec);
+  fib_acceptor.bind(server_endpoint, acceptor_ec);
+  fib_acceptor.listen(boost::asio::socket_base::max_connections, acceptor_ec);
+
+  fiber_endpoint client_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_client_, 1);
+
+  for (uint32_t i = 0; i < connection_number; ++i) {
+    test_connections.emplace_front(io_service_server_, io_service_client_);
+    auto& test_connection = test_connections.front();
+    test_connection.buffer_client.fill(static_cast<uint8_t>('a' + i));
+    fib_acceptor.async_accept(test_connection.fib_server,
+                              std::bind(async_accept_h,
+                                        std::ref(test_connection),
+                                        std::placeholders::_1));
+    test_connection.fib_client.async_connect(
+        client_endpoint, std::bind(async_connect_h, std::ref(test_connection),
+                                   std::placeholders::_1));
+  }
+
+  for (auto& test_connection : test_connections) {
+    EXPECT_TRUE(test_connection.client_done.get_future().get());
+    EXPECT_TRUE(test_connection.server_done.get_future().get());
+  }
+
+  boost::system::error_code close_ec;
+  for (auto& test_connection : test_connections) {
+    test_connection.fib_client.close(close_ec);
+    test_connection.fib_server.close(close_ec);
+  }
+  fib_acceptor.close(close_ec);
+}
+
+//-----------------------------------------------------------------------------
+TEST_F(FiberTest, LinkLossResetsItsFibers) {
+  Wait();
+
+  typedef std::array<uint8_t, 5> buffer_type;
+
+  struct TestConnection {
+    TestConnection(boost::asio::io_service& io_service_server,
+                   boost::asio::io_service& io_service_client)
+        : fib_server(io_service_server),
+          fib_client(io_service_client),
+          echoed(0) {}
+
+    fiber fib_server;
+    fiber fib_client;
+    buffer_type buffer_server;
+    buffer_type buffer_client;
+    buffer_type buffer_echo;
+    std::function<void()> echo;
+    uint32_t echoed;
+    std::promise<bool> connected;
+    std::promise<bool> client_done;
+    std::promise<uint32_t> server_done;
+  };
+
+  // Second link between the demultiplexers
+  socket link_server(io_service_server_);
+  socket link_client(io_service_client_);
+  std::promise<bool> link_accepted;
+  acceptor_server_.async_accept(
+      link_server, [&link_accepted](const boost::system::error_code& ec) {
+        link_accepted.set_value(!ec);
+      });
+  boost::system::error_code link_ec;
+  boost::asio::connect(link_client, iterator_client_, link_ec);
+  ASSERT_EQ(link_ec.value(), 0);
+  ASSERT_TRUE(link_accepted.get_future().get());
+
+  // The socket is moved in the demux: its handle is kept to break the link
+  auto link_handle = link_client.native_handle();
+  demux_server_.add_link(std::move(link_server), link_ec);
+  ASSERT_EQ(link_ec.value(), 0);
+  demux_client_.add_link(std::move(link_client), link_ec);
+  ASSERT_EQ(link_ec.value(), 0);
+
+  uint32_t connection_number = 8;
+  fiber_acceptor fib_acceptor(io_service_server_);
+  std::list<TestConnection> test_connections;
+
+  // The server echoes the packets of each fiber until it is closed
+  auto async_accept_h = [](TestConnection& connection,
+                           const boost::system::error_code& ec) {
+    if (ec) {
+      connection.server_done.set_value(0);
+      return;
+    }
+    connection.echo = [&connection]() {
+      boost::asio::async_read(
+          connection.fib_server, boost::asio::buffer(connection.buffer_server),
+          [&connection](const boost::system::error_code& ec, std::size_t) {
+            if (ec) {
+              connection.server_done.set_value(connection.echoed);
+              return;
+            }
+            boost::asio::async_write(
+                connection.fib_server,
+                boost::asio::buffer(connection.buffer_server),
+                [&connection](const boost::system::error_code& ec,
+                              std::size_t) {
+                  if (ec) {
+                    connection.server_done.set_value(connection.echoed);
+                    return;
+                  }
+                  ++connection.echoed;
+                  connection.echo();
+                });
+          });
+    };
+    connection.echo();
+  };
+
+  auto round_trip = [](TestConnection& connection, std::promise<bool>& done) {
+    boost::asio::async_write(
+        connection.fib_client, boost::asio::buffer(connection.buffer_client),
+        [&connection, &done](const boost::system::error_code& ec,
+                             std::size_t) {
+          if (ec) {
+            done.set_value(false);
+            return;
+          }
+          boost::asio::async_read(
+              connection.fib_client,
+              boost::asio::buffer(connection.buffer_echo),
+              [&connection, &done](const boost::system::error_code& ec,
+                                   std::size_t) {
+                done.set_value(!ec &&
+                               connection.buffer_echo ==
+                                   connection.buffer_client);
+              });
+        });
+  };
+
+  auto async_connect_h = [round_trip](TestConnection& connection,
+                                      const boost::system::error_code& ec) {
+    if (ec) {
+      connection.connected.set_value(false);
+      return;
+    }
+    round_trip(connection, connection.connected);
+  };
+
+  boost::system::error_code acceptor_ec;
+  fiber_endpoint server_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_server_, 1);
+  fib_acceptor.open(server_endpoint.protocol(), acceptor_ec);
+  fib_acceptor.bind(server_endpoint, acceptor_ec);
+  fib_acceptor.listen(boost::asio::socket_base::max_connections, acceptor_ec);
+
+  fiber_endpoint client_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_client_, 1);
+
+  auto connect = [&]() -> TestConnection& {
+    test_connections.emplace_back(io_service_server_, io_service_client_);
+    auto& test_connection = test_connections.back();
+    test_connection.buffer_client.fill(
+        static_cast<uint8_t>('a' + test_connections.size()));
+    fib_acceptor.async_accept(test_connection.fib_server,
+                              std::bind(async_accept_h,
+                                        std::ref(test_connection),
+                                        std::placeholders::_1));
+    test_connection.fib_client.async_connect(
+        client_endpoint, std::bind(async_connect_h, std::ref(test_connection),
+                                   std::placeholders::_1));
+    return test_connection;
+  };
+
+  for (uint32_t i = 0; i < connection_number; ++i) {
+    connect();
+  }
+  for (auto& test_connection : test_connections) {
+    ASSERT_TRUE(test_connection.connected.get_future().get());
+  }
+
+  // The owner of the demux is told to replace the lost link
+  std::promise<bool> link_lost;
+  demux_client_.set_link_lost_handler(
+      [&link_lost]() { link_lost.set_value(true); });
+
+  // Break the second link: both ends lose it
+  boost::system::error_code shutdown_ec;
+  boost::asio::detail::socket_ops::shutdown(
+      link_handle, boost::asio::socket_base::shutdown_both, shutdown_ec);
+  ASSERT_EQ(shutdown_ec.value(), 0);
+  for (int i = 0; i < 500 && (demux_client_.link_count() > 1 ||
+                              demux_server_.link_count() > 1);
+       ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(1, demux_client_.link_count());
+  ASSERT_EQ(1, demux_server_.link_count());
+  ASSERT_TRUE(link_lost.get_future().get());
+  demux_client_.set_link_lost_handler([]() {});
+
+  // The fibers of the lost link are reset on both ends, the others go on
+  std::vector<bool> alive;
+  for (auto& test_connection : test_connections) {
+    round_trip(test_connection, test_connection.client_done);
+    alive.push_back(test_connection.client_done.get_future().get());
+  }
+  auto lost = std::count(alive.begin(), alive.end(), false);
+  EXPECT_GT(lost, 0);
+  EXPECT_LT(lost, static_cast<long>(connection_number));
+
+  // A new fiber goes through the live link
+  auto& new_connection = connect();
+  EXPECT_TRUE(new_connection.connected.get_future().get());
+
+  boost::system::error_code close_ec;
+  for (auto& test_connection : test_connections) {
+    test_connection.fib_client.close(close_ec);
+  }
+
+  // Every reset reached the server fiber: none is left waiting for it
+  auto alive_it = alive.begin();
+  for (auto& test_connection : test_connections) {
+    auto echoed = test_connection.server_done.get_future().get();
+    if (alive_it != alive.end()) {
+      EXPECT_EQ(*alive_it ? 2u : 1u, echoed);
+      ++alive_it;
+    } else {
+      EXPECT_EQ(1u, echoed);
+    }
+    test_connection.fib_server.close(close_ec);
+  }
+  fib_acceptor.close(close_ec);
+}
+
 //-----------------------------------------------------------------------------
 TEST_F(FiberTest, TinyReceiverBuffer) {
   Wait();
@@ -833,6 +1307,438 @@ TEST_F(FiberTest, TinyReceiverBuffer) {
   fib_acceptor.close(close_fib_acceptor_ec);
 }
 
+//-----------------------------------------------------------------------------
+TEST_F(FiberTest, GatheredWritesKeepFramesInOrder) {
+  Wait();
+
+  // Small batches: the frames queued by the fibers span several writes
+  demux_client_.set_send_batch_limits(4 * 1024, 2);
+
+  struct TestConnection {
+    TestConnection(boost::asio::io_service& io_service_server,
+                   boost::asio::io_service& io_service_client)
+        : fib_server(io_service_server), fib_client(io_service_client) {}
+
+    fiber fib_server;
+    fiber fib_client;
+    std::vector<uint8_t> sent;
+    std::vector<uint8_t> received;
+    std::promise<boost::system::error_code> accepted;
+    std::promise<boost::system::error_code> connected;
+    std::promise<boost::system::error_code> written;
+    std::promise<boost::system::error_code> read;
+  };
+
+  const size_t connection_number = 8;
+  const size_t data_size = 256 * 1024;
+
+  boost::system::error_code acceptor_ec;
+  fiber_acceptor fib_acceptor(io_service_server_);
+  fiber_endpoint server_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_server_, 1);
+  fib_acceptor.open(server_endpoint.protocol(), acceptor_ec);
+  fib_acceptor.bind(server_endpoint, acceptor_ec);
+  fib_acceptor.listen(boost::asio::socket_base::max_connections, acceptor_ec);
+
+  fiber_endpoint client_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_client_, 1);
+
+  std::list<TestConnection> test_connections;
+  for (size_t i = 0; i < connection_number; ++i) {
+    test_connections.emplace_back(io_service_server_, io_service_client_);
+    auto& test_connection = test_connections.back();
+
+    // The first byte identifies the stream on the server
+    test_connection.sent.resize(data_size);
+    for (size_t j = 0; j < data_size; ++j) {
+      test_connection.sent[j] = static_cast<uint8_t>((j + 31 * i) % 251);
+    }
+
+    fib_acceptor.async_accept(
+        test_connection.fib_server,
+        [&test_connection](const boost::system::error_code& ec) {
+          test_connection.accepted.set_value(ec);
+        });
+    test_connection.fib_client.async_connect(
+        client_endpoint,
+        [&test_connection](const boost::system::error_code& ec) {
+          test_connection.connected.set_value(ec);
+        });
+  }
+
+  for (auto& test_connection : test_connections) {
+    ASSERT_EQ(test_connection.accepted.get_future().get().value(), 0);
+    ASSERT_EQ(test_connection.connected.get_future().get().value(), 0);
+  }
+
+  // Each fiber writes chunks of various sizes, some above the batch budget
+  std::function<void(TestConnection&, size_t, size_t)> write_chunk;
+  write_chunk = [&write_chunk](TestConnection& test_connection, size_t offset,
+                               size_t index) {
+    auto& sent = test_connection.sent;
+    if (offset == sent.size()) {
+      test_connection.written.set_value(boost::system::error_code());
+      return;
+    }
+
+    auto chunk_size =
+        std::min<size_t>(1 + (index * 397) % (6 * 1024), sent.size() - offset);
+    boost::asio::async_write(
+        test_connection.fib_client,
+        boost::asio::buffer(sent.data() + offset, chunk_size),
+        [&write_chunk, &test_connection, offset, chunk_size, index](
+            const boost::system::error_code& ec, size_t) {
+          if (ec) {
+            test_connection.written.set_value(ec);
+            return;
+          }
+          write_chunk(test_connection, offset + chunk_size, index + 1);
+        });
+  };
+
+  for (auto& test_connection : test_connections) {
+    test_connection.received.resize(data_size);
+    boost::asio::async_read(
+        test_connection.fib_server,
+        boost::asio::buffer(test_connection.received),
+        [&test_connection](const boost::system::error_code& ec, size_t) {
+          test_connection.read.set_value(ec);
+        });
+    write_chunk(test_connection, 0, 0);
+  }
+
+  for (auto& test_connection : test_connections) {
+    ASSERT_EQ(test_connection.written.get_future().get().value(), 0);
+    ASSERT_EQ(test_connection.read.get_future().get().value(), 0);
+  }
+
+  // Every stream arrives whole and in order
+  for (auto& accepted : test_connections) {
+    auto connected_it = std::find_if(
+        test_connections.begin(), test_connections.end(),
+        [&accepted](const TestConnection& connected) {
+          return connected.sent[0] == accepted.received[0];
+        });
+    ASSERT_TRUE(connected_it != test_connections.end());
+    ASSERT_TRUE(accepted.received == connected_it->sent);
+  }
+
+  for (auto& test_connection : test_connections) {
+    test_connection.fib_client.close();
+    test_connection.fib_server.close();
+  }
+  boost::system::error_code close_fib_acceptor_ec;
+  fib_acceptor.close(close_fib_acceptor_ec);
+}
+
+// TCP socket counting the writes of the demuxes and their buffers
+class CountingSocket : public boost::asio::ip::tcp::socket {
+ public:
+  explicit CountingSocket(boost::asio::io_service& io_service)
+      : boost::asio::ip::tcp::socket(io_service) {}
+
+  CountingSocket(CountingSocket&& other)
+      : boost::asio::ip::tcp::socket(std::move(other)) {}
+
+  CountingSocket& operator=(CountingSocket&& other) {
+    boost::asio::ip::tcp::socket::operator=(std::move(other));
+    return *this;
+  }
+
+  template <typename ConstBufferSequence, typename WriteHandler>
+  void async_write_some(const ConstBufferSequence& buffers,
+                        WriteHandler&& handler) {
+    ++write_calls;
+    written_buffers += std::distance(buffers.begin(), buffers.end());
+    boost::asio::ip::tcp::socket::async_write_some(
+        buffers, std::forward<WriteHandler>(handler));
+  }
+
+  static std::atomic<size_t> write_calls;
+  static std::atomic<size_t> written_buffers;
+};
+
+std::atomic<size_t> CountingSocket::write_calls(0);
+std::atomic<size_t> CountingSocket::written_buffers(0);
+
+//-----------------------------------------------------------------------------
+TEST(FiberBatchTest, OneWriteOfOneBufferPerBatch) {
+  typedef boost::asio::fiber::basic_fiber_demux<CountingSocket> demux;
+  typedef boost::asio::fiber::stream_fiber<CountingSocket> counting_fiber;
+
+  // One thread: the frames queued by a handler are sent once it returns
+  boost::asio::io_service io_service;
+  std::unique_ptr<boost::asio::io_service::work> p_worker(
+      new boost::asio::io_service::work(io_service));
+  std::thread io_thread([&io_service]() {
+    boost::system::error_code ec;
+    io_service.run(ec);
+  });
+
+  boost::asio::ip::tcp::acceptor acceptor(
+      io_service, boost::asio::ip::tcp::endpoint(
+                      boost::asio::ip::address_v4::loopback(), 0));
+  CountingSocket server_socket(io_service);
+  CountingSocket client_socket(io_service);
+  client_socket.connect(acceptor.local_endpoint());
+  acceptor.accept(server_socket);
+
+  demux demux_server(io_service);
+  demux demux_client(io_service);
+  demux_server.fiberize(std::move(server_socket));
+  demux_client.fiberize(std::move(client_socket));
+
+  const size_t max_batch_frames = 16;
+  demux_client.set_send_batch_limits(64 * 1024, max_batch_frames);
+
+  boost::system::error_code ec;
+  counting_fiber::acceptor fib_acceptor(io_service);
+  counting_fiber::socket fib_server(io_service);
+  counting_fiber::socket fib_client(io_service);
+  counting_fiber::endpoint server_endpoint(counting_fiber::v1(), demux_server,
+                                           1);
+  fib_acceptor.open(server_endpoint.protocol(), ec);
+  fib_acceptor.bind(server_endpoint, ec);
+  fib_acceptor.listen(boost::asio::socket_base::max_connections, ec);
+
+  std::promise<boost::system::error_code> accepted;
+  std::promise<boost::system::error_code> connected;
+  fib_acceptor.async_accept(fib_server,
+                            [&accepted](const boost::system::error_code& ec) {
+                              accepted.set_value(ec);
+                            });
+  fib_client.async_connect(
+      counting_fiber::endpoint(counting_fiber::v1(), demux_client, 1),
+      [&connected](const boost::system::error_code& ec) {
+        connected.set_value(ec);
+      });
+  ASSERT_EQ(accepted.get_future().get().value(), 0);
+  ASSERT_EQ(connected.get_future().get().value(), 0);
+
+  // Frames sent in one burst: the first one is written alone, the others
+  // are queued meanwhile and gathered
+  const size_t frame_number = 33;
+  const size_t frame_size = 100;
+  std::vector<uint8_t> sent(frame_number * frame_size);
+  for (size_t i = 0; i < sent.size(); ++i) {
+    sent[i] = static_cast<uint8_t>(i % 251);
+  }
+
+  CountingSocket::write_calls = 0;
+  CountingSocket::written_buffers = 0;
+
+  std::atomic<size_t> sent_frames(0);
+  std::promise<bool> all_sent;
+  io_service.post([&]() {
+    for (size_t i = 0; i < frame_number; ++i) {
+      fib_client.async_write_some(
+          boost::asio::buffer(sent.data() + i * frame_size, frame_size),
+          [&](const boost::system::error_code& ec, size_t size) {
+            EXPECT_EQ(ec.value(), 0);
+            EXPECT_EQ(size, frame_size);
+            if (++sent_frames == frame_number) {
+              all_sent.set_value(true);
+            }
+          });
+    }
+  });
+  all_sent.get_future().wait();
+
+  std::vector<uint8_t> received(sent.size());
+  std::promise<boost::system::error_code> read;
+  boost::asio::async_read(
+      fib_server, boost::asio::buffer(received),
+      [&read](const boost::system::error_code& ec, size_t) {
+        read.set_value(ec);
+      });
+  ASSERT_EQ(read.get_future().get().value(), 0);
+  ASSERT_TRUE(received == sent);
+
+  // Each batch is one write of one buffer (one TLS record per 16 KB)
+  ASSERT_EQ(CountingSocket::written_buffers.load(),
+            CountingSocket::write_calls.load());
+  ASSERT_LE(CountingSocket::write_calls.load(),
+            1 + (frame_number - 1 + max_batch_frames - 1) / max_batch_frames);
+
+  fib_client.close();
+  fib_server.close();
+  fib_acceptor.close(ec);
+  demux_client.close();
+  demux_server.close();
+  p_worker.reset();
+  io_thread.join();
+}
+
+//-----------------------------------------------------------------------------
+TEST_F(FlowControlFiberTest, ParkedSendResumesWithCredit) {
+  Wait();
+
+  fiber_acceptor fib_acceptor(io_service_server_);
+  fiber fib_server(io_service_server_);
+  fiber fib_client(io_service_client_);
+  ASSERT_TRUE(ConnectFibers(fib_acceptor, fib_server, fib_client));
+  ASSERT_TRUE(fib_client.native_handle()->is_credit_enabled());
+  ASSERT_TRUE(fib_server.native_handle()->is_credit_enabled());
+
+  // A quarter of a window more than the server fiber can receive
+  auto sent = MakeData(kWindow + kWindow / 4);
+  std::promise<boost::system::error_code> written;
+  size_t written_size = 0;
+  boost::asio::async_write(
+      fib_client, boost::asio::buffer(sent),
+      [&written, &written_size](const boost::system::error_code& ec,
+                                size_t size) {
+        written_size = size;
+        written.set_value(ec);
+      });
+  auto written_future = written.get_future();
+
+  // Nothing is read: the send waits for credits once the window is sent
+  ASSERT_TRUE(WaitParkedSend(fib_client));
+  ASSERT_EQ(written_future.wait_for(std::chrono::milliseconds(100)),
+            std::future_status::timeout);
+
+  // Credits are only granted once a quarter of the window is read
+  std::vector<uint8_t> received(sent.size());
+  ASSERT_EQ(Read(fib_server, received.data(), kWindow / 4 - 1).value(), 0);
+  ASSERT_EQ(written_future.wait_for(std::chrono::milliseconds(100)),
+            std::future_status::timeout);
+
+  ASSERT_EQ(Read(fib_server, received.data() + kWindow / 4 - 1, 1).value(), 0);
+  ASSERT_EQ(written_future.get().value(), 0);
+  ASSERT_EQ(written_size, sent.size());
+
+  ASSERT_EQ(Read(fib_server, received.data() + kWindow / 4,
+                 received.size() - kWindow / 4).value(),
+            0);
+  ASSERT_TRUE(received == sent);
+
+  boost::system::error_code ec;
+  fib_client.close();
+  fib_server.close();
+  fib_acceptor.close(ec);
+}
+
+//-----------------------------------------------------------------------------
+TEST_F(FlowControlFiberTest, SlowReaderReceivesEverything) {
+  Wait();
+
+  fiber_acceptor fib_acceptor(io_service_server_);
+  fiber fib_server(io_service_server_);
+  fiber fib_client(io_service_client_);
+  ASSERT_TRUE(ConnectFibers(fib_acceptor, fib_server, fib_client));
+
+  auto sent = MakeData(4 * kWindow);
+  std::promise<boost::system::error_code> written;
+  boost::asio::async_write(
+      fib_client, boost::asio::buffer(sent),
+      [&written](const boost::system::error_code& ec, size_t) {
+        written.set_value(ec);
+      });
+
+  // The data buffered by the server fiber stays bounded by its window
+  std::vector<uint8_t> received(sent.size());
+  const size_t chunk_size = 64 * 1024;
+  auto p_server_impl = fib_server.native_handle();
+  for (size_t offset = 0; offset < received.size(); offset += chunk_size) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    {
+      std::unique_lock<std::recursive_mutex> lock(
+          p_server_impl->data_queue_mutex);
+      ASSERT_LE(p_server_impl->data_queue.size(), kWindow);
+    }
+    ASSERT_EQ(Read(fib_server, received.data() + offset, chunk_size).value(),
+              0);
+  }
+
+  ASSERT_EQ(written.get_future().get().value(), 0);
+  ASSERT_TRUE(received == sent);
+
+  boost::system::error_code ec;
+  fib_client.close();
+  fib_server.close();
+  fib_acceptor.close(ec);
+}
+
+//-----------------------------------------------------------------------------
+TEST_F(FlowControlFiberTest, ParkedSendIsCancelledOnClose) {
+  Wait();
+
+  fiber_acceptor fib_acceptor(io_service_server_);
+  fiber fib_server(io_service_server_);
+  fiber fib_client(io_service_client_);
+  ASSERT_TRUE(ConnectFibers(fib_acceptor, fib_server, fib_client));
+
+  auto sent = MakeData(kWindow + 1024);
+  std::promise<boost::system::error_code> written;
+  size_t written_size = 0;
+  boost::asio::async_write(
+      fib_client, boost::asio::buffer(sent),
+      [&written, &written_size](const boost::system::error_code& ec,
+                                size_t size) {
+        written_size = size;
+        written.set_value(ec);
+      });
+
+  ASSERT_TRUE(WaitParkedSend(fib_client));
+  fib_client.close();
+
+  ASSERT_EQ(written.get_future().get().value(), ::error::connection_reset);
+  ASSERT_EQ(written_size, kWindow);
+
+  boost::system::error_code ec;
+  fib_server.close();
+  fib_acceptor.close(ec);
+}
+
+//-----------------------------------------------------------------------------
+TEST_F(FlowControlFiberTest, ZeroWindowKeepsAckToggle) {
+  Wait();
+
+  fiber_acceptor fib_acceptor(io_service_server_);
+  fiber fib_server(io_service_server_);
+  fiber fib_client(io_service_client_);
+
+  // The client fiber announces no window as fibers without credit support
+  fib_client.native_handle()->receive_window = 0;
+  ASSERT_TRUE(ConnectFibers(fib_acceptor, fib_server, fib_client));
+  ASSERT_FALSE(fib_client.native_handle()->is_credit_enabled());
+  ASSERT_FALSE(fib_server.native_handle()->is_credit_enabled());
+
+  // More than a window is sent each way without waiting for credits
+  auto sent = MakeData(2 * kWindow);
+  std::promise<boost::system::error_code> client_written;
+  std::promise<boost::system::error_code> server_written;
+  boost::asio::async_write(
+      fib_client, boost::asio::buffer(sent),
+      [&client_written](const boost::system::error_code& ec, size_t) {
+        client_written.set_value(ec);
+      });
+  boost::asio::async_write(
+      fib_server, boost::asio::buffer(sent),
+      [&server_written](const boost::system::error_code& ec, size_t) {
+        server_written.set_value(ec);
+      });
+  ASSERT_EQ(client_written.get_future().get().value(), 0);
+  ASSERT_EQ(server_written.get_future().get().value(), 0);
+
+  std::vector<uint8_t> server_received(sent.size());
+  std::vector<uint8_t> client_received(sent.size());
+  ASSERT_EQ(
+      Read(fib_server, server_received.data(), server_received.size()).value(),
+      0);
+  ASSERT_EQ(
+      Read(fib_client, client_received.data(), client_received.size()).value(),
+      0);
+  ASSERT_TRUE(server_received == sent);
+  ASSERT_TRUE(client_received == sent);
+
+  boost::system::error_code ec;
+  fib_client.close();
+  fib_server.close();
+  fib_acceptor.close(ec);
+}
+
 //-----------------------------------------------------------------------------
 TEST_F(FiberTest, UDPfiber) {
   Wait();
@@ -936,6 +1842,195 @@ TEST_F(FiberTest, UDPfiber) {
   server_closed.get_future().wait();
 }
 
+//----------------------------------------------------------------------------
+TEST(FiberHeaderTest, JumboDataSize) {
+  using boost::asio::fiber::detail::fiber_header;
+  using boost::asio::fiber::detail::fiber_id;
+
+  // Version 2 headers carry a 32 bits data size
+  fiber_header header(fiber_id(1, 2), 16, 300 * 1024);
+  auto raw = header.get_raw();
+
+  EXPECT_EQ(2, raw.version);
+  EXPECT_EQ(300u * 1024, raw.data_size);
+  EXPECT_EQ(sizeof(raw), fiber_header::pod_size());
+}
+
+//----------------------------------------------------------------------------
+TEST_F(FiberTest, DatagramOverMTUIsRefused) {
+  Wait();
+
+  dgr_fiber_endpoint endpoint_client_remote_port(
+      boost::asio::fiber::datagram_fiber<socket>::v1(), demux_client_,
+      (1 << 16) + 1);
+  dgr_fiber dgr_f_client(io_service_client_);
+  std::vector<uint8_t> buffer_client(fiber_demux::kDefaultMTU + 1);
+
+  std::promise<boost::system::error_code> sent;
+  dgr_f_client.async_send_to(
+      boost::asio::buffer(buffer_client), endpoint_client_remote_port,
+      [&sent](const boost::system::error_code& ec, size_t) {
+        sent.set_value(ec);
+      });
+
+  EXPECT_EQ(::error::message_too_long, sent.get_future().get().value());
+  dgr_f_client.close();
+}
+
+//----------------------------------------------------------------------------
+TEST_F(JumboFiberTest, ExchangeJumboDatagram) {
+  Wait();
+
+  uint32_t rem_p = (1 << 16) + 1;
+
+  dgr_fiber_endpoint endpoint_server_local_port(
+      boost::asio::fiber::datagram_fiber<socket>::v1(), demux_server_, rem_p);
+  dgr_fiber_endpoint endpoint_client_remote_port(
+      boost::asio::fiber::datagram_fiber<socket>::v1(), demux_client_, rem_p);
+  dgr_fiber_endpoint endpoint_server_from(
+      boost::asio::fiber::datagram_fiber<socket>::v1(), demux_server_);
+  dgr_fiber dgr_f_server(io_service_server_);
+  dgr_fiber dgr_f_client(io_service_client_);
+
+  // One datagram is one frame: its payload is well over 64 KB
+  std::vector<uint8_t> buffer_client(200 * 1024);
+  std::vector<uint8_t> buffer_server(kJumboMTU);
+  for (size_t i = 0; i < buffer_client.size(); ++i) {
+    buffer_client[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  boost::system::error_code ec;
+  dgr_f_server.open(endpoint_server_local_port.protocol(), ec);
+  dgr_f_server.bind(endpoint_server_local_port, ec);
+  ASSERT_EQ(ec.value(), 0);
+
+  std::promise<size_t> received;
+  dgr_f_server.async_receive_from(
+      boost::asio::buffer(buffer_server), endpoint_server_from,
+      [&received](const boost::system::error_code& ec, size_t length) {
+        received.set_value(ec ? 0 : length);
+      });
+
+  std::promise<bool> sent;
+  dgr_f_client.async_send_to(
+      boost::asio::buffer(buffer_client), endpoint_client_remote_port,
+      [&sent](const boost::system::error_code& ec, size_t) {
+        sent.set_value(!ec);
+      });
+
+  EXPECT_TRUE(sent.get_future().get());
+  ASSERT_EQ(buffer_client.size(), received.get_future().get());
+  EXPECT_TRUE(std::equal(buffer_client.begin(), buffer_client.end(),
+                         buffer_server.begin()));
+
+  dgr_f_client.close();
+  dgr_f_server.close();
+}
+
+//----------------------------------------------------------------------------
+TEST_F(JumboFiberTest, ExchangeJumboStream) {
+  Wait();
+
+  fiber_acceptor fib_acceptor(io_service_server_);
+  fiber fib_server(io_service_server_);
+  fiber fib_client(io_service_client_);
+
+  std::vector<uint8_t> buffer_client(1024 * 1024);
+  std::vector<uint8_t> buffer_server(buffer_client.size());
+  for (size_t i = 0; i < buffer_client.size(); ++i) {
+    buffer_client[i] = static_cast<uint8_t>(i * 13);
+  }
+
+  boost::system::error_code acceptor_ec;
+  fiber_endpoint server_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_server_, 1);
+  fib_acceptor.open(server_endpoint.protocol(), acceptor_ec);
+  fib_acceptor.bind(server_endpoint, acceptor_ec);
+  fib_acceptor.listen(boost::asio::socket_base::max_connections, acceptor_ec);
+  ASSERT_EQ(acceptor_ec.value(), 0);
+
+  std::promise<bool> server_done;
+  fib_acceptor.async_accept(fib_server, [&](
+      const boost::system::error_code& ec) {
+    if (ec) {
+      server_done.set_value(false);
+      return;
+    }
+    boost::asio::async_read(
+        fib_server, boost::asio::buffer(buffer_server),
+        [&](const boost::system::error_code& ec, size_t length) {
+          server_done.set_value(!ec && length == buffer_server.size());
+        });
+  });
+
+  std::promise<bool> client_done;
+  fiber_endpoint client_endpoint(boost::asio::fiber::stream_fiber<socket>::v1(),
+                                 demux_client_, 1);
+  fib_client.async_connect(client_endpoint, [&](
+      const boost::system::error_code& ec) {
+    if (ec) {
+      client_done.set_value(false);
+      return;
+    }
+    boost::asio::async_write(
+        fib_client, boost::asio::buffer(buffer_client),
+        [&](const boost::system::error_code& ec, size_t length) {
+          client_done.set_value(!ec && length == buffer_client.size());
+        });
+  });
+
+  EXPECT_TRUE(client_done.get_future().get());
+  EXPECT_TRUE(server_done.get_future().get());
+  EXPECT_EQ(buffer_client, buffer_server);
+
+  boost::system::error_code close_ec;
+  fib_client.close(close_ec);
+  fib_server.close(close_ec);
+  fib_acceptor.close(close_ec);
+}
+
+//----------------------------------------------------------------------------
+TEST_F(MismatchedMTUFiberTest, OversizedFrameIsRefused) {
+  Wait();
+
+  uint32_t rem_p = (1 << 16) + 1;
+
+  dgr_fiber_endpoint endpoint_server_local_port(
+      boost::asio::fiber::datagram_fiber<socket>::v1(), demux_server_, rem_p);
+  dgr_fiber_endpoint endpoint_client_remote_port(
+      boost::asio::fiber::datagram_fiber<socket>::v1(), demux_client_, rem_p);
+  dgr_fiber_endpoint endpoint_server_from(
+      boost::asio::fiber::datagram_fiber<socket>::v1(), demux_server_);
+  dgr_fiber dgr_f_server(io_service_server_);
+  dgr_fiber dgr_f_client(io_service_client_);
+
+  // Accepted by the client demux, over the size accepted by the server one
+  std::vector<uint8_t> buffer_client(fiber_demux::kDefaultMTU + 1024);
+  std::vector<uint8_t> buffer_server(kClientMTU);
+
+  boost::system::error_code ec;
+  dgr_f_server.open(endpoint_server_local_port.protocol(), ec);
+  dgr_f_server.bind(endpoint_server_local_port, ec);
+  ASSERT_EQ(ec.value(), 0);
+
+  // The server demux closes instead of receiving the frame
+  std::promise<boost::system::error_code> received;
+  dgr_f_server.async_receive_from(
+      boost::asio::buffer(buffer_server), endpoint_server_from,
+      [&received](const boost::system::error_code& ec, size_t) {
+        received.set_value(ec);
+      });
+
+  dgr_f_client.async_send_to(
+      boost::asio::buffer(buffer_client), endpoint_client_remote_port,
+      [](const boost::system::error_code&, size_t) {});
+
+  EXPECT_NE(0, received.get_future().get().value());
+
+  dgr_f_client.close();
+  dgr_f_server.close();
+}
+
 //----------------------------------------------------------------------------
 TEST_F(FiberTest, TLSConnectDisconnectFiberFromClient) {
   Wait();
@@ -0,0 +1,135 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/boost/fiber/detail/fiber_id.hpp"
+#include "common/boost/fiber/detail/fiber_table.hpp"
+
+using fiber_id = boost::asio::fiber::detail::fiber_id;
+
+// The value records the id it is bound to
+using Value = std::shared_ptr<uint64_t>;
+using FiberTable = boost::asio::fiber::detail::fiber_table<Value>;
+
+TEST(FiberTableTests, InsertFindErase) {
+  FiberTable table;
+
+  ASSERT_EQ(0, table.size());
+  ASSERT_FALSE(table.find(fiber_id(1, 2)));
+
+  for (uint32_t i = 1; i <= 1000; ++i) {
+    fiber_id id(i, i + 1);
+    ASSERT_TRUE(table.insert(id, std::make_shared<uint64_t>(id.packed())));
+  }
+  ASSERT_EQ(1000, table.size());
+  ASSERT_FALSE(table.insert(fiber_id(1, 2), std::make_shared<uint64_t>(0)));
+
+  for (uint32_t i = 1; i <= 1000; i += 2) {
+    table.erase(fiber_id(i, i + 1));
+  }
+  ASSERT_EQ(500, table.size());
+  ASSERT_EQ(500, table.values().size());
+
+  for (uint32_t i = 1; i <= 1000; ++i) {
+    fiber_id id(i, i + 1);
+    auto p_value = table.find(id);
+    if (i % 2) {
+      ASSERT_FALSE(p_value);
+      ASSERT_EQ(0, table.count(id));
+    } else {
+      ASSERT_TRUE(p_value);
+      ASSERT_EQ(id.packed(), *p_value);
+    }
+  }
+}
+
+TEST(FiberTableTests, ErasedValueIsReleased) {
+  FiberTable table;
+  auto p_value = std::make_shared<uint64_t>(1);
+  std::weak_ptr<uint64_t> w_value(p_value);
+
+  ASSERT_TRUE(table.insert(fiber_id(1, 1), p_value));
+  p_value.reset();
+  table.erase(fiber_id(1, 1));
+
+  // No reader holds the erased node
+  ASSERT_TRUE(w_value.expired());
+}
+
+TEST(FiberTableTests, ConcurrentInsertEraseFind) {
+  FiberTable table;
+  const uint32_t writer_count = 4;
+  const uint32_t reader_count = 4;
+  const uint32_t ids_per_writer = 256;
+  const uint32_t rounds = 200;
+
+  // Ids never erased: readers must always find them
+  for (uint32_t i = 1; i <= 64; ++i) {
+    fiber_id id(0xFFFF0000 + i, i);
+    ASSERT_TRUE(table.insert(id, std::make_shared<uint64_t>(id.packed())));
+  }
+
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> mismatches(0);
+  std::atomic<uint64_t> missing_stable(0);
+
+  std::vector<std::thread> readers;
+  for (uint32_t r = 0; r < reader_count; ++r) {
+    readers.emplace_back([&, r]() {
+      uint32_t i = r;
+      while (!stop) {
+        ++i;
+        fiber_id stable_id(0xFFFF0000 + (i % 64) + 1, (i % 64) + 1);
+        if (!table.find(stable_id)) {
+          ++missing_stable;
+        }
+
+        fiber_id id(i % (writer_count * ids_per_writer) + 1, 7);
+        auto p_value = table.find(id);
+        if (p_value && *p_value != id.packed()) {
+          ++mismatches;
+        }
+
+        if (i % 1024 == 0) {
+          for (const auto& p_bound : table.values()) {
+            if (!p_bound) {
+              ++mismatches;
+            }
+          }
+        }
+      }
+    });
+  }
+
+  std::vector<std::thread> writers;
+  for (uint32_t w = 0; w < writer_count; ++w) {
+    writers.emplace_back([&, w]() {
+      for (uint32_t round = 0; round < rounds; ++round) {
+        for (uint32_t i = 0; i < ids_per_writer; ++i) {
+          fiber_id id(w * ids_per_writer + i + 1, 7);
+          EXPECT_TRUE(
+              table.insert(id, std::make_shared<uint64_t>(id.packed())));
+        }
+        for (uint32_t i = 0; i < ids_per_writer; ++i) {
+          table.erase(fiber_id(w * ids_per_writer + i + 1, 7));
+        }
+      }
+    });
+  }
+
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(0, mismatches);
+  ASSERT_EQ(0, missing_stable);
+  ASSERT_EQ(64, table.size());
+}
@@ -62,7 +62,7 @@ class SSFClientServerCipherSuitesTest : public ::testing::Test {
     auto on_user_service_status = [](UserServicePtr p_user_service,
                                      const boost::system::error_code& ec) {};
     p_ssf_client_.reset(new Client());
-    p_ssf_client_->Init(endpoint_query, 1, 0, false, {}, config.services(),
+    p_ssf_client_->Init(endpoint_query, 1, 0, false, 1, {}, config.services(),
                         on_status, on_user_service_status, ec);
     if (ec) {
       return;
@@ -1,13 +1,17 @@
 #include <vector>
 #include <functional>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <future>
 #include <list>
+#include <thread>
 
 #include <gtest/gtest.h>
 #include <boost/asio.hpp>
 
 #include "common/config/config.h"
+#include "common/error/error.h"
 
 #include "core/network_protocol.h"
 #include "core/client/client.h"
@@ -30,7 +34,14 @@ class SSFClientServerTest : public ::testing::Test {
   using UserServicePtr = Client::UserServicePtr;
 
  public:
-  SSFClientServerTest() : p_ssf_client_(nullptr), p_ssf_server_(nullptr) {}
+  SSFClientServerTest()
+      : p_ssf_client_(nullptr),
+        p_ssf_server_(nullptr),
+        serve_metrics_(false),
+        engine_mode_(ssf::AsyncEngine::Mode::kShared),
+        links_(1),
+        no_reconnection_(false),
+        disconnected_set_(false) {}
 
   ~SSFClientServerTest() {}
 
@@ -55,7 +66,8 @@ class SSFClientServerTest : public ::testing::Test {
 
     auto endpoint_query =
         NetworkProtocol::GenerateServerQuery("", server_port, ssf_config);
-    p_ssf_server_.reset(new Server(ssf_config.services()));
+    p_ssf_server_.reset(new Server(ssf_config.services(), false,
+                                   engine_mode_, serve_metrics_));
 
     boost::system::error_code run_ec;
     p_ssf_server_->Run(endpoint_query, run_ec);
@@ -73,7 +85,8 @@ class SSFClientServerTest : public ::testing::Test {
     auto on_user_service_status = [](UserServicePtr p_user_service,
                                      const boost::system::error_code& ec) {};
     p_ssf_client_.reset(new Client());
-    p_ssf_client_->Init(endpoint_query, 1, 0, false, {}, ssf_config.services(),
+    p_ssf_client_->Init(endpoint_query, 1, 0, no_reconnection_, links_, {},
+                        ssf_config.services(),
                         std::bind(&SSFClientServerTest::OnClientStatus, this,
                                   std::placeholders::_1),
                         on_user_service_status, ec);
@@ -115,6 +128,9 @@ class SSFClientServerTest : public ::testing::Test {
         break;
       case ssf::Status::kDisconnected:
         SSF_LOG("test", info, "client: disconnected");
+        if (!disconnected_set_.exchange(true)) {
+          disconnected_.set_value(true);
+        }
         break;
       case ssf::Status::kRunning:
         transport_set_.set_value(true);
@@ -130,6 +146,131 @@ class SSFClientServerTest : public ::testing::Test {
 
   std::promise<bool> network_set_;
   std::promise<bool> transport_set_;
+
+  // the server answers the metrics requests of the client
+  bool serve_metrics_;
+  ssf::AsyncEngine::Mode engine_mode_;
+
+  // physical links of the client session
+  uint32_t links_;
+  bool no_reconnection_;
+
+  std::promise<bool> disconnected_;
+  std::atomic<bool> disconnected_set_;
+
+  // Ask the server for its metrics through the client session
+  boost::system::error_code GetRemoteStats(std::string* p_stats) {
+    boost::system::error_code ec;
+    auto p_session = p_ssf_client_->GetSession(ec);
+    if (!p_session) {
+      return ec;
+    }
+
+    std::promise<boost::system::error_code> done;
+    p_session->AsyncGetRemoteStats(
+        "demux.", [&done, p_stats](const boost::system::error_code& stats_ec,
+                                   const std::string& stats) {
+          *p_stats = stats;
+          done.set_value(stats_ec);
+        });
+    return done.get_future().get();
+  }
+};
+
+class SSFClientServerMetricsTest : public SSFClientServerTest {
+ public:
+  SSFClientServerMetricsTest() { serve_metrics_ = true; }
+};
+
+class SSFClientServerPerCoreTest : public SSFClientServerTest {
+ public:
+  SSFClientServerPerCoreTest() {
+    engine_mode_ = ssf::AsyncEngine::Mode::kPerCore;
+  }
+};
+
+class SSFClientServerLinksTest : public SSFClientServerTest {
+ public:
+  SSFClientServerLinksTest() {
+    links_ = 2;
+    no_reconnection_ = true;
+  }
+
+  // Wait until the session has all its links
+  bool WaitLinks() {
+    boost::system::error_code ec;
+    auto p_session = p_ssf_client_->GetSession(ec);
+    if (!p_session) {
+      return false;
+    }
+
+    for (int i = 0; i < 100; ++i) {
+      if (p_session->GetDemux().link_count() == links_) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+  }
 };
 
 TEST_F(SSFClientServerTest, connectDisconnect) { ASSERT_TRUE(Wait()); }
+
+TEST_F(SSFClientServerTest, RemoteStatsRefusedByDefault) {
+  ASSERT_TRUE(Wait());
+
+  std::string stats;
+  auto ec = GetRemoteStats(&stats);
+  EXPECT_EQ(::error::operation_not_supported, ec.value());
+  EXPECT_TRUE(stats.empty());
+}
+
+TEST_F(SSFClientServerMetricsTest, GetRemoteStats) {
+  ASSERT_TRUE(Wait());
+
+  // Two requests in a row: each reply completes its own request
+  for (int i = 0; i < 2; ++i) {
+    std::string stats;
+    auto ec = GetRemoteStats(&stats);
+    ASSERT_EQ(0, ec.value()) << ec.message();
+    ASSERT_FALSE(stats.empty());
+    EXPECT_EQ('{', stats.front());
+    EXPECT_EQ('}', stats.back());
+  }
+}
+
+TEST_F(SSFClientServerPerCoreTest, ConnectionsAreServedByTheWorkers) {
+  ASSERT_TRUE(Wait());
+
+  // The session runs on a worker io_service
+  std::string stats;
+  auto ec = GetRemoteStats(&stats);
+  EXPECT_EQ(::error::operation_not_supported, ec.value());
+
+  // The acceptor keeps accepting on the main io_service
+  p_ssf_client_->Stop(ec);
+  p_ssf_client_->Deinit();
+  network_set_ = std::promise<bool>();
+  transport_set_ = std::promise<bool>();
+  StartClient("8100");
+  ASSERT_TRUE(Wait());
+}
+
+TEST_F(SSFClientServerLinksTest, FirstLinkLossClosesTheSession) {
+  ASSERT_TRUE(Wait());
+  ASSERT_TRUE(WaitLinks());
+
+  // The admin fiber goes through the first link: the session cannot go on
+  // without its keep alive and command channel
+  boost::system::error_code ec;
+  auto p_session = p_ssf_client_->GetSession(ec);
+  ASSERT_TRUE(!!p_session);
+  p_session->get_io_service().post([p_session]() {
+    boost::system::error_code close_ec;
+    p_session->GetDemux().socket().close(close_ec);
+  });
+
+  auto disconnected = disconnected_.get_future();
+  ASSERT_EQ(std::future_status::ready,
+            disconnected.wait_for(std::chrono::seconds(10)));
+}
@@ -37,8 +37,9 @@ void SSFFixtureTest::StartClient(const std::string& server_port,
   auto on_user_service_status =
       [](UserServicePtr p_user_service, const boost::system::error_code& ec) {};
   p_ssf_client_.reset(new Client());
-  p_ssf_client_->Init(endpoint_query, 1, 0, false, {}, ssf_config.services(),
-                      callback, on_user_service_status, ec);
+  p_ssf_client_->Init(endpoint_query, 1, 0, false, 1, {},
+                      ssf_config.services(), callback, on_user_service_status,
+                      ec);
   if (ec) {
     return;
   }
@@ -0,0 +1,131 @@
+#include <cstdint>
+
+#include <future>
+#include <memory>
+#include <thread>
+
+#include <boost/asio.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <gtest/gtest.h>
+
+#include "core/transport_virtual_layer_policies/transport_protocol_policy.h"
+
+using Socket = boost::asio::ip::tcp::socket;
+using Policy = ssf::TransportProtocolPolicy<Socket>;
+
+struct HandshakeResult {
+  boost::system::error_code ec;
+  uint32_t max_frame_size;
+  uint64_t session_id;
+};
+
+class TransportProtocolTest : public ::testing::Test {
+ protected:
+  TransportProtocolTest()
+      : io_service_(),
+        p_worker_(new boost::asio::io_service::work(io_service_)),
+        acceptor_(io_service_, boost::asio::ip::tcp::endpoint(
+                                   boost::asio::ip::address_v4::loopback(), 0)),
+        server_socket_(io_service_),
+        client_socket_(io_service_) {}
+
+  virtual void SetUp() {
+    thread_ = std::thread([this]() { io_service_.run(); });
+
+    std::promise<boost::system::error_code> accepted;
+    acceptor_.async_accept(server_socket_,
+                           [&accepted](const boost::system::error_code& ec) {
+                             accepted.set_value(ec);
+                           });
+    boost::system::error_code ec;
+    client_socket_.connect(acceptor_.local_endpoint(), ec);
+    ASSERT_EQ(0, ec.value());
+    ASSERT_EQ(0, accepted.get_future().get().value());
+  }
+
+  virtual void TearDown() {
+    boost::system::error_code ec;
+    client_socket_.close(ec);
+    server_socket_.close(ec);
+    acceptor_.close(ec);
+    p_worker_.reset();
+    thread_.join();
+  }
+
+  // Run the transport handshake between the client and the server policies
+  void Handshake(Policy& server, Policy& client, uint64_t session_id,
+                 HandshakeResult* p_server_result,
+                 HandshakeResult* p_client_result) {
+    std::promise<HandshakeResult> server_done;
+    std::promise<HandshakeResult> client_done;
+
+    server.DoSSFInitiateReceive(
+        server_socket_,
+        [&server_done](Socket&, const boost::system::error_code& ec,
+                       uint32_t max_frame_size, uint64_t session_id) {
+          server_done.set_value({ec, max_frame_size, session_id});
+        });
+    client.DoSSFInitiate(
+        client_socket_,
+        [&client_done](Socket&, const boost::system::error_code& ec,
+                       uint32_t max_frame_size, uint64_t session_id) {
+          client_done.set_value({ec, max_frame_size, session_id});
+        },
+        session_id);
+
+    *p_server_result = server_done.get_future().get();
+    *p_client_result = client_done.get_future().get();
+  }
+
+  boost::asio::io_service io_service_;
+  std::unique_ptr<boost::asio::io_service::work> p_worker_;
+  std::thread thread_;
+  boost::asio::ip::tcp::acceptor acceptor_;
+  Socket server_socket_;
+  Socket client_socket_;
+};
+
+TEST_F(TransportProtocolTest, NegotiateSmallestMaxFrameSize) {
+  Policy server;
+  Policy client;
+  server.set_max_frame_size(64 * 1024);
+  client.set_max_frame_size(1024 * 1024);
+
+  HandshakeResult server_result;
+  HandshakeResult client_result;
+  Handshake(server, client, 42, &server_result, &client_result);
+
+  ASSERT_EQ(0, server_result.ec.value());
+  ASSERT_EQ(0, client_result.ec.value());
+  EXPECT_EQ(64u * 1024, server_result.max_frame_size);
+  EXPECT_EQ(64u * 1024, client_result.max_frame_size);
+  EXPECT_EQ(42u, server_result.session_id);
+  EXPECT_EQ(42u, client_result.session_id);
+}
+
+TEST_F(TransportProtocolTest, NegotiateJumboMaxFrameSize) {
+  Policy server;
+  Policy client;
+  server.set_max_frame_size(1024 * 1024);
+  client.set_max_frame_size(512 * 1024);
+
+  HandshakeResult server_result;
+  HandshakeResult client_result;
+  Handshake(server, client, 0, &server_result, &client_result);
+
+  ASSERT_EQ(0, server_result.ec.value());
+  ASSERT_EQ(0, client_result.ec.value());
+  EXPECT_EQ(512u * 1024, server_result.max_frame_size);
+  EXPECT_EQ(512u * 1024, client_result.max_frame_size);
+}
+
+TEST(TransportProtocolTests, MaxFrameSizeFloor) {
+  Policy policy;
+  EXPECT_EQ(static_cast<uint32_t>(Policy::kDefaultMaxFrameSize),
+            policy.max_frame_size());
+
+  policy.set_max_frame_size(1);
+  EXPECT_EQ(static_cast<uint32_t>(Policy::kMinFrameSize),
+            policy.max_frame_size());
+}
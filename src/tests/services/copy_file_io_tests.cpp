@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include "services/copy/file_hasher.h"
+#include "services/copy/file_reader.h"
+#include "services/copy/file_writer.h"
+#include "services/copy/packet.h"
+
+class CopyFileIoTest : public ::testing::Test {
+ protected:
+  using FileReader = ssf::services::copy::FileReader;
+  using FileWriter = ssf::services::copy::FileWriter;
+  using FileHasher = ssf::services::copy::FileHasher;
+  using FileManifest = ssf::services::copy::FileManifest;
+
+  CopyFileIoTest()
+      : input_path_("file_io_input.bin"), output_path_("file_io_output.bin") {}
+
+  void TearDown() override {
+    std::remove(input_path_.c_str());
+    std::remove(output_path_.c_str());
+  }
+
+  std::string WriteInput(std::size_t size) {
+    std::string content;
+    content.reserve(size);
+    std::minstd_rand generator;
+    for (std::size_t i = 0; i < size; ++i) {
+      content.push_back(static_cast<char>(generator()));
+    }
+    std::ofstream input(input_path_, std::ofstream::binary);
+    input.write(content.data(), content.size());
+    return content;
+  }
+
+  std::string ReadOutput() {
+    std::ifstream output(output_path_, std::ifstream::binary);
+    return std::string(std::istreambuf_iterator<char>(output),
+                       std::istreambuf_iterator<char>());
+  }
+
+  // Copy the input from offset to the output packet by packet, the way the
+  // copy session does
+  boost::system::error_code Copy(uint64_t offset) {
+    boost::asio::io_service io_service;
+    std::unique_ptr<boost::asio::io_service::work> p_work(
+        new boost::asio::io_service::work(io_service));
+    boost::system::error_code ec;
+
+    auto p_reader =
+        FileReader::Open(io_service, input_path_, offset, true, ec);
+    if (ec) {
+      return ec;
+    }
+    auto p_writer =
+        FileWriter::Open(io_service, output_path_,
+                         std::ofstream::out | std::ofstream::binary |
+                             std::ofstream::trunc,
+                         true, ec);
+    if (ec) {
+      return ec;
+    }
+
+    ssf::services::copy::Packet packet;
+    std::function<void()> copy_packets;
+    copy_packets = [&]() {
+      for (;;) {
+        if (p_writer->full()) {
+          p_writer->AsyncWaitReady(copy_packets);
+          return;
+        }
+
+        boost::system::error_code read_ec;
+        auto length = p_reader->Read(packet.buffer().data(),
+                                     packet.buffer().size(), read_ec);
+        if (read_ec == boost::asio::error::would_block) {
+          p_reader->AsyncWaitReady(copy_packets);
+          return;
+        }
+        if (read_ec) {
+          if (read_ec != boost::asio::error::eof) {
+            ec = read_ec;
+          }
+          p_reader->Close();
+          p_writer->AsyncClose([&]() { p_work.reset(); });
+          return;
+        }
+
+        p_writer->Write(packet.buffer().data(), length, ec);
+        if (ec) {
+          p_work.reset();
+          return;
+        }
+      }
+    };
+    io_service.post(copy_packets);
+    io_service.run();
+
+    if (!ec) {
+      ec = p_writer->error();
+    }
+    read_digests_ = p_reader->chunk_digests();
+    written_digests_ = p_writer->chunk_digests();
+    return ec;
+  }
+
+ protected:
+  std::string input_path_;
+  std::string output_path_;
+  FileManifest::Digests read_digests_;
+  FileManifest::Digests written_digests_;
+};
+
+TEST_F(CopyFileIoTest, CopyEmptyFile) {
+  WriteInput(0);
+  ASSERT_FALSE(Copy(0)) << "copy failed";
+  ASSERT_TRUE(ReadOutput().empty());
+}
+
+TEST_F(CopyFileIoTest, CopyLargeFile) {
+  auto content = WriteInput(5 * FileReader::kChunkSize + 1234);
+  ASSERT_FALSE(Copy(0)) << "copy failed";
+  ASSERT_TRUE(ReadOutput() == content) << "output differs from input";
+}
+
+TEST_F(CopyFileIoTest, CopyFromOffset) {
+  auto content = WriteInput(3 * FileReader::kChunkSize);
+  uint64_t offset = FileReader::kChunkSize / 2 + 17;
+  ASSERT_FALSE(Copy(offset)) << "copy failed";
+  ASSERT_TRUE(ReadOutput() == content.substr(offset))
+      << "output differs from input";
+}
+
+TEST_F(CopyFileIoTest, OpenMissingFile) {
+  boost::asio::io_service io_service;
+  boost::system::error_code ec;
+  auto p_reader =
+      FileReader::Open(io_service, "file_io_missing.bin", 0, false, ec);
+  ASSERT_TRUE(ec) << "missing file opened";
+  ASSERT_EQ(p_reader, nullptr);
+}
+
+TEST_F(CopyFileIoTest, HashChunksWhileCopying) {
+  WriteInput(3 * FileReader::kChunkSize + 100);
+  ASSERT_FALSE(Copy(FileReader::kChunkSize)) << "copy failed";
+
+  boost::system::error_code ec;
+  auto digests = FileManifest::HashFileChunks(input_path_, 1, 4, ec);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(digests.size(), 3);
+  ASSERT_TRUE(read_digests_ == digests) << "digests of read chunks differ";
+  ASSERT_TRUE(written_digests_ == digests)
+      << "digests of written chunks differ";
+}
+
+TEST_F(CopyFileIoTest, HashFileInParallel) {
+  WriteInput(7 * FileManifest::kChunkSize + 1000);
+
+  boost::system::error_code ec;
+  auto digests = FileManifest::HashFileChunks(input_path_, 0, 8, ec);
+  ASSERT_FALSE(ec);
+  ASSERT_EQ(digests.size(), 8);
+
+  boost::asio::io_service io_service;
+  std::unique_ptr<boost::asio::io_service::work> p_work(
+      new boost::asio::io_service::work(io_service));
+  auto p_hasher =
+      FileHasher::Start(io_service, input_path_,
+                        7 * FileManifest::kChunkSize + 1000,
+                        [&p_work]() { p_work.reset(); });
+  io_service.run();
+
+  ASSERT_TRUE(p_hasher->done());
+  ASSERT_FALSE(p_hasher->error());
+  auto manifest = p_hasher->manifest();
+  ASSERT_TRUE(manifest.digests() == digests) << "digests differ";
+
+  // groups of chunks
+  auto groups = manifest.GroupDigests(3);
+  ASSERT_EQ(groups.size(), 3);
+  FileManifest first_chunks(FileManifest::Digests(digests.begin(),
+                                                  digests.begin() + 3));
+  ASSERT_TRUE(groups[0] == first_chunks.Root());
+  ASSERT_FALSE(groups[0] == groups[1]);
+}
@@ -105,7 +105,7 @@ void CopyFixtureTest::StartClient(const std::string& server_port) {
   p_ssf_client_.reset(new Client());
   p_ssf_client_->Register<Copy>();
   p_ssf_client_->Init(
-      endpoint_query, 1, 0, true, copy_parameters, ssf_config.services(),
+      endpoint_query, 1, 0, true, 1, copy_parameters, ssf_config.services(),
       std::bind(&CopyFixtureTest::OnClientStatus, this, std::placeholders::_1),
       std::bind(&CopyFixtureTest::OnClientUserServiceStatus, this,
                 std::placeholders::_1, std::placeholders::_2),
@@ -151,19 +151,17 @@ bool CopyFixtureTest::StartCopy(const ssf::services::copy::CopyRequest& req,
     }
 
     uint64_t percent = 0;
-    if (context->output.good() && context->output.is_open()) {
-      uint64_t file_offset = context->output.tellp();
-      percent =
-          (file_offset == -1) ? 100 : (100 * file_offset / context->filesize);
+    if (context->output && context->output->is_open()) {
+      boost::system::error_code size_ec;
+      uint64_t file_offset =
+          context->fs.GetFilesize(context->GetOutputFilepath(), size_ec);
+      percent = size_ec ? 100 : (100 * file_offset / context->filesize);
       SSF_LOG("test", debug, "[copy_tests] Receiving: {} {}% / {}b",
               context->GetOutputFilepath().GetString(), percent,
               context->filesize);
-    } else if (context->input.good() && context->input.is_open()) {
-      uint64_t file_offset = context->input.tellg();
-      percent =
-          (file_offset == -1) ? 100 : (100 * file_offset / context->filesize);
-      SSF_LOG("test", debug, "[copy_tests] Sending: {} {}% / {}b",
-              context->GetInputFilepath().GetString(), percent, context->filesize);
+    } else if (context->input && context->input->is_open()) {
+      SSF_LOG("test", debug, "[copy_tests] Sending: {} / {}b",
+              context->GetInputFilepath().GetString(), context->filesize);
     }
   };
   auto on_file_copied = [this](ssf::services::copy::CopyContext* context,
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include <msgpack.hpp>
+
+#include "services/copy/file_hasher.h"
+#include "services/copy/packet.h"
+#include "services/copy/packet/init.h"
+#include "services/copy/packet_helper.h"
+
+namespace copy = ssf::services::copy;
+
+namespace {
+
+// Layouts of the init packets of the copy protocol version 1
+struct InitRequestV1 {
+  static const copy::PacketType kType = copy::PacketType::kInitRequest;
+
+  std::string input_filepath = "input";
+  bool check_file_integrity = true;
+  bool stdin_input = false;
+  bool resume = true;
+  uint64_t filesize = 42;
+  std::string output_dir = "dir";
+  std::string output_filename = "output";
+
+  MSGPACK_DEFINE(input_filepath, check_file_integrity, stdin_input, resume,
+                 filesize, output_dir, output_filename)
+};
+
+struct InitReplyV1 {
+  static const copy::PacketType kType = copy::PacketType::kInitReply;
+
+  InitRequestV1 req;
+  uint64_t start_offset = 0;
+  std::vector<unsigned char> sha1 = std::vector<unsigned char>(20, 0);
+  uint32_t status = 1;
+
+  MSGPACK_DEFINE(req, start_offset, sha1, status)
+};
+
+}  // unnamed namespace
+
+TEST(CopyPacketTest, InitPacketsCarryTheProtocolVersion) {
+  copy::InitRequest req("input", true, false, true, 42, "dir", "output");
+  copy::InitReply rep(req, 0, copy::FileManifest::kChunkSize, {},
+                      copy::InitReply::Status::kInitializationSucceeded);
+
+  boost::system::error_code ec;
+  copy::Packet req_packet;
+  copy::PayloadToPacket(req, &req_packet, ec);
+  ASSERT_FALSE(ec);
+  EXPECT_EQ(static_cast<uint32_t>(copy::kCopyProtocolVersion),
+            copy::GetProtocolVersion(req_packet));
+
+  copy::Packet rep_packet;
+  copy::PayloadToPacket(rep, &rep_packet, ec);
+  ASSERT_FALSE(ec);
+  EXPECT_EQ(static_cast<uint32_t>(copy::kCopyProtocolVersion),
+            copy::GetProtocolVersion(rep_packet));
+
+  copy::InitReply received;
+  copy::PacketToPayload(rep_packet, received, ec);
+  ASSERT_FALSE(ec);
+  EXPECT_EQ(static_cast<uint32_t>(copy::kCopyProtocolVersion),
+            received.protocol_version);
+  EXPECT_EQ("output", received.req.output_filename);
+}
+
+TEST(CopyPacketTest, PreviousProtocolVersionIsDetected) {
+  boost::system::error_code ec;
+  copy::Packet req_packet;
+  copy::PayloadToPacket(InitRequestV1(), &req_packet, ec);
+  ASSERT_FALSE(ec);
+  EXPECT_EQ(1u, copy::GetProtocolVersion(req_packet));
+
+  copy::Packet rep_packet;
+  copy::PayloadToPacket(InitReplyV1(), &rep_packet, ec);
+  ASSERT_FALSE(ec);
+  EXPECT_EQ(1u, copy::GetProtocolVersion(rep_packet));
+}
+
+TEST(CopyPacketTest, NotAnInitPacket) {
+  copy::Packet packet;
+  packet.set_payload_size(0);
+  EXPECT_EQ(0u, copy::GetProtocolVersion(packet));
+}
@@ -262,6 +262,74 @@ TEST_F(CopyFixtureTest, CopyGlobFileFromServerToClientSequentiallyTest) {
   }
 }
 
+TEST_F(CopyFixtureTest, StreamGlobFileFromClientToServerTest) {
+  std::string server_port("6500");
+  StartServer(server_port);
+  StartClient(server_port);
+
+  std::list<ssf::Path> files;
+  for (uint32_t i = 0; i <= 10; ++i) {
+    files.emplace_back(GenerateRandomFile(GetInputDirectory(), "test_file",
+                                          ".txt", 1024 * 1024 * i));
+  }
+  for (uint32_t i = 0; i < 100; ++i) {
+    files.emplace_back(GenerateRandomFile(GetInputDirectory(), "small_file",
+                                          ".txt", 1024 * i));
+  }
+
+  ASSERT_TRUE(Wait());
+
+  ssf::Path input_pattern(GetInputDirectory());
+  input_pattern /= "*.txt";
+
+  ssf::services::copy::CopyRequest req(false, false, false, true, 1,
+                                       input_pattern.GetString(),
+                                       GetOutputDirectory().GetString(), true);
+  StartCopy(req, true);
+
+  ASSERT_TRUE(WaitClose());
+
+  for (const auto& file : files) {
+    ssf::Path output_path(GetOutputDirectory());
+    output_path /= file.GetFilename();
+    ASSERT_TRUE(AreFilesEqual(file.GetString(), output_path.GetString()));
+  }
+}
+
+TEST_F(CopyFixtureTest, StreamGlobFileFromServerToClientTest) {
+  std::string server_port("6500");
+  StartServer(server_port);
+  StartClient(server_port);
+
+  ASSERT_TRUE(Wait());
+
+  std::list<ssf::Path> files;
+  for (uint32_t i = 0; i <= 10; ++i) {
+    files.emplace_back(GenerateRandomFile(GetInputDirectory(), "test_file",
+                                          ".txt", 1024 * 1024 * i));
+  }
+  for (uint32_t i = 0; i < 100; ++i) {
+    files.emplace_back(GenerateRandomFile(GetInputDirectory(), "small_file",
+                                          ".txt", 1024 * i));
+  }
+
+  ssf::Path input_pattern(GetInputDirectory());
+  input_pattern /= "*.txt";
+
+  ssf::services::copy::CopyRequest req(false, false, false, true, 1,
+                                       input_pattern.GetString(),
+                                       GetOutputDirectory().GetString(), true);
+  StartCopy(req, false);
+
+  ASSERT_TRUE(WaitClose());
+
+  for (const auto& file : files) {
+    ssf::Path output_path(GetOutputDirectory());
+    output_path /= file.GetFilename();
+    ASSERT_TRUE(AreFilesEqual(file.GetString(), output_path.GetString()));
+  }
+}
+
 TEST_F(CopyFixtureTest, CopyStdinFromClientToServerTest) {
   std::string server_port("6500");
   StartServer(server_port);
@@ -0,0 +1,104 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/buffer.hpp>
+
+#include <ssf/network/buffer_pool.h>
+
+#include "services/datagram/datagram_ring.h"
+
+namespace {
+
+std::string ToString(boost::asio::const_buffers_1 datagram) {
+  return std::string(boost::asio::buffer_cast<const char*>(datagram),
+                     boost::asio::buffer_size(datagram));
+}
+
+bool Push(ssf::DatagramRing& ring, const std::string& datagram) {
+  return ring.Push(boost::asio::buffer(datagram));
+}
+
+}  // namespace
+
+TEST(DatagramRingTests, DropNewestKeepsTheQueuedDatagrams) {
+  ssf::DatagramRing ring(3, ssf::QueueOverflowPolicy::kDropNewest);
+  ASSERT_TRUE(Push(ring, "a"));
+  ASSERT_TRUE(Push(ring, "b"));
+  ASSERT_TRUE(Push(ring, "c"));
+
+  ASSERT_FALSE(Push(ring, "d"));
+  ASSERT_FALSE(Push(ring, "e"));
+  ASSERT_EQ(2u, ring.dropped());
+  ASSERT_EQ(3u, ring.size());
+  ASSERT_EQ("a", ToString(ring[0]));
+  ASSERT_EQ("b", ToString(ring[1]));
+  ASSERT_EQ("c", ToString(ring[2]));
+}
+
+TEST(DatagramRingTests, DropOldestKeepsTheLatestDatagrams) {
+  ssf::DatagramRing ring(3, ssf::QueueOverflowPolicy::kDropOldest);
+  ASSERT_TRUE(Push(ring, "a"));
+  ASSERT_TRUE(Push(ring, "b"));
+  ASSERT_TRUE(Push(ring, "c"));
+
+  ASSERT_FALSE(Push(ring, "d"));
+  ASSERT_FALSE(Push(ring, "e"));
+  ASSERT_EQ(2u, ring.dropped());
+  ASSERT_EQ(3u, ring.size());
+  ASSERT_EQ("c", ToString(ring[0]));
+  ASSERT_EQ("d", ToString(ring[1]));
+  ASSERT_EQ("e", ToString(ring[2]));
+}
+
+TEST(DatagramRingTests, WrapsAround) {
+  ssf::DatagramRing ring(4, ssf::QueueOverflowPolicy::kDropNewest);
+
+  // Several turns of the ring with one to three datagrams queued, each of a
+  // different length so that slot buffers get reused and replaced
+  std::size_t next = 0;
+  std::size_t front = 0;
+  for (std::size_t turn = 0; turn < 10; ++turn) {
+    while (ring.size() < 3) {
+      ASSERT_TRUE(Push(ring, std::string(1 + next % 5, 'a' + next % 26)));
+      ++next;
+    }
+    for (std::size_t i = 0; i < ring.size(); ++i) {
+      auto expected = front + i;
+      ASSERT_EQ(std::string(1 + expected % 5, 'a' + expected % 26),
+                ToString(ring[i]));
+    }
+
+    auto datagram = ring.TakeFront();
+    ASSERT_EQ(std::string(1 + front % 5, 'a' + front % 26),
+              ToString(datagram.data()));
+    ++front;
+    ring.Pop(1);
+    ++front;
+  }
+  ASSERT_EQ(0u, ring.dropped());
+  ASSERT_EQ(1u, ring.size());
+
+  ring.Pop(10);
+  ASSERT_TRUE(ring.empty());
+  ASSERT_TRUE(Push(ring, "z"));
+  ASSERT_EQ("z", ToString(ring[0]));
+}
+
+TEST(DatagramRingTests, TrimReleasesTheFreeSlots) {
+  ssf::DatagramRing ring(4, ssf::QueueOverflowPolicy::kDropNewest);
+  std::string datagram(1000, 'x');
+  for (std::size_t i = 0; i < ring.capacity(); ++i) {
+    ASSERT_TRUE(Push(ring, datagram));
+  }
+  ring.Pop(3);
+
+  auto cached_bytes = ssf::BufferPool::Get().cached_bytes();
+  ring.Trim();
+  ASSERT_EQ(cached_bytes + 3 * ssf::BufferPool::ClassSize(datagram.size()),
+            ssf::BufferPool::Get().cached_bytes());
+
+  // The queued datagram is untouched
+  ASSERT_EQ(1u, ring.size());
+  ASSERT_EQ(datagram, ToString(ring[0]));
+}
@@ -0,0 +1,177 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/ip/udp.hpp>
+
+#include "services/datagram/flow_table.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Endpoint = boost::asio::ip::udp::endpoint;
+
+class Link {
+ public:
+  explicit Link(Clock::time_point activity) : last_activity_(activity) {}
+
+  void Touch(Clock::time_point activity) { last_activity_ = activity; }
+  Clock::time_point last_activity() const { return last_activity_; }
+
+ private:
+  Clock::time_point last_activity_;
+};
+
+using LinkPtr = std::shared_ptr<Link>;
+using Table = ssf::FlowTable<Endpoint, Link>;
+
+Endpoint MakeEndpoint(uint32_t address, uint16_t port) {
+  return Endpoint(boost::asio::ip::address_v4(address), port);
+}
+
+}  // namespace
+
+TEST(FlowTableTests, InsertFindErase) {
+  Table table(ssf::FlowLimits(16, std::chrono::seconds(10)));
+  auto now = Clock::now();
+  auto endpoint = MakeEndpoint(0x7f000001, 1000);
+  auto p_link = std::make_shared<Link>(now);
+
+  ASSERT_FALSE(table.Find(endpoint));
+  ASSERT_TRUE(table.Insert(endpoint, p_link));
+  ASSERT_FALSE(table.Insert(endpoint, std::make_shared<Link>(now)));
+  ASSERT_EQ(1u, table.size());
+  ASSERT_EQ(p_link, table.Find(endpoint));
+
+  // Same port on another address is another flow
+  auto other_endpoint = MakeEndpoint(0x7f000002, 1000);
+  ASSERT_FALSE(table.Find(other_endpoint));
+
+  ASSERT_FALSE(table.Erase(endpoint, std::make_shared<Link>(now)));
+  ASSERT_TRUE(table.Erase(endpoint, p_link));
+  ASSERT_FALSE(table.Find(endpoint));
+  ASSERT_EQ(0u, table.size());
+}
+
+TEST(FlowTableTests, IdleFlowExpiresAfterTheTimeout) {
+  Table table(ssf::FlowLimits(16, std::chrono::seconds(10)));
+  auto start = Clock::now();
+  auto endpoint = MakeEndpoint(0x7f000001, 1000);
+  auto p_link = std::make_shared<Link>(start);
+  ASSERT_TRUE(table.Insert(endpoint, p_link));
+
+  ASSERT_TRUE(table.Expire(start + std::chrono::seconds(5)).empty());
+  ASSERT_EQ(p_link, table.Find(endpoint));
+
+  auto expired = table.Expire(start + std::chrono::seconds(11));
+  ASSERT_EQ(1u, expired.size());
+  ASSERT_EQ(p_link, expired.front());
+  ASSERT_FALSE(table.Find(endpoint));
+  ASSERT_EQ(0u, table.size());
+}
+
+TEST(FlowTableTests, TouchedFlowIsRescheduled) {
+  Table table(ssf::FlowLimits(16, std::chrono::seconds(10)));
+  auto start = Clock::now();
+  auto endpoint = MakeEndpoint(0x7f000001, 1000);
+  auto p_link = std::make_shared<Link>(start);
+  ASSERT_TRUE(table.Insert(endpoint, p_link));
+
+  // Activity refreshes the link without touching the wheel: the check at the
+  // first due tick moves it to its new due tick
+  p_link->Touch(start + std::chrono::seconds(8));
+  ASSERT_TRUE(table.Expire(start + std::chrono::seconds(11)).empty());
+  ASSERT_TRUE(table.Expire(start + std::chrono::seconds(17)).empty());
+  ASSERT_EQ(p_link, table.Find(endpoint));
+
+  auto expired = table.Expire(start + std::chrono::seconds(19));
+  ASSERT_EQ(1u, expired.size());
+  ASSERT_EQ(p_link, expired.front());
+}
+
+TEST(FlowTableTests, ReplacedLinkKeepsItsOwnSchedule) {
+  Table table(ssf::FlowLimits(16, std::chrono::seconds(10)));
+  auto start = Clock::now();
+  auto endpoint = MakeEndpoint(0x7f000001, 1000);
+  auto p_old_link = std::make_shared<Link>(start);
+  ASSERT_TRUE(table.Insert(endpoint, p_old_link));
+  ASSERT_TRUE(table.Erase(endpoint, p_old_link));
+
+  auto p_new_link = std::make_shared<Link>(start + std::chrono::seconds(5));
+  ASSERT_TRUE(table.Insert(endpoint, p_new_link));
+
+  // The entry of the erased link does not expire the new one
+  ASSERT_TRUE(table.Expire(start + std::chrono::seconds(11)).empty());
+  ASSERT_EQ(p_new_link, table.Find(endpoint));
+
+  auto expired = table.Expire(start + std::chrono::seconds(16));
+  ASSERT_EQ(1u, expired.size());
+  ASSERT_EQ(p_new_link, expired.front());
+}
+
+TEST(FlowTableTests, FullTableRefusesNewFlows) {
+  const std::size_t max_flows = 4;
+  Table table(ssf::FlowLimits(max_flows, std::chrono::seconds(10)));
+  auto start = Clock::now();
+
+  std::vector<LinkPtr> links;
+  for (uint16_t port = 1; port <= max_flows; ++port) {
+    links.push_back(std::make_shared<Link>(start));
+    ASSERT_TRUE(table.Insert(MakeEndpoint(0x7f000001, port), links.back()));
+  }
+  auto new_endpoint = MakeEndpoint(0x7f000001, 100);
+  ASSERT_FALSE(table.Insert(new_endpoint, std::make_shared<Link>(start)));
+  ASSERT_EQ(max_flows, table.size());
+
+  // An erased flow makes room for a new one
+  ASSERT_TRUE(table.Erase(MakeEndpoint(0x7f000001, 1), links.front()));
+  ASSERT_TRUE(table.Insert(new_endpoint, std::make_shared<Link>(start)));
+  ASSERT_FALSE(table.Insert(MakeEndpoint(0x7f000001, 101),
+                            std::make_shared<Link>(start)));
+
+  // So do the idle flows once expired
+  ASSERT_EQ(max_flows, table.Expire(start + std::chrono::seconds(11)).size());
+  ASSERT_EQ(0u, table.size());
+  ASSERT_TRUE(table.Insert(MakeEndpoint(0x7f000001, 101),
+                           std::make_shared<Link>(start)));
+}
+
+TEST(FlowTableTests, ShardsAreUsedConcurrently) {
+  const uint32_t thread_count = 4;
+  const uint32_t flows_per_thread = 1000;
+  Table table(ssf::FlowLimits(thread_count * flows_per_thread,
+                              std::chrono::seconds(10)));
+  auto start = Clock::now();
+
+  std::atomic<uint32_t> failures(0);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&table, &failures, start, t, flows_per_thread]() {
+      for (uint32_t i = 0; i < flows_per_thread; ++i) {
+        auto endpoint =
+            MakeEndpoint(0x0a000000 + t, static_cast<uint16_t>(1 + i));
+        auto p_link = std::make_shared<Link>(start);
+        if (!table.Insert(endpoint, p_link) || table.Find(endpoint) != p_link) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(0u, failures.load());
+  ASSERT_EQ(thread_count * flows_per_thread, table.size());
+
+  // Every shard holds some of the flows: they all come back on clear
+  auto links = table.Clear();
+  ASSERT_EQ(thread_count * flows_per_thread, links.size());
+  ASSERT_EQ(0u, table.size());
+  ASSERT_TRUE(table.Expire(start + std::chrono::seconds(11)).empty());
+}
@@ -117,7 +117,8 @@ class ServiceFixtureTest : public ::testing::Test {
     p_ssf_client_.reset(new Client());
     p_ssf_client_->Register<TServiceTested<demux>>();
     p_ssf_client_->Init(
-        endpoint_query, 1, 0, false, user_service_params, ssf_config.services(),
+        endpoint_query, 1, 0, false, 1, user_service_params,
+        ssf_config.services(),
         std::bind(&ServiceFixtureTest::OnClientStatus, this,
                   std::placeholders::_1),
         std::bind(&ServiceFixtureTest::OnClientUserServiceStatus, this,